@@ -14,9 +14,12 @@
 #define __PROCESS_DISPATCH_HPP__
 
 #include <functional>
-#include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 
+#include <process/event.hpp>
 #include <process/process.hpp>
 
 #include <stout/preprocessor.hpp>
@@ -53,18 +56,28 @@ namespace process {
 
 namespace internal {
 
+// Delivers the dispatch event to the process associated with the
+// event's pid, unless that process is no longer valid.
+void dispatch(DispatchEvent* event);
+
+
 // The internal dispatch routine schedules a function to get invoked
 // within the context of the process associated with the specified pid
 // (first argument), unless that process is no longer valid. Note that
 // this routine does not expect anything in particular about the
 // specified function (second argument). The semantics are simple: the
 // function gets applied/invoked with the process as its first
-// argument. Currently we wrap the function in a shared_ptr but this
-// will probably change in the future to unique_ptr (or a variant).
+// argument. The function is stored in the dispatch event itself, so
+// dispatching only requires allocating the event.
+template <typename F>
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<std::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType = None());
+    F&& f,
+    const Option<const std::type_info*>& functionType = None())
+{
+  dispatch(new FunctionDispatchEvent<typename std::decay<F>::type>(
+      pid, std::forward<F>(f), functionType));
+}
 
 
 // NOTE: This struct is used by the public `dispatch(const UPID& pid, F&& f)`
@@ -83,13 +96,11 @@ struct Dispatch<void>
   template <typename F>
   void operator()(const UPID& pid, F&& f)
   {
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              f();
-            }));
-
-    internal::dispatch(pid, f_);
+    internal::dispatch(
+        pid,
+        [=](ProcessBase*) {
+          f();
+        });
   }
 };
 
@@ -106,13 +117,11 @@ struct Dispatch<Future<R>>
   {
     std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              promise->associate(f());
-            }));
-
-    internal::dispatch(pid, f_);
+    internal::dispatch(
+        pid,
+        [=](ProcessBase*) {
+          promise->associate(f());
+        });
 
     return promise->future();
   }
@@ -130,13 +139,11 @@ struct Dispatch
   {
     std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              promise->set(f());
-            }));
-
-    internal::dispatch(pid, f_);
+    internal::dispatch(
+        pid,
+        [=](ProcessBase*) {
+          promise->set(f());
+        });
 
     return promise->future();
   }
@@ -156,16 +163,15 @@ struct Dispatch
 template <typename T>
 void dispatch(const PID<T>& pid, void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != nullptr);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != nullptr);
-            (t->*method)();
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != nullptr);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != nullptr);
+        (t->*method)();
+      },
+      &typeid(method));
 }
 
 template <typename T>
@@ -192,16 +198,15 @@ void dispatch(const Process<T>* process, void (T::*method)())
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != nullptr);                               \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != nullptr);                                     \
-              (t->*method)(ENUM_PARAMS(N, a));                          \
-            }));                                                        \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != nullptr);                                   \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != nullptr);                                         \
+          (t->*method)(ENUM_PARAMS(N, a));                              \
+        },                                                              \
+        &typeid(method));                                               \
   }                                                                     \
                                                                         \
   template <typename T,                                                 \
@@ -237,16 +242,15 @@ Future<R> dispatch(const PID<T>& pid, Future<R> (T::*method)())
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != nullptr);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != nullptr);
-            promise->associate((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != nullptr);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != nullptr);
+        promise->associate((t->*method)());
+      },
+      &typeid(method));
 
   return promise->future();
 }
@@ -275,16 +279,15 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
   {                                                                     \
     std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != nullptr);                               \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != nullptr);                                     \
-              promise->associate((t->*method)(ENUM_PARAMS(N, a)));      \
-            }));                                                        \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != nullptr);                                   \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != nullptr);                                         \
+          promise->associate((t->*method)(ENUM_PARAMS(N, a)));          \
+        },                                                              \
+        &typeid(method));                                               \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -324,16 +327,15 @@ Future<R> dispatch(const PID<T>& pid, R (T::*method)())
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != nullptr);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != nullptr);
-            promise->set((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != nullptr);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != nullptr);
+        promise->set((t->*method)());
+      },
+      &typeid(method));
 
   return promise->future();
 }
@@ -362,16 +364,15 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
   {                                                                     \
     std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != nullptr);                               \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != nullptr);                                     \
-              promise->set((t->*method)(ENUM_PARAMS(N, a)));            \
-            }));                                                        \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != nullptr);                                   \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != nullptr);                                         \
+          promise->set((t->*method)(ENUM_PARAMS(N, a)));                \
+        },                                                              \
+        &typeid(method));                                               \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -13,7 +13,11 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
-#include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <stddef.h>
+
+#include <atomic>
+#include <typeinfo>
+#include <utility>
 
 #include <process/future.hpp>
 #include <process/http.hpp>
@@ -26,6 +30,7 @@
 namespace process {
 
 // Forward declarations.
+class EventQueue;
 class ProcessBase;
 struct MessageEvent;
 struct DispatchEvent;
@@ -45,12 +50,42 @@ struct EventVisitor
 };
 
 
+// The types of events, e.g., used to count the events of each type
+// that are queued for a process without visiting them.
+enum class EventType
+{
+  MESSAGE,
+  DISPATCH,
+  HTTP,
+  EXITED,
+  TERMINATE
+};
+
+
 struct Event
 {
+  Event() : next(nullptr) {}
+
+  // NOTE: A copy of an event is not queued anywhere.
+  Event(const Event&) : next(nullptr) {}
+
   virtual ~Event() {}
 
+  // Events are allocated from per-thread pools on the libprocess
+  // worker threads (and from the heap otherwise), since an event is
+  // allocated for every message and dispatch. See process.cpp.
+  static void* operator new(size_t size);
+  static void operator delete(void* event, size_t size);
+
+  // NOTE: Declaring the above hides the placement forms, which are
+  // used to construct events in place (e.g., in an `Option`).
+  static void* operator new(size_t, void* event) { return event; }
+  static void operator delete(void*, void*) {}
+
   virtual void visit(EventVisitor* visitor) const = 0;
 
+  virtual EventType type() const = 0;
+
   template <typename T>
   bool is() const
   {
@@ -81,6 +116,13 @@ struct Event
     }
     return *result;
   }
+
+private:
+  friend class EventQueue;
+
+  // Link to the next event in the queue of a process, so that
+  // queueing an event does not require an allocation.
+  std::atomic<Event*> next;
 };
 
 
@@ -102,6 +144,13 @@ struct MessageEvent : Event
     visitor->visit(*this);
   }
 
+  virtual EventType type() const
+  {
+    return TYPE;
+  }
+
+  static constexpr EventType TYPE = EventType::MESSAGE;
+
   Message* const message;
 
 private:
@@ -135,6 +184,13 @@ struct HttpEvent : Event
     visitor->visit(*this);
   }
 
+  virtual EventType type() const
+  {
+    return TYPE;
+  }
+
+  static constexpr EventType TYPE = EventType::HTTP;
+
   http::Request* const request;
   Promise<http::Response>* response;
 
@@ -149,10 +205,8 @@ struct DispatchEvent : Event
 {
   DispatchEvent(
       const UPID& _pid,
-      const std::shared_ptr<lambda::function<void(ProcessBase*)>>& _f,
       const Option<const std::type_info*>& _functionType)
     : pid(_pid),
-      f(_f),
       functionType(_functionType)
   {}
 
@@ -161,12 +215,19 @@ struct DispatchEvent : Event
     visitor->visit(*this);
   }
 
+  virtual EventType type() const
+  {
+    return TYPE;
+  }
+
+  static constexpr EventType TYPE = EventType::DISPATCH;
+
+  // Invokes the function of this dispatch event on the process.
+  virtual void invoke(ProcessBase* process) const = 0;
+
   // PID receiving the dispatch.
   const UPID pid;
 
-  // Function to get invoked as a result of this dispatch event.
-  const std::shared_ptr<lambda::function<void(ProcessBase*)>> f;
-
   const Option<const std::type_info*> functionType;
 
 private:
@@ -176,6 +237,33 @@ private:
 };
 
 
+namespace internal {
+
+// A dispatch event that holds the function (e.g., the lambda created
+// by `dispatch`) by value, so that dispatching a function does not
+// require any allocations besides the event itself.
+template <typename F>
+struct FunctionDispatchEvent : DispatchEvent
+{
+  template <typename G>
+  FunctionDispatchEvent(
+      const UPID& _pid,
+      G&& _f,
+      const Option<const std::type_info*>& _functionType)
+    : DispatchEvent(_pid, _functionType),
+      f(std::forward<G>(_f)) {}
+
+  virtual void invoke(ProcessBase* process) const
+  {
+    f(process);
+  }
+
+  const F f;
+};
+
+} // namespace internal {
+
+
 struct ExitedEvent : Event
 {
   explicit ExitedEvent(const UPID& _pid)
@@ -186,6 +274,13 @@ struct ExitedEvent : Event
     visitor->visit(*this);
   }
 
+  virtual EventType type() const
+  {
+    return TYPE;
+  }
+
+  static constexpr EventType TYPE = EventType::EXITED;
+
   const UPID pid;
 
 private:
@@ -206,6 +301,13 @@ struct TerminateEvent : Event
     visitor->visit(*this);
   }
 
+  virtual EventType type() const
+  {
+    return TYPE;
+  }
+
+  static constexpr EventType TYPE = EventType::TERMINATE;
+
   const UPID from;
 
 private:
@@ -0,0 +1,205 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_HISTOGRAM_HPP__
+#define __PROCESS_HISTOGRAM_HPP__
+
+#include <glog/logging.h>
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include <stout/foreach.hpp>
+
+namespace process {
+
+// A histogram of values in logarithmically sized buckets, from which
+// percentiles can be computed without keeping (and sorting) the
+// values themselves. Each bucket spans values within a relative
+// 'error' of each other, and the value of a bucket is the mean of
+// the values in it. Percentiles are thus within a relative 'error'
+// of the exact ones, and are exact as long as every bucket holds a
+// single distinct value (e.g., for small numbers of values).
+//
+// Unlike most such sketches, values can also be removed (e.g., as
+// they leave the window of a time series), and histograms with the
+// same error can be merged. Values that are not finite (NaN and
+// infinities) are ignored, since they do not fall in any bucket.
+class Histogram
+{
+public:
+  explicit Histogram(double _error = 0.01)
+    : error(_error),
+      gamma(std::log1p(_error)),
+      // Offset the indices of positive values so that they are all
+      // positive, down to the smallest (subnormal) doubles.
+      offset(static_cast<int>(std::ceil(-std::log(4.9e-324) / gamma)) + 1),
+      total(0)
+  {
+    CHECK(error > 0 && error < 1);
+  }
+
+  void add(double value)
+  {
+    if (!std::isfinite(value)) {
+      return;
+    }
+
+    Bucket& bucket = buckets[index(value)];
+    bucket.count++;
+    bucket.sum += value;
+    total++;
+  }
+
+  // Removes a value that was previously added.
+  void remove(double value)
+  {
+    if (!std::isfinite(value)) {
+      return;
+    }
+
+    std::map<int, Bucket>::iterator bucket = buckets.find(index(value));
+
+    if (bucket == buckets.end()) {
+      return;
+    }
+
+    if (--bucket->second.count == 0) {
+      buckets.erase(bucket);
+    } else {
+      bucket->second.sum -= value;
+    }
+
+    total--;
+  }
+
+  void merge(const Histogram& that)
+  {
+    CHECK_EQ(error, that.error);
+
+    foreachpair (int index, const Bucket& bucket, that.buckets) {
+      buckets[index].count += bucket.count;
+      buckets[index].sum += bucket.sum;
+    }
+
+    total += that.total;
+  }
+
+  size_t count() const { return total; }
+
+  bool empty() const { return total == 0; }
+
+  // Returns the values at the given percentiles, which must be in
+  // [0, 1] and in increasing order. Like the percentiles of a sorted
+  // sequence of the values, we interpolate linearly between the two
+  // values around the position of each percentile. The cost depends
+  // on the number of (non-empty) buckets, not on the number of values.
+  // Note that we need at least two values to compute percentiles!
+  std::vector<double> percentiles(const std::vector<double>& percentiles) const
+  {
+    CHECK_GE(total, 2u);
+
+    std::vector<double> result;
+    result.reserve(percentiles.size());
+
+    // The bucket holding the value at 'rank', and the number of
+    // values in the buckets preceding it. Since the percentiles are
+    // in increasing order, we only ever need to advance the bucket.
+    std::map<int, Bucket>::const_iterator bucket = buckets.begin();
+    size_t preceding = 0;
+
+    auto advance = [](
+        std::map<int, Bucket>::const_iterator& bucket,
+        size_t& preceding,
+        size_t rank) {
+      while (preceding + bucket->second.count <= rank) {
+        preceding += bucket->second.count;
+        ++bucket;
+      }
+
+      return bucket->second.sum / bucket->second.count;
+    };
+
+    foreach (double percentile, percentiles) {
+      CHECK(result.empty() || percentile >= percentiles[result.size() - 1]);
+
+      if (percentile <= 0.0) {
+        result.push_back(advance(bucket, preceding, 0));
+        continue;
+      }
+
+      if (percentile >= 1.0) {
+        result.push_back(advance(bucket, preceding, total - 1));
+        continue;
+      }
+
+      const double position = percentile * (total - 1);
+      const size_t rank = static_cast<size_t>(std::floor(position));
+      const double delta = position - rank;
+
+      CHECK_LT(rank, total - 1);
+
+      const double lower = advance(bucket, preceding, rank);
+
+      // NOTE: The next rank is looked up on copies, since the next
+      // percentile may be at the same rank.
+      std::map<int, Bucket>::const_iterator next = bucket;
+      size_t preceding_ = preceding;
+
+      const double upper = advance(next, preceding_, rank + 1);
+
+      result.push_back(lower + delta * (upper - lower));
+    }
+
+    return result;
+  }
+
+private:
+  struct Bucket
+  {
+    Bucket() : count(0), sum(0.0) {}
+
+    size_t count;
+    double sum;
+  };
+
+  // Returns the index of the bucket for the value. Indices increase
+  // with the values: negative values map to negative indices, zero
+  // to 0, and positive values to positive indices. The value must
+  // be finite, since the logarithm of an infinity is not
+  // representable as an index.
+  int index(double value) const
+  {
+    CHECK(std::isfinite(value));
+
+    if (value > 0) {
+      return offset + static_cast<int>(std::ceil(std::log(value) / gamma));
+    } else if (value < 0) {
+      return -(offset + static_cast<int>(std::ceil(std::log(-value) / gamma)));
+    }
+
+    return 0;
+  }
+
+  // Non-const for assignability.
+  double error;
+  double gamma; // The logarithm of the ratio of the bucket bounds.
+  int offset;
+
+  std::map<int, Bucket> buckets;
+  size_t total;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_HISTOGRAM_HPP__
@@ -387,6 +387,16 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns the number of bytes written to the pipe that have yet
+    // to be read, e.g., to detect a reader that can't keep up.
+    size_t pending() const;
+
+    // Returns a future that is satisfied once everything written to
+    // the pipe so far has been read, or the read-end is closed. This
+    // allows a writer to apply backpressure, i.e., to wait for a slow
+    // reader before writing more.
+    Future<Nothing> drained() const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -418,7 +428,8 @@ private:
   {
     Data()
       : readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        bytes(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -434,6 +445,12 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // The total size of the unread 'writes'.
+    size_t bytes;
+
+    // Represents writers waiting for the unread 'writes' to be read.
+    std::queue<Owned<Promise<Nothing>>> drains;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -448,11 +465,12 @@ private:
 struct Response
 {
   Response()
-    : type(NONE)
+    : type(NONE),
+      compressible(false)
   {}
 
   Response(uint16_t _code)
-    : type(NONE), code(_code)
+    : type(NONE), compressible(false), code(_code)
   {
     status = Status::string(code);
   }
@@ -462,6 +480,7 @@ struct Response
       uint16_t _code,
       const std::string& contentType = "text/plain; charset=utf-8")
     : type(BODY),
+      compressible(false),
       body(_body),
       code(_code)
   {
@@ -504,6 +523,12 @@ struct Response
     PIPE
   } type;
 
+  // Whether a PIPE response may be gzip encoded (chunk by chunk) for
+  // the clients that accept it. Streams are left alone by default,
+  // since clients of long-lived streams (e.g., of events) may read
+  // the raw body, and every chunk has to be flushed separately.
+  bool compressible;
+
   std::string body;
   std::string path;
   Option<Pipe::Reader> reader;
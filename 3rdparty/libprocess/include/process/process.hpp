@@ -15,7 +15,9 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -327,6 +329,39 @@ protected:
     route(name, realm, help, handler);
   }
 
+  /**
+   * Caches the responses of the HTTP endpoint with the specified
+   * name, which must already have been set up using `route`.
+   *
+   * Successful responses to `GET` requests are tagged with an `ETag`
+   * that is unique to the request's path, query and principal as well
+   * as to the current cache version of this process. Requests whose
+   * `If-None-Match` header includes the current tag are answered with
+   * a `304 Not Modified` without invoking the handler. If `responses`
+   * is true, other requests are served `BODY` responses from the
+   * cache until the version changes (`PIPE` responses are never
+   * kept). Endpoints that stream their responses should thus only
+   * have them tagged.
+   *
+   * The cache hits and misses of the endpoint are exposed as the
+   * `<id>/http_cache/<name>/hits` and `.../misses` metrics.
+   *
+   * @see process::ProcessBase::invalidateCache
+   */
+  void cache(const std::string& name, bool responses = true);
+
+  /**
+   * Invalidates the cached responses (and tags) of all the endpoints
+   * of this process. A process must call this whenever any state
+   * exposed by its cached endpoints changes.
+   *
+   * @see process::ProcessBase::cache
+   */
+  void invalidateCache()
+  {
+    ++cacheVersion;
+  }
+
   /**
    * Sets up the default HTTP request handler to provide the static
    * asset(s) at the specified _absolute_ path for the specified name.
@@ -356,18 +391,13 @@ protected:
 
   /**
    * Returns the number of events of the given type currently on the event
-   * queue.
+   * queue. The count is approximate when events are concurrently being
+   * enqueued or dequeued, but it does not require a walk of the queue.
    */
   template <typename T>
   size_t eventCount()
   {
-    size_t count = 0U;
-
-    synchronized (mutex) {
-      count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    }
-
-    return count;
+    return eventCount(T::TYPE);
   }
 
 private:
@@ -377,6 +407,9 @@ private:
   friend void* schedule(void*);
 
   // Process states.
+  //
+  // NOTE: The enum is anonymous (and 'state' an `int`) so that it
+  // doesn't hide a `State` type in the scope of subclasses.
   enum
   {
     BOTTOM,
@@ -385,21 +418,19 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
 
-  template <typename T>
-  static bool isEventType(const Event* event)
-  {
-    return event->is<T>();
-  }
+  std::atomic<int> state;
 
-  // Mutex protecting internals.
-  // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
-  std::recursive_mutex mutex;
+  // Returns the number of events of the given type on the event queue.
+  size_t eventCount(EventType type);
 
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
 
+  // The responses cached for an HTTP endpoint, see `cache`.
+  struct HttpCache;
+
   // Delegates for messages.
   std::map<std::string, UPID> delegates;
 
@@ -423,8 +454,23 @@ private:
 
     Option<std::string> realm;
     Option<AuthenticatedHttpRequestHandler> authenticatedHandler;
+
+    // Only set for endpoints whose responses are cached. This is
+    // shared with the continuations that populate the cache.
+    std::shared_ptr<HttpCache> cache;
   };
 
+  // Invokes the handler of the endpoint for the request, serving the
+  // response from the endpoint's cache if possible.
+  Future<http::Response> _visit(
+      const HttpEndpoint& endpoint,
+      const Owned<http::Request>& request,
+      const Option<std::string>& principal);
+
+  // Version of the responses cached by this process, increased by
+  // `invalidateCache`.
+  uint64_t cacheVersion;
+
   // Handlers for messages and HTTP requests.
   struct {
     std::map<std::string, MessageHandler> message;
@@ -446,12 +492,25 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queue of received events. Events can be enqueued by any thread
+  // without locking, but only dequeued by the thread running the
+  // process (see `ProcessManager::resume`).
+  Owned<EventQueue> events;
+
+  // Number of events that have been enqueued but not yet been served,
+  // plus one while the process is being initialized. The thread that
+  // increments this from zero is responsible for putting the process
+  // on a run queue, and the thread that decrements it to zero must not
+  // touch the process anymore.
+  std::atomic_long pending;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the run queue (i.e., processing thread) the process was
+  // last placed on, or -1 if it has not been enqueued yet.
+  std::atomic_long runq;
+
   // Process PID.
   UPID pid;
 };
@@ -15,12 +15,12 @@
 
 #include <glog/logging.h>
 
-#include <algorithm>
 #include <vector>
 
+#include <process/histogram.hpp>
 #include <process/timeseries.hpp>
 
-#include <stout/foreach.hpp>
+#include <stout/none.hpp>
 #include <stout/option.hpp>
 
 namespace process {
@@ -30,40 +30,37 @@ template <typename T>
 struct Statistics
 {
   // Returns Statistics for the given TimeSeries, or None() if the
-  // TimeSeries is empty.
-  // TODO(dhamon): Consider adding a histogram abstraction for better
-  // performance.
+  // TimeSeries is empty. The statistics are computed from the
+  // histogram of the TimeSeries, so the percentiles are approximate
+  // (see Histogram) and the cost does not grow with the number of
+  // values. The minimum and maximum are exact.
   static Option<Statistics<T> > from(const TimeSeries<T>& timeseries)
   {
-    std::vector<typename TimeSeries<T>::Value> values_ = timeseries.get();
+    const Histogram& histogram = timeseries.histogram();
 
     // We need at least 2 values to compute aggregates.
-    if (values_.size() < 2) {
+    if (histogram.count() < 2) {
       return None();
     }
 
-    std::vector<T> values;
-    values.reserve(values_.size());
-
-    foreach (const typename TimeSeries<T>::Value& value, values_) {
-      values.push_back(value.data);
-    }
-
-    std::sort(values.begin(), values.end());
+    const std::vector<double> percentiles = histogram.percentiles(
+        {0.5, 0.9, 0.95, 0.99, 0.999, 0.9999});
 
     Statistics statistics;
 
-    statistics.count = values.size();
+    statistics.count = histogram.count();
 
-    statistics.min = values.front();
-    statistics.max = values.back();
+    // NOTE: The histogram holds at least two (finite) values, so
+    // the extremes are defined.
+    statistics.min = timeseries.min().get();
+    statistics.max = timeseries.max().get();
 
-    statistics.p50 = percentile(values, 0.5);
-    statistics.p90 = percentile(values, 0.90);
-    statistics.p95 = percentile(values, 0.95);
-    statistics.p99 = percentile(values, 0.99);
-    statistics.p999 = percentile(values, 0.999);
-    statistics.p9999 = percentile(values, 0.9999);
+    statistics.p50 = static_cast<T>(percentiles[0]);
+    statistics.p90 = static_cast<T>(percentiles[1]);
+    statistics.p95 = static_cast<T>(percentiles[2]);
+    statistics.p99 = static_cast<T>(percentiles[3]);
+    statistics.p999 = static_cast<T>(percentiles[4]);
+    statistics.p9999 = static_cast<T>(percentiles[5]);
 
     return statistics;
   }
@@ -80,33 +77,6 @@ struct Statistics
   T p99;
   T p999;
   T p9999;
-
-private:
-  // Returns the requested percentile from the sorted values.
-  // Note that we need at least two values to compute percentiles!
-  // TODO(dhamon): Use a 'Percentage' abstraction.
-  static T percentile(const std::vector<T>& values, double percentile)
-  {
-    CHECK_GE(values.size(), 2u);
-
-    if (percentile <= 0.0) {
-      return values.front();
-    }
-
-    if (percentile >= 1.0) {
-      return values.back();
-    }
-
-    // Use linear interpolation.
-    const double position = percentile * (values.size() - 1);
-    const size_t index = static_cast<size_t>(floor(position));
-    const double delta = position - index;
-
-    CHECK_GE(index, 0u);
-    CHECK_LT(index, values.size() - 1);
-
-    return values[index] + delta * (values[index + 1] - values[index]);
-  }
 };
 
 } // namespace process {
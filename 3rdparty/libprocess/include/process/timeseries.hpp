@@ -13,11 +13,14 @@
 #ifndef __PROCESS_TIMESERIES_HPP__
 #define __PROCESS_TIMESERIES_HPP__
 
-#include <algorithm> // For max.
+#include <algorithm> // For max, min.
+#include <cmath>
 #include <map>
+#include <utility>
 #include <vector>
 
 #include <process/clock.hpp>
+#include <process/histogram.hpp>
 #include <process/time.hpp>
 
 #include <stout/duration.hpp>
@@ -44,7 +47,9 @@ extern const size_t TIME_SERIES_CAPACITY;
 // data points (coarse granularity). The tunable bit here is the
 // total number of data points to keep around, which informs how
 // often to delete older data points, while still keeping a window
-// worth of data.
+// worth of data. A histogram of the values is maintained alongside
+// the time series, so that statistics can be computed without
+// copying and sorting the values.
 // TODO(bmahler): Investigate using Google's btree implementation.
 // This provides better insertion and lookup performance for large
 // containers. This _should_ also provide significant memory
@@ -60,7 +65,8 @@ struct TimeSeries
              size_t _capacity = TIME_SERIES_CAPACITY)
     : window(_window),
       // The truncation technique requires at least 3 elements.
-      capacity(std::max((size_t) 3, _capacity)) {}
+      capacity(std::max((size_t) 3, _capacity)),
+      stale(false) {}
 
   struct Value
   {
@@ -82,7 +88,17 @@ struct TimeSeries
       index = None();
     }
 
-    values[time] = value;
+    std::pair<typename std::map<Time, T>::iterator, bool> inserted =
+      values.insert(std::make_pair(time, value));
+
+    // Overwrite the existing value, if any.
+    if (!inserted.second) {
+      removed(inserted.first->second);
+      inserted.first->second = value;
+    }
+
+    added(value);
+
     truncate();
     sparsify();
   }
@@ -122,6 +138,26 @@ struct TimeSeries
 
   bool empty() const { return values.empty(); }
 
+  // Returns the histogram of the values in the time series.
+  const Histogram& histogram() const { return distribution; }
+
+  // Returns the exact minimum and maximum of the (finite) values in
+  // the time series, or None() if there are no such values. Unlike
+  // the percentiles of the histogram, these are not approximated.
+  // They are maintained as values are added, and only recomputed
+  // from the values when the current extreme has been removed.
+  Option<T> min() const
+  {
+    extremes();
+    return minimum;
+  }
+
+  Option<T> max() const
+  {
+    extremes();
+    return maximum;
+  }
+
   // Removes values outside the time window. This will ensure at
   // least one value remains. Note that this is called automatically
   // when writing to the time series, so this is only needed when
@@ -165,6 +201,12 @@ struct TimeSeries
     //                               After truncating, we must
     //   After:          4 5 6 7 ... reset index to None().
     //   ----------------------------------------------------------
+    for (typename std::map<Time, T>::iterator it = values.begin();
+         it != upper_bound;
+         ++it) {
+      removed(it->second);
+    }
+
     if (index.isSome() && upper_bound->first < next->first) {
       size_t size = values.size();
       values.erase(values.begin(), upper_bound);
@@ -176,6 +218,59 @@ struct TimeSeries
   }
 
 private:
+  static bool finite(const T& value)
+  {
+    return std::isfinite(static_cast<double>(value));
+  }
+
+  void added(const T& value)
+  {
+    distribution.add(static_cast<double>(value));
+
+    // Stale extremes are recomputed from all of the values anyway.
+    if (!stale && finite(value)) {
+      minimum = minimum.isNone() ? value : std::min(minimum.get(), value);
+      maximum = maximum.isNone() ? value : std::max(maximum.get(), value);
+    }
+  }
+
+  void removed(const T& value)
+  {
+    distribution.remove(static_cast<double>(value));
+
+    // Removing a value equal to an extreme may change it, in which
+    // case we defer recomputing it until it is next needed, since
+    // values often leave the time series in batches.
+    if (!stale && finite(value) &&
+        (!(minimum.get() < value) || !(value < maximum.get()))) {
+      stale = true;
+    }
+  }
+
+  // Recomputes the extremes from the values if they are stale.
+  void extremes() const
+  {
+    if (!stale) {
+      return;
+    }
+
+    minimum = None();
+    maximum = None();
+
+    for (typename std::map<Time, T>::const_iterator it = values.begin();
+         it != values.end();
+         ++it) {
+      if (finite(it->second)) {
+        minimum = minimum.isNone()
+          ? it->second : std::min(minimum.get(), it->second);
+        maximum = maximum.isNone()
+          ? it->second : std::max(maximum.get(), it->second);
+      }
+    }
+
+    stale = false;
+  }
+
   // Performs "sparsification" to limit the size of the time series
   // to be within the capacity.
   //
@@ -227,6 +322,7 @@ private:
         index = 1;
       }
 
+      removed(next->second);
       next = values.erase(next);
       next++; // Skip one element.
       index = index.get() + 1;
@@ -241,6 +337,16 @@ private:
   // that way we can retrieve a series in sorted order efficiently.
   std::map<Time, T> values;
 
+  // The histogram of 'values', updated as values are added and
+  // removed.
+  Histogram distribution;
+
+  // The exact extremes of the (finite) 'values', which are only
+  // valid when not 'stale'.
+  mutable Option<T> minimum;
+  mutable Option<T> maximum;
+  mutable bool stale;
+
   // Next deletion candidate. We store both the iterator and index.
   // The index is None initially, and whenever a value is appended
   // out-of-order. This means 'next' is only valid when 'index' is
@@ -13,12 +13,17 @@
 #ifndef __DECODER_HPP__
 #define __DECODER_HPP__
 
+#include <limits.h>
+#include <stdint.h>
+
 #include <http_parser.h>
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/http.hpp>
@@ -27,6 +32,7 @@
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/option.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 
@@ -34,6 +40,11 @@ namespace process {
 
 // TODO(benh): Make DataDecoder abstract and make RequestDecoder a
 // concrete subclass.
+//
+// NOTE: A decoder is used for all the requests of a connection, so
+// it keeps the header fields and values of the request being decoded
+// in a buffer (`arena`) that is reused across requests, and only
+// copies them out once all the headers have been decoded.
 class DataDecoder
 {
 public:
@@ -98,8 +109,9 @@ private:
     CHECK(!decoder->failure);
 
     decoder->header = HEADER_FIELD;
-    decoder->field.clear();
-    decoder->value.clear();
+    decoder->arena.clear();
+    decoder->headers.clear();
+    decoder->url.clear();
     decoder->query.clear();
 
     CHECK(decoder->request == nullptr);
@@ -150,16 +162,26 @@ private:
   }
 #endif // !(HTTP_PARSER_VERSION_MAJOR >= 2)
 
+  // NOTE: The URL might be passed in pieces (e.g., when it spans
+  // reads), so it only gets parsed once the request is complete.
   static int on_url(http_parser* p, const char* data, size_t length)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
+    decoder->url.append(data, length);
+    return 0;
+  }
+
+  static int parse_url(DataDecoder* decoder)
+  {
     int result = 0;
 
 #if (HTTP_PARSER_VERSION_MAJOR >= 2)
     // Reworked parsing for version >= 2.0.
+    const char* data = decoder->url.data();
+
     http_parser_url url;
-    result = http_parser_parse_url(data, length, 0, &url);
+    result = http_parser_parse_url(data, decoder->url.size(), 0, &url);
 
     if (result == 0) {
       if (url.field_set & (1 << UF_PATH)) {
@@ -188,18 +210,21 @@ private:
     return result;
   }
 
+  // NOTE: A header field or value might be passed in pieces (e.g.,
+  // when it spans reads), in which case the pieces are contiguous in
+  // the arena since nothing else is decoded in between.
   static int on_header_field(http_parser* p, const char* data, size_t length)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
 
-    if (decoder->header != HEADER_FIELD) {
-      decoder->request->headers[decoder->field] = decoder->value;
-      decoder->field.clear();
-      decoder->value.clear();
+    if (decoder->header != HEADER_FIELD || decoder->headers.empty()) {
+      const View view = {decoder->arena.size(), 0};
+      decoder->headers.push_back(std::make_pair(view, view));
     }
 
-    decoder->field.append(data, length);
+    decoder->arena.append(data, length);
+    decoder->headers.back().first.length += length;
     decoder->header = HEADER_FIELD;
 
     return 0;
@@ -209,8 +234,16 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
-    decoder->value.append(data, length);
+    CHECK(!decoder->headers.empty());
+
+    if (decoder->header != HEADER_VALUE) {
+      decoder->headers.back().second.offset = decoder->arena.size();
+    }
+
+    decoder->arena.append(data, length);
+    decoder->headers.back().second.length += length;
     decoder->header = HEADER_VALUE;
+
     return 0;
   }
 
@@ -220,16 +253,34 @@ private:
 
     CHECK_NOTNULL(decoder->request);
 
-    // Add final header.
-    decoder->request->headers[decoder->field] = decoder->value;
-    decoder->field.clear();
-    decoder->value.clear();
+    const char* arena = decoder->arena.data();
+
+    foreach (const Header& header, decoder->headers) {
+      decoder->request->headers[
+          std::string(arena + header.first.offset, header.first.length)]
+        .assign(arena + header.second.offset, header.second.length);
+    }
 
     decoder->request->method =
       http_method_str((http_method) decoder->parser.method);
 
     decoder->request->keepAlive = http_should_keep_alive(&decoder->parser);
 
+    // Allocate the body up front if its length is known, so that a
+    // small body does not get reallocated (and copied) as it arrives
+    // in pieces.
+    // NOTE: The length is given by the client, which need not send
+    // that much, so we only allocate up to 64KB up front; a larger
+    // body grows geometrically as it arrives.
+    const uint64_t limit = 64 * 1024;
+
+    if (!(decoder->parser.flags & F_CHUNKED) &&
+        decoder->parser.content_length > 0 &&
+        decoder->parser.content_length != ULLONG_MAX) {
+      decoder->request->body.reserve(static_cast<size_t>(
+          std::min(decoder->parser.content_length, limit)));
+    }
+
     return 0;
   }
 
@@ -245,6 +296,12 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
 
+    CHECK_NOTNULL(decoder->request);
+
+    if (parse_url(decoder) != 0) {
+      return 1;
+    }
+
     // Parse the query key/values.
     Try<hashmap<std::string, std::string>> decoded =
       http::query::decode(decoder->query);
@@ -253,8 +310,6 @@ private:
       return 1;
     }
 
-    CHECK_NOTNULL(decoder->request);
-
     decoder->request->url.query = decoded.get();
 
     Option<std::string> encoding =
@@ -265,9 +320,9 @@ private:
       if (decompressed.isError()) {
         return 1;
       }
-      decoder->request->body = decompressed.get();
+      decoder->request->body = std::move(decompressed.get());
       decoder->request->headers["Content-Length"] =
-        decoder->request->body.length();
+        stringify(decoder->request->body.length());
     }
 
     decoder->requests.push_back(decoder->request);
@@ -288,8 +343,21 @@ private:
     HEADER_VALUE
   } header;
 
-  std::string field;
-  std::string value;
+  // A piece of the arena.
+  struct View
+  {
+    size_t offset;
+    size_t length;
+  };
+
+  // A header field and its value.
+  typedef std::pair<View, View> Header;
+
+  // The header fields and values of the request being decoded.
+  std::string arena;
+  std::vector<Header> headers;
+
+  std::string url;
   std::string query;
 
   http::Request* request;
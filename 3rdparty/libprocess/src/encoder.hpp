@@ -14,25 +14,85 @@
 #define __ENCODER_HPP__
 
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 
 #include <map>
 #include <sstream>
+#include <string>
 
+#include <glog/logging.h>
+
+#include <process/future.hpp>
 #include <process/http.hpp>
 #include <process/process.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
 #include <stout/numify.hpp>
+#include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/unreachable.hpp>
 
 
 namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+
+// How responses are compressed for the HTTP clients that accept the
+// gzip encoding. These can be overridden with the
+// LIBPROCESS_HTTP_COMPRESSION_LEVEL and
+// LIBPROCESS_HTTP_COMPRESSION_MINIMUM_LENGTH environment variables.
+struct HttpCompression
+{
+  HttpCompression()
+    : level(Z_DEFAULT_COMPRESSION),
+      minimumLength(GZIP_MINIMUM_BODY_LENGTH) {}
+
+  // The zlib compression level, see `gzip::compress()`. Setting it
+  // to `Z_NO_COMPRESSION` disables compression.
+  int level;
+
+  // Responses with shorter bodies are not worth compressing. Streamed
+  // responses that opt in are compressed regardless, since their length
+  // is unknown (see `http::Response::compressible`).
+  size_t minimumLength;
+};
+
+
+// Defined in process.cpp.
+extern HttpCompression http_compression;
+
+
+// Returns whether the response should be gzip compressed for the
+// request.
+inline bool compressible(
+    const http::Response& response,
+    const http::Request& request)
+{
+  if (http_compression.level == Z_NO_COMPRESSION ||
+      response.headers.contains("Content-Encoding") ||
+      !request.acceptsEncoding("gzip")) {
+    return false;
+  }
+
+  switch (response.type) {
+    case http::Response::BODY:
+      return response.body.length() >= http_compression.minimumLength;
+    case http::Response::PIPE:
+      return response.compressible;
+    case http::Response::NONE:
+    case http::Response::PATH:
+      return false;
+  }
+
+  UNREACHABLE();
+}
+
 // Forward declarations.
 class Encoder;
 
@@ -98,63 +158,144 @@ public:
     return data.size() - index;
   }
 
+protected:
+  // NOTE: Subclasses may only append to the data before any of it has
+  // been sent (i.e., before the first call to `next`).
+  std::string data;
+
 private:
-  const std::string data;
   size_t index;
 };
 
 
+// Encodes a chunk of a streamed HTTP response. The encoder gets
+// deleted once the chunk has been sent (or dropped because the socket
+// was closed), which satisfies `sent()`.
+class ChunkEncoder : public DataEncoder
+{
+public:
+  ChunkEncoder(const network::Socket& s, const std::string& data)
+    : DataEncoder(s, data) {}
+
+  virtual ~ChunkEncoder()
+  {
+    promise.set(Nothing());
+  }
+
+  // NOTE: This must be called before the encoder is handed to the
+  // `SocketManager`, which may delete it at any time afterwards.
+  Future<Nothing> sent()
+  {
+    return promise.future();
+  }
+
+private:
+  Promise<Nothing> promise;
+};
+
+
+// Encodes messages as HTTP POST requests. An encoder can hold more
+// than one message: messages that get sent on a socket while it is
+// busy are appended to the last queued encoder (see `SocketManager`),
+// so that they are all sent at once when the socket becomes ready.
 class MessageEncoder : public DataEncoder
 {
 public:
-  MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+  MessageEncoder(const network::Socket& s, Message* message)
+    : DataEncoder(s, std::string())
+  {
+    append(message);
+  }
 
-  virtual ~MessageEncoder()
+  // Appends the encoded message and deletes it. Must not be called
+  // once the encoder has started sending.
+  void append(Message* message)
   {
-    if (message != nullptr) {
-      delete message;
+    CHECK_NOTNULL(message);
+
+    // Most of the headers only depend on the sender, so we reuse them
+    // for consecutive messages from the same sender.
+    if (from.isNone() || from.get() != message->from) {
+      from = message->from;
+      headers = encode(message->from);
     }
+
+    encode(*message, headers, &data);
+
+    delete message;
   }
 
   static std::string encode(Message* message)
   {
-    std::ostringstream out;
+    std::string out;
 
     if (message != nullptr) {
-      out << "POST ";
-      // Nothing keeps the 'id' component of a PID from being an empty
-      // string which would create a malformed path that has two
-      // '//' unless we check for it explicitly.
-      // TODO(benh): Make the 'id' part of a PID optional so when it's
-      // missing it's clear that we're simply addressing an ip:port.
-      if (message->to.id != "") {
-        out << "/" << message->to.id;
-      }
-
-      out << "/" << message->name << " HTTP/1.1\r\n"
-          << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
-          << "Host: \r\n";
-
-      if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
-      } else {
-        out << "\r\n";
-      }
+      encode(*message, encode(message->from), &out);
     }
 
-    return out.str();
+    return out;
   }
 
 private:
-  Message* message;
+  // Returns the headers of a message from the given sender.
+  static std::string encode(const UPID& from)
+  {
+    const std::string sender = stringify(from);
+
+    std::string out;
+    out.reserve(96 + 2 * sender.size());
+
+    out.append("User-Agent: libprocess/").append(sender).append("\r\n");
+    out.append("Libprocess-From: ").append(sender).append("\r\n");
+    out.append("Connection: Keep-Alive\r\n");
+    out.append("Host: \r\n");
+
+    return out;
+  }
+
+  static void encode(
+      const Message& message,
+      const std::string& headers,
+      std::string* out)
+  {
+    out->reserve(
+        out->size() +
+        message.to.id.size() +
+        message.name.size() +
+        headers.size() +
+        message.body.size() +
+        96);
+
+    out->append("POST ");
+
+    // Nothing keeps the 'id' component of a PID from being an empty
+    // string which would create a malformed path that has two
+    // '//' unless we check for it explicitly.
+    // TODO(benh): Make the 'id' part of a PID optional so when it's
+    // missing it's clear that we're simply addressing an ip:port.
+    if (message.to.id != "") {
+      out->append("/").append(message.to.id);
+    }
+
+    out->append("/").append(message.name).append(" HTTP/1.1\r\n");
+    out->append(headers);
+
+    if (message.body.size() > 0) {
+      char size[32];
+      snprintf(size, sizeof(size), "%zx", message.body.size());
+
+      out->append("Transfer-Encoding: chunked\r\n\r\n");
+      out->append(size).append("\r\n");
+      out->append(message.body);
+      out->append("\r\n0\r\n\r\n");
+    } else {
+      out->append("\r\n");
+    }
+  }
+
+  // The sender of the last appended message, and its headers.
+  Option<UPID> from;
+  std::string headers;
 };
 
 
@@ -197,23 +338,30 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
+    // Should we compress this response? Streamed responses are
+    // compressed chunk by chunk as they are sent, see `HttpProxy`.
+    //
+    // NOTE: We avoid copying the body unless it gets compressed, as
+    // it can be very large (e.g., the master's state).
+    Option<std::string> compressed;
 
     if (response.type == http::Response::BODY &&
-        response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
-        !headers.contains("Content-Encoding") &&
-        request.acceptsEncoding("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
-      if (compressed.isError()) {
-        LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
+        compressible(response, request)) {
+      Try<std::string> result =
+        gzip::compress(response.body, http_compression.level);
+
+      if (result.isError()) {
+        LOG(WARNING) << "Failed to gzip response body: " << result.error();
       } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
+        compressed = result.get();
+        headers["Content-Length"] = stringify(compressed->length());
         headers["Content-Encoding"] = "gzip";
       }
     }
 
+    const std::string& body =
+      compressed.isSome() ? compressed.get() : response.body;
+
     foreachpair (const std::string& key, const std::string& value, headers) {
       out << key << ": " << value << "\r\n";
     }
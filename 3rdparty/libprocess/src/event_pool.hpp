@@ -0,0 +1,116 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_EVENT_POOL_HPP__
+#define __PROCESS_EVENT_POOL_HPP__
+
+#include <stddef.h>
+
+#include <new>
+
+namespace process {
+
+// A pool of memory for events that is used by a single thread, so
+// that allocating and deleting events does not need to go through
+// the global allocator (nor synchronize with other threads).
+//
+// Events are usually allocated by one thread and deleted by another
+// (the one running the receiving process), so a pool only keeps up
+// to `CAPACITY` free blocks of each size and returns any others to
+// the global allocator.
+class EventPool
+{
+public:
+  EventPool()
+  {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      blocks[i] = nullptr;
+      sizes[i] = 0;
+    }
+  }
+
+  ~EventPool()
+  {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      while (blocks[i] != nullptr) {
+        Block* block = blocks[i];
+        blocks[i] = block->next;
+        ::operator delete(block);
+      }
+    }
+  }
+
+  void* allocate(size_t size)
+  {
+    const size_t bucket = index(size);
+
+    if (bucket < BUCKETS && blocks[bucket] != nullptr) {
+      Block* block = blocks[bucket];
+      blocks[bucket] = block->next;
+      sizes[bucket]--;
+      return block;
+    }
+
+    return ::operator new(capacity(size));
+  }
+
+  // NOTE: The block must have been allocated by some `EventPool`
+  // (i.e., with the capacity of its size).
+  void deallocate(void* pointer, size_t size)
+  {
+    const size_t bucket = index(size);
+
+    if (bucket < BUCKETS && sizes[bucket] < CAPACITY) {
+      Block* block = static_cast<Block*>(pointer);
+      block->next = blocks[bucket];
+      blocks[bucket] = block;
+      sizes[bucket]++;
+      return;
+    }
+
+    ::operator delete(pointer);
+  }
+
+  // Returns the size of the block used for an event of the given
+  // size, so that blocks can be reused for events of similar sizes.
+  static size_t capacity(size_t size)
+  {
+    const size_t bucket = index(size);
+    return bucket < BUCKETS ? (bucket + 1) * GRANULARITY : size;
+  }
+
+private:
+  // Events are pooled in blocks of multiples of `GRANULARITY` bytes,
+  // which covers all events but dispatches with large arguments.
+  static constexpr size_t GRANULARITY = 64;
+  static constexpr size_t BUCKETS = 8;
+
+  // The maximum number of free blocks of each size.
+  static constexpr size_t CAPACITY = 1024;
+
+  static size_t index(size_t size)
+  {
+    return size == 0 ? 0 : (size - 1) / GRANULARITY;
+  }
+
+  struct Block
+  {
+    Block* next;
+  };
+
+  Block* blocks[BUCKETS];
+  size_t sizes[BUCKETS];
+};
+
+} // namespace process {
+
+#endif // __PROCESS_EVENT_POOL_HPP__
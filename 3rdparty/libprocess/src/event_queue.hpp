@@ -0,0 +1,232 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_EVENT_QUEUE_HPP__
+#define __PROCESS_EVENT_QUEUE_HPP__
+
+#include <atomic>
+#include <mutex>
+
+#include <process/event.hpp>
+
+#include <stout/synchronized.hpp>
+#include <stout/unreachable.hpp>
+
+namespace process {
+
+// The queue of events of a process. Any number of threads (producers)
+// can enqueue events without locking, while only the thread running
+// the process (the consumer) can dequeue them.
+//
+// Events are linked intrusively (see `Event::next`), using Dmitry
+// Vyukov's intrusive MPSC node-based queue algorithm: a producer
+// only swaps the head of the queue and links the previous head to its
+// event, while the consumer follows the links from the tail.
+class EventQueue
+{
+public:
+  EventQueue() : decommissioned(false)
+  {
+    for (size_t i = 0; i < TYPES; i++) {
+      counts[i].store(0);
+    }
+  }
+
+  ~EventQueue()
+  {
+    synchronized (mutex) {
+      drain();
+    }
+  }
+
+  // Enqueues the event, unless the queue has been decommissioned, in
+  // which case the event is deleted. Injected events are dequeued
+  // before all other events (in the order they were injected).
+  void enqueue(Event* event, bool inject = false)
+  {
+    if (decommissioned.load()) {
+      delete event;
+      return;
+    }
+
+    counts[index(event->type())].fetch_add(1);
+
+    if (inject) {
+      injected.push(event);
+    } else {
+      events.push(event);
+    }
+
+    // If the queue was decommissioned while we were enqueueing, the
+    // consumer might have already drained the queue, so we delete the
+    // event (and any other events enqueued in the meantime) ourselves.
+    if (decommissioned.load()) {
+      synchronized (mutex) {
+        drain();
+      }
+    }
+  }
+
+  // Returns the next event, if any. Must only be called by the
+  // consumer. Note that an event that is in the middle of being
+  // enqueued might not be returned yet.
+  Event* dequeue()
+  {
+    Event* event = injected.pop();
+
+    if (event == nullptr) {
+      event = events.pop();
+    }
+
+    if (event != nullptr) {
+      counts[index(event->type())].fetch_sub(1);
+    }
+
+    return event;
+  }
+
+  // Returns the (approximate) number of queued events of the type.
+  size_t count(EventType type) const
+  {
+    return static_cast<size_t>(counts[index(type)].load());
+  }
+
+  bool isDecommissioned() const
+  {
+    return decommissioned.load();
+  }
+
+  // Deletes all of the queued events, and any events that get
+  // enqueued later on. Must only be called by the consumer, after
+  // which there is no consumer anymore.
+  void decommission()
+  {
+    synchronized (mutex) {
+      decommissioned.store(true);
+      drain();
+    }
+  }
+
+private:
+  static constexpr size_t TYPES = 5;
+
+  static size_t index(EventType type)
+  {
+    return static_cast<size_t>(type);
+  }
+
+  // Deletes all the events, must be called with `mutex` held so that
+  // there is only a single consumer.
+  void drain()
+  {
+    Event* event = nullptr;
+
+    while ((event = injected.pop()) != nullptr ||
+           (event = events.pop()) != nullptr) {
+      counts[index(event->type())].fetch_sub(1);
+      delete event;
+    }
+  }
+
+  class Queue
+  {
+  public:
+    Queue() : head(&stub), tail(&stub) {}
+
+    void push(Event* event)
+    {
+      event->next.store(nullptr);
+
+      Event* previous = head.exchange(event);
+
+      // NOTE: Until the previous head is linked to the event, the
+      // consumer can not see the event (or any later events).
+      previous->next.store(event);
+    }
+
+    Event* pop()
+    {
+      Event* event = tail;
+      Event* next = event->next.load();
+
+      // Skip the stub.
+      if (event == &stub) {
+        if (next == nullptr) {
+          return nullptr;
+        }
+
+        tail = next;
+        event = next;
+        next = next->next.load();
+      }
+
+      if (next != nullptr) {
+        tail = next;
+        return event;
+      }
+
+      // An event is in the middle of being enqueued after this one.
+      if (event != head.load()) {
+        return nullptr;
+      }
+
+      // This is the last event, so we need to put the stub back
+      // before we can take it off the queue.
+      push(&stub);
+
+      next = event->next.load();
+
+      if (next != nullptr) {
+        tail = next;
+        return event;
+      }
+
+      return nullptr;
+    }
+
+  private:
+    // Placeholder so that the queue is never empty.
+    struct Stub : Event
+    {
+      virtual void visit(EventVisitor* visitor) const {}
+
+      virtual EventType type() const
+      {
+        UNREACHABLE();
+      }
+    };
+
+    // The most recently enqueued event (producers).
+    std::atomic<Event*> head;
+
+    // The next event to be dequeued (consumer).
+    Event* tail;
+
+    Stub stub;
+  };
+
+  Queue events;
+  Queue injected;
+
+  // Number of queued events of each type.
+  std::atomic_long counts[TYPES];
+
+  std::atomic_bool decommissioned;
+
+  // Used to make sure there is a single consumer once the queue has
+  // been decommissioned.
+  std::mutex mutex;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_EVENT_QUEUE_HPP__
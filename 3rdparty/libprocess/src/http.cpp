@@ -390,13 +390,21 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
       future = Failure("closed");
     } else if (!data->writes.empty()) {
       future = data->writes.front();
+      data->bytes -= data->writes.front().size();
       data->writes.pop();
+
+      // Extract the waiting writers once the pipe is drained so we
+      // can notify them.
+      if (data->writes.empty()) {
+        std::swap(data->drains, drains);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -408,6 +416,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!drains.empty()) {
+    drains.front()->set(Nothing());
+    drains.pop();
+  }
+
   return future;
 }
 
@@ -417,6 +432,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -425,8 +441,12 @@ bool Pipe::Reader::close()
         data->writes.pop();
       }
 
-      // Extract the pending reads so we can fail them.
+      data->bytes = 0;
+
+      // Extract the pending reads so we can fail them, and the
+      // waiting writers so we can notify them.
       std::swap(data->reads, reads);
+      std::swap(data->drains, drains);
 
       closed = true;
       data->readEnd = Reader::CLOSED;
@@ -444,6 +464,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!drains.empty()) {
+      drains.front()->set(Nothing());
+      drains.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     }
@@ -464,6 +489,7 @@ bool Pipe::Writer::write(string s)
       // Don't bother surfacing empty writes to the readers.
       if (!s.empty()) {
         if (data->reads.empty()) {
+          data->bytes += s.size();
           data->writes.push(std::move(s));
         } else {
           read = data->reads.front();
@@ -543,6 +569,35 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+size_t Pipe::Writer::pending() const
+{
+  size_t bytes = 0;
+
+  synchronized (data->lock) {
+    bytes = data->bytes;
+  }
+
+  return bytes;
+}
+
+
+Future<Nothing> Pipe::Writer::drained() const
+{
+  Future<Nothing> future;
+
+  synchronized (data->lock) {
+    if (data->readEnd == Reader::CLOSED || data->writes.empty()) {
+      future = Nothing();
+    } else {
+      data->drains.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      future = data->drains.back()->future();
+    }
+  }
+
+  return future;
+}
+
+
 OK::OK(const JSON::Value& value, const Option<string>& jsonp)
   : Response(Status::OK)
 {
@@ -0,0 +1,177 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_INSTRUMENTED_MUTEX_HPP__
+#define __PROCESS_INSTRUMENTED_MUTEX_HPP__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include <stout/duration.hpp>
+
+namespace process {
+
+// Counts how often a mutex gets acquired, and how long threads wait
+// for it and hold it. The counters of many mutexes (e.g., one for each
+// socket) can be summed up with `merge()`.
+class MutexContention
+{
+public:
+  constexpr MutexContention()
+    : acquisitions_(0),
+      waited(0),
+      held(0) {}
+
+  MutexContention(const MutexContention& that)
+    : acquisitions_(that.acquisitions()),
+      waited(that.waited.load(std::memory_order_relaxed)),
+      held(that.held.load(std::memory_order_relaxed)) {}
+
+  // Adds the counters of another mutex to these. This may be called
+  // concurrently, but not on the counters of a mutex while it is used.
+  void merge(const MutexContention& that)
+  {
+    acquisitions_.fetch_add(that.acquisitions(), std::memory_order_relaxed);
+    waited.fetch_add(
+        that.waited.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    held.fetch_add(
+        that.held.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+
+  // Returns the number of times the mutexes have been acquired.
+  uint64_t acquisitions() const
+  {
+    return acquisitions_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the total time threads have waited to acquire the mutexes.
+  Duration wait_time() const
+  {
+    return Nanoseconds(waited.load(std::memory_order_relaxed));
+  }
+
+  // Returns the total time the mutexes have been held.
+  Duration hold_time() const
+  {
+    return Nanoseconds(held.load(std::memory_order_relaxed));
+  }
+
+private:
+  template <typename Mutex>
+  friend class BasicInstrumentedMutex;
+
+  // Adds `value` to `counter`. Since the counters of a mutex are only
+  // updated with the mutex held, this doesn't need an atomic
+  // read-modify-write; the counters are only atomic so that they can
+  // be read without acquiring the mutex.
+  template <typename T>
+  static void add(std::atomic<T>& counter, T value)
+  {
+    counter.store(
+        counter.load(std::memory_order_relaxed) + value,
+        std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> acquisitions_;
+  std::atomic<int64_t> waited;
+  std::atomic<int64_t> held;
+};
+
+
+// A mutex that keeps track of how often it gets acquired, and of how
+// long threads wait for it and hold it. It can be used with
+// `synchronized`. The counters are kept with the mutex, so that
+// instrumenting a mutex doesn't introduce contention of its own.
+//
+// To keep the overhead low, the time spent waiting is only measured
+// when the mutex is not immediately available.
+//
+// NOTE: Only the outermost acquisition of a recursive acquisition
+// is accounted for.
+template <typename Mutex>
+class BasicInstrumentedMutex
+{
+public:
+  BasicInstrumentedMutex() : depth(0) {}
+
+  void lock()
+  {
+    if (mutex.try_lock()) {
+      if (depth++ == 0) {
+        acquired = std::chrono::steady_clock::now();
+        MutexContention::add<uint64_t>(contention_.acquisitions_, 1);
+      }
+      return;
+    }
+
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+    mutex.lock();
+
+    // NOTE: The mutex can't be held by this thread already, or else
+    // `try_lock()` would have succeeded.
+    depth++;
+    acquired = std::chrono::steady_clock::now();
+    MutexContention::add<uint64_t>(contention_.acquisitions_, 1);
+    MutexContention::add(contention_.waited, nanoseconds(acquired - start));
+  }
+
+  void unlock()
+  {
+    if (--depth == 0) {
+      MutexContention::add(
+          contention_.held,
+          nanoseconds(std::chrono::steady_clock::now() - acquired));
+    }
+
+    mutex.unlock();
+  }
+
+  const MutexContention& contention() const { return contention_; }
+
+  uint64_t acquisitions() const { return contention_.acquisitions(); }
+  Duration wait_time() const { return contention_.wait_time(); }
+  Duration hold_time() const { return contention_.hold_time(); }
+
+private:
+  static int64_t nanoseconds(std::chrono::steady_clock::duration duration)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        duration).count();
+  }
+
+  Mutex mutex;
+
+  // The recursion depth and the time of the outermost acquisition,
+  // only accessed with the mutex held.
+  size_t depth;
+  std::chrono::steady_clock::time_point acquired;
+
+  MutexContention contention_;
+};
+
+
+// For mutexes that may get reacquired by the thread holding them.
+typedef BasicInstrumentedMutex<std::recursive_mutex> InstrumentedMutex;
+
+// For mutexes that are never reacquired by the thread holding them.
+typedef BasicInstrumentedMutex<std::mutex> InstrumentedSimpleMutex;
+
+} // namespace process {
+
+#endif // __PROCESS_INSTRUMENTED_MUTEX_HPP__
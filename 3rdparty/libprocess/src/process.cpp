@@ -85,10 +85,14 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -100,13 +104,17 @@
 #include <stout/synchronized.hpp>
 #include <stout/thread_local.hpp>
 #include <stout/unreachable.hpp>
+#include <stout/uuid.hpp>
 
 #include "authenticator_manager.hpp"
 #include "config.hpp"
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_pool.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
+#include "instrumented_mutex.hpp"
 #ifdef USE_SSL_SOCKET
 #include "openssl.hpp"
 #endif
@@ -236,6 +244,9 @@ private:
 
   Option<http::Pipe::Reader> pipe; // Current pipe, if streaming.
 
+  // Compresses the current pipe, if the client accepts gzip.
+  Owned<gzip::Compressor> compressor;
+
   // We sequence the authentication results exposed to the caller
   // in order to satisfy HTTP pipelining.
   //
@@ -297,6 +308,116 @@ private:
 };
 
 
+// The contention on the mutexes of the outgoing queues of the sockets
+// that are gone, see `SocketManager::outgoing_mutex_contention()`.
+static MutexContention retired_outgoing_mutex_contention;
+
+
+// The data waiting to be sent on a socket. This is protected by its
+// own mutex (rather than the `SocketManager` mutex), so that queueing
+// data on a busy socket and continuing to send on a socket do not
+// contend with other sockets.
+struct Outgoing
+{
+  explicit Outgoing(bool _sending)
+    : sending(_sending),
+      closed(false),
+      batch(nullptr) {}
+
+  ~Outgoing()
+  {
+    retired_outgoing_mutex_contention.merge(mutex.contention());
+  }
+
+  // Queues the encoder if the socket is busy, in which case `nullptr`
+  // is returned; otherwise the socket becomes busy and the encoder is
+  // returned so that the caller sends it.
+  Encoder* enqueue(Encoder* encoder)
+  {
+    synchronized (mutex) {
+      if (closed) {
+        delete encoder;
+        return nullptr;
+      }
+
+      if (sending) {
+        encoders.push_back(encoder);
+        batch = nullptr;
+        return nullptr;
+      }
+
+      sending = true;
+    }
+
+    return encoder;
+  }
+
+  // Like above, except that a message queued on a busy socket is
+  // appended to the last queued message encoder, if any, so that
+  // consecutive messages get sent at once.
+  Encoder* enqueue(const Socket& socket, Message* message)
+  {
+    synchronized (mutex) {
+      if (closed) {
+        delete message;
+        return nullptr;
+      }
+
+      if (sending) {
+        if (batch != nullptr) {
+          batch->append(message);
+        } else {
+          batch = new MessageEncoder(socket, message);
+          encoders.push_back(batch);
+        }
+        return nullptr;
+      }
+
+      sending = true;
+    }
+
+    return new MessageEncoder(socket, message);
+  }
+
+  // Returns the next queued encoder, if any.
+  Encoder* dequeue()
+  {
+    synchronized (mutex) {
+      if (closed || encoders.empty()) {
+        return nullptr;
+      }
+
+      Encoder* encoder = encoders.front();
+      encoders.pop_front();
+
+      if (encoder == batch) {
+        batch = nullptr;
+      }
+
+      return encoder;
+    }
+  }
+
+  InstrumentedSimpleMutex mutex;
+
+  // Encoders that are queued while another encoder is being sent.
+  deque<Encoder*> encoders;
+
+  // Whether the socket is busy, i.e., an encoder is being sent or the
+  // socket is still being connected.
+  bool sending;
+
+  // Whether the socket has been closed (or replaced, see
+  // `SocketManager::swap_implementing_socket`), in which case nothing
+  // more gets sent.
+  bool closed;
+
+  // The last queued encoder if it is a `MessageEncoder`, so that
+  // messages can be appended to it.
+  MessageEncoder* batch;
+};
+
+
 class SocketManager
 {
 public:
@@ -323,18 +444,36 @@ public:
   void send(Message* message,
             const Socket::Kind& kind = Socket::DEFAULT_KIND());
 
-  Encoder* next(int s);
+  // Returns the next encoder to send on the socket once the current
+  // one has been sent, or `nullptr` once there is nothing more to send.
+  Encoder* next(int s, const std::shared_ptr<Outgoing>& outgoing);
 
   void close(int s);
 
   void exited(const Address& address);
   void exited(ProcessBase* process);
 
+  // The mutexes of the socket manager, exposed for their contention
+  // metrics (see `SocketManagerMetrics`).
+  const InstrumentedMutex& sockets_mutex() const { return mutex; }
+  const InstrumentedMutex& links_mutex() const { return links.mutex; }
+
+  // The contention on the mutexes of all shards, and on the mutexes
+  // of the outgoing queues of all sockets (including those that are
+  // gone), which are each accounted for per mutex.
+  MutexContention shard_mutex_contention() const;
+  MutexContention outgoing_mutex_contention();
+
 private:
   // TODO(bmahler): Leverage a bidirectional multimap instead, or
   // hide the complexity of manipulating 'links' through methods.
   struct
   {
+    // Protects the links, so that processes exiting do not contend
+    // with the sockets. If both are needed, 'links.mutex' must be
+    // acquired after 'mutex'.
+    InstrumentedMutex mutex;
+
     // For links, we maintain a bidirectional mapping between the
     // "linkers" (Processes) and the "linkees" (remote / local UPIDs).
     // For remote socket addresses, we also need a mapping to the
@@ -385,14 +524,156 @@ private:
   // (and thus generate ExitedEvents).
   map<Address, int> persists;
 
-  // Map from outbound socket to outgoing queue.
-  map<int, queue<Encoder*>> outgoing;
+  // Map from socket to the data waiting to be sent on it.
+  hashmap<int, std::shared_ptr<Outgoing>> outgoing;
 
   // HTTP proxies.
   map<int, HttpProxy*> proxies;
 
   // Protects instance variables.
-  std::recursive_mutex mutex;
+  InstrumentedMutex mutex;
+
+  // A persistent socket along with its outgoing queue.
+  struct Persistent
+  {
+    Socket socket;
+    std::shared_ptr<Outgoing> outgoing;
+  };
+
+  // The persistent sockets are also kept in shards by socket address,
+  // so that sending a message on an existing persistent socket (the
+  // common case, e.g., for a master sending to its agents) only needs
+  // to acquire the mutex of a shard rather than 'mutex'.
+  //
+  // NOTE: Shards are only modified with 'mutex' held (in addition to
+  // the mutex of the shard) and are kept in sync with 'persists'.
+  struct Shard
+  {
+    InstrumentedSimpleMutex mutex;
+    hashmap<Address, Persistent> sockets;
+
+    // Keeps neighbouring shards off each other's cache lines, whatever
+    // the alignment of 'shards', so that sending on sockets of
+    // different shards does not contend.
+    char padding[64];
+  };
+
+  static constexpr size_t SHARDS = 16;
+
+  Shard& shard(const Address& address)
+  {
+    return shards[std::hash<Address>()(address) % SHARDS];
+  }
+
+  Shard shards[SHARDS];
+};
+
+
+// Exposes the contention on the socket manager mutexes as metrics.
+class SocketManagerMetrics : public Process<SocketManagerMetrics>
+{
+public:
+  SocketManagerMetrics()
+    : ProcessBase("socket_manager"),
+      mutex_acquisitions(
+          self().id + "/mutex_acquisitions",
+          defer(self(), &SocketManagerMetrics::_mutex_acquisitions)),
+      mutex_wait_time_ms(
+          self().id + "/mutex_wait_time_ms",
+          defer(self(), &SocketManagerMetrics::_mutex_wait_time_ms)),
+      mutex_hold_time_ms(
+          self().id + "/mutex_hold_time_ms",
+          defer(self(), &SocketManagerMetrics::_mutex_hold_time_ms)),
+      links_mutex_acquisitions(
+          self().id + "/links_mutex_acquisitions",
+          defer(self(), &SocketManagerMetrics::_links_mutex_acquisitions)),
+      links_mutex_wait_time_ms(
+          self().id + "/links_mutex_wait_time_ms",
+          defer(self(), &SocketManagerMetrics::_links_mutex_wait_time_ms)),
+      links_mutex_hold_time_ms(
+          self().id + "/links_mutex_hold_time_ms",
+          defer(self(), &SocketManagerMetrics::_links_mutex_hold_time_ms)),
+      shard_mutex_acquisitions(
+          self().id + "/shard_mutex_acquisitions",
+          defer(self(), &SocketManagerMetrics::_shard_mutex_acquisitions)),
+      shard_mutex_wait_time_ms(
+          self().id + "/shard_mutex_wait_time_ms",
+          defer(self(), &SocketManagerMetrics::_shard_mutex_wait_time_ms)),
+      shard_mutex_hold_time_ms(
+          self().id + "/shard_mutex_hold_time_ms",
+          defer(self(), &SocketManagerMetrics::_shard_mutex_hold_time_ms)),
+      outgoing_mutex_acquisitions(
+          self().id + "/outgoing_mutex_acquisitions",
+          defer(self(), &SocketManagerMetrics::_outgoing_mutex_acquisitions)),
+      outgoing_mutex_wait_time_ms(
+          self().id + "/outgoing_mutex_wait_time_ms",
+          defer(self(), &SocketManagerMetrics::_outgoing_mutex_wait_time_ms)),
+      outgoing_mutex_hold_time_ms(
+          self().id + "/outgoing_mutex_hold_time_ms",
+          defer(self(), &SocketManagerMetrics::_outgoing_mutex_hold_time_ms)) {}
+
+  virtual ~SocketManagerMetrics() {}
+
+protected:
+  virtual void initialize()
+  {
+    metrics::add(mutex_acquisitions);
+    metrics::add(mutex_wait_time_ms);
+    metrics::add(mutex_hold_time_ms);
+    metrics::add(links_mutex_acquisitions);
+    metrics::add(links_mutex_wait_time_ms);
+    metrics::add(links_mutex_hold_time_ms);
+    metrics::add(shard_mutex_acquisitions);
+    metrics::add(shard_mutex_wait_time_ms);
+    metrics::add(shard_mutex_hold_time_ms);
+    metrics::add(outgoing_mutex_acquisitions);
+    metrics::add(outgoing_mutex_wait_time_ms);
+    metrics::add(outgoing_mutex_hold_time_ms);
+  }
+
+  virtual void finalize()
+  {
+    metrics::remove(mutex_acquisitions);
+    metrics::remove(mutex_wait_time_ms);
+    metrics::remove(mutex_hold_time_ms);
+    metrics::remove(links_mutex_acquisitions);
+    metrics::remove(links_mutex_wait_time_ms);
+    metrics::remove(links_mutex_hold_time_ms);
+    metrics::remove(shard_mutex_acquisitions);
+    metrics::remove(shard_mutex_wait_time_ms);
+    metrics::remove(shard_mutex_hold_time_ms);
+    metrics::remove(outgoing_mutex_acquisitions);
+    metrics::remove(outgoing_mutex_wait_time_ms);
+    metrics::remove(outgoing_mutex_hold_time_ms);
+  }
+
+private:
+  // Gauge handlers.
+  Future<double> _mutex_acquisitions();
+  Future<double> _mutex_wait_time_ms();
+  Future<double> _mutex_hold_time_ms();
+  Future<double> _links_mutex_acquisitions();
+  Future<double> _links_mutex_wait_time_ms();
+  Future<double> _links_mutex_hold_time_ms();
+  Future<double> _shard_mutex_acquisitions();
+  Future<double> _shard_mutex_wait_time_ms();
+  Future<double> _shard_mutex_hold_time_ms();
+  Future<double> _outgoing_mutex_acquisitions();
+  Future<double> _outgoing_mutex_wait_time_ms();
+  Future<double> _outgoing_mutex_hold_time_ms();
+
+  metrics::Gauge mutex_acquisitions;
+  metrics::Gauge mutex_wait_time_ms;
+  metrics::Gauge mutex_hold_time_ms;
+  metrics::Gauge links_mutex_acquisitions;
+  metrics::Gauge links_mutex_wait_time_ms;
+  metrics::Gauge links_mutex_hold_time_ms;
+  metrics::Gauge shard_mutex_acquisitions;
+  metrics::Gauge shard_mutex_wait_time_ms;
+  metrics::Gauge shard_mutex_hold_time_ms;
+  metrics::Gauge outgoing_mutex_acquisitions;
+  metrics::Gauge outgoing_mutex_wait_time_ms;
+  metrics::Gauge outgoing_mutex_hold_time_ms;
 };
 
 
@@ -438,7 +719,12 @@ public:
   string absolutePath(const string& path);
 
   void enqueue(ProcessBase* process);
-  ProcessBase* dequeue();
+
+  // Returns a runnable process for the given processing thread, taking
+  // it from the thread's own run queue or, if that is empty, stealing
+  // it from another thread's run queue. If 'wait' is false, run queues
+  // that are locked by other threads are skipped.
+  ProcessBase* dequeue(size_t worker, bool wait);
 
   void settle();
 
@@ -456,9 +742,42 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
-  list<ProcessBase*> runq;
-  std::recursive_mutex runq_mutex;
+  // Queue of runnable processes of a processing thread. A process is
+  // placed on the run queue of the thread it last ran on, so that it
+  // tends to resume on the same thread, and threads that run out of
+  // processes steal them from the other run queues.
+  struct RunQueue
+  {
+    RunQueue() : idle(false) {}
+
+    deque<ProcessBase*> processes;
+    std::mutex mutex;
+
+    // Whether the thread is about to wait, or is waiting, at 'gate'.
+    std::atomic_bool idle;
+
+    // Gate the thread waits at when there is nothing to run. It is
+    // only opened to wake up this thread, see 'wakeup'.
+    Gate gate;
+  };
+
+  // Takes the first process from the run queue, if any. If 'wait' is
+  // false and the run queue is locked, no process is taken.
+  ProcessBase* dequeue(RunQueue* runq, bool wait);
+
+  // Wakes up the thread of the run queue a process was just placed
+  // on if it is idle, or else another idle thread to steal it.
+  void wakeup(size_t worker);
+
+  // Run queues, one per processing thread (created in 'init_threads').
+  vector<Owned<RunQueue>> runqs;
+
+  // Run queue to place the next process without affinity on.
+  std::atomic_ulong next_runq;
+
+  // Number of idle processing threads, to avoid looking for one to
+  // wake up when all of them are busy.
+  std::atomic_long idle;
 
   // Number of running processes, to support Clock::settle operation.
   std::atomic_long running;
@@ -487,12 +806,12 @@ static Address __address__;
 // Active SocketManager (eventually will probably be thread-local).
 static SocketManager* socket_manager = nullptr;
 
+// Compression of HTTP responses, see 'encoder.hpp'.
+HttpCompression http_compression;
+
 // Active ProcessManager (eventually will probably be thread-local).
 static ProcessManager* process_manager = nullptr;
 
-// Scheduling gate that threads wait at when there is nothing to run.
-static Gate* gate = new Gate();
-
 // Used for authenticating HTTP requests.
 static AuthenticatorManager* authenticator_manager = nullptr;
 
@@ -520,6 +839,31 @@ THREAD_LOCAL ProcessBase* __process__ = nullptr;
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = nullptr;
 
+// Per thread pool of events, only used by the worker threads.
+THREAD_LOCAL EventPool* _event_pool_ = nullptr;
+
+
+void* Event::operator new(size_t size)
+{
+  if (_event_pool_ != nullptr) {
+    return _event_pool_->allocate(size);
+  }
+
+  // NOTE: The event might get deleted by a worker thread, which will
+  // put it in its pool, so we need to allocate a whole block.
+  return ::operator new(EventPool::capacity(size));
+}
+
+
+void Event::operator delete(void* event, size_t size)
+{
+  if (_event_pool_ != nullptr) {
+    _event_pool_->deallocate(event, size);
+  } else {
+    ::operator delete(event);
+  }
+}
+
 
 namespace http {
 
@@ -571,6 +915,22 @@ void Clock::settle()
 }
 
 
+// Called while waiting for another thread to make progress (e.g., to
+// finish enqueueing an event). We spin for a bit, which is cheapest
+// if that thread is running on another CPU, and then yield, so that
+// we don't burn a whole timeslice if that thread has been preempted.
+static void backoff(size_t* spins)
+{
+  if (++(*spins) <= 64) {
+#if defined(__i386__) || defined(__x86_64__)
+    asm ("pause");
+#endif
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+
 static Message* encode(const UPID& from,
                        const UPID& to,
                        const string& name,
@@ -663,12 +1023,31 @@ static Message* parse(Request* request)
   message->name = name;
   message->from = from.get();
   message->to = to;
-  message->body = request->body;
+
+  // NOTE: The body is moved rather than copied since the request only
+  // gets used for its headers from now on.
+  message->body = std::move(request->body);
 
   return message;
 }
 
 
+// Returns a copy of the request without its body, which is all the
+// `HttpProxy` needs in order to send the response. This avoids
+// copying (possibly large) request bodies.
+static Request metadata(Request* request)
+{
+  string body;
+  std::swap(body, request->body);
+
+  Request result = *request;
+
+  std::swap(body, request->body);
+
+  return result;
+}
+
+
 namespace internal {
 
 void decode_recv(
@@ -918,6 +1297,31 @@ bool initialize(
     }
   }
 
+  // Check environment for the compression of HTTP responses.
+  value = os::getenv("LIBPROCESS_HTTP_COMPRESSION_LEVEL");
+  if (value.isSome()) {
+    Try<int> result = numify<int>(value.get().c_str());
+    if (result.isSome() &&
+        result.get() >= Z_DEFAULT_COMPRESSION &&
+        result.get() <= Z_BEST_COMPRESSION) {
+      http_compression.level = result.get();
+    } else {
+      LOG(FATAL) << "LIBPROCESS_HTTP_COMPRESSION_LEVEL=" << value.get()
+                 << " is not a valid compression level";
+    }
+  }
+
+  value = os::getenv("LIBPROCESS_HTTP_COMPRESSION_MINIMUM_LENGTH");
+  if (value.isSome()) {
+    Try<size_t> result = numify<size_t>(value.get().c_str());
+    if (result.isSome()) {
+      http_compression.minimumLength = result.get();
+    } else {
+      LOG(FATAL) << "LIBPROCESS_HTTP_COMPRESSION_MINIMUM_LENGTH="
+                 << value.get() << " is not a valid length";
+    }
+  }
+
   // Create a "server" socket for communicating.
   Try<Socket> create = Socket::create();
   if (create.isError()) {
@@ -1051,6 +1455,9 @@ bool initialize(
   // Create the global system statistics process.
   spawn(new System(), true);
 
+  // Create the process for the socket manager metrics.
+  spawn(new SocketManagerMetrics(), true);
+
   // Create the global HTTP authentication router.
   authenticator_manager = new AuthenticatorManager();
 
@@ -1299,6 +1706,15 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     // header, we fill in (or overwrite) 'Transfer-Encoding' header.
     response.headers["Transfer-Encoding"] = "chunked";
 
+    // If the producer opted in, compress the chunks as they are read
+    // from the pipe, rather than having the producer hold the whole
+    // compressed response.
+    CHECK(compressor.get() == nullptr);
+    if (compressible(response, request)) {
+      response.headers["Content-Encoding"] = "gzip";
+      compressor.reset(new gzip::Compressor(http_compression.level));
+    }
+
     VLOG(3) << "Starting \"chunked\" streaming";
 
     socket_manager->send(
@@ -1339,27 +1755,61 @@ void HttpProxy::stream(
 
   bool finished = false; // Whether we're done streaming.
 
-  if (chunk.isReady()) {
+  // Compress the chunk, if requested. We flush each chunk so that
+  // the client can decompress everything that was produced so far
+  // (e.g., every event of a long-lived stream).
+  Option<Try<string>> compressed;
+  if (chunk.isReady() && compressor.get() != nullptr) {
+    compressed = chunk.get().empty()
+      ? compressor->finish()
+      : compressor->compress(chunk.get(), true);
+  }
+
+  if (compressed.isSome() && compressed->isError()) {
+    VLOG(1) << "Failed to compress stream: " << compressed->error();
+    // TODO(bmahler): Have to close connection if headers were sent!
+    socket_manager->send(InternalServerError(), *request, socket);
+    finished = true;
+  } else if (chunk.isReady()) {
+    const string& data =
+      compressed.isSome() ? compressed->get() : chunk.get();
+
     std::ostringstream out;
 
+    // NOTE: An empty chunk would mark the end of the response, so we
+    // omit it if the compressor produced no output.
+    if (!data.empty()) {
+      out << std::hex << data.size() << "\r\n";
+      out << data;
+      out << "\r\n";
+    }
+
     if (chunk.get().empty()) {
       // Finished reading.
       out << "0\r\n" << "\r\n";
       finished = true;
-    } else {
-      out << std::hex << chunk.get().size() << "\r\n";
-      out << chunk.get();
-      out << "\r\n";
-
-      // Keep reading.
-      reader.read()
-        .onAny(defer(self(), &Self::stream, request, lambda::_1));
     }
 
+    Future<Nothing> sent = Nothing();
+
     // Always persist the connection when streaming is not finished.
-    socket_manager->send(
-        new DataEncoder(socket, out.str()),
-        finished ? request->keepAlive : true);
+    if (!out.str().empty()) {
+      ChunkEncoder* encoder = new ChunkEncoder(socket, out.str());
+      sent = encoder->sent();
+
+      socket_manager->send(encoder, finished ? request->keepAlive : true);
+    }
+
+    // Keep reading, once the chunk has been sent. This leaves the
+    // chunks that a slow client did not receive yet in the pipe (see
+    // `Pipe::Writer::pending()`) rather than queued on the socket.
+    if (!finished) {
+      sent.onAny(defer(self(), [=](const Future<Nothing>&) {
+        http::Pipe::Reader source = reader;
+        source.read()
+          .onAny(defer(self(), &Self::stream, request, lambda::_1));
+      }));
+    }
   } else if (chunk.isFailed()) {
     VLOG(1) << "Failed to read from stream: " << chunk.failure();
     // TODO(bmahler): Have to close connection if headers were sent!
@@ -1375,6 +1825,7 @@ void HttpProxy::stream(
   if (finished) {
     reader.close();
     pipe = None();
+    compressor.reset();
     next();
   }
 }
@@ -1391,6 +1842,7 @@ void SocketManager::accepted(const Socket& socket)
   synchronized (mutex) {
     CHECK(sockets.count(socket) == 0);
     sockets.emplace(socket, socket);
+    outgoing[socket].reset(new Outgoing(false));
   }
 }
 
@@ -1421,7 +1873,10 @@ void ignore_recv_data(
 
 
 // Forward declaration.
-void send(Encoder* encoder, Socket socket);
+void send(
+    Encoder* encoder,
+    Socket socket,
+    const std::shared_ptr<Outgoing>& outgoing);
 
 
 } // namespace internal {
@@ -1501,19 +1956,29 @@ void SocketManager::link_connect(
 
   // In order to avoid a race condition where internal::send() is
   // called after SocketManager::link() but before the socket is
-  // connected, we initialize the 'outgoing' queue in
+  // connected, we initialize the 'outgoing' queue as busy in
   // SocketManager::link() and then check if the queue has anything in
   // it to send during this connection completion. When a subsequent
   // call to SocketManager::send() occurs we'll now just add the
   // encoder to the 'outgoing' queue, and when we complete the
   // connection here we'll start sending, otherwise when we call
-  // SocketManager::next() the 'outgoing' queue will get removed and
+  // SocketManager::next() the 'outgoing' queue will become idle and
   // any subsequent call to SocketManager::send() will take care of
-  // setting it back up and sending.
-  Encoder* encoder = socket_manager->next(socket);
+  // sending.
+  std::shared_ptr<Outgoing> queue;
 
-  if (encoder != nullptr) {
-    internal::send(encoder, socket);
+  synchronized (mutex) {
+    if (outgoing.contains(socket)) {
+      queue = outgoing.at(socket);
+    }
+  }
+
+  if (queue) {
+    Encoder* encoder = next(socket, queue);
+
+    if (encoder != nullptr) {
+      internal::send(encoder, socket, queue);
+    }
   }
 }
 
@@ -1561,12 +2026,18 @@ void SocketManager::link(
 
         persists[to.address] = s;
 
-        // Initialize 'outgoing' to prevent a race with
+        // Initialize 'outgoing' as busy to prevent a race with
         // SocketManager::send() while the socket is not yet connected.
-        // Initializing the 'outgoing' queue prevents
+        // Initializing the 'outgoing' queue this way prevents
         // SocketManager::send() from trying to write before it's
         // connected.
-        outgoing[s];
+        outgoing[s].reset(new Outgoing(true));
+
+        Shard& shard = this->shard(to.address);
+
+        synchronized (shard.mutex) {
+          shard.sockets.put(to.address, {socket.get(), outgoing[s]});
+        }
 
         connect = true;
       } else if (remote == ProcessBase::RemoteConnection::RECONNECT) {
@@ -1591,10 +2062,12 @@ void SocketManager::link(
       }
     }
 
-    links.linkers[to].insert(process);
-    links.linkees[process].insert(to);
-    if (to.address != __address__) {
-      links.remotes[to.address].insert(to);
+    synchronized (links.mutex) {
+      links.linkers[to].insert(process);
+      links.linkees[process].insert(to);
+      if (to.address != __address__) {
+        links.remotes[to.address].insert(to);
+      }
     }
   }
 
@@ -1671,10 +2144,14 @@ void _send(
     const Future<size_t>& result,
     Socket socket,
     Encoder* encoder,
-    size_t size);
+    size_t size,
+    const std::shared_ptr<Outgoing>& outgoing);
 
 
-void send(Encoder* encoder, Socket socket)
+void send(
+    Encoder* encoder,
+    Socket socket,
+    const std::shared_ptr<Outgoing>& outgoing)
 {
   switch (encoder->kind()) {
     case Encoder::DATA: {
@@ -1686,7 +2163,8 @@ void send(Encoder* encoder, Socket socket)
             lambda::_1,
             socket,
             encoder,
-            size));
+            size,
+            outgoing));
       break;
     }
     case Encoder::FILE: {
@@ -1699,7 +2177,8 @@ void send(Encoder* encoder, Socket socket)
             lambda::_1,
             socket,
             encoder,
-            size));
+            size,
+            outgoing));
       break;
     }
   }
@@ -1710,7 +2189,8 @@ void _send(
     const Future<size_t>& length,
     Socket socket,
     Encoder* encoder,
-    size_t size)
+    size_t size,
+    const std::shared_ptr<Outgoing>& outgoing)
 {
   if (length.isDiscarded() || length.isFailed()) {
     socket_manager->close(socket);
@@ -1724,12 +2204,12 @@ void _send(
       delete encoder;
 
       // Check for more stuff to send on socket.
-      Encoder* next = socket_manager->next(socket);
+      Encoder* next = socket_manager->next(socket, outgoing);
       if (next != nullptr) {
-        send(next, socket);
+        send(next, socket, outgoing);
       }
     } else {
-      send(encoder, socket);
+      send(encoder, socket, outgoing);
     }
   }
 }
@@ -1741,6 +2221,8 @@ void SocketManager::send(Encoder* encoder, bool persist)
 {
   CHECK(encoder != nullptr);
 
+  std::shared_ptr<Outgoing> queue;
+
   synchronized (mutex) {
     Socket socket = encoder->socket();
     if (sockets.count(socket) > 0) {
@@ -1750,22 +2232,19 @@ void SocketManager::send(Encoder* encoder, bool persist)
         dispose.insert(socket);
       }
 
-      if (outgoing.count(socket) > 0) {
-        outgoing[socket].push(encoder);
-        encoder = nullptr;
-      } else {
-        // Initialize the outgoing queue.
-        outgoing[socket];
-      }
+      queue = outgoing.at(socket);
     } else {
       VLOG(1) << "Attempting to send on a no longer valid socket!";
       delete encoder;
-      encoder = nullptr;
+      return;
     }
   }
 
+  // NOTE: The encoder gets queued if the socket is busy.
+  encoder = queue->enqueue(encoder);
+
   if (encoder != nullptr) {
-    internal::send(encoder, encoder->socket());
+    internal::send(encoder, encoder->socket(), queue);
   }
 }
 
@@ -1854,6 +2333,20 @@ void SocketManager::send_connect(
     return;
   }
 
+  std::shared_ptr<Outgoing> queue;
+
+  synchronized (mutex) {
+    if (outgoing.contains(socket)) {
+      queue = outgoing.at(socket);
+    }
+  }
+
+  // The socket might have been closed in the meantime.
+  if (!queue) {
+    delete message;
+    return;
+  }
+
   Encoder* encoder = new MessageEncoder(socket, message);
 
   // Receive and ignore data from this socket. Note that we don't
@@ -1870,7 +2363,7 @@ void SocketManager::send_connect(
         data,
         size));
 
-  internal::send(encoder, socket);
+  internal::send(encoder, socket, queue);
 }
 
 
@@ -1880,7 +2373,31 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
 
   const Address& address = message->to.address;
 
+  // Fast path: send on an existing persistent socket without acquiring
+  // 'mutex'. The message is queued with the shard mutex held so that
+  // it can not end up on a queue that has since been replaced (see
+  // `swap_implementing_socket`).
+  Shard& shard = this->shard(address);
+
+  Option<Persistent> persistent = None();
+  Encoder* encoder = nullptr;
+
+  synchronized (shard.mutex) {
+    if (shard.sockets.contains(address)) {
+      persistent = shard.sockets.at(address);
+      encoder = persistent->outgoing->enqueue(persistent->socket, message);
+    }
+  }
+
+  if (persistent.isSome()) {
+    if (encoder != nullptr) {
+      internal::send(encoder, persistent->socket, persistent->outgoing);
+    }
+    return;
+  }
+
   Option<Socket> socket = None();
+  std::shared_ptr<Outgoing> queue;
   bool connect = false;
 
   synchronized (mutex) {
@@ -1898,14 +2415,7 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
         dispose.insert(socket.get());
       }
 
-      if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(socket.get(), message));
-        return;
-      } else {
-        // Initialize the outgoing queue.
-        outgoing[socket.get()];
-      }
-
+      queue = outgoing.at(s);
     } else {
       // No persistent or temporary socket to the socket address
       // currently exists, so we create a temporary one.
@@ -1929,8 +2439,9 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
 
       dispose.insert(s);
 
-      // Initialize the outgoing queue.
-      outgoing[s];
+      // Initialize the outgoing queue as busy until the socket is
+      // connected (see `send_connect`).
+      outgoing[s].reset(new Outgoing(true));
 
       connect = true;
     }
@@ -1946,17 +2457,26 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
           socket.get(),
           message));
   } else {
-    // If we're not connecting and we haven't added the encoder to
-    // the 'outgoing' queue then schedule it to be sent.
-    internal::send(
-        new MessageEncoder(socket.get(), message),
-        socket.get());
+    // If the socket is busy the message gets queued (possibly batched
+    // with other queued messages), otherwise we send it now.
+    Encoder* encoder = queue->enqueue(socket.get(), message);
+
+    if (encoder != nullptr) {
+      internal::send(encoder, socket.get(), queue);
+    }
   }
 }
 
 
-Encoder* SocketManager::next(int s)
+Encoder* SocketManager::next(int s, const std::shared_ptr<Outgoing>& queue)
 {
+  // Fast path: continue with the next queued encoder, which does not
+  // require the `SocketManager` mutex.
+  Encoder* encoder = queue->dequeue();
+  if (encoder != nullptr) {
+    return encoder;
+  }
+
   HttpProxy* proxy = nullptr; // Non-null if needs to be terminated.
 
   synchronized (mutex) {
@@ -1971,57 +2491,74 @@ Encoder* SocketManager::next(int s)
     // references, namely the reference being used in send_data or
     // send_file!). However, when SocketManager::next is actually
     // invoked we find out there there is no more data and thus stop
-    // sending.
+    // sending. In that case the queue has been closed.
     // TODO(benh): Should we actually finish sending the data!?
-    if (sockets.count(s) > 0) {
-      CHECK(outgoing.count(s) > 0);
+    synchronized (queue->mutex) {
+      if (queue->closed) {
+        return nullptr;
+      }
+
+      // More messages might have been queued in the meantime.
+      if (!queue->encoders.empty()) {
+        encoder = queue->encoders.front();
+        queue->encoders.pop_front();
+
+        if (encoder == queue->batch) {
+          queue->batch = nullptr;
+        }
 
-      if (!outgoing[s].empty()) {
-        // More messages!
-        Encoder* encoder = outgoing[s].front();
-        outgoing[s].pop();
         return encoder;
-      } else {
-        // No more messages ... erase the outgoing queue.
-        outgoing.erase(s);
+      }
 
-        if (dispose.count(s) > 0) {
-          // This is either a temporary socket we created or it's a
-          // socket that we were receiving data from and possibly
-          // sending HTTP responses back on. Clean up either way.
-          if (addresses.count(s) > 0) {
-            const Address& address = addresses[s];
-            CHECK(temps.count(address) > 0 && temps[address] == s);
-            temps.erase(address);
-            addresses.erase(s);
-          }
+      // No more messages ... the socket is no longer busy.
+      queue->sending = false;
+    }
 
-          if (proxies.count(s) > 0) {
-            proxy = proxies[s];
-            proxies.erase(s);
-          }
+    CHECK(sockets.count(s) > 0);
 
-          dispose.erase(s);
+    if (dispose.count(s) > 0) {
+      // This is either a temporary socket we created or it's a
+      // socket that we were receiving data from and possibly
+      // sending HTTP responses back on. Clean up either way.
+      if (addresses.count(s) > 0) {
+        const Address& address = addresses[s];
+        CHECK(temps.count(address) > 0 && temps[address] == s);
+        temps.erase(address);
+        addresses.erase(s);
+      }
 
-          auto iterator = sockets.find(s);
+      if (proxies.count(s) > 0) {
+        proxy = proxies[s];
+        proxies.erase(s);
+      }
 
-          // We don't actually close the socket (we wait for the Socket
-          // abstraction to close it once there are no more references),
-          // but we do shutdown the receiving end so any DataDecoder
-          // will get cleaned up (which might have the last reference).
+      dispose.erase(s);
 
-          // Hold on to the Socket and remove it from the 'sockets'
-          // map so that in the case where 'shutdown()' ends up
-          // calling close the termination logic is not run twice.
-          Socket socket = iterator->second;
-          sockets.erase(iterator);
+      // Anything that gets queued from now on gets dropped, as it
+      // would have been if it was sent after the socket got removed.
+      synchronized (queue->mutex) {
+        queue->closed = true;
+      }
 
-          Try<Nothing> shutdown = socket.shutdown();
-          if (shutdown.isError()) {
-            LOG(ERROR) << "Failed to shutdown socket with fd " << socket.get()
-                       << ": " << shutdown.error();
-          }
-        }
+      outgoing.erase(s);
+
+      auto iterator = sockets.find(s);
+
+      // We don't actually close the socket (we wait for the Socket
+      // abstraction to close it once there are no more references),
+      // but we do shutdown the receiving end so any DataDecoder
+      // will get cleaned up (which might have the last reference).
+
+      // Hold on to the Socket and remove it from the 'sockets'
+      // map so that in the case where 'shutdown()' ends up
+      // calling close the termination logic is not run twice.
+      Socket socket = iterator->second;
+      sockets.erase(iterator);
+
+      Try<Nothing> shutdown = socket.shutdown();
+      if (shutdown.isError()) {
+        LOG(ERROR) << "Failed to shutdown socket with fd " << socket.get()
+                   << ": " << shutdown.error();
       }
     }
   }
@@ -2048,12 +2585,32 @@ void SocketManager::close(int s)
     // try and close it again). Thus, ignore the request if we don't
     // know about the socket.
     if (sockets.count(s) > 0) {
+      // Stop sending on this socket if it is a persistent one.
+      if (addresses.count(s) > 0) {
+        const Address& address = addresses[s];
+
+        if (persists.count(address) > 0 && persists[address] == s) {
+          Shard& shard = this->shard(address);
+
+          synchronized (shard.mutex) {
+            shard.sockets.erase(address);
+          }
+        }
+      }
+
       // Clean up any remaining encoders for this socket.
-      if (outgoing.count(s) > 0) {
-        while (!outgoing[s].empty()) {
-          Encoder* encoder = outgoing[s].front();
-          delete encoder;
-          outgoing[s].pop();
+      if (outgoing.contains(s)) {
+        const std::shared_ptr<Outgoing>& queue = outgoing.at(s);
+
+        synchronized (queue->mutex) {
+          queue->closed = true;
+
+          foreach (Encoder* encoder, queue->encoders) {
+            delete encoder;
+          }
+
+          queue->encoders.clear();
+          queue->batch = nullptr;
         }
 
         outgoing.erase(s);
@@ -2139,7 +2696,7 @@ void SocketManager::exited(const Address& address)
   // into ProcessManager ... then we wouldn't have to convince
   // ourselves that the accesses to each Process object will always be
   // valid.
-  synchronized (mutex) {
+  synchronized (links.mutex) {
     if (!links.remotes.contains(address)) {
       return; // No linkees for this socket address!
     }
@@ -2180,7 +2737,7 @@ void SocketManager::exited(ProcessBase* process)
   // can update the clocks of linked processes as appropriate.
   const Time time = Clock::now(process);
 
-  synchronized (mutex) {
+  synchronized (links.mutex) {
     // If this process had linked to anything, we need to clean
     // up any pointers to it. Also, if this process was the last
     // linker to a remote linkee, we must remove linkee from the
@@ -2270,16 +2827,149 @@ void SocketManager::swap_implementing_socket(
       // No need to erase as we're changing the value, not the key.
     }
 
-    // Move any encoders queued against this link to the new socket.
-    outgoing[to_fd] = std::move(outgoing[from_fd]);
-    outgoing.erase(from_fd);
+    // Move any encoders queued against this link to the new socket,
+    // which is busy until it is connected. The queue of the old socket
+    // gets closed so that nothing more gets sent on it.
+    std::shared_ptr<Outgoing> queue(new Outgoing(true));
+
+    const Address& address = addresses[to_fd];
+    const bool persistent =
+      persists.count(address) > 0 && persists[address] == to_fd;
+
+    // NOTE: The shard mutex is held while moving the encoders so that
+    // messages sent on the persistent socket in the meantime end up
+    // on the new queue.
+    Shard& shard = this->shard(address);
+
+    synchronized (shard.mutex) {
+      if (outgoing.contains(from_fd)) {
+        const std::shared_ptr<Outgoing>& existing = outgoing.at(from_fd);
+
+        synchronized (existing->mutex) {
+          existing->closed = true;
+          queue->encoders.swap(existing->encoders);
+          queue->batch = existing->batch;
+          existing->batch = nullptr;
+        }
 
-    // Update the fd any proxies are associated with.
-    if (proxies.count(from_fd) > 0) {
-      proxies[to_fd] = proxies[from_fd];
-      proxies.erase(from_fd);
+        outgoing.erase(from_fd);
+      }
+
+      outgoing[to_fd] = queue;
+
+      if (persistent) {
+        shard.sockets.put(address, {to, queue});
+      }
+    }
+
+    // Update the fd any proxies are associated with.
+    if (proxies.count(from_fd) > 0) {
+      proxies[to_fd] = proxies[from_fd];
+      proxies.erase(from_fd);
+    }
+  }
+}
+
+
+MutexContention SocketManager::shard_mutex_contention() const
+{
+  MutexContention contention;
+
+  foreach (const Shard& shard, shards) {
+    contention.merge(shard.mutex.contention());
+  }
+
+  return contention;
+}
+
+
+MutexContention SocketManager::outgoing_mutex_contention()
+{
+  MutexContention contention(retired_outgoing_mutex_contention);
+
+  // NOTE: A queue that was removed but is still being sent on is not
+  // accounted for until it is gone.
+  synchronized (mutex) {
+    foreachvalue (const std::shared_ptr<Outgoing>& queue, outgoing) {
+      contention.merge(queue->mutex.contention());
     }
   }
+
+  return contention;
+}
+
+
+Future<double> SocketManagerMetrics::_mutex_acquisitions()
+{
+  return static_cast<double>(socket_manager->sockets_mutex().acquisitions());
+}
+
+
+Future<double> SocketManagerMetrics::_mutex_wait_time_ms()
+{
+  return socket_manager->sockets_mutex().wait_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_mutex_hold_time_ms()
+{
+  return socket_manager->sockets_mutex().hold_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_links_mutex_acquisitions()
+{
+  return static_cast<double>(socket_manager->links_mutex().acquisitions());
+}
+
+
+Future<double> SocketManagerMetrics::_links_mutex_wait_time_ms()
+{
+  return socket_manager->links_mutex().wait_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_links_mutex_hold_time_ms()
+{
+  return socket_manager->links_mutex().hold_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_shard_mutex_acquisitions()
+{
+  return static_cast<double>(
+      socket_manager->shard_mutex_contention().acquisitions());
+}
+
+
+Future<double> SocketManagerMetrics::_shard_mutex_wait_time_ms()
+{
+  return socket_manager->shard_mutex_contention().wait_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_shard_mutex_hold_time_ms()
+{
+  return socket_manager->shard_mutex_contention().hold_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_outgoing_mutex_acquisitions()
+{
+  return static_cast<double>(
+      socket_manager->outgoing_mutex_contention().acquisitions());
+}
+
+
+Future<double> SocketManagerMetrics::_outgoing_mutex_wait_time_ms()
+{
+  return socket_manager->outgoing_mutex_contention().wait_time().ms();
+}
+
+
+Future<double> SocketManagerMetrics::_outgoing_mutex_hold_time_ms()
+{
+  return socket_manager->outgoing_mutex_contention().hold_time().ms();
 }
 
 
@@ -2287,6 +2977,8 @@ ProcessManager::ProcessManager(const Option<string>& _delegate)
   : delegate(_delegate)
 {
   running.store(0);
+  next_runq.store(0);
+  idle.store(0);
 }
 
 
@@ -2311,7 +3003,9 @@ ProcessManager::~ProcessManager()
 
   // Send signal to all processing threads to stop running.
   joining_threads.store(true);
-  gate->open();
+  foreach (const Owned<RunQueue>& runq, runqs) {
+    runq->gate.open();
+  }
   EventLoop::stop();
 
   // Join all threads.
@@ -2368,36 +3062,66 @@ long ProcessManager::init_threads()
 
   threads.reserve(num_worker_threads + 1);
 
+  runqs.reserve(num_worker_threads);
+  for (long i = 0; i < num_worker_threads; i++) {
+    runqs.push_back(Owned<RunQueue>(new RunQueue()));
+  }
+
   struct
   {
     void operator()() const
     {
+      RunQueue* runq = process_manager->runqs[index].get();
+
+      _event_pool_ = new EventPool();
+
       do {
-        ProcessBase* process = process_manager->dequeue();
+        ProcessBase* process = process_manager->dequeue(index, false);
         if (process == nullptr) {
-          Gate::state_t old = gate->approach();
-          process = process_manager->dequeue();
+          Gate::state_t old = runq->gate.approach();
+
+          // NOTE: We must mark ourselves idle before looking at the
+          // run queues again, so that a process enqueued after we
+          // looked is guaranteed to wake us up (see 'wakeup').
+          runq->idle.store(true);
+          process_manager->idle.fetch_add(1);
+
+          process = process_manager->dequeue(index, true);
           if (process == nullptr) {
             if (joining_threads.load()) {
               break;
             }
-            gate->arrive(old); // Wait at gate if idle.
-            continue;
+            runq->gate.arrive(old); // Wait at gate if idle.
           } else {
-            gate->leave();
+            runq->gate.leave();
+          }
+
+          runq->idle.store(false);
+          process_manager->idle.fetch_sub(1);
+
+          if (process == nullptr) {
+            continue;
           }
         }
         process_manager->resume(process);
       } while (true);
+
+      delete _event_pool_;
+      _event_pool_ = nullptr;
     }
 
     // We hold a constant reference to `joining_threads` to make it clear that
     // this value is only being tested (read), and not manipulated.
     const std::atomic_bool& joining_threads;
-  } worker{joining_threads};
+
+    // Index of this thread's run queue.
+    size_t index;
+  } worker{joining_threads, 0};
 
   // Create processing threads.
   for (long i = 0; i < num_worker_threads; i++) {
+    worker.index = i;
+
     // Retain the thread handles so that we can join when shutting down.
     threads.emplace_back(new std::thread(worker));
   }
@@ -2484,7 +3208,7 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::enqueue, BadRequest(), *request);
+    dispatch(proxy, &HttpProxy::enqueue, BadRequest(), metadata(request));
 
     // Cleanup request.
     delete request;
@@ -2501,7 +3225,7 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
+    dispatch(proxy, &HttpProxy::enqueue, NotFound(), metadata(request));
 
     // Cleanup request.
     delete request;
@@ -2554,7 +3278,7 @@ void ProcessManager::handle(
             proxy,
             &HttpProxy::enqueue,
             rejection.get(),
-            *request);
+            metadata(request));
 
         // Cleanup request.
         delete request;
@@ -2572,7 +3296,7 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::handle, promise->future(), *request);
+    dispatch(proxy, &HttpProxy::handle, promise->future(), metadata(request));
 
     // TODO(benh): Use the sender PID in order to capture
     // happens-before timing relationships for testing.
@@ -2589,7 +3313,7 @@ void ProcessManager::handle(
 
   // Enqueue the response with the HttpProxy so that it respects the
   // order of requests to account for HTTP/1.1 pipelining.
-  dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
+  dispatch(proxy, &HttpProxy::enqueue, NotFound(), metadata(request));
 
   // Cleanup request.
   delete request;
@@ -2685,65 +3409,70 @@ void ProcessManager::resume(ProcessBase* process)
     process->state = ProcessBase::RUNNING;
     try { process->initialize(); }
     catch (...) { terminate = true; }
+
+    // NOTE: The pending count starts at one while the process is
+    // being initialized, so that events enqueued in the meantime do
+    // not put the process on a run queue a second time.
+    if (!terminate) {
+      process->state = ProcessBase::BLOCKED;
+      blocked = process->pending.fetch_sub(1) == 1;
+    }
   }
 
+  size_t spins = 0;
+
   while (!terminate && !blocked) {
-    Event* event = nullptr;
+    Event* event = process->events->dequeue();
 
-    synchronized (process->mutex) {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
-        process->state = ProcessBase::BLOCKED;
-        blocked = true;
-      }
+    // The pending count is non-zero so there must be an event, but
+    // the thread that is enqueueing it might not have linked it into
+    // the queue yet.
+    if (event == nullptr) {
+      backoff(&spins);
+      continue;
     }
 
-    if (!blocked) {
-      CHECK(event != nullptr);
+    spins = 0;
 
-      // Determine if we should filter this event.
-      synchronized (filterer_mutex) {
-        if (filterer != nullptr) {
-          bool filter = false;
-          struct FilterVisitor : EventVisitor
-          {
-            explicit FilterVisitor(bool* _filter) : filter(_filter) {}
-
-            virtual void visit(const MessageEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    process->state = ProcessBase::RUNNING;
 
-            virtual void visit(const DispatchEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    // Determine if we should filter this event.
+    bool filter = false;
 
-            virtual void visit(const HttpEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    synchronized (filterer_mutex) {
+      if (filterer != nullptr) {
+        struct FilterVisitor : EventVisitor
+        {
+          explicit FilterVisitor(bool* _filter) : filter(_filter) {}
 
-            virtual void visit(const ExitedEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+          virtual void visit(const MessageEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-            bool* filter;
-          } visitor(&filter);
+          virtual void visit(const DispatchEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-          event->visit(&visitor);
+          virtual void visit(const HttpEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-          if (filter) {
-            delete event;
-            continue; // Try and execute the next event.
+          virtual void visit(const ExitedEvent& event)
+          {
+            *filter = filterer->filter(event);
           }
-        }
+
+          bool* filter;
+        } visitor(&filter);
+
+        event->visit(&visitor);
       }
+    }
 
+    if (!filter) {
       // Determine if we should terminate.
       terminate = event->is<TerminateEvent>();
 
@@ -2760,12 +3489,19 @@ void ProcessManager::resume(ProcessBase* process)
                   << " terminating due to unknown exception" << std::endl;
         terminate = true;
       }
+    }
 
-      delete event;
+    delete event;
 
-      if (terminate) {
-        cleanup(process);
-      }
+    if (terminate) {
+      cleanup(process);
+    } else {
+      // NOTE: We must set the state before decrementing the pending
+      // count because once it drops to zero another thread may
+      // enqueue (and run) the process, or the process may even get
+      // terminated and deleted.
+      process->state = ProcessBase::BLOCKED;
+      blocked = process->pending.fetch_sub(1) == 1;
     }
   }
 
@@ -2780,30 +3516,19 @@ void ProcessManager::cleanup(ProcessBase* process)
 {
   VLOG(2) << "Cleaning up " << process->pid;
 
-  // First, set the terminating state so no more events will get
-  // enqueued and delete all the pending events. We want to delete the
-  // events before we hold the processes lock because deleting an
-  // event could cause code outside libprocess to get executed which
-  // might cause a deadlock with the processes lock. Likewise,
-  // deleting the events now rather than later has the nice property
-  // of making sure that any events that might have gotten enqueued on
-  // the process we are cleaning up will get dropped (since it's
-  // terminating) and eliminates the potential of enqueueing them on
-  // another process that gets spawned with the same PID.
-  deque<Event*> events;
-
-  synchronized (process->mutex) {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
-  }
-
-  // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
-    delete event;
-  }
+  // First, set the terminating state and decommission the event queue
+  // so no more events will get enqueued and all the pending events get
+  // deleted. We want to delete the events before we hold the processes
+  // lock because deleting an event could cause code outside libprocess
+  // to get executed which might cause a deadlock with the processes
+  // lock. Likewise, deleting the events now rather than later has the
+  // nice property of making sure that any events that might have
+  // gotten enqueued on the process we are cleaning up will get dropped
+  // (since it's terminating) and eliminates the potential of
+  // enqueueing them on another process that gets spawned with the
+  // same PID.
+  process->state = ProcessBase::TERMINATING;
+  process->events->decommission();
 
   // Remove help strings for all installed routes for this process.
   dispatch(help, &Help::remove, process->pid.id);
@@ -2814,29 +3539,24 @@ void ProcessManager::cleanup(ProcessBase* process)
   // Remove process.
   synchronized (processes_mutex) {
     // Wait for all process references to get cleaned up.
+    size_t spins = 0;
     while (process->refs.load() > 0) {
-#if defined(__i386__) || defined(__x86_64__)
-      asm ("pause");
-#endif
+      backoff(&spins);
     }
 
-    synchronized (process->mutex) {
-      CHECK(process->events.empty());
+    processes.erase(process->pid.id);
 
-      processes.erase(process->pid.id);
-
-      // Lookup gate to wake up waiting threads.
-      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
-      if (it != gates.end()) {
-        gate = it->second;
-        // N.B. The last thread that leaves the gate also free's it.
-        gates.erase(it);
-      }
-
-      CHECK(process->refs.load() == 0);
-      process->state = ProcessBase::TERMINATED;
+    // Lookup gate to wake up waiting threads.
+    map<ProcessBase*, Gate*>::iterator it = gates.find(process);
+    if (it != gates.end()) {
+      gate = it->second;
+      // N.B. The last thread that leaves the gate also free's it.
+      gates.erase(it);
     }
 
+    CHECK(process->refs.load() == 0);
+    process->state = ProcessBase::TERMINATED;
+
     // Note that we don't remove the process from the clock during
     // cleanup, but rather the clock is reset for a process when it is
     // created (see ProcessBase::ProcessBase). We do this so that
@@ -2952,22 +3672,32 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            running.fetch_add(1);
-          } else {
-            // Another thread has resumed the process ...
-            process = nullptr;
+        // NOTE: A runnable process is on the run queue it was last
+        // placed on, unless a thread has taken it since (or it is
+        // still being spawned and has not been placed on one yet).
+        const long index = process->runq.load();
+        RunQueue* runq = index >= 0 ? runqs[index].get() : nullptr;
+
+        if (runq == nullptr) {
+          process = nullptr;
+        } else {
+          synchronized (runq->mutex) {
+            deque<ProcessBase*>::iterator it =
+              find(runq->processes.begin(), runq->processes.end(), process);
+            if (it != runq->processes.end()) {
+              // Found it! Remove it from the run queue since we'll be
+              // donating our thread and also increment 'running' before
+              // leaving this 'runq' protected critical section so that
+              // everyone that is waiting for the processes to settle
+              // continue to wait (otherwise they could see nothing in
+              // 'runq' and 'running' equal to 0 between when we exit
+              // this critical section and increment 'running').
+              runq->processes.erase(it);
+              running.fetch_add(1);
+            } else {
+              // Another thread has resumed the process ...
+              process = nullptr;
+            }
           }
         }
       } else {
@@ -3055,44 +3785,101 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  CHECK(!runqs.empty());
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+  // Place the process on the run queue of the thread it last ran on,
+  // or spread the processes that have not run yet over all of them.
+  long worker = process->runq.load();
+  if (worker < 0) {
+    worker = next_runq.fetch_add(1) % runqs.size();
+    process->runq.store(worker);
   }
 
-  // Wake up the processing thread if necessary.
-  gate->open();
+  RunQueue* runq = runqs[worker].get();
+
+  synchronized (runq->mutex) {
+    CHECK(find(runq->processes.begin(), runq->processes.end(), process) ==
+          runq->processes.end());
+    runq->processes.push_back(process);
+  }
+
+  // Wake up a processing thread if necessary.
+  wakeup(worker);
 }
 
 
-ProcessBase* ProcessManager::dequeue()
+ProcessBase* ProcessManager::dequeue(size_t worker, bool wait)
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  // Look at our own run queue first, then steal from the others
+  // starting with the next one (so that threads that run out of
+  // processes do not all steal from the same run queue).
+  for (size_t i = 0; i < runqs.size(); i++) {
+    const size_t victim = (worker + i) % runqs.size();
 
-  ProcessBase* process = nullptr;
-
-  synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      running.fetch_add(1);
+    ProcessBase* process = dequeue(runqs[victim].get(), wait);
+    if (process != nullptr) {
+      // The process will now tend to resume on this thread.
+      process->runq.store(worker);
+      return process;
     }
   }
 
+  return nullptr;
+}
+
+
+ProcessBase* ProcessManager::dequeue(RunQueue* runq, bool wait)
+{
+  std::unique_lock<std::mutex> lock(runq->mutex, std::defer_lock);
+
+  if (wait) {
+    lock.lock();
+  } else if (!lock.try_lock()) {
+    return nullptr;
+  }
+
+  if (runq->processes.empty()) {
+    return nullptr;
+  }
+
+  ProcessBase* process = runq->processes.front();
+  runq->processes.pop_front();
+
+  // Increment the running count of processes in order to support
+  // the Clock::settle() operation (this must be done atomically
+  // with removing the process from the runq).
+  running.fetch_add(1);
+
   return process;
 }
 
 
+void ProcessManager::wakeup(size_t worker)
+{
+  // NOTE: A thread marks itself idle before it looks at the run
+  // queues one last time (while holding their locks) and waits at
+  // its gate. Since the process was placed on the run queue while
+  // holding its lock, either that thread will find the process, or
+  // we will see that the thread is idle here.
+  if (runqs[worker]->idle.load()) {
+    runqs[worker]->gate.open();
+    return;
+  }
+
+  // The thread is busy, so wake up an idle thread (if any) to steal
+  // the process rather than waiting for the busy thread to get to it.
+  if (idle.load() > 0) {
+    for (size_t i = 1; i < runqs.size(); i++) {
+      RunQueue* runq = runqs[(worker + i) % runqs.size()].get();
+      if (runq->idle.load()) {
+        runq->gate.open();
+        return;
+      }
+    }
+  }
+}
+
+
 void ProcessManager::settle()
 {
   bool done = true;
@@ -3113,22 +3900,32 @@ void ProcessManager::settle()
 
     done = true; // Assume to start that we are settled.
 
-    synchronized (runq_mutex) {
-      if (!runq.empty()) {
-        done = false;
-        continue;
-      }
+    // NOTE: We lock all of the run queues (always in the same order)
+    // so that no process can be enqueued or dequeued while we check.
+    vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(runqs.size());
 
-      if (running.load() > 0) {
-        done = false;
-        continue;
-      }
+    foreach (const Owned<RunQueue>& runq, runqs) {
+      locks.emplace_back(runq->mutex);
 
-      if (!Clock::settled()) {
+      if (!runq->processes.empty()) {
         done = false;
-        continue;
       }
     }
+
+    if (!done) {
+      continue;
+    }
+
+    if (running.load() > 0) {
+      done = false;
+      continue;
+    }
+
+    if (!Clock::settled()) {
+      done = false;
+      continue;
+    }
   } while (!done);
 }
 
@@ -3142,67 +3939,26 @@ Future<Response> ProcessManager::__processes__(const Request&)
       JSON::Object object;
       object.values["id"] = process->pid.id;
 
+      // NOTE: The events can not be walked while they are being
+      // served, so we only report the number of events of each type.
       JSON::Array events;
 
-      struct JSONVisitor : EventVisitor
-      {
-        explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
-
-        virtual void visit(const MessageEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "MESSAGE";
-
-          const Message& message = *event.message;
-
-          object.values["name"] = message.name;
-          object.values["from"] = string(message.from);
-          object.values["to"] = string(message.to);
-          object.values["body"] = message.body;
-
-          events->values.push_back(object);
-        }
-
-        virtual void visit(const HttpEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "HTTP";
-
-          const Request& request = *event.request;
-
-          object.values["method"] = request.method;
-          object.values["url"] = stringify(request.url);
-
-          events->values.push_back(object);
-        }
-
-        virtual void visit(const DispatchEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "DISPATCH";
-          events->values.push_back(object);
-        }
-
-        virtual void visit(const ExitedEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "EXITED";
-          events->values.push_back(object);
-        }
-
-        virtual void visit(const TerminateEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "TERMINATE";
-          events->values.push_back(object);
-        }
-
-        JSON::Array* events;
-      } visitor(&events);
-
-      synchronized (process->mutex) {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
+      const vector<pair<EventType, string>> types = {
+        {EventType::MESSAGE, "MESSAGE"},
+        {EventType::DISPATCH, "DISPATCH"},
+        {EventType::HTTP, "HTTP"},
+        {EventType::EXITED, "EXITED"},
+        {EventType::TERMINATE, "TERMINATE"}
+      };
+
+      foreach (const auto& type, types) {
+        const size_t count = process->eventCount(type.first);
+
+        if (count > 0) {
+          JSON::Object event;
+          event.values["type"] = type.second;
+          event.values["count"] = count;
+          events.values.push_back(event);
         }
       }
 
@@ -3221,8 +3977,16 @@ ProcessBase::ProcessBase(const string& id)
 
   state = ProcessBase::BOTTOM;
 
+  events.reset(new EventQueue());
+
+  pending = 1;
+
   refs = 0;
 
+  runq = -1;
+
+  cacheVersion = 0;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -3242,29 +4006,32 @@ void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != nullptr);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  if (events->isDecommissioned()) {
+    delete event;
+    return;
+  }
 
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  // NOTE: We increment the pending count before the event is on the
+  // queue so that the process can not block in the meantime (the
+  // thread running it will wait for the event instead).
+  if (pending.fetch_add(1) == 0) {
+    events->enqueue(event, inject);
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
-    }
+    CHECK(state == BLOCKED);
+    state = READY;
+    process_manager->enqueue(this);
+  } else {
+    events->enqueue(event, inject);
   }
 }
 
 
+size_t ProcessBase::eventCount(EventType type)
+{
+  return events->count(type);
+}
+
+
 void ProcessBase::inject(
     const UPID& from,
     const string& name,
@@ -3313,7 +4080,7 @@ void ProcessBase::visit(const MessageEvent& event)
 
 void ProcessBase::visit(const DispatchEvent& event)
 {
-  (*event.f)(this);
+  event.invoke(this);
 }
 
 
@@ -3368,7 +4135,9 @@ void ProcessBase::visit(const HttpEvent& event)
     authentication = handlers.httpSequence->add<Option<AuthenticationResult>>(
         [authentication]() { return authentication; });
 
-    Request request = *event.request;
+    // NOTE: The request is moved rather than copied into the callbacks
+    // below, as the event is not used anymore after this.
+    Owned<Request> request(new Request(std::move(*event.request)));
     Promise<Response>* response = new Promise<Response>();
     event.response->associate(response->future());
 
@@ -3382,7 +4151,7 @@ void ProcessBase::visit(const HttpEvent& event)
                 : ServiceUnavailable());
 
           VLOG(1) << "Returning '" << response->future()->status << "'"
-                  << " for '" << request.url.path << "'"
+                  << " for '" << request->url.path << "'"
                   << " (authentication failed: "
                   << (authentication.isFailed()
                       ? authentication.failure()
@@ -3422,7 +4191,7 @@ void ProcessBase::visit(const HttpEvent& event)
         if (authorization_callbacks != nullptr &&
             authorization_callbacks->count(callback_path) > 0) {
           authorization = authorization_callbacks->at(callback_path)(
-              request, principal);
+              *request, principal);
 
           // Sequence the authorization future to ensure the handlers
           // are invoked in the same order that requests arrive.
@@ -3435,7 +4204,7 @@ void ProcessBase::visit(const HttpEvent& event)
 
         // Install a callback on the authorization result.
         authorization
-          .onAny(defer(self(), [endpoint, request, response, principal](
+          .onAny(defer(self(), [this, endpoint, request, response, principal](
               const Future<bool>& authorization) {
             if (!authorization.isReady()) {
               response->set(
@@ -3444,7 +4213,7 @@ void ProcessBase::visit(const HttpEvent& event)
                     : ServiceUnavailable());
 
               VLOG(1) << "Returning '" << response->future()->status << "'"
-                      << " for '" << request.url.path << "'"
+                      << " for '" << request->url.path << "'"
                       << " (authorization failed: "
                       << (authorization.isFailed()
                           ? authorization.failure()
@@ -3456,12 +4225,7 @@ void ProcessBase::visit(const HttpEvent& event)
 
             if (authorization.get() == true) {
               // Authorization succeeded, so forward request to the handler.
-              if (endpoint.realm.isNone()) {
-                response->associate(endpoint.handler.get()(request));
-              } else {
-                response->associate(endpoint.authenticatedHandler.get()(
-                    request, principal));
-              }
+              response->associate(_visit(endpoint, request, principal));
             } else {
               // Authorization failed, so return a `Forbidden` response.
               response->set(Forbidden());
@@ -3571,6 +4335,221 @@ void ProcessBase::route(
 }
 
 
+// Maximum number of responses cached for an HTTP endpoint, i.e., the
+// number of distinct queries and principals served from the cache.
+static const size_t HTTP_CACHE_CAPACITY = 16;
+
+
+struct ProcessBase::HttpCache
+{
+  // A cached response, along with its gzip compressed representation
+  // once a client that accepts gzip requested it.
+  struct Entry
+  {
+    explicit Entry(const Response& _response) : response(_response) {}
+
+    const Response response;
+    Option<Response> compressed;
+  };
+
+  HttpCache(const string& prefix, bool _enabled)
+    : tag(UUID::random().toString()),
+      enabled(_enabled),
+      version(0),
+      responses(_enabled ? HTTP_CACHE_CAPACITY : 0),
+      hits(prefix + "/hits"),
+      misses(prefix + "/misses")
+  {
+    metrics::add(hits);
+    metrics::add(misses);
+  }
+
+  ~HttpCache()
+  {
+    metrics::remove(hits);
+    metrics::remove(misses);
+  }
+
+  // Identifies this instance of the cache in the tags, so that the
+  // tags handed out before a restart of the process never match.
+  const string tag;
+
+  // Whether the `BODY` responses are kept, rather than only tagged.
+  const bool enabled;
+
+  // NOTE: The responses are populated by the continuations of the
+  // handlers, which need not run within the process.
+  std::mutex mutex;
+
+  // The version of the process that all of `responses` belong to.
+  uint64_t version;
+
+  Cache<string, std::shared_ptr<Entry>> responses;
+
+  metrics::Counter hits;
+  metrics::Counter misses;
+};
+
+
+void ProcessBase::cache(const string& name, bool responses)
+{
+  // Routes must start with '/'.
+  CHECK(name.find('/') == 0);
+  CHECK(handlers.http.count(name.substr(1)) > 0)
+    << "Endpoint '" << name << "' is not routed";
+
+  handlers.http[name.substr(1)].cache.reset(
+      new HttpCache(pid.id + "/http_cache" + name, responses));
+}
+
+
+// Returns the key under which the response to the request is cached.
+static string cacheKey(const Request& request, const Option<string>& principal)
+{
+  // Sort the query so that equivalent requests share their key.
+  const map<string, string> query(
+      request.url.query.begin(),
+      request.url.query.end());
+
+  // NOTE: The components are separated by '\0', which can appear in
+  // none of them.
+  string key = request.url.path;
+  key += '\0';
+
+  foreachpair (const string& name, const string& value, query) {
+    key += name + "=" + value;
+    key += '\0';
+  }
+
+  if (principal.isSome()) {
+    key += principal.get();
+  }
+
+  return key;
+}
+
+
+Future<Response> ProcessBase::_visit(
+    const HttpEndpoint& endpoint,
+    const Owned<Request>& request,
+    const Option<string>& principal)
+{
+  // Responses are only cached for `GET` requests, as any other method
+  // might have side effects.
+  if (endpoint.cache.get() == nullptr || request->method != "GET") {
+    if (endpoint.realm.isNone()) {
+      return endpoint.handler.get()(*request);
+    }
+
+    return endpoint.authenticatedHandler.get()(*request, principal);
+  }
+
+  std::shared_ptr<HttpCache> cache = endpoint.cache;
+
+  const uint64_t version = cacheVersion;
+  const string key = cacheKey(*request, principal);
+  const string tag = "\"" + cache->tag + "-" + stringify(version) + "-" +
+    stringify(std::hash<string>()(key)) + "\"";
+
+  Option<string> ifNoneMatch = request->headers.get("If-None-Match");
+  if (ifNoneMatch.isSome()) {
+    foreach (string candidate, strings::tokenize(ifNoneMatch.get(), ",")) {
+      // Weak tags are fine, since we serve the same response for
+      // the same tag.
+      candidate = strings::remove(
+          strings::trim(candidate), "W/", strings::PREFIX);
+
+      if (candidate == tag) {
+        ++cache->hits;
+
+        Response response(http::Status::NOT_MODIFIED);
+        response.headers["ETag"] = tag;
+        return response;
+      }
+    }
+  }
+
+  std::shared_ptr<HttpCache::Entry> entry;
+
+  synchronized (cache->mutex) {
+    if (cache->enabled && cache->version == version) {
+      entry = cache->responses.get(key).getOrElse(nullptr);
+    }
+  }
+
+  if (entry) {
+    ++cache->hits;
+
+    if (!compressible(entry->response, *request)) {
+      return entry->response;
+    }
+
+    // Compress the response once for all the clients that accept
+    // gzip, rather than once per request in the encoder.
+    synchronized (cache->mutex) {
+      if (entry->compressed.isSome()) {
+        return entry->compressed.get();
+      }
+    }
+
+    Try<string> compressed =
+      gzip::compress(entry->response.body, http_compression.level);
+
+    if (compressed.isError()) {
+      LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
+      return entry->response;
+    }
+
+    Response response = entry->response;
+    response.body = compressed.get();
+    response.headers["Content-Length"] = stringify(response.body.length());
+    response.headers["Content-Encoding"] = "gzip";
+
+    synchronized (cache->mutex) {
+      entry->compressed = response;
+    }
+
+    return response;
+  }
+
+  ++cache->misses;
+
+  Future<Response> response = endpoint.realm.isNone()
+    ? endpoint.handler.get()(*request)
+    : endpoint.authenticatedHandler.get()(*request, principal);
+
+  // NOTE: The response is tagged with the version at the time of the
+  // request, which is conservative: the handler has observed (at
+  // least) this version, so the tag and the cached response become
+  // stale at the latest when the state they reflect does.
+  return response
+    .then([cache, version, key, tag](Response response) {
+      if (response.code != http::Status::OK) {
+        return response;
+      }
+
+      response.headers["ETag"] = tag;
+
+      if (cache->enabled && response.type == Response::BODY) {
+        synchronized (cache->mutex) {
+          if (version > cache->version) {
+            cache->version = version;
+            cache->responses.clear();
+          }
+
+          if (version == cache->version) {
+            cache->responses.put(
+                key,
+                std::make_shared<HttpCache::Entry>(response));
+          }
+        }
+      }
+
+      return response;
+    });
+}
+
+
 UPID spawn(ProcessBase* process, bool manage)
 {
   process::initialize();
@@ -3718,15 +4697,13 @@ bool exited(const UPID& from, const UPID& to)
 
 namespace internal {
 
-void dispatch(
-    const UPID& pid,
-    const std::shared_ptr<lambda::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType)
+void dispatch(DispatchEvent* event)
 {
   process::initialize();
 
-  DispatchEvent* event = new DispatchEvent(pid, f, functionType);
-  process_manager->deliver(pid, event, __process__);
+  // NOTE: Passing `event->pid` is safe because `deliver` does not use
+  // the pid anymore once it has enqueued (or deleted) the event.
+  process_manager->deliver(event->pid, event, __process__);
 }
 
 } // namespace internal {
@@ -18,39 +18,93 @@
 
 #include <gmock/gmock.h>
 
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <sys/resource.h>
+
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <string>
 #include <vector>
 
+#include <process/address.hpp>
 #include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/gzip.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "decoder.hpp"
+#include "encoder.hpp"
 
 namespace http = process::http;
 
+using process::DataDecoder;
 using process::Future;
+using process::Message;
+using process::MessageEncoder;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
 using process::UPID;
 
+using process::network::Address;
+using process::network::Socket;
+
 using std::cout;
+using std::deque;
 using std::endl;
 using std::list;
 using std::ostringstream;
 using std::string;
 using std::vector;
 
+// Number of allocations done through the global allocator, so that
+// benchmarks can report the number of allocations of an operation.
+static std::atomic<uint64_t> allocations(0);
+
+
+void* operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  void* pointer = malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return pointer;
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+  free(pointer);
+}
+
+
 int main(int argc, char** argv)
 {
   // Initialize Google Mock/Test.
@@ -374,3 +428,730 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// A process that bounces dispatches back and forth with a peer.
+class PingPongProcess : public Process<PingPongProcess>
+{
+public:
+  explicit PingPongProcess(Promise<Nothing>* _done) : done(_done) {}
+
+  void peer(const PID<PingPongProcess>& _other)
+  {
+    other = _other;
+  }
+
+  void ping(size_t remaining)
+  {
+    if (remaining == 0) {
+      done->set(Nothing());
+      return;
+    }
+
+    dispatch(other, &PingPongProcess::ping, remaining - 1);
+  }
+
+private:
+  Promise<Nothing>* done;
+  PID<PingPongProcess> other;
+};
+
+
+// Measures the number of allocations and the latency of a dispatch
+// between two processes.
+TEST(ProcessTest, Process_BENCHMARK_DispatchAllocations)
+{
+  const size_t messages = 100000;
+
+  Promise<Nothing> done;
+
+  PingPongProcess ping(&done);
+  PingPongProcess pong(&done);
+
+  spawn(ping);
+  spawn(pong);
+
+  ping.peer(pong.self());
+  pong.peer(ping.self());
+
+  // Warm up, e.g., so that the event pools of the worker threads
+  // are populated.
+  {
+    Promise<Nothing> warmup;
+    PingPongProcess first(&warmup);
+    PingPongProcess second(&warmup);
+
+    spawn(first);
+    spawn(second);
+
+    first.peer(second.self());
+    second.peer(first.self());
+
+    dispatch(first, &PingPongProcess::ping, messages);
+
+    AWAIT_READY(warmup.future());
+
+    terminate(first);
+    wait(first);
+    terminate(second);
+    wait(second);
+  }
+
+  const uint64_t before = allocations.load();
+
+  Stopwatch watch;
+  watch.start();
+
+  dispatch(ping, &PingPongProcess::ping, messages);
+
+  AWAIT_READY_FOR(done.future(), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+
+  const uint64_t after = allocations.load();
+
+  cout << messages << " dispatches took " << elapsed
+       << " (" << elapsed / messages << " per dispatch) with "
+       << static_cast<double>(after - before) / messages
+       << " allocations per dispatch" << endl;
+
+  terminate(ping);
+  wait(ping);
+  terminate(pong);
+  wait(pong);
+}
+
+
+// Measures the throughput of dispatches between pairs of processes
+// as the number of pairs (i.e., the parallelism) grows. Run this with
+// different values of LIBPROCESS_NUM_WORKER_THREADS to see how the
+// throughput scales with the number of worker threads.
+TEST(ProcessTest, Process_BENCHMARK_MessageThroughput)
+{
+  const size_t messages = 100000;
+
+  Option<string> workers = os::getenv("LIBPROCESS_NUM_WORKER_THREADS");
+  cout << "Using " << workers.getOrElse("the default number of")
+       << " worker threads" << endl;
+
+  for (size_t pairs = 1; pairs <= 64; pairs *= 2) {
+    vector<Owned<Promise<Nothing>>> promises;
+    vector<Owned<PingPongProcess>> processes;
+    list<Future<Nothing>> futures;
+
+    for (size_t i = 0; i < pairs; i++) {
+      promises.push_back(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      futures.push_back(promises.back()->future());
+
+      Owned<PingPongProcess> ping(new PingPongProcess(promises.back().get()));
+      Owned<PingPongProcess> pong(new PingPongProcess(promises.back().get()));
+
+      spawn(ping.get());
+      spawn(pong.get());
+
+      ping->peer(pong->self());
+      pong->peer(ping->self());
+
+      processes.push_back(ping);
+      processes.push_back(pong);
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < pairs; i++) {
+      dispatch(processes[2 * i]->self(), &PingPongProcess::ping, messages);
+    }
+
+    AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << pairs << " pairs of processes exchanged "
+         << messages * pairs << " messages in " << elapsed
+         << " (" << (messages * pairs) / elapsed.secs() << " messages / sec)"
+         << endl;
+
+    foreach (const Owned<PingPongProcess>& process, processes) {
+      terminate(process.get());
+      wait(process.get());
+    }
+  }
+}
+
+
+class SinkProcess : public Process<SinkProcess>
+{
+public:
+  explicit SinkProcess(size_t _expected) : expected(_expected), received(0) {}
+
+  void receive()
+  {
+    if (++received == expected) {
+      done.set(Nothing());
+    }
+  }
+
+  Promise<Nothing> done;
+
+private:
+  const size_t expected;
+  size_t received;
+};
+
+
+class SenderProcess : public Process<SenderProcess>
+{
+public:
+  explicit SenderProcess(const PID<SinkProcess>& _sink) : sink(_sink) {}
+
+  void send(size_t messages)
+  {
+    for (size_t i = 0; i < messages; i++) {
+      dispatch(sink, &SinkProcess::receive);
+    }
+  }
+
+private:
+  const PID<SinkProcess> sink;
+};
+
+
+// Measures the throughput of the event queue of a single process that
+// many processes are concurrently sending messages to.
+TEST(ProcessTest, Process_BENCHMARK_ManySendersOneReceiver)
+{
+  const size_t messages = 100000;
+
+  Option<string> workers = os::getenv("LIBPROCESS_NUM_WORKER_THREADS");
+  cout << "Using " << workers.getOrElse("the default number of")
+       << " worker threads" << endl;
+
+  for (size_t senders = 1; senders <= 16; senders *= 2) {
+    SinkProcess sink(messages * senders);
+    spawn(sink);
+
+    vector<Owned<SenderProcess>> processes;
+
+    for (size_t i = 0; i < senders; i++) {
+      Owned<SenderProcess> sender(new SenderProcess(sink.self()));
+      spawn(sender.get());
+      processes.push_back(sender);
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    foreach (const Owned<SenderProcess>& sender, processes) {
+      dispatch(sender->self(), &SenderProcess::send, messages);
+    }
+
+    AWAIT_READY_FOR(sink.done.future(), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << senders << " senders sent " << messages * senders
+         << " messages to one receiver in " << elapsed
+         << " (" << (messages * senders) / elapsed.secs()
+         << " messages / sec)" << endl;
+
+    foreach (const Owned<SenderProcess>& sender, processes) {
+      terminate(sender.get());
+      wait(sender.get());
+    }
+
+    terminate(sink);
+    wait(sink);
+  }
+}
+
+
+class MessageSenderProcess : public Process<MessageSenderProcess>
+{
+public:
+  explicit MessageSenderProcess(const UPID& _to) : to(_to) {}
+
+  void run(size_t messages, const string& body)
+  {
+    for (size_t i = 0; i < messages; i++) {
+      send(to, "message", body.data(), body.size());
+    }
+  }
+
+protected:
+  virtual void initialize()
+  {
+    // Link so that the messages are sent on a persistent socket.
+    link(to);
+  }
+
+private:
+  const UPID to;
+};
+
+
+// Measures the throughput of sending messages to a remote process,
+// i.e., of the outbound path of the socket manager. The "remote"
+// process is a plain socket that reads and drops all the data.
+TEST(ProcessTest, Process_BENCHMARK_RemoteMessageThroughput)
+{
+  const size_t messages = 100000;
+
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket server = create.get();
+
+  Try<Address> address = server.bind();
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.listen(1));
+
+  Future<Socket> accept = server.accept();
+
+  const UPID receiver("receiver", address.get());
+
+  foreach (size_t size, vector<size_t>({0, 100, 1000})) {
+    const string body(size, 'x');
+
+    MessageSenderProcess sender(receiver);
+    spawn(sender);
+
+    // Determine the number of bytes that the messages get encoded to.
+    Message message;
+    message.name = "message";
+    message.from = sender.self();
+    message.to = receiver;
+    message.body = body;
+
+    const size_t bytes = messages * MessageEncoder::encode(&message).size();
+
+    Stopwatch watch;
+    watch.start();
+
+    dispatch(sender, &MessageSenderProcess::run, messages, body);
+
+    AWAIT_READY(accept);
+    Socket socket = accept.get();
+
+    size_t received = 0;
+    while (received < bytes) {
+      Future<string> data = socket.recv();
+      AWAIT_READY(data);
+      ASSERT_FALSE(data->empty());
+      received += data->size();
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Sent " << messages << " messages with " << size
+         << " byte bodies in " << elapsed << " ("
+         << messages / elapsed.secs() << " messages / sec)" << endl;
+
+    terminate(sender);
+    wait(sender);
+  }
+}
+
+
+
+class PeersSenderProcess : public Process<PeersSenderProcess>
+{
+public:
+  explicit PeersSenderProcess(const vector<UPID>& _peers) : peers(_peers) {}
+
+  // Links to the peers in [first, last).
+  void connect(size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; i++) {
+      link(peers[i]);
+    }
+  }
+
+  void run(size_t messages)
+  {
+    for (size_t i = 0; i < messages; i++) {
+      foreach (const UPID& peer, peers) {
+        send(peer, "message");
+      }
+    }
+  }
+
+private:
+  const vector<UPID> peers;
+};
+
+
+// The number of bytes received across sockets, see `receive()`.
+struct ReceivedBytes
+{
+  explicit ReceivedBytes(size_t _expected)
+    : expected(_expected), received(0) {}
+
+  const size_t expected;
+  std::atomic<size_t> received;
+
+  // Completed once the expected number of bytes have been received.
+  Promise<Nothing> done;
+};
+
+
+// Reads and drops all the data on the socket until it gets shut down.
+static void receive(
+    Socket socket,
+    const std::shared_ptr<string>& buffer,
+    const std::shared_ptr<ReceivedBytes>& bytes)
+{
+  socket.recv(&buffer->at(0), buffer->size())
+    .onAny([=](const Future<size_t>& length) {
+      if (!length.isReady() || length.get() == 0) {
+        return;
+      }
+
+      const size_t received = bytes->received.fetch_add(length.get());
+
+      if (received + length.get() >= bytes->expected) {
+        bytes->done.set(Nothing());
+      }
+
+      receive(socket, buffer, bytes);
+    });
+}
+
+
+// Returns the socket manager metrics.
+static hashmap<string, double> socketManagerMetrics()
+{
+  Future<http::Response> response =
+    http::get(UPID("metrics", process::address()), "snapshot");
+
+  response.await();
+  CHECK_READY(response);
+
+  Try<JSON::Object> snapshot = JSON::parse<JSON::Object>(response->body);
+  CHECK_SOME(snapshot);
+
+  hashmap<string, double> metrics;
+
+  foreachpair (const string& key, const JSON::Value& value,
+               snapshot->values) {
+    if (strings::startsWith(key, "socket_manager/")) {
+      metrics[key] = value.as<JSON::Number>().as<double>();
+    }
+  }
+
+  return metrics;
+}
+
+
+// Measures sending messages from a few processes to many remote peers
+// (e.g., a master sending to its agents), which contends on the state
+// of the socket manager. The peers are simulated by a single listening
+// socket that is reached through many loopback addresses.
+TEST(ProcessTest, Process_BENCHMARK_ManyPeers)
+{
+  const size_t senders = 4;
+  const size_t messages = 5;
+
+  // Each peer uses two file descriptors (one for either end of the
+  // connection), so we simulate fewer peers if we are short of them.
+  struct rlimit limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+
+  const size_t peers = std::min<size_t>(
+      10000,
+      limit.rlim_cur > 1024 ? (limit.rlim_cur - 1024) / 2 : 0);
+
+  ASSERT_LT(0u, peers);
+
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket server = create.get();
+
+  Try<Address> address = server.bind(Address(net::IP(INADDR_ANY), 0));
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.listen(static_cast<int>(peers)));
+
+  vector<UPID> remotes;
+  for (size_t i = 0; i < peers; i++) {
+    // Addresses 127.0.0.1 through 127.0.39.16.
+    const net::IP ip(INADDR_LOOPBACK + static_cast<uint32_t>(i));
+    remotes.push_back(UPID("peer", Address(ip, address->port)));
+  }
+
+  vector<Owned<PeersSenderProcess>> processes;
+  size_t bytes = 0;
+
+  for (size_t i = 0; i < senders; i++) {
+    Owned<PeersSenderProcess> process(new PeersSenderProcess(remotes));
+    spawn(process.get());
+    processes.push_back(process);
+
+    foreach (const UPID& remote, remotes) {
+      Message message;
+      message.name = "message";
+      message.from = process->self();
+      message.to = remote;
+
+      bytes += messages * MessageEncoder::encode(&message).size();
+    }
+  }
+
+  std::shared_ptr<ReceivedBytes> received(new ReceivedBytes(bytes));
+
+  // Link to the peers in chunks that fit in the backlog of the
+  // listening socket, as connections that overflow it get dropped.
+  const size_t chunk = 1000;
+
+  vector<Socket> sockets;
+  for (size_t first = 0; first < peers; first += chunk) {
+    const size_t last = std::min(first + chunk, peers);
+
+    foreach (const Owned<PeersSenderProcess>& process, processes) {
+      dispatch(process.get(), &PeersSenderProcess::connect, first, last);
+    }
+
+    for (size_t i = first; i < last; i++) {
+      Future<Socket> accept = server.accept();
+      AWAIT_READY(accept);
+      sockets.push_back(accept.get());
+
+      receive(accept.get(), std::make_shared<string>(4096, '\0'), received);
+    }
+  }
+
+  const hashmap<string, double> before = socketManagerMetrics();
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const Owned<PeersSenderProcess>& process, processes) {
+    dispatch(process.get(), &PeersSenderProcess::run, messages);
+  }
+
+  AWAIT_READY_FOR(received->done.future(), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+
+  const hashmap<string, double> after = socketManagerMetrics();
+
+  const size_t total = senders * messages * peers;
+
+  cout << "Sent " << total << " messages from " << senders
+       << " processes to " << peers << " peers in " << elapsed << " ("
+       << total / elapsed.secs() << " messages / sec)" << endl;
+
+  foreachpair (const string& key, double value, after) {
+    cout << "  " << key << ": "
+         << value - before.get(key).getOrElse(0) << endl;
+  }
+
+  foreach (const Owned<PeersSenderProcess>& process, processes) {
+    terminate(process.get());
+    wait(process.get());
+  }
+
+  // Shutting down the peers also closes the links.
+  foreach (Socket& socket, sockets) {
+    socket.shutdown();
+  }
+}
+
+
+// Measures decoding pipelined HTTP requests with bodies of various
+// sizes (e.g., scheduler calls), which are passed to the decoder in
+// pieces of the size that gets read from a socket.
+TEST(DecoderTest, DataDecoder_BENCHMARK_PipelinedRequests)
+{
+  // The size of the reads, see `internal::on_accept()`.
+  const size_t chunk = 80 * 1024;
+
+  // The number of bytes of requests to decode for each body size.
+  const size_t total = 64 * 1024 * 1024;
+
+  const vector<size_t> sizes = {0, 1024, 100 * 1024, 10 * 1024 * 1024};
+
+  foreach (size_t size, sizes) {
+    ostringstream out;
+    out << "POST /master/api/v1/scheduler HTTP/1.1\r\n"
+        << "Host: localhost:5050\r\n"
+        << "Accept: application/json\r\n"
+        << "Content-Type: application/json\r\n"
+        << "Content-Length: " << size << "\r\n"
+        << "\r\n"
+        << string(size, 'x');
+
+    const string request = out.str();
+    const size_t requests = std::max<size_t>(1, total / request.size());
+
+    string data;
+    data.reserve(requests * request.size());
+
+    for (size_t i = 0; i < requests; i++) {
+      data += request;
+    }
+
+    Try<Socket> socket = Socket::create();
+    ASSERT_SOME(socket);
+
+    DataDecoder decoder(socket.get());
+
+    size_t decoded = 0;
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+      deque<http::Request*> result = decoder.decode(
+          data.data() + offset,
+          std::min(chunk, data.size() - offset));
+
+      ASSERT_FALSE(decoder.failed());
+
+      foreach (http::Request* request, result) {
+        delete request;
+      }
+
+      decoded += result.size();
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    EXPECT_EQ(requests, decoded);
+
+    cout << "Decoded " << requests << " requests with " << size
+         << " byte bodies in " << elapsed << " ("
+         << requests / elapsed.secs() << " requests / sec, "
+         << data.size() / elapsed.secs() / 1024 / 1024 << " MB / sec)"
+         << endl;
+  }
+}
+
+
+// Measures compressing a large JSON response (e.g., the master's
+// state) in one shot, as done for `BODY` responses, against
+// compressing it chunk by chunk, as done for streamed responses. The
+// memory reported is the output that has to be held at once, on top
+// of the response body itself.
+TEST(EncoderTest, HttpResponseEncoder_BENCHMARK_Compression)
+{
+  // The size of the chunks of a streamed response, as written by the
+  // master's read-only endpoints.
+  const size_t chunk = 64 * 1024;
+
+  string json = "{\"tasks\":[";
+  for (size_t i = 0; json.size() < 100 * 1024 * 1024; i++) {
+    json += "{\"id\":\"task-" + stringify(i) + "\","
+            "\"framework_id\":\"" + stringify(i % 97) + "\","
+            "\"state\":\"TASK_RUNNING\","
+            "\"resources\":{\"cpus\":" + stringify(i % 8) + ","
+            "\"mem\":" + stringify(i % 4096) + "}},";
+  }
+  json.back() = ']';
+  json += "}";
+
+  http::Request request;
+  request.headers["Accept-Encoding"] = "gzip";
+
+  const vector<int> levels = {Z_BEST_SPEED, Z_DEFAULT_COMPRESSION};
+
+  foreach (int level, levels) {
+    process::http_compression.level = level;
+
+    // One shot.
+    http::OK response(json);
+
+    Stopwatch watch;
+    watch.start();
+
+    const string encoded = process::HttpResponseEncoder::encode(
+        response,
+        request);
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Compressed " << json.size() << " bytes at level " << level
+         << " in one shot in " << elapsed << " ("
+         << json.size() / elapsed.secs() / 1024 / 1024 << " MB / sec), "
+         << "holding " << encoded.size() << " bytes of output" << endl;
+
+    // Streamed.
+    gzip::Compressor compressor(level);
+
+    size_t compressed = 0;
+    size_t held = 0;
+
+    watch.start();
+
+    for (size_t offset = 0; offset < json.size(); offset += chunk) {
+      Try<string> output =
+        compressor.compress(json.substr(offset, chunk), true);
+      ASSERT_SOME(output);
+
+      compressed += output->size();
+      held = std::max(held, output->size());
+    }
+
+    Try<string> output = compressor.finish();
+    ASSERT_SOME(output);
+
+    compressed += output->size();
+
+    elapsed = watch.elapsed();
+
+    cout << "Compressed " << json.size() << " bytes at level " << level
+         << " in " << chunk << " byte chunks in " << elapsed << " ("
+         << json.size() / elapsed.secs() / 1024 / 1024 << " MB / sec, "
+         << compressed << " bytes), holding at most " << held
+         << " bytes of output" << endl;
+  }
+
+  process::http_compression = process::HttpCompression();
+}
+
+
+// Measures snapshotting the metrics with many timers (e.g., one for
+// each of many frameworks or agents), each holding a full window of
+// values from which the percentiles are computed.
+TEST(MetricsTest, Metrics_BENCHMARK_SnapshotTimers)
+{
+  const size_t timers = 5000;
+  const size_t samples = 200;
+
+  vector<process::metrics::Timer<Milliseconds>> metrics;
+  metrics.reserve(timers);
+
+  for (size_t i = 0; i < timers; i++) {
+    process::metrics::Timer<Milliseconds> timer(
+        "benchmark/timer" + stringify(i), Hours(1));
+
+    for (size_t j = 0; j < samples; j++) {
+      timer.start();
+      timer.stop();
+    }
+
+    AWAIT_READY(process::metrics::add(timer));
+    metrics.push_back(timer);
+  }
+
+  const size_t snapshots = 10;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < snapshots; i++) {
+    Future<hashmap<string, double>> snapshot =
+      process::metrics::snapshot(None());
+
+    AWAIT_READY_FOR(snapshot, Minutes(1));
+  }
+
+  Duration elapsed = watch.elapsed();
+
+  cout << "Took " << elapsed / snapshots << " on average to snapshot "
+       << timers << " timers with " << samples << " values each" << endl;
+
+  foreach (const process::metrics::Timer<Milliseconds>& timer, metrics) {
+    AWAIT_READY(process::metrics::remove(timer));
+  }
+}
@@ -26,9 +26,13 @@
 
 namespace http = process::http;
 
+using process::GZIP_MINIMUM_BODY_LENGTH;
+using process::HttpCompression;
 using process::HttpResponseEncoder;
 using process::ResponseDecoder;
 
+using process::http_compression;
+
 using std::deque;
 using std::string;
 using std::vector;
@@ -67,6 +71,61 @@ TEST(EncoderTest, Response)
 }
 
 
+TEST(EncoderTest, CompressedResponse)
+{
+  http::Request request;
+  request.headers["Accept-Encoding"] = "gzip";
+
+  const string body(GZIP_MINIMUM_BODY_LENGTH, 'x');
+
+  // Responses that are long enough are compressed.
+  string encoded = HttpResponseEncoder::encode(http::OK(body), request);
+
+  ResponseDecoder decoder;
+  deque<http::Response*> responses =
+    decoder.decode(encoded.data(), encoded.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, responses.size());
+
+  EXPECT_SOME_EQ("gzip", responses[0]->headers.get("Content-Encoding"));
+  EXPECT_EQ(body, responses[0]->body);
+
+  delete responses[0];
+
+  // Shorter responses are not.
+  encoded = HttpResponseEncoder::encode(http::OK(body.substr(1)), request);
+
+  responses = decoder.decode(encoded.data(), encoded.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, responses.size());
+
+  EXPECT_NONE(responses[0]->headers.get("Content-Encoding"));
+  EXPECT_EQ(body.substr(1), responses[0]->body);
+
+  delete responses[0];
+
+  // Compression can be disabled.
+  const HttpCompression compression = http_compression;
+  http_compression.level = Z_NO_COMPRESSION;
+
+  encoded = HttpResponseEncoder::encode(http::OK(body), request);
+
+  http_compression = compression;
+
+  responses = decoder.decode(encoded.data(), encoded.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, responses.size());
+
+  EXPECT_NONE(responses[0]->headers.get("Content-Encoding"));
+  EXPECT_EQ(body, responses[0]->body);
+
+  delete responses[0];
+}
+
+
 TEST(EncoderTest, AcceptableEncodings)
 {
   // Create requests that do not accept gzip encoding.
@@ -22,6 +22,7 @@
 
 #include <process/address.hpp>
 #include <process/authenticator.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -50,6 +51,7 @@ using authentication::AuthenticationResult;
 using authentication::BasicAuthenticator;
 
 using process::Future;
+using process::dispatch;
 using process::Owned;
 using process::PID;
 using process::Process;
@@ -411,6 +413,72 @@ TEST(HTTPTest, PipeReaderCloses)
 }
 
 
+TEST(HTTPTest, PipePending)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  EXPECT_EQ(0u, writer.pending());
+
+  // Writes are pending until they are read.
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world!"));
+  EXPECT_EQ(11u, writer.pending());
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_EQ(6u, writer.pending());
+
+  AWAIT_EQ("world!", reader.read());
+  EXPECT_EQ(0u, writer.pending());
+
+  // Writes that satisfy an outstanding read are never pending.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("hello"));
+  AWAIT_EQ("hello", read);
+  EXPECT_EQ(0u, writer.pending());
+
+  // Closing the read end discards the pending writes.
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_EQ(5u, writer.pending());
+  EXPECT_TRUE(reader.close());
+  EXPECT_EQ(0u, writer.pending());
+}
+
+
+TEST(HTTPTest, PipeDrained)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // Nothing has been written yet.
+  AWAIT_READY(writer.drained());
+
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world!"));
+
+  Future<Nothing> drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  // The pipe is only drained once all of the writes are read.
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("world!", reader.read());
+  AWAIT_READY(drained);
+
+  // Closing the read end drains the pipe as well.
+  EXPECT_TRUE(writer.write("hello"));
+
+  drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  EXPECT_TRUE(reader.close());
+  AWAIT_READY(drained);
+}
+
+
 TEST(HTTPTest, Encode)
 {
   string unencoded = "a$&+,/:;=?@ \"<>#%{}|\\^~[]`\x19\x80\xFF";
@@ -602,6 +670,79 @@ TEST(HTTPTest, StreamingGetComplete)
 }
 
 
+// Tests that streamed responses that opt in are gzip compressed chunk
+// by chunk for the clients that accept it.
+TEST(HTTPTest, StreamingGetCompressed)
+{
+  Http http;
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+  ok.compressible = true;
+
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(Return(ok));
+
+  http::Headers headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<http::Response> response =
+    http::get(http.process->self(), "pipe", None(), headers);
+
+  http::Pipe::Writer writer = pipe.writer();
+
+  string body;
+  for (int i = 0; i < 1000; i++) {
+    const string chunk = "{\"chunk\":" + stringify(i) + "}";
+    body += chunk;
+    EXPECT_TRUE(writer.write(chunk));
+  }
+
+  EXPECT_TRUE(writer.close());
+
+  // The response is decompressed by the client.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(body, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("gzip", "Content-Encoding", response);
+}
+
+
+// Tests that streamed responses are not compressed unless they opt
+// in, even for the clients that accept it.
+TEST(HTTPTest, StreamingGetUncompressed)
+{
+  Http http;
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+  ok.headers["Content-Type"] = "application/recordio";
+
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(Return(ok));
+
+  http::Headers headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<http::Response> response =
+    http::get(http.process->self(), "pipe", None(), headers);
+
+  http::Pipe::Writer writer = pipe.writer();
+
+  const string body(4096, 'x');
+  EXPECT_TRUE(writer.write(body));
+  EXPECT_TRUE(writer.close());
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(body, response);
+
+  EXPECT_FALSE(response->headers.contains("Content-Encoding"));
+}
+
+
 TEST(HTTPTest, StreamingGetFailure)
 {
   Http http;
@@ -1237,6 +1378,131 @@ TEST(HTTPTest, Accepts)
 }
 
 
+class CachedHttpProcess : public Process<CachedHttpProcess>
+{
+public:
+  CachedHttpProcess() {}
+
+  MOCK_METHOD1(body, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(tagged, Future<http::Response>(const http::Request&));
+
+  void invalidate() { invalidateCache(); }
+
+protected:
+  virtual void initialize()
+  {
+    route("/body", None(), &CachedHttpProcess::body);
+    cache("/body");
+
+    route("/tagged", None(), &CachedHttpProcess::tagged);
+    cache("/tagged", false);
+  }
+};
+
+
+// Tests that the responses of a cached endpoint are served from the
+// cache until it is invalidated, and that conditional requests are
+// answered with '304 Not Modified'.
+TEST(HTTPTest, CachedEndpoint)
+{
+  CachedHttpProcess process;
+  PID<CachedHttpProcess> pid = spawn(process);
+
+  EXPECT_CALL(process, body(_))
+    .WillOnce(Return(http::OK("1")))
+    .WillOnce(Return(http::OK("2")))
+    .WillOnce(Return(http::OK("3")))
+    .WillOnce(Return(http::OK("4")));
+
+  Future<http::Response> response = http::get(pid, "body");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", response);
+  ASSERT_TRUE(response->headers.contains("ETag"));
+
+  const string etag = response->headers.at("ETag");
+
+  // The second request is served from the cache.
+  response = http::get(pid, "body");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(etag, "ETag", response);
+
+  // A conditional request for the same version is not modified.
+  http::Headers headers;
+  headers["If-None-Match"] = "\"foo\", W/" + etag;
+
+  response = http::get(pid, "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::Status::string(http::Status::NOT_MODIFIED), response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(etag, "ETag", response);
+
+  // Requests with a different query are cached separately.
+  response = http::get(pid, "body", "foo=bar");
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", response);
+
+  // Requests other than GET bypass the cache.
+  response = http::post(pid, "body", None(), "", "text/plain");
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("3", response);
+
+  // Once invalidated, a conditional request for the previous version
+  // is served a new response.
+  dispatch(pid, &CachedHttpProcess::invalidate);
+
+  response = http::get(pid, "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("4", response);
+  ASSERT_TRUE(response->headers.contains("ETag"));
+  EXPECT_NE(etag, response->headers.at("ETag"));
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that the responses of an endpoint that is only tagged are not
+// served from the cache, while conditional requests are still
+// answered with '304 Not Modified'.
+TEST(HTTPTest, TaggedEndpoint)
+{
+  CachedHttpProcess process;
+  PID<CachedHttpProcess> pid = spawn(process);
+
+  EXPECT_CALL(process, tagged(_))
+    .WillOnce(Return(http::OK("1")))
+    .WillOnce(Return(http::OK("2")));
+
+  Future<http::Response> response = http::get(pid, "tagged");
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", response);
+  ASSERT_TRUE(response->headers.contains("ETag"));
+
+  const string etag = response->headers.at("ETag");
+
+  // The second request invokes the handler again, but the response
+  // has the same tag since the version didn't change.
+  response = http::get(pid, "tagged");
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(etag, "ETag", response);
+
+  http::Headers headers;
+  headers["If-None-Match"] = etag;
+
+  response = http::get(pid, "tagged", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::NOT_MODIFIED), response);
+
+  terminate(process);
+  wait(process);
+}
+
+
 // TODO(evelinad): Add URLTest for IPv6.
 TEST(URLTest, Stringification)
 {
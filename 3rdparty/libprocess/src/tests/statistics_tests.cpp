@@ -12,17 +12,24 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <vector>
+
 #include <process/clock.hpp>
+#include <process/histogram.hpp>
 #include <process/statistics.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 
 using process::Clock;
+using process::Histogram;
 using process::Statistics;
 using process::Time;
 using process::TimeSeries;
 
+using std::vector;
+
 TEST(StatisticsTest, Empty)
 {
   TimeSeries<double> timeseries;
@@ -69,3 +76,204 @@ TEST(StatisticsTest, Statistics)
   EXPECT_FLOAT_EQ(4.99, statistics.get().p999);
   EXPECT_FLOAT_EQ(4.999, statistics.get().p9999);
 }
+
+
+// Tests that the statistics only reflect the values that remain in
+// the time series after truncation and sparsification.
+TEST(StatisticsTest, Truncate)
+{
+  Clock::pause();
+
+  // Keep at most 3 values within a window of 10 seconds.
+  TimeSeries<double> timeseries(Seconds(10), 3);
+
+  timeseries.set(100.0);
+  timeseries.set(200.0, Clock::now() + Seconds(1));
+  timeseries.set(300.0, Clock::now() + Seconds(2));
+
+  // Sparsification removes the second value.
+  timeseries.set(400.0, Clock::now() + Seconds(3));
+
+  Option<Statistics<double>> statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(3u, statistics->count);
+  EXPECT_FLOAT_EQ(100.0, statistics->min);
+  EXPECT_FLOAT_EQ(300.0, statistics->p50);
+  EXPECT_FLOAT_EQ(400.0, statistics->max);
+
+  // Overwriting a value replaces it in the statistics.
+  timeseries.set(50.0, Clock::now() + Seconds(3));
+
+  statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(3u, statistics->count);
+  EXPECT_FLOAT_EQ(300.0, statistics->max);
+  EXPECT_FLOAT_EQ(100.0, statistics->p50);
+
+  // Truncation removes all but the last two values.
+  Clock::advance(Seconds(11));
+  timeseries.truncate();
+
+  statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(2u, statistics->count);
+  EXPECT_FLOAT_EQ(50.0, statistics->min);
+  EXPECT_FLOAT_EQ(300.0, statistics->max);
+
+  Clock::resume();
+}
+
+
+// Tests that the percentiles of a large distribution are within the
+// relative error of the histogram.
+TEST(StatisticsTest, Approximation)
+{
+  TimeSeries<double> timeseries(Duration::max(), 100000);
+
+  Time now = Clock::now();
+
+  for (int i = 1; i <= 100000; ++i) {
+    now += Milliseconds(1);
+    timeseries.set(i, now);
+  }
+
+  Option<Statistics<double>> statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(100000u, statistics->count);
+
+  EXPECT_NEAR(1.0, statistics->min, 0.01);
+  EXPECT_NEAR(100000.0, statistics->max, 1000.0);
+  EXPECT_NEAR(50000.5, statistics->p50, 500.0);
+  EXPECT_NEAR(90000.1, statistics->p90, 900.0);
+  EXPECT_NEAR(99000.01, statistics->p99, 990.0);
+  EXPECT_NEAR(99990.0001, statistics->p9999, 1000.0);
+}
+
+
+// Tests that the minimum and maximum are exact, even when they share
+// a bucket of the histogram with other values, and that they are
+// kept up to date as values leave the time series.
+TEST(StatisticsTest, Extremes)
+{
+  Clock::pause();
+
+  TimeSeries<double> timeseries(Seconds(10), 10);
+
+  timeseries.set(1000.0);
+  timeseries.set(1000.5, Clock::now() + Seconds(1));
+  timeseries.set(1001.0, Clock::now() + Seconds(2));
+  timeseries.set(1001.5, Clock::now() + Seconds(3));
+
+  Option<Statistics<double>> statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(4u, statistics->count);
+  EXPECT_EQ(1000.0, statistics->min);
+  EXPECT_EQ(1001.5, statistics->max);
+
+  // Overwriting the maximum recomputes it from the remaining values.
+  timeseries.set(999.5, Clock::now() + Seconds(3));
+
+  statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(999.5, statistics->min);
+  EXPECT_EQ(1001.0, statistics->max);
+
+  // Truncation removes the first three values, including the
+  // maximum.
+  Clock::advance(Seconds(12));
+  timeseries.set(1000.25);
+
+  statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(2u, statistics->count);
+  EXPECT_EQ(999.5, statistics->min);
+  EXPECT_EQ(1000.25, statistics->max);
+
+  Clock::resume();
+}
+
+
+// Tests that values which are not finite are left out of the
+// statistics.
+TEST(StatisticsTest, NonFinite)
+{
+  TimeSeries<double> timeseries;
+
+  Time now = Clock::now();
+
+  timeseries.set(1.0, now + Seconds(1));
+  timeseries.set(INFINITY, now + Seconds(2));
+  timeseries.set(-INFINITY, now + Seconds(3));
+  timeseries.set(NAN, now + Seconds(4));
+
+  EXPECT_NONE(Statistics<double>::from(timeseries));
+
+  timeseries.set(2.0, now + Seconds(5));
+
+  Option<Statistics<double>> statistics = Statistics<double>::from(timeseries);
+
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(2u, statistics->count);
+  EXPECT_EQ(1.0, statistics->min);
+  EXPECT_EQ(2.0, statistics->max);
+}
+
+
+TEST(HistogramTest, NonFinite)
+{
+  Histogram histogram;
+
+  histogram.add(INFINITY);
+  histogram.add(-INFINITY);
+  histogram.add(NAN);
+
+  EXPECT_TRUE(histogram.empty());
+
+  histogram.add(1.0);
+  histogram.remove(INFINITY);
+
+  EXPECT_EQ(1u, histogram.count());
+}
+
+
+TEST(HistogramTest, Merge)
+{
+  Histogram histogram1;
+  Histogram histogram2;
+
+  for (int i = 0; i < 50; ++i) {
+    histogram1.add(i);
+    histogram2.add(i + 50);
+  }
+
+  histogram1.merge(histogram2);
+
+  EXPECT_EQ(100u, histogram1.count());
+
+  vector<double> percentiles = histogram1.percentiles({0.0, 0.5, 1.0});
+
+  ASSERT_EQ(3u, percentiles.size());
+  EXPECT_FLOAT_EQ(0.0, percentiles[0]);
+  EXPECT_NEAR(49.5, percentiles[1], 0.5);
+  EXPECT_FLOAT_EQ(99.0, percentiles[2]);
+
+  // Removing the merged values restores the original percentiles.
+  for (int i = 50; i < 100; ++i) {
+    histogram1.remove(i);
+  }
+
+  EXPECT_EQ(50u, histogram1.count());
+
+  percentiles = histogram1.percentiles({0.0, 1.0});
+
+  ASSERT_EQ(2u, percentiles.size());
+  EXPECT_FLOAT_EQ(0.0, percentiles[0]);
+  EXPECT_FLOAT_EQ(49.0, percentiles[1]);
+}
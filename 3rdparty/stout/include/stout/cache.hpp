@@ -85,6 +85,12 @@ public:
 
   size_t size() const { return keys.size(); }
 
+  void clear()
+  {
+    values.clear();
+    keys.clear();
+  }
+
 private:
   // Not copyable, not assignable.
   Cache(const Cache&);
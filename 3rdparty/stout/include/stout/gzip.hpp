@@ -23,7 +23,7 @@
 
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression / decompression as well.
+// TODO(bmahler): Provide streaming decompression as well.
 namespace gzip {
 
 // We use a 16KB buffer with zlib compression / decompression.
@@ -144,6 +144,138 @@ inline Try<std::string> decompress(const std::string& compressed)
   return result;
 }
 
+
+// Incrementally gzip compresses a stream of data (e.g., the chunks of
+// a streamed HTTP response) without holding all of it in memory. The
+// output of all the calls to `compress()` followed by the output of
+// `finish()` forms a single gzip stream.
+class Compressor
+{
+public:
+  // The compression level must be within the range [-1, 9], see
+  // `compress()` above.
+  explicit Compressor(int _level = Z_DEFAULT_COMPRESSION)
+    : level(_level), initialized(false), finished(false) {}
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  ~Compressor()
+  {
+    if (initialized) {
+      deflateEnd(&stream);
+    }
+  }
+
+  // Returns the compressed output that is available after consuming
+  // the provided data. zlib may buffer some of the input unless
+  // `flush` is set, in which case all of the input so far can be
+  // decompressed from the output so far (at a small cost in size).
+  Try<std::string> compress(const std::string& decompressed, bool flush = false)
+  {
+    if (finished) {
+      return Error("Compression has already finished");
+    }
+
+    if (!initialized) {
+      // Verify the level is within range.
+      if (!(level == Z_DEFAULT_COMPRESSION ||
+          (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION))) {
+        return Error("Invalid compression level: " + stringify(level));
+      }
+
+      stream.next_in = Z_NULL;
+      stream.avail_in = 0;
+      stream.zalloc = Z_NULL;
+      stream.zfree = Z_NULL;
+      stream.opaque = Z_NULL;
+
+      int code = deflateInit2(
+          &stream,
+          level,          // Compression level.
+          Z_DEFLATED,     // Compression method.
+          MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+          8,              // Default memLevel value.
+          Z_DEFAULT_STRATEGY);
+
+      if (code != Z_OK) {
+        return Error("Failed to initialize zlib: " + std::string(stream.msg));
+      }
+
+      initialized = true;
+    }
+
+    return deflate_(decompressed, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+  }
+
+  // Returns the remainder of the compressed output, including the
+  // gzip trailer. No more data can be compressed afterwards.
+  Try<std::string> finish()
+  {
+    if (finished) {
+      return Error("Compression has already finished");
+    }
+
+    // Initialize the stream if nothing was compressed, so that we
+    // emit a valid (empty) gzip stream.
+    std::string header;
+    if (!initialized) {
+      Try<std::string> result = compress("");
+      if (result.isError()) {
+        return result;
+      }
+
+      header = result.get();
+    }
+
+    Try<std::string> result = deflate_("", Z_FINISH);
+    finished = true;
+
+    if (result.isError()) {
+      return result;
+    }
+
+    return header + result.get();
+  }
+
+private:
+  Try<std::string> deflate_(const std::string& decompressed, int flush)
+  {
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = decompressed.length();
+
+    // Build up the compressed output. zlib is done with the input
+    // once it leaves room in the output buffer (see zlib.h).
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    int code;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      code = deflate(&stream, flush);
+
+      // NOTE: `Z_BUF_ERROR` only indicates that no progress was
+      // possible, e.g., when flushing without any new input.
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        return Error(std::string(stream.msg));
+      }
+
+      // Consume output.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (stream.avail_out == 0 && code != Z_STREAM_END);
+
+    return result;
+  }
+
+  const int level;
+  bool initialized;
+  bool finished;
+  z_stream_s stream;
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_GZIP_HPP__
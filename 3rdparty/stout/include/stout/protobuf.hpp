@@ -22,8 +22,11 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <google/protobuf/descriptor.h>
@@ -679,6 +682,545 @@ struct Parse<google::protobuf::RepeatedPtrField<T>>
   }
 };
 
+
+// Parses a protobuf message directly from a JSON string in a single
+// pass, without building a `JSON::Value` (and then walking it with
+// the `Parser` above) first. The JSON is accepted and converted like
+// `JSON::parse()` followed by `protobuf::parse()` do: unknown fields
+// are ignored, 'null' leaves a field unset, bytes are base64 encoded
+// and enums are given by name.
+class StreamingParser
+{
+public:
+  explicit StreamingParser(const std::string& json)
+    : cursor(json.data()),
+      end(json.data() + json.size()) {}
+
+  Try<Nothing> parse(google::protobuf::Message* message)
+  {
+    whitespace();
+
+    if (!consume('{')) {
+      return Error("Expecting a JSON object");
+    }
+
+    Try<Nothing> parse = object(message);
+    if (parse.isError()) {
+      return parse;
+    }
+
+    whitespace();
+
+    if (cursor != end) {
+      return Error(
+          "Parsed JSON included non-whitespace trailing characters: " +
+          std::string(cursor, end));
+    }
+
+    return Nothing();
+  }
+
+private:
+  // Parses the members of an object, after the opening brace, into
+  // the message.
+  Try<Nothing> object(google::protobuf::Message* message)
+  {
+    const google::protobuf::Descriptor* descriptor = message->GetDescriptor();
+    const google::protobuf::Reflection* reflection = message->GetReflection();
+
+    whitespace();
+
+    if (consume('}')) {
+      return Nothing();
+    }
+
+    do {
+      whitespace();
+
+      if (!consume('"')) {
+        return syntax("Expecting a string");
+      }
+
+      // NOTE: The key is parsed into a member to reuse its storage.
+      key.clear();
+
+      Try<Nothing> parse = string(&key);
+      if (parse.isError()) {
+        return parse;
+      }
+
+      whitespace();
+
+      if (!consume(':')) {
+        return syntax("Expecting ':'");
+      }
+
+      const google::protobuf::FieldDescriptor* field =
+        descriptor->FindFieldByName(key);
+
+      if (field == nullptr) {
+        parse = skip();
+      } else {
+        // Like for a `JSON::Object`, the last of duplicate keys wins.
+        reflection->ClearField(message, field);
+
+        parse = value(message, field);
+      }
+
+      if (parse.isError()) {
+        return parse;
+      }
+
+      whitespace();
+    } while (consume(','));
+
+    if (!consume('}')) {
+      return syntax("Expecting ',' or '}'");
+    }
+
+    return Nothing();
+  }
+
+  // Parses a value into the field of the message.
+  Try<Nothing> value(
+      google::protobuf::Message* message,
+      const google::protobuf::FieldDescriptor* field)
+  {
+    using google::protobuf::FieldDescriptor;
+
+    const google::protobuf::Reflection* reflection = message->GetReflection();
+
+    whitespace();
+
+    if (cursor == end) {
+      return syntax("Expecting a value");
+    }
+
+    switch (*cursor) {
+      case '{': {
+        ++cursor;
+
+        if (field->type() != FieldDescriptor::TYPE_MESSAGE) {
+          return Error("Not expecting a JSON object for field '" +
+                       field->name() + "'");
+        }
+
+        if (field->is_repeated()) {
+          return object(reflection->AddMessage(message, field));
+        }
+
+        return object(reflection->MutableMessage(message, field));
+      }
+      case '[': {
+        ++cursor;
+
+        if (!field->is_repeated()) {
+          return Error("Not expecting a JSON array for field '" +
+                       field->name() + "'");
+        }
+
+        whitespace();
+
+        if (consume(']')) {
+          return Nothing();
+        }
+
+        do {
+          Try<Nothing> parse = value(message, field);
+          if (parse.isError()) {
+            return parse;
+          }
+
+          whitespace();
+        } while (consume(','));
+
+        if (!consume(']')) {
+          return syntax("Expecting ',' or ']'");
+        }
+
+        return Nothing();
+      }
+      case '"': {
+        ++cursor;
+
+        std::string s;
+
+        Try<Nothing> parse = string(&s);
+        if (parse.isError()) {
+          return parse;
+        }
+
+        switch (field->type()) {
+          case FieldDescriptor::TYPE_STRING:
+            if (field->is_repeated()) {
+              reflection->AddString(message, field, std::move(s));
+            } else {
+              reflection->SetString(message, field, std::move(s));
+            }
+            break;
+          case FieldDescriptor::TYPE_BYTES: {
+            Try<std::string> decode = base64::decode(s);
+
+            if (decode.isError()) {
+              return Error("Failed to base64 decode bytes field"
+                           " '" + field->name() + "': " + decode.error());
+            }
+
+            if (field->is_repeated()) {
+              reflection->AddString(message, field, decode.get());
+            } else {
+              reflection->SetString(message, field, decode.get());
+            }
+            break;
+          }
+          case FieldDescriptor::TYPE_ENUM: {
+            const google::protobuf::EnumValueDescriptor* descriptor =
+              field->enum_type()->FindValueByName(s);
+
+            if (descriptor == nullptr) {
+              return Error("Failed to find enum for '" + s + "'");
+            }
+
+            if (field->is_repeated()) {
+              reflection->AddEnum(message, field, descriptor);
+            } else {
+              reflection->SetEnum(message, field, descriptor);
+            }
+            break;
+          }
+          default:
+            return Error("Not expecting a JSON string for field '" +
+                         field->name() + "'");
+        }
+
+        return Nothing();
+      }
+      case 't':
+      case 'f': {
+        const bool boolean = *cursor == 't';
+
+        if (!literal(boolean ? "true" : "false")) {
+          return syntax("Expecting a value");
+        }
+
+        if (field->type() != FieldDescriptor::TYPE_BOOL) {
+          return Error("Not expecting a JSON boolean for field '" +
+                       field->name() + "'");
+        }
+
+        if (field->is_repeated()) {
+          reflection->AddBool(message, field, boolean);
+        } else {
+          reflection->SetBool(message, field, boolean);
+        }
+
+        return Nothing();
+      }
+      case 'n': {
+        if (!literal("null")) {
+          return syntax("Expecting a value");
+        }
+
+        // We treat 'null' as an unset field, see `Parser` above.
+        return Nothing();
+      }
+      default: {
+        Try<JSON::Number> number = this->number();
+        if (number.isError()) {
+          return Error(number.error());
+        }
+
+        return Parser(message, field)(number.get());
+      }
+    }
+  }
+
+  // Skips a value (e.g., of an unknown field), while still checking
+  // that it is valid JSON.
+  Try<Nothing> skip()
+  {
+    whitespace();
+
+    if (cursor == end) {
+      return syntax("Expecting a value");
+    }
+
+    switch (*cursor) {
+      case '{':
+      case '[': {
+        const char close = *cursor == '{' ? '}' : ']';
+
+        ++cursor;
+        whitespace();
+
+        if (consume(close)) {
+          return Nothing();
+        }
+
+        do {
+          if (close == '}') {
+            whitespace();
+
+            if (!consume('"')) {
+              return syntax("Expecting a string");
+            }
+
+            key.clear();
+
+            Try<Nothing> parse = string(&key);
+            if (parse.isError()) {
+              return parse;
+            }
+
+            whitespace();
+
+            if (!consume(':')) {
+              return syntax("Expecting ':'");
+            }
+          }
+
+          Try<Nothing> parse = skip();
+          if (parse.isError()) {
+            return parse;
+          }
+
+          whitespace();
+        } while (consume(','));
+
+        if (!consume(close)) {
+          return syntax(std::string("Expecting ',' or '") + close + "'");
+        }
+
+        return Nothing();
+      }
+      case '"': {
+        ++cursor;
+
+        key.clear();
+        return string(&key);
+      }
+      case 't':
+        return literal("true") ? Try<Nothing>(Nothing())
+                               : syntax("Expecting a value");
+      case 'f':
+        return literal("false") ? Try<Nothing>(Nothing())
+                                : syntax("Expecting a value");
+      case 'n':
+        return literal("null") ? Try<Nothing>(Nothing())
+                               : syntax("Expecting a value");
+      default: {
+        Try<JSON::Number> number = this->number();
+        if (number.isError()) {
+          return Error(number.error());
+        }
+
+        return Nothing();
+      }
+    }
+  }
+
+  // Parses a string, after the opening quote, appending it to 's'.
+  Try<Nothing> string(std::string* s)
+  {
+    while (cursor != end) {
+      // Append the characters up to the next quote or escape at once.
+      const char* begin = cursor;
+      while (cursor != end &&
+             *cursor != '"' &&
+             *cursor != '\\' &&
+             static_cast<unsigned char>(*cursor) >= ' ') {
+        ++cursor;
+      }
+
+      s->append(begin, cursor);
+
+      if (cursor == end || static_cast<unsigned char>(*cursor) < ' ') {
+        break;
+      }
+
+      if (*cursor++ == '"') {
+        return Nothing();
+      }
+
+      if (cursor == end) {
+        break;
+      }
+
+      switch (*cursor++) {
+        case '"': s->push_back('"'); break;
+        case '\\': s->push_back('\\'); break;
+        case '/': s->push_back('/'); break;
+        case 'b': s->push_back('\b'); break;
+        case 'f': s->push_back('\f'); break;
+        case 'n': s->push_back('\n'); break;
+        case 'r': s->push_back('\r'); break;
+        case 't': s->push_back('\t'); break;
+        case 'u': {
+          Try<Nothing> parse = codepoint(s);
+          if (parse.isError()) {
+            return parse;
+          }
+          break;
+        }
+        default:
+          return syntax("Invalid escape in string");
+      }
+    }
+
+    return syntax("Unterminated string");
+  }
+
+  // Parses the hexadecimal digits of a '\\u' escape (including a
+  // following low surrogate, if any), appending the UTF-8 encoding
+  // of the code point to 's'.
+  Try<Nothing> codepoint(std::string* s)
+  {
+    int codepoint = hex();
+
+    if (codepoint == -1 || (0xdc00 <= codepoint && codepoint <= 0xdfff)) {
+      return syntax("Invalid unicode escape in string");
+    }
+
+    if (0xd800 <= codepoint && codepoint <= 0xdbff) {
+      if (!consume('\\') || !consume('u')) {
+        return syntax("Invalid unicode escape in string");
+      }
+
+      const int low = hex();
+
+      if (!(0xdc00 <= low && low <= 0xdfff)) {
+        return syntax("Invalid unicode escape in string");
+      }
+
+      codepoint = 0x10000 + (((codepoint - 0xd800) << 10) | (low - 0xdc00));
+    }
+
+    if (codepoint < 0x80) {
+      s->push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+      s->push_back(static_cast<char>(0xc0 | (codepoint >> 6)));
+      s->push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    } else if (codepoint < 0x10000) {
+      s->push_back(static_cast<char>(0xe0 | (codepoint >> 12)));
+      s->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+      s->push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    } else {
+      s->push_back(static_cast<char>(0xf0 | (codepoint >> 18)));
+      s->push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f)));
+      s->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+      s->push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    }
+
+    return Nothing();
+  }
+
+  // Returns the value of the next four hexadecimal digits, or -1.
+  int hex()
+  {
+    int value = 0;
+
+    for (int i = 0; i < 4; i++) {
+      if (cursor == end) {
+        return -1;
+      }
+
+      const char c = *cursor++;
+
+      if ('0' <= c && c <= '9') {
+        value = value * 16 + (c - '0');
+      } else if ('a' <= c && c <= 'f') {
+        value = value * 16 + (c - 'a' + 10);
+      } else if ('A' <= c && c <= 'F') {
+        value = value * 16 + (c - 'A' + 10);
+      } else {
+        return -1;
+      }
+    }
+
+    return value;
+  }
+
+  // Parses a number the way `JSON::parse()` does: as a signed integer
+  // if it is one that fits, and as a double otherwise.
+  Try<JSON::Number> number()
+  {
+    if (cursor == end || !(('0' <= *cursor && *cursor <= '9') ||
+                           *cursor == '-')) {
+      return syntax("Expecting a value");
+    }
+
+    const char* begin = cursor;
+    while (cursor != end &&
+           (('0' <= *cursor && *cursor <= '9') ||
+            *cursor == '+' || *cursor == '-' || *cursor == '.' ||
+            *cursor == 'e' || *cursor == 'E')) {
+      ++cursor;
+    }
+
+    // NOTE: We copy the number since `strtoll()` and `strtod()`
+    // expect a terminated string.
+    const std::string s(begin, cursor);
+    char* last = nullptr;
+
+    errno = 0;
+    const long long integer = std::strtoll(s.c_str(), &last, 10);
+
+    if (errno == 0 && last == s.c_str() + s.size()) {
+      return JSON::Number(static_cast<int64_t>(integer));
+    }
+
+    const double floating = std::strtod(s.c_str(), &last);
+
+    if (last == s.c_str() + s.size()) {
+      return JSON::Number(floating);
+    }
+
+    return syntax("Invalid number '" + s + "'");
+  }
+
+  void whitespace()
+  {
+    while (cursor != end &&
+           (*cursor == ' ' || *cursor == '\t' ||
+            *cursor == '\n' || *cursor == '\r')) {
+      ++cursor;
+    }
+  }
+
+  bool consume(char c)
+  {
+    if (cursor != end && *cursor == c) {
+      ++cursor;
+      return true;
+    }
+
+    return false;
+  }
+
+  bool literal(const std::string& s)
+  {
+    if (static_cast<size_t>(end - cursor) < s.size() ||
+        s.compare(0, s.size(), cursor, s.size()) != 0) {
+      return false;
+    }
+
+    cursor += s.size();
+    return true;
+  }
+
+  Error syntax(const std::string& message) const
+  {
+    return Error("Failed to parse JSON: " + message + " at '" +
+                 std::string(cursor, std::min<size_t>(end - cursor, 16)) +
+                 "'");
+  }
+
+  const char* cursor;
+  const char* end;
+
+  std::string key;
+};
+
 } // namespace internal {
 
 // A dispatch wrapper which parses protobuf messages(s) from a given JSON value.
@@ -695,6 +1237,31 @@ Try<T> parse(const JSON::Value& value)
   return internal::Parse<T>()(value);
 }
 
+
+// Parses a protobuf message of type T from a JSON string. This is
+// equivalent to parsing the string into a `JSON::Value` and then
+// parsing that into the message, but does so in a single pass.
+template <typename T>
+Try<T> parse(const std::string& json)
+{
+  static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                "T must be a protobuf message");
+
+  T message;
+
+  Try<Nothing> parse = internal::StreamingParser(json).parse(&message);
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  if (!message.IsInitialized()) {
+    return Error("Missing required fields: " +
+                 message.InitializationErrorString());
+  }
+
+  return message;
+}
+
 } // namespace protobuf {
 
 namespace JSON {
@@ -57,6 +57,23 @@ TEST(CacheTest, Erase)
 }
 
 
+TEST(CacheTest, Clear)
+{
+  Cache<int, std::string> cache(2);
+  cache.put(1, "a");
+  cache.put(2, "b");
+
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_NONE(cache.get(1));
+  EXPECT_NONE(cache.get(2));
+
+  cache.put(3, "c");
+  EXPECT_SOME_EQ("c", cache.get(3));
+  EXPECT_EQ(1, cache.size());
+}
+
+
 TEST(CacheTest, LRUEviction)
 {
   Cache<int, std::string> cache(2);
@@ -62,4 +62,54 @@ TEST(GzipTest, CompressDecompressString)
   ASSERT_SOME(decompressed);
   ASSERT_EQ(s, decompressed.get());
 }
+
+TEST(GzipTest, StreamingCompression)
+{
+  ASSERT_ERROR(gzip::Compressor(-2).compress(""));
+
+  string s;
+  while (s.length() < (1024 * 1024)) {
+    s.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  // Compress in chunks of various sizes, flushing some of them.
+  gzip::Compressor compressor;
+  string compressed;
+  size_t offset = 0;
+  for (size_t size = 1; offset < s.length(); size *= 2) {
+    const string chunk = s.substr(offset, size);
+    offset += chunk.length();
+
+    Try<string> output = compressor.compress(chunk, size % 3 == 0);
+    ASSERT_SOME(output);
+    compressed += output.get();
+  }
+
+  Try<string> output = compressor.finish();
+  ASSERT_SOME(output);
+  compressed += output.get();
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+
+  // No more data can be compressed after finishing.
+  EXPECT_ERROR(compressor.compress("foo"));
+  EXPECT_ERROR(compressor.finish());
+
+  // A flush makes all the data so far available to the reader.
+  gzip::Compressor flushing;
+  output = flushing.compress("hello world", true);
+  ASSERT_SOME(output);
+  EXPECT_FALSE(output->empty());
+
+  // An empty stream is valid.
+  gzip::Compressor empty;
+  output = empty.finish();
+  ASSERT_SOME(output);
+
+  decompressed = gzip::decompress(output.get());
+  ASSERT_SOME(decompressed);
+  EXPECT_EQ("", decompressed.get());
+}
 #endif // HAVE_LIBZ
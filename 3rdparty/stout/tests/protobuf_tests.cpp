@@ -601,3 +601,140 @@ TEST(ProtobufTest, JsonifyLargeIntegers)
   // Check JSON -> String.
   EXPECT_EQ(expected, string(jsonify(JSON::Protobuf(message))));
 }
+
+
+// Tests that parsing a protobuf message directly from a JSON string
+// is equivalent to parsing it from the `JSON::Value` of the string.
+TEST(ProtobufTest, ParseJSONString)
+{
+  tests::Message message;
+  message.set_b(true);
+  message.set_str("string");
+  message.set_bytes(UUID::random().toBytes());
+  message.set_int32(-2147483647);
+  message.set_int64(-9223372036854775807);
+  message.set_uint32(4294967295U);
+  message.set_uint64(9223372036854775807);
+  message.set_sint32(-1);
+  message.set_sint64(-1);
+  message.set_f(1.5);
+  message.set_d(-0.25);
+  message.set_e(tests::ONE);
+  message.mutable_nested()->set_str("nested");
+  message.add_repeated_bool(true);
+  message.add_repeated_bool(false);
+  message.add_repeated_string("repeated_string");
+  message.add_repeated_bytes("repeated_bytes");
+  message.add_repeated_int32(-2);
+  message.add_repeated_int64(-2);
+  message.add_repeated_uint32(2);
+  message.add_repeated_uint64(2);
+  message.add_repeated_sint32(-2);
+  message.add_repeated_sint64(-2);
+  message.add_repeated_float(1.0);
+  message.add_repeated_double(1.0);
+  message.add_repeated_double(2.0);
+  message.add_repeated_enum(tests::TWO);
+  message.add_repeated_nested()->set_str("repeated_nested");
+
+  tests::Nested* nested = message.add_repeated_nested();
+  nested->set_str("repeated_nested");
+  nested->add_repeated_str("repeated_str");
+
+  const string json = jsonify(JSON::Protobuf(message));
+
+  Try<tests::Message> parse = protobuf::parse<tests::Message>(json);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(json, string(jsonify(JSON::Protobuf(parse.get()))));
+
+  Try<JSON::Value> value = JSON::parse(json);
+  ASSERT_SOME(value);
+
+  Try<tests::Message> expected = protobuf::parse<tests::Message>(value.get());
+  ASSERT_SOME(expected);
+
+  EXPECT_EQ(expected->SerializeAsString(), parse->SerializeAsString());
+}
+
+
+TEST(ProtobufTest, ParseJSONStringSyntax)
+{
+  // Escapes, unicode (including a surrogate pair), whitespace,
+  // 'null' and unknown fields (of any type) are handled like
+  // `JSON::parse()` does.
+  string json =
+    "\t{\n"
+    "  \"str\": \"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u00e9\\u20ac\\ud83d\\ude00\",\r\n"
+    "  \"optional_str\": null,\n"
+    "  \"unknown\": {\"a\": [1, -2.5e3, \"}\", true, false, null, {}, []]},\n"
+    "  \"repeated_str\": [\"x\", \"y\"]\n"
+    "}\n";
+
+  Try<tests::Nested> parse = protobuf::parse<tests::Nested>(json);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ("a\"b\\c/d\b\f\n\r\t\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80",
+            parse->str());
+  EXPECT_FALSE(parse->has_optional_str());
+  ASSERT_EQ(2, parse->repeated_str_size());
+  EXPECT_EQ("x", parse->repeated_str(0));
+  EXPECT_EQ("y", parse->repeated_str(1));
+
+  Try<JSON::Value> value = JSON::parse(json);
+  ASSERT_SOME(value);
+
+  Try<tests::Nested> expected = protobuf::parse<tests::Nested>(value.get());
+  ASSERT_SOME(expected);
+
+  EXPECT_EQ(expected->SerializeAsString(), parse->SerializeAsString());
+
+  // The last of duplicate keys wins.
+  parse = protobuf::parse<tests::Nested>(string(
+      "{\"str\": \"a\", \"repeated_str\": [\"x\"],"
+      " \"str\": \"b\", \"repeated_str\": [\"y\"]}"));
+
+  ASSERT_SOME(parse);
+  EXPECT_EQ("b", parse->str());
+  ASSERT_EQ(1, parse->repeated_str_size());
+  EXPECT_EQ("y", parse->repeated_str(0));
+
+  // Malformed JSON.
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("[]")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"a\"")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"a\",}")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\" \"a\"}")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"a}")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"\\x\"}")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"\n\"}")));
+  EXPECT_ERROR(
+      protobuf::parse<tests::Nested>(string("{\"str\": \"\\udc00\"}")));
+  EXPECT_ERROR(
+      protobuf::parse<tests::Nested>(string("{\"str\": \"a\", \"x\": nul}")));
+  EXPECT_ERROR(
+      protobuf::parse<tests::Nested>(string("{\"str\": \"a\", \"x\": 1-}")));
+  EXPECT_ERROR(protobuf::parse<tests::Nested>(string("{\"str\": \"a\"} x")));
+
+  // Well-formed JSON that does not match the message.
+  parse = protobuf::parse<tests::Nested>(string("{\"str\": 1}"));
+  ASSERT_ERROR(parse);
+  EXPECT_TRUE(strings::contains(
+      parse.error(), "Not expecting a JSON number for field 'str'"));
+
+  parse = protobuf::parse<tests::Nested>(string("{\"str\": [\"a\"]}"));
+  ASSERT_ERROR(parse);
+  EXPECT_TRUE(strings::contains(
+      parse.error(), "Not expecting a JSON array for field 'str'"));
+
+  parse = protobuf::parse<tests::Nested>(string("{\"optional_str\": \"a\"}"));
+  ASSERT_ERROR(parse);
+  EXPECT_TRUE(strings::contains(parse.error(), "Missing required fields"));
+
+  Try<tests::Message> message = protobuf::parse<tests::Message>(
+      string("{\"e\": \"THREE\"}"));
+
+  ASSERT_ERROR(message);
+  EXPECT_TRUE(strings::contains(
+      message.error(), "Failed to find enum for 'THREE'"));
+}
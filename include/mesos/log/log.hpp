@@ -160,7 +160,38 @@ public:
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
     // another writer) must be restarted.
+    //
+    // A writer accepts concurrent appends and truncates, which are
+    // pipelined and written to the log in the order they were issued.
+    // A write completes only after all the writes issued before it.
+    //
+    // NOTE: When a write returns none, so do all the writes issued
+    // after it that have not completed yet. However, any of these
+    // writes might still end up in the log (i.e., be read once the
+    // writer or another writer is started), even if a write issued
+    // before it does not. A writer that needs a write to be in the
+    // log only if all the writes before it are (e.g., because it
+    // depends on them) must wait for those writes to complete before
+    // issuing it.
     explicit Writer(Log* log);
+
+    // Creates a new writer which group commits its writes: appends
+    // and truncates issued within the specified window (or while the
+    // previous group is being written) are written together, using a
+    // single round of the replicated log protocol and a single synced
+    // write on each replica. A write returning none invalidates all
+    // the writes of its group. The writer exposes its group commit
+    // metrics under '<metricsPrefix>log/group_commit/', where the
+    // metrics prefix defaults to the one of the log. Writers of the
+    // same log that exist at the same time need distinct prefixes.
+    //
+    // NOTE: All the replicas of the log must support batched writes
+    // (Mesos >= 1.1), since older replicas ignore them.
+    Writer(
+        Log* log,
+        const Duration& groupCommitWindow,
+        const Option<std::string>& metricsPrefix = None());
+
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -34,6 +34,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
 #include <stout/unreachable.hpp>
@@ -94,8 +95,9 @@ string serialize(
       return message.SerializeAsString();
     }
     case ContentType::JSON: {
-      JSON::Object object = JSON::protobuf(message);
-      return stringify(object);
+      // NOTE: We write the JSON directly from the message rather than
+      // building (and then stringifying) a `JSON::Object` of it.
+      return jsonify(JSON::Protobuf(message));
     }
   }
 
@@ -67,12 +67,7 @@ Try<Message> deserialize(
       return message;
     }
     case ContentType::JSON: {
-      Try<JSON::Value> value = JSON::parse(body);
-      if (value.isError()) {
-        return Error("Failed to parse body into JSON: " + value.error());
-      }
-
-      return ::protobuf::parse<Message>(value.get());
+      return ::protobuf::parse<Message>(body);
     }
   }
 
@@ -0,0 +1,402 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/synchronized.hpp>
+
+#include "common/resource_quantities.hpp"
+
+using std::ostream;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+
+namespace {
+
+// A process-wide table of interned strings.
+class Strings
+{
+public:
+  uint32_t index(const string& s)
+  {
+    synchronized (mutex) {
+      if (!indices.contains(s)) {
+        indices[s] = strings.size();
+        strings.push_back(s);
+      }
+
+      return indices.at(s);
+    }
+  }
+
+  string get(uint32_t index)
+  {
+    synchronized (mutex) {
+      return strings.at(index);
+    }
+  }
+
+private:
+  std::mutex mutex;
+  hashmap<string, uint32_t> indices;
+  vector<string> strings;
+};
+
+} // namespace {
+
+
+// NOTE: The tables are never deleted, so that quantities can be used
+// during static destruction.
+static Strings* resourceNames()
+{
+  static Strings* strings = new Strings();
+  return strings;
+}
+
+
+static Strings* resourceRoles()
+{
+  static Strings* strings = new Strings();
+  return strings;
+}
+
+
+// See the `Value::Scalar` arithmetic in common/values.cpp.
+static int64_t convertToFixed(double floatValue)
+{
+  return std::llround(floatValue * 1000);
+}
+
+
+static double convertToFloating(int64_t fixedValue)
+{
+  double quotient = static_cast<double>(fixedValue / 1000);
+  double remainder = static_cast<double>(fixedValue % 1000) / 1000.0;
+
+  return quotient + remainder;
+}
+
+
+static bool operator<(
+    const ResourceQuantities::Entry& left,
+    const ResourceQuantities::Entry& right)
+{
+  return std::tie(left.name, left.role, left.revocable) <
+         std::tie(right.name, right.role, right.revocable);
+}
+
+
+static bool same(
+    const ResourceQuantities::Entry& left,
+    const ResourceQuantities::Entry& right)
+{
+  return left.name == right.name &&
+         left.role == right.role &&
+         left.revocable == right.revocable;
+}
+
+
+double ResourceQuantities::Entry::quantity() const
+{
+  return convertToFloating(value);
+}
+
+
+ResourceQuantities ResourceQuantities::fromScalarResources(
+    const Resources& resources)
+{
+  vector<Entry> scalars;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.type() != Value::SCALAR) {
+      continue;
+    }
+
+    const int64_t value = convertToFixed(resource.scalar().value());
+
+    if (value > 0) {
+      scalars.push_back({
+          resourceNames()->index(resource.name()),
+          resourceRoles()->index(resource.role()),
+          resource.has_revocable(),
+          value});
+    }
+  }
+
+  std::sort(scalars.begin(), scalars.end());
+
+  // Combine the quantities of resources that differ only in their
+  // reservation or disk info.
+  ResourceQuantities result;
+
+  for (size_t i = 0; i < scalars.size(); i++) {
+    Entry entry = scalars[i];
+
+    while (i + 1 < scalars.size() && same(entry, scalars[i + 1])) {
+      entry.value += scalars[++i].value;
+    }
+
+    result.append(entry);
+  }
+
+  return result;
+}
+
+
+uint32_t ResourceQuantities::index(const string& name)
+{
+  return resourceNames()->index(name);
+}
+
+
+string ResourceQuantities::name(uint32_t index)
+{
+  return resourceNames()->get(index);
+}
+
+
+bool ResourceQuantities::contains(const ResourceQuantities& that) const
+{
+  const_iterator it = begin();
+
+  foreach (const Entry& entry, that) {
+    while (it != end() && *it < entry) {
+      ++it;
+    }
+
+    if (it == end() || !same(*it, entry) || it->value < entry.value) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+double ResourceQuantities::get(const string& name) const
+{
+  return get(resourceNames()->index(name));
+}
+
+
+double ResourceQuantities::get(uint32_t name) const
+{
+  int64_t value = 0;
+
+  foreach (const Entry& entry, *this) {
+    if (entry.name == name) {
+      value += entry.value;
+    }
+  }
+
+  return convertToFloating(value);
+}
+
+
+set<string> ResourceQuantities::names() const
+{
+  set<string> result;
+
+  foreach (const Entry& entry, *this) {
+    result.insert(name(entry.name));
+  }
+
+  return result;
+}
+
+
+ResourceQuantities ResourceQuantities::flatten() const
+{
+  static const uint32_t ANY_ROLE = resourceRoles()->index("*");
+
+  vector<Entry> flattened(begin(), end());
+
+  foreach (Entry& entry, flattened) {
+    entry.role = ANY_ROLE;
+  }
+
+  std::sort(flattened.begin(), flattened.end());
+
+  ResourceQuantities result;
+
+  for (size_t i = 0; i < flattened.size(); i++) {
+    Entry entry = flattened[i];
+
+    while (i + 1 < flattened.size() && same(entry, flattened[i + 1])) {
+      entry.value += flattened[++i].value;
+    }
+
+    result.append(entry);
+  }
+
+  return result;
+}
+
+
+Resources ResourceQuantities::toResources() const
+{
+  Resources result;
+
+  foreach (const Entry& entry, *this) {
+    Resource resource;
+    resource.set_name(name(entry.name));
+    resource.set_type(Value::SCALAR);
+    resource.mutable_scalar()->set_value(entry.quantity());
+    resource.set_role(resourceRoles()->get(entry.role));
+
+    if (entry.revocable) {
+      resource.mutable_revocable();
+    }
+
+    result += resource;
+  }
+
+  return result;
+}
+
+
+bool ResourceQuantities::operator==(const ResourceQuantities& that) const
+{
+  if (size() != that.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < size(); i++) {
+    const Entry& left = data()[i];
+    const Entry& right = that.data()[i];
+
+    if (!same(left, right) || left.value != right.value) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool ResourceQuantities::operator!=(const ResourceQuantities& that) const
+{
+  return !(*this == that);
+}
+
+
+ResourceQuantities ResourceQuantities::operator+(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result;
+
+  const_iterator left = begin();
+  const_iterator right = that.begin();
+
+  while (left != end() || right != that.end()) {
+    if (right == that.end() || (left != end() && *left < *right)) {
+      result.append(*left++);
+    } else if (left == end() || *right < *left) {
+      result.append(*right++);
+    } else {
+      Entry entry = *left++;
+      entry.value += (right++)->value;
+      result.append(entry);
+    }
+  }
+
+  return result;
+}
+
+
+ResourceQuantities ResourceQuantities::operator-(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result;
+
+  const_iterator right = that.begin();
+
+  foreach (Entry entry, *this) {
+    while (right != that.end() && *right < entry) {
+      ++right;
+    }
+
+    if (right != that.end() && same(*right, entry)) {
+      entry.value -= right->value;
+    }
+
+    // Like `Resources`, we drop the resources that become empty
+    // or negative.
+    if (entry.value > 0) {
+      result.append(entry);
+    }
+  }
+
+  return result;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator+=(
+    const ResourceQuantities& that)
+{
+  *this = *this + that;
+  return *this;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator-=(
+    const ResourceQuantities& that)
+{
+  *this = *this - that;
+  return *this;
+}
+
+
+void ResourceQuantities::append(const Entry& entry)
+{
+  if (heap.empty() && size_ < INLINE_CAPACITY) {
+    entries[size_++] = entry;
+    return;
+  }
+
+  if (heap.empty()) {
+    heap.reserve(2 * INLINE_CAPACITY);
+    heap.assign(entries, entries + size_);
+    size_ = 0;
+  }
+
+  heap.push_back(entry);
+}
+
+
+ostream& operator<<(ostream& stream, const ResourceQuantities& quantities)
+{
+  return stream << quantities.toResources();
+}
+
+} // namespace internal {
+} // namespace mesos {
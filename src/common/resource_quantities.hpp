@@ -0,0 +1,142 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __RESOURCE_QUANTITIES_HPP__
+#define __RESOURCE_QUANTITIES_HPP__
+
+#include <stdint.h>
+
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <mesos/resources.hpp>
+
+namespace mesos {
+namespace internal {
+
+// The quantities of scalar resources, i.e., the equivalent of
+// `Resources::createStrippedScalarQuantity()`, in a representation
+// that is cheap to do arithmetic on: there are no protobufs, resource
+// names and roles are interned, and a few quantities are stored
+// inline (i.e., without any heap allocation).
+//
+// Like the stripped `Resources`, quantities are distinguished by
+// resource name, role and revocability, and the arithmetic has the
+// same semantics (e.g., subtracting more than is contained yields
+// nothing rather than a negative quantity).
+//
+// NOTE: Quantities are kept in fixed point with three decimal digits,
+// which is the precision of the `Value::Scalar` arithmetic.
+class ResourceQuantities
+{
+public:
+  struct Entry
+  {
+    // Interned resource name and role, see `index()`.
+    uint32_t name;
+    uint32_t role;
+    bool revocable;
+
+    // The quantity in thousandths.
+    int64_t value;
+
+    double quantity() const;
+  };
+
+  typedef const Entry* iterator;
+  typedef const Entry* const_iterator;
+
+  // Returns the quantities of the scalar resources in `resources`,
+  // omitting dynamic reservations and persistent volumes.
+  static ResourceQuantities fromScalarResources(const Resources& resources);
+
+  // Returns the (process-wide) index of the resource name, and the
+  // resource name of an index. Indices are dense, so they can be used
+  // to index vectors of per-resource state.
+  static uint32_t index(const std::string& name);
+  static std::string name(uint32_t index);
+
+  ResourceQuantities() : size_(0) {}
+
+  bool empty() const { return size() == 0; }
+
+  size_t size() const { return heap.empty() ? size_ : heap.size(); }
+
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+
+  // Checks if this contains at least the quantities in `that`.
+  bool contains(const ResourceQuantities& that) const;
+
+  // Returns the total quantity of the resources with the given name,
+  // across roles and revocability.
+  double get(const std::string& name) const;
+
+  // Same as above for the index of a resource name, see `index()`.
+  // Unlike the above this neither interns the name nor locks, so
+  // callers on hot paths should look up the index once.
+  double get(uint32_t name) const;
+
+  // Returns the names of the resources.
+  std::set<std::string> names() const;
+
+  // Returns the quantities with all roles set to "*", similar to
+  // `Resources::flatten()`.
+  ResourceQuantities flatten() const;
+
+  // Returns the quantities as `Resources`, i.e., as they would be
+  // returned by `Resources::createStrippedScalarQuantity()`.
+  Resources toResources() const;
+
+  bool operator==(const ResourceQuantities& that) const;
+  bool operator!=(const ResourceQuantities& that) const;
+
+  ResourceQuantities operator+(const ResourceQuantities& that) const;
+  ResourceQuantities operator-(const ResourceQuantities& that) const;
+  ResourceQuantities& operator+=(const ResourceQuantities& that);
+  ResourceQuantities& operator-=(const ResourceQuantities& that);
+
+private:
+  // The number of entries stored inline. Most quantities are of a
+  // handful of resources (e.g., cpus, mem, disk and gpus) in a role
+  // or two.
+  static const size_t INLINE_CAPACITY = 8;
+
+  const Entry* data() const { return heap.empty() ? entries : heap.data(); }
+
+  // Appends an entry, which must be ordered after all other entries.
+  void append(const Entry& entry);
+
+  // Entries are ordered by name, role and revocability, and only
+  // entries with a positive quantity are kept. The first entries are
+  // stored inline, all of them are moved to `heap` once they exceed
+  // `INLINE_CAPACITY`.
+  Entry entries[INLINE_CAPACITY];
+  size_t size_;
+  std::vector<Entry> heap;
+};
+
+
+std::ostream& operator<<(
+    std::ostream& stream,
+    const ResourceQuantities& quantities);
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __RESOURCE_QUANTITIES_HPP__
@@ -17,9 +17,12 @@
 #ifndef __INTERNAL_DEVOLVE_HPP__
 #define __INTERNAL_DEVOLVE_HPP__
 
+#include <string>
+
 #include <google/protobuf/message.h>
 
 #include <mesos/agent/agent.hpp>
+#include <mesos/http.hpp>
 
 #include <mesos/mesos.hpp>
 
@@ -39,7 +42,10 @@
 
 #include <mesos/v1/scheduler/scheduler.hpp>
 
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/try.hpp>
 
 namespace mesos {
 namespace internal {
@@ -81,6 +87,34 @@ google::protobuf::RepeatedPtrField<T1> devolve(
   return t1s;
 }
 
+
+// Helper for deserializing a v1 message of type 'T2' (e.g., a
+// `v1::master::Call` sent to the 'api/v1' endpoint) as the internal
+// message of type 'T1' it devolves to. The internal and v1 messages
+// have the same wire format, so for protobuf the body is parsed into
+// the internal message directly, without devolving a v1 message.
+// Only JSON, whose field names differ between the versions, requires
+// parsing the v1 message first.
+template <typename T1, typename T2>
+Try<T1> deserialize(ContentType contentType, const std::string& body)
+{
+  if (contentType == ContentType::PROTOBUF) {
+    T1 t1;
+    if (!t1.ParseFromString(body)) {
+      return Error("Failed to parse protobuf");
+    }
+
+    return t1;
+  }
+
+  Try<T2> t2 = ::protobuf::parse<T2>(body);
+  if (t2.isError()) {
+    return Error(t2.error());
+  }
+
+  return devolve(t2.get());
+}
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -25,8 +25,11 @@
 #include <process/pid.hpp>
 
 #include <stout/check.hpp>
+#include <stout/foreach.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/unreachable.hpp>
 
 #include "internal/evolve.hpp"
 
@@ -40,12 +43,11 @@ namespace mesos {
 namespace internal {
 
 // Helper for evolving a type by serializing/parsing when the types
-// have not changed across versions.
-template <typename T>
-static T evolve(const google::protobuf::Message& message)
+// have not changed across versions. The message is parsed into the
+// given (e.g., newly added repeated) field to avoid copying it.
+static void evolve(const google::protobuf::Message& message,
+                   google::protobuf::Message* t)
 {
-  T t;
-
   string data;
 
   // NOTE: We need to use 'SerializePartialToString' instead of
@@ -53,15 +55,22 @@ static T evolve(const google::protobuf::Message& message)
   // and we don't want an exception to get thrown.
   CHECK(message.SerializePartialToString(&data))
     << "Failed to serialize " << message.GetTypeName()
-    << " while evolving to " << t.GetTypeName();
+    << " while evolving to " << t->GetTypeName();
 
   // NOTE: We need to use 'ParsePartialFromString' instead of
   // 'ParsePartialFromString' because some required fields might not
   // be set and we don't want an exception to get thrown.
-  CHECK(t.ParsePartialFromString(data))
-    << "Failed to parse " << t.GetTypeName()
+  CHECK(t->ParsePartialFromString(data))
+    << "Failed to parse " << t->GetTypeName()
     << " while evolving from " << message.GetTypeName();
+}
+
 
+template <typename T>
+static T evolve(const google::protobuf::Message& message)
+{
+  T t;
+  evolve(message, &t);
   return t;
 }
 
@@ -238,7 +247,11 @@ v1::scheduler::Event evolve(const ResourceOffersMessage& message)
   event.set_type(v1::scheduler::Event::OFFERS);
 
   v1::scheduler::Event::Offers* offers = event.mutable_offers();
-  offers->mutable_offers()->CopyFrom(evolve<v1::Offer>(message.offers()));
+  offers->mutable_offers()->Reserve(message.offers_size());
+
+  foreach (const Offer& offer, message.offers()) {
+    evolve(offer, offers->add_offers());
+  }
 
   return event;
 }
@@ -252,8 +265,12 @@ v1::scheduler::Event evolve(const InverseOffersMessage& message)
   v1::scheduler::Event::InverseOffers* inverse_offers =
     event.mutable_inverse_offers();
 
-  inverse_offers->mutable_inverse_offers()->CopyFrom(evolve<v1::InverseOffer>(
-      message.inverse_offers()));
+  inverse_offers->mutable_inverse_offers()->Reserve(
+      message.inverse_offers_size());
+
+  foreach (const InverseOffer& inverseOffer, message.inverse_offers()) {
+    evolve(inverseOffer, inverse_offers->add_inverse_offers());
+  }
 
   return event;
 }
@@ -294,7 +311,7 @@ v1::scheduler::Event evolve(const StatusUpdateMessage& message)
 
   v1::scheduler::Event::Update* update = event.mutable_update();
 
-  update->mutable_status()->CopyFrom(evolve(message.update().status()));
+  evolve(message.update().status(), update->mutable_status());
 
   if (message.update().has_slave_id()) {
     update->mutable_status()->mutable_agent_id()->CopyFrom(
@@ -410,7 +427,7 @@ v1::executor::Event evolve(const RunTaskMessage& message)
 
   v1::executor::Event::Launch* launch = event.mutable_launch();
 
-  launch->mutable_task()->CopyFrom(evolve(message.task()));
+  evolve(message.task(), launch->mutable_task());
 
   return event;
 }
@@ -452,14 +469,9 @@ v1::executor::Event evolve(const ExecutorRegisteredMessage& message)
 
   v1::executor::Event::Subscribed* subscribed = event.mutable_subscribed();
 
-  subscribed->mutable_executor_info()->
-    CopyFrom(evolve(message.executor_info()));
-
-  subscribed->mutable_framework_info()->
-    CopyFrom(evolve(message.framework_info()));
-
-  subscribed->mutable_agent_info()->
-    CopyFrom(evolve(message.slave_info()));
+  evolve(message.executor_info(), subscribed->mutable_executor_info());
+  evolve(message.framework_info(), subscribed->mutable_framework_info());
+  evolve(message.slave_info(), subscribed->mutable_agent_info());
 
   return event;
 }
@@ -481,8 +493,7 @@ v1::master::Response evolve(const maintenance::ClusterStatus& status)
 
   v1::master::Response::GetMaintenanceStatus* maintenanceStatus =
       response.mutable_get_maintenance_status();
-  maintenanceStatus->mutable_status()->CopyFrom(
-      evolve<v1::maintenance::ClusterStatus>(status));
+  evolve(status, maintenanceStatus->mutable_status());
 
   return response;
 }
@@ -495,8 +506,7 @@ v1::master::Response evolve(const maintenance::Schedule& schedule)
 
   v1::master::Response::GetMaintenanceSchedule* maintenanceSchedule =
       response.mutable_get_maintenance_schedule();
-  maintenanceSchedule->mutable_schedule()->CopyFrom(
-      evolve<v1::maintenance::Schedule>(schedule));
+  evolve(schedule, maintenanceSchedule->mutable_schedule());
 
   return response;
 }
@@ -656,5 +666,67 @@ v1::agent::Response evolve<v1::agent::Response::GET_CONTAINERS>(
   return response;
 }
 
+
+// Helper for serializing an internal message as the v1 message 'T'
+// it evolves to, see `serialize()` in 'internal/evolve.hpp'.
+template <typename T>
+static string serialize(
+    ContentType contentType,
+    const google::protobuf::Message& message)
+{
+  switch (contentType) {
+    case ContentType::PROTOBUF: {
+      // NOTE: We use 'SerializePartialAsString' for the same reason
+      // as when evolving the message, see above.
+      return message.SerializePartialAsString();
+    }
+    case ContentType::JSON: {
+      return jsonify(JSON::Protobuf(evolve<T>(message)));
+    }
+  }
+
+  UNREACHABLE();
+}
+
+
+string serialize(
+    ContentType contentType,
+    const mesos::agent::Response& response)
+{
+  return serialize<v1::agent::Response>(contentType, response);
+}
+
+
+string serialize(
+    ContentType contentType,
+    const mesos::master::Response& response)
+{
+  return serialize<v1::master::Response>(contentType, response);
+}
+
+
+string serialize(
+    ContentType contentType,
+    const mesos::master::Event& event)
+{
+  return serialize<v1::master::Event>(contentType, event);
+}
+
+
+string serialize(
+    ContentType contentType,
+    const scheduler::Event& event)
+{
+  return serialize<v1::scheduler::Event>(contentType, event);
+}
+
+
+string serialize(
+    ContentType contentType,
+    const mesos::executor::Event& event)
+{
+  return serialize<v1::executor::Event>(contentType, event);
+}
+
 } // namespace internal {
 } // namespace mesos {
@@ -17,9 +17,12 @@
 #ifndef __INTERNAL_EVOLVE_HPP__
 #define __INTERNAL_EVOLVE_HPP__
 
+#include <string>
+
 #include <google/protobuf/message.h>
 
 #include <mesos/agent/agent.hpp>
+#include <mesos/http.hpp>
 
 #include <mesos/mesos.hpp>
 
@@ -82,12 +85,14 @@ v1::scheduler::Call evolve(const scheduler::Call& call);
 // Helper for repeated field evolving to 'T1' from 'T2'.
 template <typename T1, typename T2>
 google::protobuf::RepeatedPtrField<T1> evolve(
-    google::protobuf::RepeatedPtrField<T2> t2s)
+    const google::protobuf::RepeatedPtrField<T2>& t2s)
 {
   google::protobuf::RepeatedPtrField<T1> t1s;
+  t1s.Reserve(t2s.size());
 
   foreach (const T2& t2, t2s) {
-    t1s.Add()->CopyFrom(evolve(t2));
+    T1 t1 = evolve(t2);
+    t1s.Add()->Swap(&t1);
   }
 
   return t1s;
@@ -155,6 +160,32 @@ v1::agent::Response evolve(const JSON::Object& object);
 template <v1::agent::Response::Type T>
 v1::agent::Response evolve(const JSON::Array& array);
 
+
+// Helpers for serializing internal messages as the v1 messages they
+// evolve to. The internal and v1 messages have the same wire format,
+// so for protobuf the internal message is serialized as is, without
+// evolving it first. Only JSON, whose field names differ between the
+// versions, requires evolving the message.
+std::string serialize(
+    ContentType contentType,
+    const mesos::agent::Response& response);
+
+std::string serialize(
+    ContentType contentType,
+    const mesos::master::Response& response);
+
+std::string serialize(
+    ContentType contentType,
+    const mesos::master::Event& event);
+
+std::string serialize(
+    ContentType contentType,
+    const scheduler::Event& event);
+
+std::string serialize(
+    ContentType contentType,
+    const mesos::executor::Event& event);
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -18,6 +18,7 @@
 #include <stdlib.h>
 
 #include <set>
+#include <vector>
 
 #include <process/defer.hpp>
 #include <process/delay.hpp>
@@ -37,6 +38,7 @@
 using namespace process;
 
 using std::set;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -432,6 +434,37 @@ private:
 };
 
 
+static WriteRequest createWriteRequest(uint64_t proposal, const Action& action)
+{
+  WriteRequest request;
+  request.set_proposal(proposal);
+  request.set_position(action.position());
+  request.set_type(action.type());
+  switch (action.type()) {
+    case Action::NOP:
+      CHECK(action.has_nop());
+      request.mutable_nop();
+      break;
+    case Action::APPEND:
+      CHECK(action.has_append());
+      request.mutable_append()->CopyFrom(action.append());
+      break;
+    case Action::TRUNCATE:
+      CHECK(action.has_truncate());
+      request.mutable_truncate()->CopyFrom(action.truncate());
+      break;
+    default:
+      LOG(FATAL) << "Unknown Action::Type " << action.type();
+  }
+
+  return request;
+}
+
+
+// Runs the write phase for one or more actions. A single action is
+// written using a WriteRequest. Multiple actions are written using a
+// single BatchWriteRequest, in which case each replica votes once for
+// the whole batch (see 'batched' below).
 class WriteProcess : public Process<WriteProcess>
 {
 public:
@@ -439,14 +472,17 @@ public:
       size_t _quorum,
       const Shared<Network>& _network,
       uint64_t _proposal,
-      const Action& _action)
+      const vector<Action>& _actions)
     : ProcessBase(ID::generate("log-write")),
       quorum(_quorum),
       network(_network),
       proposal(_proposal),
-      action(_action),
+      actions(_actions),
       responsesReceived(0),
-      ignoresReceived(0) {}
+      ignoresReceived(0)
+  {
+    CHECK(!actions.empty());
+  }
 
   virtual ~WriteProcess() {}
 
@@ -472,6 +508,7 @@ protected:
     // quorum of replicas. In that case, we no longer care about
     // responses from other replicas, thus discarding them here.
     discard(responses);
+    discard(batchResponses);
 
     promise.discard();
   }
@@ -491,28 +528,21 @@ private:
 
     CHECK_GE(future.get(), quorum);
 
-    request.set_proposal(proposal);
-    request.set_position(action.position());
-    request.set_type(action.type());
-    switch (action.type()) {
-      case Action::NOP:
-        CHECK(action.has_nop());
-        request.mutable_nop();
-        break;
-      case Action::APPEND:
-        CHECK(action.has_append());
-        request.mutable_append()->CopyFrom(action.append());
-        break;
-      case Action::TRUNCATE:
-        CHECK(action.has_truncate());
-        request.mutable_truncate()->CopyFrom(action.truncate());
-        break;
-      default:
-        LOG(FATAL) << "Unknown Action::Type " << action.type();
+    if (actions.size() == 1) {
+      network->broadcast(
+          protocol::write,
+          createWriteRequest(proposal, actions.front()))
+        .onAny(defer(self(), &Self::broadcasted, lambda::_1));
+      return;
     }
 
-    network->broadcast(protocol::write, request)
-      .onAny(defer(self(), &Self::broadcasted, lambda::_1));
+    BatchWriteRequest request;
+    foreach (const Action& action, actions) {
+      request.add_requests()->CopyFrom(createWriteRequest(proposal, action));
+    }
+
+    network->broadcast(protocol::batchWrite, request)
+      .onAny(defer(self(), &Self::batchBroadcasted, lambda::_1));
   }
 
   void broadcasted(const Future<set<Future<WriteResponse> > >& future)
@@ -532,9 +562,59 @@ private:
     }
   }
 
+  void batchBroadcasted(
+      const Future<set<Future<BatchWriteResponse> > >& future)
+  {
+    if (!future.isReady()) {
+      promise.fail(
+          future.isFailed() ?
+          "Failed to broadcast the batch write request: " + future.failure() :
+          "Not expecting discarded future");
+      terminate(self());
+      return;
+    }
+
+    batchResponses = future.get();
+    foreach (const Future<BatchWriteResponse>& response, batchResponses) {
+      response.onReady(defer(self(), &Self::batched, lambda::_1));
+    }
+  }
+
+  // Converts the responses of a replica to a batch write request into
+  // a single vote: the replica rejects the batch if it rejects any of
+  // the writes, ignores the batch if it ignores any of the writes, and
+  // accepts the batch otherwise.
+  void batched(const BatchWriteResponse& responses)
+  {
+    CHECK_EQ(static_cast<size_t>(responses.responses_size()), actions.size());
+
+    WriteResponse vote;
+    vote.set_type(WriteResponse::ACCEPT);
+    vote.set_okay(true);
+    vote.set_proposal(proposal);
+    vote.set_position(actions.front().position());
+
+    foreach (const WriteResponse& response, responses.responses()) {
+      if (isRejectedWrite(response)) {
+        if (vote.type() != WriteResponse::REJECT ||
+            vote.proposal() < response.proposal()) {
+          vote.set_proposal(response.proposal());
+        }
+        vote.set_type(WriteResponse::REJECT);
+        vote.set_okay(false);
+      } else if (response.type() == WriteResponse::IGNORE &&
+                 vote.type() == WriteResponse::ACCEPT) {
+        vote.set_type(WriteResponse::IGNORE);
+        vote.set_okay(false);
+      }
+    }
+
+    received(vote);
+  }
+
   void received(const WriteResponse& response)
   {
-    CHECK_EQ(response.position(), request.position());
+    CHECK_EQ(response.position(), actions.front().position());
 
     if (response.has_type() && response.type() == WriteResponse::IGNORE) {
       ignoresReceived++;
@@ -590,10 +670,10 @@ private:
   const size_t quorum;
   const Shared<Network> network;
   const uint64_t proposal;
-  const Action action;
+  const vector<Action> actions;
 
-  WriteRequest request;
   set<Future<WriteResponse> > responses;
+  set<Future<BatchWriteResponse> > batchResponses;
   size_t responsesReceived;
   size_t ignoresReceived;
   Option<uint64_t> highestNackProposal;
@@ -829,13 +909,23 @@ Future<WriteResponse> write(
     const Shared<Network>& network,
     uint64_t proposal,
     const Action& action)
+{
+  return write(quorum, network, proposal, vector<Action>(1, action));
+}
+
+
+Future<WriteResponse> write(
+    size_t quorum,
+    const Shared<Network>& network,
+    uint64_t proposal,
+    const vector<Action>& actions)
 {
   WriteProcess* process =
     new WriteProcess(
         quorum,
         network,
         proposal,
-        action);
+        actions);
 
   Future<WriteResponse> future = process->future();
   spawn(process, true);
@@ -856,6 +946,25 @@ Future<Nothing> learn(const Shared<Network>& network, const Action& action)
 }
 
 
+Future<Nothing> learn(
+    const Shared<Network>& network,
+    const vector<Action>& actions)
+{
+  if (actions.size() == 1) {
+    return learn(network, actions.front());
+  }
+
+  BatchLearnedMessage message;
+  foreach (const Action& action, actions) {
+    Action* learned = message.add_actions();
+    learned->CopyFrom(action);
+    learned->set_learned(true);
+  }
+
+  return network->broadcast(message);
+}
+
+
 Future<Action> fill(
     size_t quorum,
     const Shared<Network>& network,
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <process/future.hpp>
 #include <process/shared.hpp>
 
@@ -102,6 +104,19 @@ extern process::Future<WriteResponse> write(
     const Action& action);
 
 
+// Runs the write phase for the given actions (at distinct positions)
+// using a single round of messages. A replica accepts the batch only
+// if it accepts the writes of all the actions; otherwise the result
+// is the same as if a single action was rejected (or ignored). A
+// batch of a single action uses the same messages as above, which
+// allows talking to replicas that do not support batched writes.
+extern process::Future<WriteResponse> write(
+    size_t quorum,
+    const process::Shared<Network>& network,
+    uint64_t proposal,
+    const std::vector<Action>& actions);
+
+
 // Runs the learn phase (a.k.a, the commit phase) in Paxos. In fact,
 // this phase is not required, but treated as an optimization. In this
 // phase, a proposer broadcasts a learned message to replicas,
@@ -113,6 +128,12 @@ extern process::Future<Nothing> learn(
     const Action& action);
 
 
+// Broadcasts a single learned message for all the given actions.
+extern process::Future<Nothing> learn(
+    const process::Shared<Network>& network,
+    const std::vector<Action>& actions);
+
+
 // Tries to reach consensus for the given log position by running a
 // full Paxos round (i.e., promise -> write -> learn). If no value has
 // been previously agreed on for the given log position, a NOP will be
@@ -17,12 +17,15 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
 #include <stout/none.hpp>
@@ -35,12 +38,20 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// Maximum number of writes the coordinator keeps in flight. Writes
+// issued while this many writes are in flight wait for the earliest
+// one to be learned.
+static const size_t MAX_PIPELINED_WRITES = 32;
+
+
 class CoordinatorProcess : public Process<CoordinatorProcess>
 {
 public:
@@ -54,7 +65,8 @@ public:
       network(_network),
       state(INITIAL),
       proposal(0),
-      index(0) {}
+      index(0),
+      writes(0) {}
 
   virtual ~CoordinatorProcess() {}
 
@@ -63,12 +75,23 @@ public:
   Future<uint64_t> demote();
   Future<Option<uint64_t> > append(const string& bytes);
   Future<Option<uint64_t> > truncate(uint64_t to);
+  Future<Option<uint64_t> > write(const vector<Action>& actions);
 
 protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreach (const Owned<Write>& write, pipeline) {
+      write->response.discard();
+      write->promise.discard();
+    }
+    pipeline.clear();
+
+    foreach (const Owned<Write>& write, waiting) {
+      write->promise.discard();
+    }
+    waiting.clear();
   }
 
 private:
@@ -92,17 +115,23 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
-  Future<Option<uint64_t> > write(const Action& action);
-  Future<WriteResponse> runWritePhase(const Action& action);
-  Future<Option<uint64_t> > checkWritePhase(
-      const Action& action,
-      const WriteResponse& response);
-  Future<Nothing> runLearnPhase(const Action& action);
-  Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  // A write of one or more actions to consecutive positions.
+  struct Write
+  {
+    uint64_t id;
+    vector<Action> actions;
+    Future<WriteResponse> response;
+    bool learning;
+    process::Promise<Option<uint64_t> > promise;
+  };
+
+  void runWritePhase(const Owned<Write>& write);
+  void checkWritePhase();
+  Future<Nothing> runLearnPhase(const vector<Action>& actions);
+  Future<bool> checkLearnPhase(const vector<Action>& actions);
+  void checkLearned(uint64_t position, const Future<bool>& missing);
+  void writingDiscarded(uint64_t id);
+  void writingAborted(const Option<string>& failure);
 
   const size_t quorum;
   const Shared<Replica> replica;
@@ -115,7 +144,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // while it has writes in flight.
   enum
   {
     INITIAL,
@@ -131,7 +161,19 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // The writes in flight, in the order of their positions, which are
+  // assigned when a write enters the pipeline. The write phases of
+  // these writes run concurrently, but each write is only learned
+  // (and completed) after all the preceding writes were accepted,
+  // so a write never completes before the writes issued before it.
+  deque<Owned<Write> > pipeline;
+
+  // The writes waiting for room in the pipeline.
+  deque<Owned<Write> > waiting;
+
+  // The number of writes issued, used to identify them.
+  uint64_t writes;
 };
 
 
@@ -305,136 +347,251 @@ Future<uint64_t> CoordinatorProcess::demote()
 
 Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
 {
-  if (state == INITIAL || state == ELECTING) {
-    return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
-  }
-
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::APPEND);
   Action::Append* append = action.mutable_append();
   append->set_bytes(bytes);
 
-  return write(action);
+  return write(vector<Action>(1, action));
 }
 
 
 Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
-  if (state == INITIAL || state == ELECTING) {
-    return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
-  }
-
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
   Action::Truncate* truncate = action.mutable_truncate();
   truncate->set_to(to);
 
-  return write(action);
+  return write(vector<Action>(1, action));
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
+Future<Option<uint64_t> > CoordinatorProcess::write(
+    const vector<Action>& actions)
 {
-  LOG(INFO) << "Coordinator attempting to write " << action.type()
-            << " action at position " << action.position();
+  if (state == INITIAL || state == ELECTING) {
+    return None();
+  } else if (actions.empty()) {
+    return Failure("No actions to write");
+  }
 
-  CHECK_EQ(state, ELECTED);
-  CHECK(action.has_performed() && action.has_type());
+  CHECK(state == ELECTED || state == WRITING);
+
+  Owned<Write> write(new Write());
+  write->id = writes++;
+  write->actions = actions;
+  write->learning = false;
+
+  // Demote the coordinator if a write in flight is discarded since we
+  // don't actually know whether the write was successful or not and
+  // we really need to "catch-up" that position before we try and do
+  // another write (see MESOS-1038 for more details).
+  write->promise.future()
+    .onDiscard(defer(self(), &Self::writingDiscarded, write->id));
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  if (pipeline.size() < MAX_PIPELINED_WRITES) {
+    runWritePhase(write);
+  } else {
+    waiting.push_back(write);
+  }
 
-  return writing;
+  return write->promise.future();
 }
 
 
-Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
+void CoordinatorProcess::runWritePhase(const Owned<Write>& write)
 {
-  return log::write(quorum, network, proposal, action);
+  // Write the actions to consecutive positions starting at 'index'.
+  for (size_t i = 0; i < write->actions.size(); i++) {
+    Action& action = write->actions[i];
+
+    CHECK(action.has_type());
+
+    action.set_position(index + i);
+    action.set_promised(proposal);
+    action.set_performed(proposal);
+  }
+
+  LOG(INFO) << "Coordinator attempting to write " << write->actions.size()
+            << " action(s) at position " << index;
+
+  index += write->actions.size();
+
+  write->response = log::write(quorum, network, proposal, write->actions);
+  write->response
+    .onAny(defer(self(), &Self::checkWritePhase));
+
+  pipeline.push_back(write);
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
-    const Action& action,
-    const WriteResponse& response)
+void CoordinatorProcess::checkWritePhase()
 {
-  if (!response.okay()) {
-    // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
-
-    return None();
+  // Start the learn phases of the accepted writes in order, stopping
+  // at the first write whose write phase is still in flight.
+  foreach (const Owned<Write>& write, pipeline) {
+    if (write->learning) {
+      continue;
+    } else if (write->response.isPending()) {
+      break;
+    }
+
+    if (write->response.isDiscarded()) {
+      writingAborted(None());
+      return;
+    } else if (write->response.isFailed()) {
+      writingAborted(write->response.failure());
+      return;
+    }
+
+    const WriteResponse& response = write->response.get();
+
+    if (!response.okay()) {
+      // Received a NACK. Save the proposal number.
+      CHECK_LE(proposal, response.proposal());
+      proposal = response.proposal();
+
+      writingAborted(None());
+      return;
+    }
+
+    write->learning = true;
+
+    runLearnPhase(write->actions)
+      .then(defer(self(), &Self::checkLearnPhase, write->actions))
+      .onAny(defer(self(),
+                   &Self::checkLearned,
+                   write->actions.front().position(),
+                   lambda::_1));
   }
-
-  return runLearnPhase(action)
-    .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
 }
 
 
-Future<Nothing> CoordinatorProcess::runLearnPhase(const Action& action)
+Future<Nothing> CoordinatorProcess::runLearnPhase(
+    const vector<Action>& actions)
 {
-  return log::learn(network, action);
+  return log::learn(network, actions);
 }
 
 
-Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
+Future<bool> CoordinatorProcess::checkLearnPhase(
+    const vector<Action>& actions)
 {
   // Make sure that the local replica has learned the newly written
-  // log entry. Since messages are delivered and dispatched in order
-  // locally, we should always have the new entry learned by now.
-  return replica->missing(action.position());
+  // log entries. Since messages are delivered and dispatched in order
+  // locally, we should always have the new entries learned by now.
+  return replica->missing(actions.back().position());
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
-    bool missing)
+void CoordinatorProcess::checkLearned(
+    uint64_t position,
+    const Future<bool>& missing)
 {
-  CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+  // The pipeline is cleared if the coordinator is demoted while the
+  // write is being learned.
+  if (pipeline.empty() ||
+      pipeline.front()->actions.front().position() != position) {
+    return;
+  }
 
-  return index++;
-}
+  // The learn phases are started in order and, since messages are
+  // delivered and dispatched in order, they also finish in order.
+  Owned<Write> write = pipeline.front();
+  CHECK(write->learning);
+
+  if (!missing.isReady()) {
+    writingAborted(
+        missing.isFailed()
+          ? missing.failure()
+          : Option<string>::none());
+    return;
+  }
 
+  CHECK(!missing.get())
+    << "Not expecting local replica to be missing position "
+    << write->actions.back().position() << " after the writing is done";
 
-void CoordinatorProcess::writingFinished()
-{
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  pipeline.pop_front();
+
+  write->promise.set(Option<uint64_t>(position));
+
+  while (!waiting.empty() && pipeline.size() < MAX_PIPELINED_WRITES) {
+    runWritePhase(waiting.front());
+    waiting.pop_front();
+  }
+
+  if (pipeline.empty()) {
+    CHECK_EQ(state, WRITING);
+    state = ELECTED;
+  }
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::writingDiscarded(uint64_t id)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  // A write that is still waiting for room in the pipeline has not
+  // been written to any position, so it can simply be dropped.
+  for (auto it = waiting.begin(); it != waiting.end(); ++it) {
+    if ((*it)->id == id) {
+      (*it)->promise.discard();
+      waiting.erase(it);
+      return;
+    }
+  }
+
+  // By the time the discard is dispatched, the write might already
+  // have completed, or the coordinator might have been demoted (and
+  // even elected again). Only a write that is still in flight demotes
+  // the coordinator, rather than aborting unrelated writes.
+  foreach (const Owned<Write>& write, pipeline) {
+    if (write->id == id) {
+      writingAborted(None());
+      return;
+    }
+  }
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::writingAborted(const Option<string>& failure)
 {
-  CHECK_EQ(state, WRITING);
+  if (state != WRITING) {
+    return;
+  }
 
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
+  // Demote the coordinator since the positions of the writes in
+  // flight might or might not have been written, and need to be
+  // "caught-up" before another write can be done. Writes that were
+  // discarded stay discarded, the others return none (or the failure
+  // that caused the demotion).
+  //
+  // NOTE: None of these writes is learned by this coordinator, but
+  // the writes that follow a rejected one might still have been
+  // accepted by a quorum. The next elected coordinator then learns
+  // them, so the log may end up containing a write without some of
+  // the writes issued before it (whose positions are filled with
+  // no-ops).
   state = INITIAL;
+
+  deque<Owned<Write> > aborted;
+  std::swap(aborted, pipeline);
+  aborted.insert(aborted.end(), waiting.begin(), waiting.end());
+  waiting.clear();
+
+  foreach (const Owned<Write>& write, aborted) {
+    write->response.discard();
+
+    if (write->promise.future().hasDiscard()) {
+      write->promise.discard();
+    } else if (failure.isSome()) {
+      write->promise.fail(failure.get());
+    } else {
+      write->promise.set(Option<uint64_t>::none());
+    }
+  }
 }
 
 
@@ -484,6 +641,12 @@ Future<Option<uint64_t> > Coordinator::truncate(uint64_t to)
   return dispatch(process, &CoordinatorProcess::truncate, to);
 }
 
+
+Future<Option<uint64_t> > Coordinator::write(const vector<Action>& actions)
+{
+  return dispatch(process, &CoordinatorProcess::write, actions);
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
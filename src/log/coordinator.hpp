@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/shared.hpp>
@@ -61,6 +62,15 @@ public:
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
   // if the coordinator was demoted.
+  //
+  // NOTE: Writes (appends and truncates) can be issued without
+  // waiting for the previous ones. They are written to consecutive
+  // positions in the order they were issued, with a bounded number of
+  // them in flight, and each of them completes only after all the
+  // writes issued before it. If a write fails or the coordinator is
+  // demoted, all the writes in flight return the failure (or none),
+  // although some of them might still end up in the log, even if a
+  // write issued before them does not.
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -69,6 +79,13 @@ public:
   // coordinator was demoted.
   process::Future<Option<uint64_t> > truncate(uint64_t to);
 
+  // Writes the specified actions (appends and/or truncates, which
+  // only need their type and payload set) to consecutive positions
+  // at the end of the log, using a single round of the write and
+  // learn phases. Returns the position of the first action if the
+  // operation succeeds or none if the coordinator was demoted.
+  process::Future<Option<uint64_t> > write(const std::vector<Action>& actions);
+
 private:
   CoordinatorProcess* process;
 };
@@ -24,7 +24,9 @@
 #include <stdint.h>
 
 #include <stout/check.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -126,19 +128,71 @@ static string encode(uint64_t position, bool adjust = true)
 // }
 
 
+// The key of the summary record. Note that it sorts after the keys of
+// all positions (see 'encode' above).
+static const char SUMMARY_KEY[] = "summary";
+
+
+// Maximum number of (learned and unlearned) intervals in the summary.
+// A log with more intervals (i.e., with lots of holes) is restored by
+// reading all of its records instead.
+static const size_t MAX_SUMMARY_INTERVALS = 1024;
+
+
+// Minimum time between two compactions of truncated positions.
+static const Duration COMPACTION_INTERVAL = Minutes(10);
+
+
 LevelDBStorage::LevelDBStorage()
-  : db(nullptr), first(None())
+  : db(nullptr),
+    first(None()),
+    begin(0),
+    end(0),
+    compacting(false)
 {
-  // Nothing to see here.
+  compacted.start();
 }
 
 
 LevelDBStorage::~LevelDBStorage()
 {
+  // Wait for the compaction (if any) before closing the database.
+  if (compactor.joinable()) {
+    compactor.join();
+  }
+
   delete db; // Might be null if open failed in LevelDBStorage::restore.
 }
 
 
+static Try<Record> parse(const leveldb::Slice& slice)
+{
+  google::protobuf::io::ArrayInputStream stream(slice.data(), slice.size());
+
+  Record record;
+
+  if (!record.ParseFromZeroCopyStream(&stream)) {
+    return Error("Failed to deserialize record");
+  }
+
+  return record;
+}
+
+
+static IntervalSet<uint64_t> intervals(
+    const google::protobuf::RepeatedPtrField<Summary::Interval>& intervals)
+{
+  IntervalSet<uint64_t> result;
+
+  foreach (const Summary::Interval& interval, intervals) {
+    result += (Bound<uint64_t>::closed(interval.start()),
+               Bound<uint64_t>::open(interval.end()));
+  }
+
+  return result;
+}
+
+
 Try<Storage::State> LevelDBStorage::restore(const string& path)
 {
   leveldb::Options options;
@@ -173,17 +227,88 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   LOG(INFO) << "Opened db in " << stopwatch.elapsed();
 
+  State state;
+  state.begin = 0;
+  state.end = 0;
+  state.records = 0;
+
+  stopwatch.start(); // Restart the stopwatch.
+
+  // If the log has a summary, we only need to read the summary and
+  // the metadata (or the deprecated promise) records.
+  string value;
+  status = db->Get(leveldb::ReadOptions(), SUMMARY_KEY, &value);
+
+  if (status.ok()) {
+    Try<Record> record = parse(value);
+
+    if (record.isError() ||
+        record->type() != Record::SUMMARY ||
+        !record->has_summary()) {
+      LOG(WARNING) << "Ignoring bad summary record in the db";
+    } else {
+      state.records++;
+
+      const Summary& summary = record->summary();
+
+      state.begin = summary.begin();
+      state.end = summary.end();
+      state.learned = intervals(summary.learned());
+      state.unlearned = intervals(summary.unlearned());
+
+      if (summary.has_first()) {
+        first = summary.first();
+      }
+
+      status = db->Get(leveldb::ReadOptions(), encode(0, false), &value);
+
+      if (status.ok()) {
+        state.records++;
+
+        record = parse(value);
+
+        if (record.isError()) {
+          return Error(record.error());
+        }
+
+        if (record->type() == Record::METADATA) {
+          CHECK(record->has_metadata());
+          state.metadata.CopyFrom(record->metadata());
+        } else if (record->type() == Record::PROMISE) {
+          // DEPRECATED! See below.
+          CHECK(record->has_promise());
+          state.metadata.set_status(Metadata::VOTING);
+          state.metadata.set_promised(record->promise().proposal());
+        } else {
+          return Error("Bad record");
+        }
+      } else if (!status.IsNotFound()) {
+        return Error(status.ToString());
+      }
+
+      begin = state.begin;
+      end = state.end;
+      learned = state.learned;
+      unlearned = state.unlearned;
+
+      LOG(INFO) << "Restored the summary of the db in " << stopwatch.elapsed();
+
+      return state;
+    }
+  } else if (!status.IsNotFound()) {
+    return Error(status.ToString());
+  }
+
+  // Otherwise (i.e., the log was written by an older version or has
+  // too many holes) we have to iterate through the db, which we
+  // compact first. Logs that keep a summary only get their truncated
+  // positions compacted, in the background (see 'compact').
   stopwatch.start(); // Restart the stopwatch.
 
-  // TODO(benh): Conditionally compact to avoid long recovery times?
   db->CompactRange(nullptr, nullptr);
 
   LOG(INFO) << "Compacted db in " << stopwatch.elapsed();
 
-  State state;
-  state.begin = 0;
-  state.end = 0;
-
   // TODO(benh): Consider just reading the "promise" record (e.g.,
   // 'encode(0, false)') and then iterating over the rest of the
   // records and confirming that they are all indeed of type
@@ -207,16 +332,16 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   while (iterator->Valid()) {
     keys++;
-    const leveldb::Slice& slice = iterator->value();
-
-    google::protobuf::io::ArrayInputStream stream(slice.data(), slice.size());
 
-    Record record;
+    Try<Record> _record = parse(iterator->value());
 
-    if (!record.ParseFromZeroCopyStream(&stream)) {
-      return Error("Failed to deserialize record");
+    if (_record.isError()) {
+      delete iterator;
+      return Error(_record.error());
     }
 
+    const Record& record = _record.get();
+
     switch (record.type()) {
       case Record::METADATA: {
         CHECK(record.has_metadata());
@@ -260,7 +385,13 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
         break;
       }
 
+      // An unreadable summary, which we rewrite below.
+      case Record::SUMMARY: {
+        break;
+      }
+
       default: {
+        delete iterator;
         return Error("Bad record");
       }
     }
@@ -273,6 +404,26 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   delete iterator;
 
+  state.records = keys;
+
+  begin = state.begin;
+  end = state.end;
+  learned = state.learned;
+  unlearned = state.unlearned;
+
+  // Persist the summary so that the next restore does not need to
+  // iterate through the db. This is best-effort since we can always
+  // iterate through the db again.
+  leveldb::WriteBatch batch;
+  summarize(&batch);
+
+  Try<Nothing> written = write(&batch);
+
+  if (written.isError()) {
+    LOG(WARNING) << "Failed to persist the summary of the db: "
+                 << written.error();
+  }
+
   return state;
 }
 
@@ -308,11 +459,10 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 }
 
 
-Try<Nothing> LevelDBStorage::persist(const Action& action)
+Try<size_t> LevelDBStorage::add(
+    leveldb::WriteBatch* batch,
+    const Action& action)
 {
-  Stopwatch stopwatch;
-  stopwatch.start();
-
   Record record;
   record.set_type(Record::ACTION);
   record.mutable_action()->MergeFrom(action);
@@ -323,24 +473,136 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     return Error("Failed to serialize record");
   }
 
+  batch->Put(encode(action.position()), value);
+
+  return value.size();
+}
+
+
+Try<Nothing> LevelDBStorage::write(leveldb::WriteBatch* batch)
+{
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  leveldb::Status status = db->Write(options, batch);
 
   if (!status.ok()) {
     return Error(status.ToString());
   }
 
-  // Updated the first position. Notice that we use 'min' here instead
+  return Nothing();
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  leveldb::WriteBatch batch;
+
+  Try<size_t> size = add(&batch, action);
+
+  if (size.isError()) {
+    return Error(size.error());
+  }
+
+  // Update the summary along with the action, restoring the previous
+  // summary if the write fails.
+  const uint64_t _begin = begin;
+  const uint64_t _end = end;
+  const IntervalSet<uint64_t> _learned = learned;
+  const IntervalSet<uint64_t> _unlearned = unlearned;
+  const Option<uint64_t> _first = first;
+
+  // Update the first position. Notice that we use 'min' here instead
   // of checking 'isNone()' because it's likely that log entries are
   // written out of order during catch-up (e.g. if a random bulk
   // catch-up policy is used).
   first = min(first, action.position());
 
-  LOG(INFO) << "Persisting action (" << value.size()
+  update(action);
+  summarize(&batch);
+
+  Try<Nothing> written = write(&batch);
+
+  if (written.isError()) {
+    begin = _begin;
+    end = _end;
+    learned = _learned;
+    unlearned = _unlearned;
+    first = _first;
+    return Error(written.error());
+  }
+
+  LOG(INFO) << "Persisting action (" << size.get()
+            << " bytes) to leveldb took " << stopwatch.elapsed();
+
+  truncate(action);
+
+  return Nothing();
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const std::vector<Action>& actions)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // We persist all the actions with a single synchronous write, which
+  // is what makes committing a group of actions cheaper than
+  // persisting them one by one.
+  leveldb::WriteBatch batch;
+
+  size_t bytes = 0;
+
+  foreach (const Action& action, actions) {
+    Try<size_t> size = add(&batch, action);
+
+    if (size.isError()) {
+      return Error(size.error());
+    }
+
+    bytes += size.get();
+  }
+
+  const uint64_t _begin = begin;
+  const uint64_t _end = end;
+  const IntervalSet<uint64_t> _learned = learned;
+  const IntervalSet<uint64_t> _unlearned = unlearned;
+  const Option<uint64_t> _first = first;
+
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+    update(action);
+  }
+
+  summarize(&batch);
+
+  Try<Nothing> written = write(&batch);
+
+  if (written.isError()) {
+    begin = _begin;
+    end = _end;
+    learned = _learned;
+    unlearned = _unlearned;
+    first = _first;
+    return Error(written.error());
+  }
+
+  LOG(INFO) << "Persisting " << actions.size() << " actions (" << bytes
             << " bytes) to leveldb took " << stopwatch.elapsed();
 
+  foreach (const Action& action, actions) {
+    truncate(action);
+  }
+
+  return Nothing();
+}
+
+
+void LevelDBStorage::truncate(const Action& action)
+{
   // Delete positions if a truncate action has been *learned*. Note
   // that we do this in a best-effort fashion (i.e., we ignore any
   // failures to the database since we can always try again).
@@ -348,7 +610,8 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
 
-    stopwatch.start(); // Restart the stopwatch.
+    Stopwatch stopwatch;
+    stopwatch.start();
 
     // To actually perform the truncation in leveldb we need to remove
     // all the keys that represent positions no longer in the log. We
@@ -385,24 +648,140 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
 
     // If we added any positions, attempt to delete them!
     if (index > 0) {
+      // The deleted positions are no longer in the summary.
+      const IntervalSet<uint64_t> _learned = learned;
+      const IntervalSet<uint64_t> _unlearned = unlearned;
+      const Option<uint64_t> _first = first;
+
+      const IntervalSet<uint64_t> deleted(
+          Bound<uint64_t>::closed(0),
+          Bound<uint64_t>::open(action.truncate().to()));
+
+      learned -= deleted;
+      unlearned -= deleted;
+      first = action.truncate().to();
+
+      summarize(&batch);
+
       // We do this write asynchronously (e.g., using default options).
       leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
 
       if (!status.ok()) {
         LOG(WARNING) << "Ignoring leveldb batch delete failure: "
                      << status.ToString();
+
+        learned = _learned;
+        unlearned = _unlearned;
+        first = _first;
       } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
+        CHECK_LT(_first.get(), first.get());
+
+        uncompacted = min(uncompacted, _first.get());
 
         LOG(INFO) << "Deleting ~" << index
                   << " keys from leveldb took " << stopwatch.elapsed();
+
+        compact();
       }
     }
   }
+}
 
-  return Nothing();
+
+void LevelDBStorage::update(const Action& action)
+{
+  // NOTE: This mirrors how the positions are restored when iterating
+  // through the db in 'restore'.
+  if (action.has_learned() && action.learned()) {
+    learned += action.position();
+    unlearned -= action.position();
+    if (action.has_type() && action.type() == Action::TRUNCATE) {
+      begin = std::max(begin, action.truncate().to());
+    }
+  } else {
+    learned -= action.position();
+    unlearned += action.position();
+  }
+
+  end = std::max(end, action.position());
+}
+
+
+void LevelDBStorage::summarize(leveldb::WriteBatch* batch)
+{
+  if (learned.intervalCount() + unlearned.intervalCount() >
+      MAX_SUMMARY_INTERVALS) {
+    batch->Delete(SUMMARY_KEY);
+    return;
+  }
+
+  Record record;
+  record.set_type(Record::SUMMARY);
+
+  Summary* summary = record.mutable_summary();
+  summary->set_begin(begin);
+  summary->set_end(end);
+
+  if (first.isSome()) {
+    summary->set_first(first.get());
+  }
+
+  foreach (const Interval<uint64_t>& interval, learned) {
+    Summary::Interval* _interval = summary->add_learned();
+    _interval->set_start(interval.lower());
+    _interval->set_end(interval.upper());
+  }
+
+  foreach (const Interval<uint64_t>& interval, unlearned) {
+    Summary::Interval* _interval = summary->add_unlearned();
+    _interval->set_start(interval.lower());
+    _interval->set_end(interval.upper());
+  }
+
+  string value;
+  CHECK(record.SerializeToString(&value));
+
+  batch->Put(SUMMARY_KEY, value);
+}
+
+
+void LevelDBStorage::compact()
+{
+  CHECK_SOME(first);
+
+  if (uncompacted.isNone() ||
+      compacting.load() ||
+      compacted.elapsed() < COMPACTION_INTERVAL) {
+    return;
+  }
+
+  // Reap the previous compaction, which has finished.
+  if (compactor.joinable()) {
+    compactor.join();
+  }
+
+  const string from = encode(uncompacted.get());
+  const string to = encode(first.get());
+
+  uncompacted = None();
+
+  compacting.store(true);
+  compacted.start();
+
+  compactor = std::thread([=]() {
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    const leveldb::Slice begin(from);
+    const leveldb::Slice end(to);
+
+    db->CompactRange(&begin, &end);
+
+    LOG(INFO) << "Compacted truncated positions in leveldb in "
+              << stopwatch.elapsed();
+
+    compacting.store(false);
+  });
 }
 
 
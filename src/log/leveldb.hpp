@@ -21,7 +21,15 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <leveldb/write_batch.h>
+
+#include <stout/interval.hpp>
 #include <stout/option.hpp>
+#include <stout/stopwatch.hpp>
 
 #include "log/storage.hpp"
 
@@ -39,13 +47,51 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Adds the specified action to the batch. Returns the size of the
+  // serialized record.
+  static Try<size_t> add(leveldb::WriteBatch* batch, const Action& action);
+
+  // Synchronously writes the batch.
+  Try<Nothing> write(leveldb::WriteBatch* batch);
+
+  // Deletes the positions preceding the action if it is a learned
+  // truncate action.
+  void truncate(const Action& action);
+
+  // Updates the summary of the log after persisting the action.
+  void update(const Action& action);
+
+  // Adds the summary of the log to the batch, or removes the summary
+  // from leveldb if it has grown too large to be worth keeping.
+  void summarize(leveldb::WriteBatch* batch);
+
+  // Compacts the positions deleted by truncations in the background,
+  // unless a compaction is already running or has run recently.
+  void compact();
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // The summary of the log, which is persisted along with every
+  // action so that the log can be restored without a full scan.
+  uint64_t begin;
+  uint64_t end;
+  IntervalSet<uint64_t> learned;
+  IntervalSet<uint64_t> unlearned;
+
+  // For compacting truncated positions in the background. Leveldb
+  // supports concurrent operations, so the compaction can run while
+  // the replica keeps writing.
+  std::thread compactor;
+  std::atomic_bool compacting;
+  Stopwatch compacted; // Time since the last compaction started.
+  Option<uint64_t> uncompacted; // First deleted, uncompacted position.
 };
 
 } // namespace log {
@@ -18,9 +18,13 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <mesos/log/log.hpp>
 
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
@@ -46,6 +50,7 @@ using namespace process;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using mesos::log::Log;
 
@@ -67,14 +72,15 @@ LogProcess::LogProcess(
     const string& path,
     const set<UPID>& pids,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& _metricsPrefix)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
     replica(new Replica(path)),
     network(new Network(pids + (UPID) replica->pid())),
     autoInitialize(_autoInitialize),
+    metricsPrefix(_metricsPrefix),
     group(nullptr),
-    metrics(*this, metricsPrefix) {}
+    metrics(*this, _metricsPrefix) {}
 
 
 LogProcess::LogProcess(
@@ -85,7 +91,7 @@ LogProcess::LogProcess(
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& _metricsPrefix)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
     replica(new Replica(path)),
@@ -96,12 +102,15 @@ LogProcess::LogProcess(
         auth,
         Set<UPID>((UPID) replica->pid()))),
     autoInitialize(_autoInitialize),
+    metricsPrefix(_metricsPrefix),
     group(new zookeeper::Group(servers, timeout, znode, auth)),
-    metrics(*this, metricsPrefix) {}
+    metrics(*this, _metricsPrefix) {}
 
 
 void LogProcess::initialize()
 {
+  restoration = replica->restoration();
+
   if (group != nullptr) {
     // Need to add our replica to the ZooKeeper group!
     LOG(INFO) << "Attempting to join replica to ZooKeeper group";
@@ -248,6 +257,22 @@ double LogProcess::_recovered()
 }
 
 
+Future<double> LogProcess::_restore_ms()
+{
+  return restoration.then([](const Replica::Restoration& restoration) {
+    return restoration.duration.ms();
+  });
+}
+
+
+Future<double> LogProcess::_restore_records()
+{
+  return restoration.then([](const Replica::Restoration& restoration) {
+    return static_cast<double>(restoration.records);
+  });
+}
+
+
 void LogProcess::watch(
     const UPID& pid,
     const set<zookeeper::Group::Membership>& memberships)
@@ -285,15 +310,25 @@ LogProcess::Metrics::Metrics(
     const Option<string>& prefix)
   : recovered(
         prefix.getOrElse("") + "log/recovered",
-        defer(process, &LogProcess::_recovered))
+        defer(process, &LogProcess::_recovered)),
+    restore_ms(
+        prefix.getOrElse("") + "log/restore_ms",
+        defer(process, &LogProcess::_restore_ms)),
+    restore_records(
+        prefix.getOrElse("") + "log/restore_records",
+        defer(process, &LogProcess::_restore_records))
 {
   process::metrics::add(recovered);
+  process::metrics::add(restore_ms);
+  process::metrics::add(restore_records);
 }
 
 
 LogProcess::Metrics::~Metrics()
 {
   process::metrics::remove(recovered);
+  process::metrics::remove(restore_ms);
+  process::metrics::remove(restore_records);
 }
 
 
@@ -459,13 +494,30 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+// Maximum number of queued actions written by a single group commit.
+static const size_t MAX_GROUP_COMMIT_SIZE = 1024;
+
+
+LogWriterProcess::LogWriterProcess(
+    Log* log,
+    const Option<Duration>& groupCommitWindow,
+    const Option<string>& metricsPrefix)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(nullptr),
-    error(None()) {}
+    error(None()),
+    window(groupCommitWindow),
+    scheduled(false)
+{
+  if (window.isSome()) {
+    metrics.reset(new Metrics(
+        metricsPrefix.isSome()
+          ? metricsPrefix.get()
+          : log->process->metricsPrefix.getOrElse("")));
+  }
+}
 
 
 void LogWriterProcess::initialize()
@@ -482,6 +534,16 @@ void LogWriterProcess::finalize()
   }
   promises.clear();
 
+  foreach (const Operation& operation, queued) {
+    operation.promise->fail("Log writer is being deleted");
+  }
+  queued.clear();
+
+  foreach (const Operation& operation, committing) {
+    operation.promise->fail("Log writer is being deleted");
+  }
+  committing.clear();
+
   delete coordinator;
 }
 
@@ -584,6 +646,15 @@ Future<Option<Log::Position> > LogWriterProcess::append(const string& bytes)
     return Failure(error.get());
   }
 
+  if (window.isSome()) {
+    Action action;
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(bytes);
+
+    return enqueue(action)
+      .then(lambda::bind(&Self::position, lambda::_1));
+  }
+
   return coordinator->append(bytes)
     .then(lambda::bind(&Self::position, lambda::_1))
     .onFailed(defer(self(), &Self::failed, "Failed to append", lambda::_1));
@@ -603,6 +674,15 @@ Future<Option<Log::Position> > LogWriterProcess::truncate(
     return Failure(error.get());
   }
 
+  if (window.isSome()) {
+    Action action;
+    action.set_type(Action::TRUNCATE);
+    action.mutable_truncate()->set_to(to.value);
+
+    return enqueue(action)
+      .then(lambda::bind(&Self::position, lambda::_1));
+  }
+
   return coordinator->truncate(to.value)
     .then(lambda::bind(&Self::position, lambda::_1))
     .onFailed(defer(self(), &Self::failed, "Failed to truncate", lambda::_1));
@@ -620,11 +700,118 @@ Option<Log::Position> LogWriterProcess::position(
 }
 
 
+Future<Option<uint64_t> > LogWriterProcess::enqueue(const Action& action)
+{
+  CHECK_SOME(window);
+
+  Operation operation;
+  operation.action = action;
+  operation.promise.reset(new process::Promise<Option<uint64_t> >());
+
+  queued.push_back(operation);
+
+  // If a group is being written, the queued actions are committed as
+  // soon as that write finishes (see 'committed'). Otherwise, we wait
+  // for the window to elapse so that concurrent writes can join.
+  if (committing.empty() && !scheduled) {
+    scheduled = true;
+    delay(window.get(), self(), &Self::commit);
+  }
+
+  return metrics->commit.time(operation.promise->future());
+}
+
+
+void LogWriterProcess::commit()
+{
+  scheduled = false;
+
+  if (!committing.empty() || queued.empty()) {
+    return;
+  }
+
+  if (error.isSome()) {
+    foreach (const Operation& operation, queued) {
+      operation.promise->fail(error.get());
+    }
+    queued.clear();
+    return;
+  }
+
+  CHECK_NOTNULL(coordinator);
+
+  vector<Action> actions;
+
+  while (!queued.empty() && committing.size() < MAX_GROUP_COMMIT_SIZE) {
+    actions.push_back(queued.front().action);
+    committing.push_back(queued.front());
+    queued.pop_front();
+  }
+
+  LOG(INFO) << "Committing a group of " << actions.size() << " writes";
+
+  coordinator->write(actions)
+    .onAny(defer(self(), &Self::committed, lambda::_1));
+}
+
+
+void LogWriterProcess::committed(const Future<Option<uint64_t> >& position)
+{
+  vector<Operation> operations;
+  std::swap(operations, committing);
+
+  if (position.isReady()) {
+    ++metrics->batches;
+    metrics->entries += operations.size();
+
+    // The actions of a group are written to consecutive positions.
+    for (size_t i = 0; i < operations.size(); i++) {
+      operations[i].promise->set(
+          position->isSome()
+            ? Option<uint64_t>(position->get() + i)
+            : Option<uint64_t>::none());
+    }
+  } else if (position.isFailed()) {
+    failed("Failed to write", position.failure());
+
+    foreach (const Operation& operation, operations) {
+      operation.promise->fail(position.failure());
+    }
+  } else {
+    foreach (const Operation& operation, operations) {
+      operation.promise->discard();
+    }
+  }
+
+  // Commit the actions queued during the write right away.
+  commit();
+}
+
+
 void LogWriterProcess::failed(const string& message, const string& reason)
 {
   error = message + ": " + reason;
 }
 
+
+LogWriterProcess::Metrics::Metrics(const string& prefix)
+  : batches(prefix + "log/group_commit/batches"),
+    entries(prefix + "log/group_commit/entries"),
+    commit(prefix + "log/group_commit/commit")
+{
+  process::metrics::add(batches);
+  process::metrics::add(entries);
+  process::metrics::add(commit);
+}
+
+
+LogWriterProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(batches);
+  process::metrics::remove(entries);
+  process::metrics::remove(commit);
+}
+
 } // namespace log {
 } // namespace internal {
 
@@ -738,7 +925,17 @@ Future<Log::Position> Log::Reader::ending()
 
 Log::Writer::Writer(Log* log)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, None());
+  spawn(process);
+}
+
+
+Log::Writer::Writer(
+    Log* log,
+    const Duration& groupCommitWindow,
+    const Option<string>& metricsPrefix)
+{
+  process = new LogWriterProcess(log, groupCommitWindow, metricsPrefix);
   spawn(process);
 }
 
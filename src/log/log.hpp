@@ -19,6 +19,9 @@
 
 #include <stdint.h>
 
+#include <deque>
+#include <vector>
+
 #include <mesos/log/log.hpp>
 
 #include <process/future.hpp>
@@ -26,9 +29,13 @@
 #include <process/process.hpp>
 #include <process/shared.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 
 #include "log/coordinator.hpp"
 #include "log/network.hpp"
@@ -77,6 +84,11 @@ private:
   // Return true if the log has finished recovery.
   double _recovered();
 
+  // Return the time it took to restore the local replica from disk,
+  // and the number of records read to do so.
+  process::Future<double> _restore_ms();
+  process::Future<double> _restore_records();
+
   // TODO(benh): Factor this out into "membership renewer".
   void watch(
       const process::UPID& pid,
@@ -89,12 +101,17 @@ private:
   process::Shared<Replica> replica;
   process::Shared<Network> network;
   const bool autoInitialize;
+  const Option<std::string> metricsPrefix;
 
   // For replica recovery.
   Option<process::Future<process::Owned<Replica>>> recovering;
   process::Promise<Nothing> recovered;
   std::list<process::Promise<process::Shared<Replica>>*> promises;
 
+  // The restoration of the local replica, captured on initialization
+  // since the replica is not available while it is being recovered.
+  process::Future<Replica::Restoration> restoration;
+
   // For renewing membership. We store a Group instance in order to
   // continually renew the replicas membership (when using ZooKeeper).
   zookeeper::Group* group;
@@ -109,6 +126,8 @@ private:
     ~Metrics();
 
     process::metrics::Gauge recovered;
+    process::metrics::Gauge restore_ms;
+    process::metrics::Gauge restore_records;
   } metrics;
 };
 
@@ -160,7 +179,10 @@ private:
 class LogWriterProcess : public process::Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(mesos::log::Log* log);
+  LogWriterProcess(
+      mesos::log::Log* log,
+      const Option<Duration>& groupCommitWindow,
+      const Option<std::string>& metricsPrefix = None());
 
   process::Future<Option<mesos::log::Log::Position>> start();
   process::Future<Option<mesos::log::Log::Position>> append(
@@ -188,6 +210,16 @@ private:
   process::Future<Option<mesos::log::Log::Position>> _start();
   Option<mesos::log::Log::Position> __start(const Option<uint64_t>& position);
 
+  // Queues the specified action (an append or a truncate) to be
+  // written by the next group commit. Returns the position at which
+  // the action is written or none if the coordinator was demoted.
+  process::Future<Option<uint64_t>> enqueue(const Action& action);
+
+  // Writes (some of) the queued actions using a single write of the
+  // coordinator.
+  void commit();
+  void committed(const process::Future<Option<uint64_t>>& position);
+
   void failed(const std::string& message, const std::string& reason);
 
   const size_t quorum;
@@ -198,6 +230,37 @@ private:
 
   Coordinator* coordinator;
   Option<std::string> error;
+
+  // For group commit, which is enabled if a window is specified.
+  // The actions are queued until the window elapses, or until the
+  // write of the previous group finishes, whichever happens last.
+  struct Operation
+  {
+    Action action;
+    process::Owned<process::Promise<Option<uint64_t>>> promise;
+  };
+
+  const Option<Duration> window;
+  std::deque<Operation> queued;
+  std::vector<Operation> committing;
+  bool scheduled;
+
+  struct Metrics
+  {
+    explicit Metrics(const std::string& prefix);
+
+    ~Metrics();
+
+    // Number of group commits, and number of actions written by them.
+    process::metrics::Counter batches;
+    process::metrics::Counter entries;
+
+    // Time between queueing an action and completing its write.
+    process::metrics::Timer<Milliseconds> commit;
+  };
+
+  // Only set if group commit is enabled.
+  process::Owned<Metrics> metrics;
 };
 
 } // namespace log {
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
@@ -30,6 +31,7 @@
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
 
@@ -51,6 +53,7 @@ namespace protocol {
 // Some replica protocol definitions.
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
+Protocol<BatchWriteRequest, BatchWriteResponse> batchWrite;
 Protocol<RecoverRequest, RecoverResponse> recover;
 
 } // namespace protocol {
@@ -97,6 +100,9 @@ public:
   // Returns the highest implicit promise this replica has given.
   uint64_t promised();
 
+  // Returns statistics about restoring this replica from storage.
+  Replica::Restoration restoration();
+
   // Updates the status of this replica. The update will be persisted
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
@@ -109,15 +115,32 @@ private:
   // Handles a request from a proposer to write an action.
   void write(const UPID& from, const WriteRequest& request);
 
+  // Handles a request from a proposer to write a batch of actions.
+  void batchWrite(const UPID& from, const BatchWriteRequest& request);
+
+  // Returns the response to a write request, or none if the request
+  // must be ignored. Sets 'persisting' to the action that has to be
+  // persisted before responding, if any.
+  Option<WriteResponse> _write(
+      const WriteRequest& request,
+      Option<Action>* persisting);
+
   // Handles a request from a recover process.
   void recover(const UPID& from, const RecoverRequest& request);
 
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
-  // Persists the specified action to storage. Returns true on success
-  // and false otherwise.
+  // Handles a message notifying of a batch of learned actions.
+  void batchLearned(const UPID& from, const BatchLearnedMessage& message);
+
+  // Persists the specified action(s) to storage. Returns true on
+  // success and false otherwise.
   bool persist(const Action& action);
+  bool persist(const std::vector<Action>& actions);
+
+  // Updates the positions of the log after persisting the action.
+  void advance(const Action& action);
 
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
@@ -145,6 +168,9 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // Statistics about restoring the log.
+  Replica::Restoration restored;
 };
 
 
@@ -165,12 +191,18 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<WriteRequest>(
       &ReplicaProcess::write);
 
+  install<BatchWriteRequest>(
+      &ReplicaProcess::batchWrite);
+
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
+
+  install<BatchLearnedMessage>(
+      &ReplicaProcess::batchLearned);
 }
 
 
@@ -304,6 +336,12 @@ uint64_t ReplicaProcess::promised()
 }
 
 
+Replica::Restoration ReplicaProcess::restoration()
+{
+  return restored;
+}
+
+
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
   Metadata metadata_;
@@ -537,6 +575,75 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position() << " from " << from;
 
+  Option<Action> action;
+  Option<WriteResponse> response = _write(request, &action);
+
+  if (response.isSome() && (action.isNone() || persist(action.get()))) {
+    reply(response.get());
+  }
+}
+
+
+void ReplicaProcess::batchWrite(
+    const UPID& from,
+    const BatchWriteRequest& request)
+{
+  BatchWriteResponse response;
+
+  // Ignore write requests if this replica is not in VOTING status; we
+  // also inform the requester, so that they can retry promptly.
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica ignoring batch write request from " << from
+              << " as it is in " << status() << " status";
+
+    foreach (const WriteRequest& write, request.requests()) {
+      WriteResponse* ignore = response.add_responses();
+      ignore->set_type(WriteResponse::IGNORE);
+      ignore->set_okay(false);
+      ignore->set_proposal(write.proposal());
+      ignore->set_position(write.position());
+    }
+
+    reply(response);
+    return;
+  }
+
+  LOG(INFO) << "Replica received batch write request for "
+            << request.requests_size() << " positions from " << from;
+
+  std::vector<Action> actions;
+  actions.reserve(request.requests_size());
+
+  foreach (const WriteRequest& write, request.requests()) {
+    Option<Action> action;
+    Option<WriteResponse> _response = _write(write, &action);
+
+    // We reply to all the requests of a batch, or to none of them, so
+    // that the proposer can tell which replicas accepted the batch.
+    if (_response.isNone()) {
+      LOG(INFO) << "Replica ignoring batch write request from " << from
+                << " because it ignores the write request for position "
+                << write.position();
+      return;
+    }
+
+    response.add_responses()->CopyFrom(_response.get());
+
+    if (action.isSome()) {
+      actions.push_back(action.get());
+    }
+  }
+
+  if (actions.empty() || persist(actions)) {
+    reply(response);
+  }
+}
+
+
+Option<WriteResponse> ReplicaProcess::_write(
+    const WriteRequest& request,
+    Option<Action>* persisting)
+{
   Result<Action> result = read(request.position());
 
   if (result.isError()) {
@@ -549,7 +656,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
       response.set_okay(false);
       response.set_proposal(promised());
       response.set_position(request.position());
-      reply(response);
+      return response;
     } else {
       Action action;
       action.set_position(request.position());
@@ -575,14 +682,14 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      *persisting = action;
+
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+      return response;
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -594,7 +701,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
       response.set_okay(false);
       response.set_proposal(action.promised());
       response.set_position(request.position());
-      reply(response);
+      return response;
     } else {
       if (action.has_learned() && action.learned()) {
         // We ignore the write request if this position has already
@@ -654,17 +761,19 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        *persisting = action;
+
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        return response;
       }
     }
   }
+
+  return None();
 }
 
 
@@ -700,17 +809,65 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
 }
 
 
+void ReplicaProcess::batchLearned(
+    const UPID& from,
+    const BatchLearnedMessage& message)
+{
+  LOG(INFO) << "Replica received learned notice for "
+            << message.actions_size() << " positions from " << from;
+
+  std::vector<Action> actions(
+      message.actions().begin(),
+      message.actions().end());
+
+  foreach (const Action& action, actions) {
+    CHECK(action.learned());
+  }
+
+  if (persist(actions)) {
+    LOG(INFO) << "Replica learned " << actions.size() << " actions";
+  }
+}
+
+
 bool ReplicaProcess::persist(const Action& action)
 {
-  Try<Nothing> persisted = storage->persist(action);
+  Try<Nothing> _persist = storage->persist(action);
 
-  if (persisted.isError()) {
-    LOG(ERROR) << "Error writing to log: " << persisted.error();
+  if (_persist.isError()) {
+    LOG(ERROR) << "Error writing to log: " << _persist.error();
     return false;
   }
 
   LOG(INFO) << "Persisted action at " << action.position();
 
+  advance(action);
+
+  return true;
+}
+
+
+bool ReplicaProcess::persist(const std::vector<Action>& actions)
+{
+  Try<Nothing> _persist = storage->persist(actions);
+
+  if (_persist.isError()) {
+    LOG(ERROR) << "Error writing to log: " << _persist.error();
+    return false;
+  }
+
+  foreach (const Action& action, actions) {
+    LOG(INFO) << "Persisted action at " << action.position();
+
+    advance(action);
+  }
+
+  return true;
+}
+
+
+void ReplicaProcess::advance(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -745,19 +902,23 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
 void ReplicaProcess::restore(const string& path)
 {
+  Stopwatch stopwatch;
+  stopwatch.start();
+
   Try<Storage::State> state = storage->restore(path);
 
   if (state.isError()) {
     EXIT(EXIT_FAILURE) << "Failed to recover the log: " << state.error();
   }
 
+  restored.duration = stopwatch.elapsed();
+  restored.records = state.get().records;
+
   // Pull out and save some of the state.
   metadata = state.get().metadata;
   begin = state.get().begin;
@@ -841,6 +1002,12 @@ Future<uint64_t> Replica::promised() const
 }
 
 
+Future<Replica::Restoration> Replica::restoration() const
+{
+  return dispatch(process, &ReplicaProcess::restoration);
+}
+
+
 Future<bool> Replica::update(const Metadata::Status& status)
 {
   return dispatch(process, &ReplicaProcess::update, status);
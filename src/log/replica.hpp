@@ -26,6 +26,7 @@
 #include <process/pid.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/interval.hpp>
 
 #include "messages/log.hpp"
@@ -39,6 +40,7 @@ namespace protocol {
 // Some replica protocol declarations.
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
+extern Protocol<BatchWriteRequest, BatchWriteResponse> batchWrite;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
 
 } // namespace protocol {
@@ -89,6 +91,16 @@ public:
   // Returns the highest implicit promise this replica has given.
   process::Future<uint64_t> promised() const;
 
+  // Statistics about restoring the state of this replica from the
+  // underlying storage, which happens when the replica is created.
+  struct Restoration
+  {
+    Duration duration;
+    uint64_t records; // Number of records read from the storage.
+  };
+
+  process::Future<Restoration> restoration() const;
+
   // Updates the status of this replica. Returns true if status was
   // updated successfully, false otherwise. Made "virtual" for
   // mocking in tests.
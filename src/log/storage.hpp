@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include <stout/interval.hpp>
 #include <stout/nothing.hpp>
@@ -46,6 +47,9 @@ public:
     // merged and represented using an interval.
     IntervalSet<uint64_t> learned;
     IntervalSet<uint64_t> unlearned;
+
+    // The number of records read to restore the state.
+    uint64_t records;
   };
 
   virtual ~Storage() {}
@@ -53,6 +57,9 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists the specified actions atomically.
+  virtual Try<Nothing> persist(const std::vector<Action>& actions) = 0;
   virtual Try<Action> read(uint64_t position) = 0;
 };
 
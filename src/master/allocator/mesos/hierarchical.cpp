@@ -17,8 +17,12 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <mesos/resources.hpp>
@@ -31,8 +35,10 @@
 
 #include <stout/check.hpp>
 #include <stout/hashset.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 
 #include "common/protobuf_utils.hpp"
 
@@ -42,9 +48,11 @@ using std::vector;
 
 using mesos::allocator::InverseOfferStatus;
 
+using process::Clock;
 using process::Failure;
 using process::Future;
 using process::Owned;
+using process::Time;
 using process::Timeout;
 
 namespace mesos {
@@ -120,6 +128,126 @@ private:
 };
 
 
+// A fixed set of threads that the shards of the allocation runs are
+// evaluated on, so that threads are not created for every run.
+class EvaluationPool
+{
+public:
+  explicit EvaluationPool(size_t size)
+  {
+    for (size_t i = 0; i < size; i++) {
+      threads.emplace_back(&EvaluationPool::work, this, true);
+    }
+  }
+
+  ~EvaluationPool()
+  {
+    synchronized (mutex) {
+      stopped = true;
+    }
+
+    available.notify_all();
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+  }
+
+  // Invokes `evaluate` for each of the shards in [0, shards) and
+  // returns once all of them are evaluated. The calling thread
+  // evaluates shards as well, hence a pool of `shards - 1` threads
+  // evaluates all of the shards concurrently.
+  void run(size_t shards, const std::function<void(size_t)>& evaluate)
+  {
+    synchronized (mutex) {
+      CHECK(task == nullptr);
+
+      task = &evaluate;
+      next = 0;
+      total = shards;
+      remaining = shards;
+    }
+
+    available.notify_all();
+
+    // NOTE: `work()` returns once there are no shards left to start,
+    // rather than once all of them are evaluated.
+    work(false);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return remaining == 0; });
+
+    task = nullptr;
+  }
+
+private:
+  // Evaluates the shards of the current run until there are none left
+  // to start. If `wait` is true (i.e., on the pool's threads) this
+  // then waits for the next run rather than returning.
+  void work(bool wait)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+      if (wait) {
+        available.wait(lock, [this]() {
+          return stopped || (task != nullptr && next < total);
+        });
+      }
+
+      if (stopped || task == nullptr || next >= total) {
+        return;
+      }
+
+      const size_t shard = next++;
+      const std::function<void(size_t)>* evaluate = task;
+
+      lock.unlock();
+      (*evaluate)(shard);
+      lock.lock();
+
+      if (--remaining == 0) {
+        finished.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable available;
+  std::condition_variable finished;
+
+  // The function evaluating the shards of the current run, if any,
+  // the next of its shards to start, its total number of shards and
+  // the number of those not evaluated yet.
+  const std::function<void(size_t)>* task = nullptr;
+  size_t next = 0;
+  size_t total = 0;
+  size_t remaining = 0;
+
+  bool stopped = false;
+
+  vector<std::thread> threads;
+};
+
+
+// Returns the tick of the offer filter wheel that `time` falls into,
+// see `HierarchicalAllocatorProcess::offerFilterWheel`.
+static int64_t tick(const Time& time, const Duration& interval)
+{
+  return time.duration().ns() / std::max<int64_t>(interval.ns(), 1);
+}
+
+
+HierarchicalAllocatorProcess::~HierarchicalAllocatorProcess()
+{
+  foreachvalue (const vector<ExpiringOfferFilter>& filters, offerFilterWheel) {
+    foreach (const ExpiringOfferFilter& filter, filters) {
+      delete filter.offerFilter;
+    }
+  }
+}
+
+
 void HierarchicalAllocatorProcess::initialize(
     const Duration& _allocationInterval,
     const lambda::function<
@@ -148,6 +276,9 @@ void HierarchicalAllocatorProcess::initialize(
   quotaRoleSorter.reset(quotaRoleSorterFactory());
   quotaRoleSorter->initialize(fairnessExcludeResourceNames);
 
+  fullAllocationTimeout = Timeout::in(FULL_ALLOCATION_INTERVAL);
+  offerFilterTick = tick(Clock::now(), allocationInterval);
+
   VLOG(1) << "Initialized hierarchical allocator process";
 
   delay(allocationInterval, self(), &Self::batch);
@@ -328,6 +459,7 @@ void HierarchicalAllocatorProcess::removeFramework(
   // framework's `offerFilters` hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
   // HierarchicalAllocatorProcess::expire.
+  removeOfferFilters(frameworkId);
   frameworks.erase(frameworkId);
 
   LOG(INFO) << "Removed framework " << frameworkId;
@@ -372,7 +504,7 @@ void HierarchicalAllocatorProcess::deactivateFramework(
   // framework's `offerFilters` hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
   // HierarchicalAllocatorProcess::expire.
-  frameworks[frameworkId].offerFilters.clear();
+  removeOfferFilters(frameworkId);
   frameworks[frameworkId].inverseOfferFilters.clear();
 
   // Clear the suppressed flag to make sure the framework can be offered
@@ -401,6 +533,10 @@ void HierarchicalAllocatorProcess::updateFramework(
 
   frameworks[frameworkId].gpuAware = protobuf::frameworkHasCapability(
       frameworkInfo, FrameworkInfo::Capability::GPU_RESOURCES);
+
+  // The framework might now accept resources on any slave that it
+  // could not be offered before.
+  fullAllocationPending = true;
 }
 
 
@@ -501,6 +637,7 @@ void HierarchicalAllocatorProcess::removeSlave(
   quotaRoleSorter->remove(slaveId, slaves[slaveId].total.nonRevocable());
 
   slaves.erase(slaveId);
+  allocationCandidates.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
   // this slave, that will occur when the delayed
@@ -556,6 +693,8 @@ void HierarchicalAllocatorProcess::activateSlave(
 
   slaves[slaveId].activated = true;
 
+  allocationCandidates.insert(slaveId);
+
   LOG(INFO)<< "Agent " << slaveId << " reactivated";
 }
 
@@ -588,6 +727,8 @@ void HierarchicalAllocatorProcess::updateWhitelist(
   } else {
     LOG(INFO) << "Advertising offers for all agents";
   }
+
+  fullAllocationPending = true;
 }
 
 
@@ -729,6 +870,10 @@ Future<Nothing> HierarchicalAllocatorProcess::updateAvailable(
   quotaRoleSorter->remove(slaveId, oldTotal.nonRevocable());
   quotaRoleSorter->add(slaveId, updatedTotal.get().nonRevocable());
 
+  // The updated resources (e.g., unreserved ones) might be
+  // allocatable to other frameworks.
+  allocationCandidates.insert(slaveId);
+
   return Nothing();
 }
 
@@ -790,6 +935,7 @@ void HierarchicalAllocatorProcess::updateInverseOffer(
     // We always remove the outstanding offer so that we will send a new offer
     // out the next time we schedule inverse offers.
     maintenance.offersOutstanding.erase(frameworkId);
+    allocationCandidates.insert(slaveId);
 
     // If the response is `Some`, this means the framework responded. Otherwise
     // if it is `None` the inverse offer timed out or was rescinded.
@@ -909,6 +1055,11 @@ void HierarchicalAllocatorProcess::recoverResources(
       if (quotas.contains(role)) {
         // See comment at `quotaRoleSorter` declaration regarding non-revocable.
         quotaRoleSorter->unallocated(role, slaveId, resources.nonRevocable());
+
+        // The role's quota might no longer be satisfied, in which case
+        // the unreserved resources on any slave could be allocated to
+        // the role, see the first stage of `allocate()`.
+        fullAllocationPending = true;
       }
     }
   }
@@ -921,6 +1072,8 @@ void HierarchicalAllocatorProcess::recoverResources(
 
     slaves[slaveId].allocated -= resources;
 
+    allocationCandidates.insert(slaveId);
+
     VLOG(1) << "Recovered " << resources
             << " (total: " << slaves[slaveId].total
             << ", allocated: " << slaves[slaveId].allocated
@@ -965,29 +1118,24 @@ void HierarchicalAllocatorProcess::recoverResources(
     // Create a new filter.
     OfferFilter* offerFilter = new RefusedOfferFilter(resources);
     frameworks[frameworkId].offerFilters[slaveId].insert(offerFilter);
-
-    // We need to disambiguate the function call to pick the correct
-    // expire() overload.
-    void (Self::*expireOffer)(
-              const FrameworkID&,
-              const SlaveID&,
-              OfferFilter*) = &Self::expire;
-
-    // Expire the filter after both an `allocationInterval` and the
-    // `timeout` have elapsed. This ensures that the filter does not
-    // expire before we perform the next allocation for this agent,
-    // see MESOS-4302 for more information.
-    //
-    // TODO(alexr): If we allocated upon resource recovery
-    // (MESOS-3078), we would not need to increase the timeout here.
-    timeout = std::max(allocationInterval, timeout.get());
-
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          slaveId,
-          offerFilter);
+    offerFiltered[slaveId].insert(frameworkId);
+    ++offerFilterCount;
+
+    // Add the filter to the timer wheel, so that the batch allocations
+    // expire it once both the `timeout` has elapsed and the next batch
+    // allocation was performed. The latter ensures that the filter does
+    // not expire before we perform the next allocation for this agent,
+    // see MESOS-4302 for more information. Once the filter expires, the
+    // agent becomes an allocation candidate again.
+    const Time now = Clock::now();
+
+    const Time expiry = timeout.get() < Time::max() - now
+      ? now + timeout.get()
+      : Time::max();
+
+    offerFilterWheel[std::max(tick(expiry, allocationInterval),
+                              offerFilterTick)]
+      .push_back({frameworkId, slaveId, offerFilter, expiry, batches});
   }
 }
 
@@ -1008,7 +1156,7 @@ void HierarchicalAllocatorProcess::reviveOffers(
 {
   CHECK(initialized);
 
-  frameworks[frameworkId].offerFilters.clear();
+  removeOfferFilters(frameworkId);
   frameworks[frameworkId].inverseOfferFilters.clear();
   frameworks[frameworkId].suppressed = false;
 
@@ -1141,13 +1289,30 @@ void HierarchicalAllocatorProcess::resume()
     VLOG(1) << "Allocation resumed";
 
     paused = false;
+
+    // Allocations that were skipped while paused might have
+    // considered any slave.
+    fullAllocationPending = true;
   }
 }
 
 
 void HierarchicalAllocatorProcess::batch()
 {
-  allocate();
+  expireOfferFilters();
+
+  // Only the allocation candidates have resources that might have
+  // become allocatable since the last allocation. We still consider
+  // all slaves periodically, as a safeguard against changes that we
+  // do not track.
+  if (fullAllocationPending || fullAllocationTimeout.expired()) {
+    allocate();
+  } else if (!allocationCandidates.empty()) {
+    allocateCandidates();
+  }
+
+  ++batches;
+
   delay(allocationInterval, self(), &Self::batch);
 }
 
@@ -1157,6 +1322,7 @@ void HierarchicalAllocatorProcess::allocate()
   if (paused) {
     VLOG(1) << "Skipped allocation because the allocator is paused";
 
+    fullAllocationPending = true;
     return;
   }
 
@@ -1165,6 +1331,9 @@ void HierarchicalAllocatorProcess::allocate()
 
   metrics.allocation_run.start();
 
+  fullAllocationPending = false;
+  fullAllocationTimeout = Timeout::in(FULL_ALLOCATION_INTERVAL);
+
   allocate(slaves.keys());
 
   metrics.allocation_run.stop();
@@ -1180,6 +1349,7 @@ void HierarchicalAllocatorProcess::allocate(
   if (paused) {
     VLOG(1) << "Skipped allocation because the allocator is paused";
 
+    allocationCandidates.insert(slaveId);
     return;
   }
 
@@ -1197,12 +1367,44 @@ void HierarchicalAllocatorProcess::allocate(
 }
 
 
+void HierarchicalAllocatorProcess::allocateCandidates()
+{
+  if (paused) {
+    VLOG(1) << "Skipped allocation because the allocator is paused";
+
+    return;
+  }
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+  metrics.allocation_run.start();
+
+  // NOTE: We take the candidates out before allocating, since the
+  // allocation adds back the slaves that it defers.
+  hashset<SlaveID> candidates;
+  std::swap(candidates, allocationCandidates);
+
+  allocate(candidates);
+
+  metrics.allocation_run.stop();
+
+  VLOG(1) << "Performed allocation for " << candidates.size()
+          << " candidate agents in " << stopwatch.elapsed();
+}
+
+
 // TODO(alexr): Consider factoring out the quota allocation logic.
 void HierarchicalAllocatorProcess::allocate(
     const hashset<SlaveID>& slaveIds_)
 {
   ++metrics.allocation_runs;
 
+  // The specified slaves are no longer allocation candidates, unless
+  // the allocation is deferred for them below.
+  foreach (const SlaveID& slaveId, slaveIds_) {
+    allocationCandidates.erase(slaveId);
+  }
+
   // Compute the offerable resources, per framework:
   //   (1) For reserved resources on the slave, allocate these to a
   //       framework having the corresponding role.
@@ -1230,6 +1432,15 @@ void HierarchicalAllocatorProcess::allocate(
   // TODO(vinod): Implement a smarter sorting algorithm.
   std::random_shuffle(slaveIds.begin(), slaveIds.end());
 
+  metrics.allocation_candidates += slaveIds.size();
+
+  // Evaluate the offerable resources and offer filters on each slave
+  // up front, possibly in parallel. The allocation loops below then
+  // consume the candidates in the same (deterministic) order as
+  // before, updating a slave's candidate whenever they allocate
+  // resources on it.
+  vector<Candidate> candidates = evaluate(slaveIds);
+
   // Returns the __quantity__ of resources allocated to a quota role. Since we
   // account for reservations and persistent volumes toward quota, we strip
   // reservation and persistent volume related information for comparability.
@@ -1243,24 +1454,24 @@ void HierarchicalAllocatorProcess::allocate(
 
     // NOTE: `allocationScalarQuantities` omits dynamic reservation and
     // persistent volume info, but we additionally strip `role` here.
-    Resources resources;
-
-    foreach (Resource resource,
-             quotaRoleSorter->allocationScalarQuantities(role)) {
-      CHECK(!resource.has_reservation());
-      CHECK(!resource.has_disk());
-
-      resource.set_role("*");
-      resources += resource;
-    }
-
-    return resources;
+    return quotaRoleSorter->allocationScalarQuantities(role).flatten();
   };
 
+  // The quota guarantees are compared against the quantities above,
+  // so we convert them only once per allocation.
+  hashmap<string, ResourceQuantities> quotaGuarantees;
+  foreachpair (const string& role, const Quota& quota, quotas) {
+    quotaGuarantees[role] =
+      ResourceQuantities::fromScalarResources(quota.info.guarantee());
+  }
+
   // Quota comes first and fair share second. Here we process only those
   // roles, for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
-  foreach (const SlaveID& slaveId, slaveIds) {
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+    Candidate& candidate = candidates[i];
+
     foreach (const string& role, quotaRoleSorter->sort()) {
       CHECK(quotas.contains(role));
 
@@ -1272,7 +1483,8 @@ void HierarchicalAllocatorProcess::allocate(
 
       // Get the total quantity of resources allocated to a quota role. The
       // value omits role, reservation, and persistence info.
-      Resources roleConsumedResources = getQuotaRoleAllocatedResources(role);
+      ResourceQuantities roleConsumedResources =
+        getQuotaRoleAllocatedResources(role);
 
       // If quota for the role is satisfied, we do not need to do any further
       // allocations for this role, at least at this stage.
@@ -1281,7 +1493,7 @@ void HierarchicalAllocatorProcess::allocate(
       // alternatives are:
       //   * A custom sorter that is aware of quotas and sorts accordingly.
       //   * Removing satisfied roles from the sorter.
-      if (roleConsumedResources.contains(quotas[role].info.guarantee())) {
+      if (roleConsumedResources.contains(quotaGuarantees[role])) {
         continue;
       }
 
@@ -1299,14 +1511,10 @@ void HierarchicalAllocatorProcess::allocate(
         // Only offer resources from slaves that have GPUs to
         // frameworks that are capable of receiving GPUs.
         // See MESOS-5634.
-        if (!frameworks[frameworkId].gpuAware &&
-            slaves[slaveId].total.gpus().getOrElse(0) > 0) {
+        if (!frameworks[frameworkId].gpuAware && candidate.gpus) {
           continue;
         }
 
-        // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-
         // The resources we offer are the unreserved resources as well as the
         // reserved resources for this particular role. This is necessary to
         // ensure that we don't offer resources that are reserved for another
@@ -1321,7 +1529,8 @@ void HierarchicalAllocatorProcess::allocate(
         // were to rely on stage 2 to offer them out, they would not be checked
         // against the quota guarantee.
         Resources resources =
-          (available.unreserved() + available.reserved(role)).nonRevocable();
+          (candidate.unreserved + candidate.reserved.reserved(role))
+            .nonRevocable();
 
         // It is safe to break here, because all frameworks under a role would
         // consider the same resources, so in case we don't have allocatable
@@ -1337,7 +1546,9 @@ void HierarchicalAllocatorProcess::allocate(
 
         // If the framework filters these resources, ignore. The unallocated
         // part of the quota will not be allocated to other roles.
-        if (isFiltered(frameworkId, slaveId, resources)) {
+        if (candidate.filtersEvaluated
+              ? candidate.quotaFiltered.contains(frameworkId)
+              : isFiltered(frameworkId, slaveId, resources)) {
           continue;
         }
 
@@ -1351,6 +1562,10 @@ void HierarchicalAllocatorProcess::allocate(
         offerable[frameworkId][slaveId] += resources;
         slaves[slaveId].allocated += resources;
 
+        // The filters evaluated up front no longer apply to the
+        // remaining resources on the slave.
+        evaluate(slaveId, false, &candidate);
+
         // Resources allocated as part of the quota count towards the
         // role's and the framework's fair share.
         //
@@ -1375,21 +1590,22 @@ void HierarchicalAllocatorProcess::allocate(
   // agents participating in the current allocation (i.e. provided as an
   // argument to the `allocate()` call) so that frameworks in roles without
   // quota are not unnecessarily deprived of resources.
-  Resources remainingClusterResources = roleSorter->totalScalarQuantities();
+  ResourceQuantities remainingClusterResources =
+    roleSorter->totalScalarQuantities();
   foreachkey (const string& role, activeRoles) {
     remainingClusterResources -= roleSorter->allocationScalarQuantities(role);
   }
 
   // Frameworks in a quota'ed role may temporarily reject resources by
   // filtering or suppressing offers. Hence quotas may not be fully allocated.
-  Resources unallocatedQuotaResources;
-  foreachpair (const string& name, const Quota& quota, quotas) {
+  ResourceQuantities unallocatedQuotaResources;
+  foreachkey (const string& name, quotas) {
     // Compute the amount of quota that the role does not have allocated.
     //
     // NOTE: Revocable resources are excluded in `quotaRoleSorter`.
     // NOTE: Only scalars are considered for quota.
-    Resources allocated = getQuotaRoleAllocatedResources(name);
-    const Resources required = quota.info.guarantee();
+    const ResourceQuantities allocated = getQuotaRoleAllocatedResources(name);
+    const ResourceQuantities& required = quotaGuarantees[name];
     unallocatedQuotaResources += (required - allocated);
   }
 
@@ -1412,14 +1628,19 @@ void HierarchicalAllocatorProcess::allocate(
   // information about dynamic reservations and persistent volumes for
   // performance reasons. This invariant is preserved because we only add
   // resources to it that have also had this metadata stripped from them
-  // (typically by using `Resources::createStrippedScalarQuantity`).
-  Resources allocatedStage2;
+  // (by using `ResourceQuantities::fromScalarResources`).
+  ResourceQuantities allocatedStage2;
 
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
-  foreach (const SlaveID& slaveId, slaveIds) {
-    // If there are no resources available for the second stage, stop.
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+    Candidate& candidate = candidates[i];
+
+    // If there are no resources available for the second stage, stop,
+    // and defer the allocation for the remaining slaves.
     if (!allocatable(remainingClusterResources - allocatedStage2)) {
+      allocationCandidates.insert(slaveIds.begin() + i, slaveIds.end());
       break;
     }
 
@@ -1437,14 +1658,10 @@ void HierarchicalAllocatorProcess::allocate(
         // Only offer resources from slaves that have GPUs to
         // frameworks that are capable of receiving GPUs.
         // See MESOS-5634.
-        if (!frameworks[frameworkId].gpuAware &&
-            slaves[slaveId].total.gpus().getOrElse(0) > 0) {
+        if (!frameworks[frameworkId].gpuAware && candidate.gpus) {
           continue;
         }
 
-        // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-
         // The resources we offer are the unreserved resources as well as the
         // reserved resources for this particular role. This is necessary to
         // ensure that we don't offer resources that are reserved for another
@@ -1459,9 +1676,9 @@ void HierarchicalAllocatorProcess::allocate(
         // allocation algorithm in stage 1.
         //
         // TODO(mpark): Offer unreserved resources as revocable beyond quota.
-        Resources resources = available.reserved(role);
+        Resources resources = candidate.reserved.reserved(role);
         if (!quotas.contains(role)) {
-          resources += available.unreserved();
+          resources += candidate.unreserved;
         }
 
         // It is safe to break here, because all frameworks under a role would
@@ -1492,7 +1709,9 @@ void HierarchicalAllocatorProcess::allocate(
         }
 
         // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, slaveId, resources)) {
+        if (candidate.filtersEvaluated
+              ? candidate.filtered.contains(frameworkId)
+              : isFiltered(frameworkId, slaveId, resources)) {
           continue;
         }
 
@@ -1500,11 +1719,12 @@ void HierarchicalAllocatorProcess::allocate(
         // stage to use more than `remainingClusterResources`, move along.
         // We do not terminate early, as offers generated further in the
         // loop may be small enough to fit within `remainingClusterResources`.
-        const Resources scalarQuantity =
-          resources.createStrippedScalarQuantity();
+        const ResourceQuantities scalarQuantity =
+          ResourceQuantities::fromScalarResources(resources);
 
         if (!remainingClusterResources.contains(
                 allocatedStage2 + scalarQuantity)) {
+          allocationCandidates.insert(slaveId);
           continue;
         }
 
@@ -1520,6 +1740,8 @@ void HierarchicalAllocatorProcess::allocate(
         allocatedStage2 += scalarQuantity;
         slaves[slaveId].allocated += resources;
 
+        evaluate(slaveId, false, &candidate);
+
         frameworkSorters[role]->add(slaveId, resources);
         frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
@@ -1549,6 +1771,108 @@ void HierarchicalAllocatorProcess::allocate(
 }
 
 
+vector<HierarchicalAllocatorProcess::Candidate>
+HierarchicalAllocatorProcess::evaluate(const vector<SlaveID>& slaveIds)
+{
+  vector<Candidate> candidates(slaveIds.size());
+
+  const size_t shards = std::max<size_t>(1, std::min<size_t>(
+      maxShards,
+      slaveIds.size() / std::max<size_t>(1, agentsPerShard)));
+
+  // Each shard evaluates a contiguous range of the slaves, and writes
+  // only the corresponding range of the candidates.
+  auto evaluateShard = [&](size_t shard) {
+    const size_t begin = slaveIds.size() * shard / shards;
+    const size_t end = slaveIds.size() * (shard + 1) / shards;
+
+    for (size_t i = begin; i < end; i++) {
+      evaluate(slaveIds[i], true, &candidates[i]);
+    }
+  };
+
+  if (shards == 1) {
+    evaluateShard(0);
+    return candidates;
+  }
+
+  // The pool is only started once an allocation run is sharded, as
+  // most clusters are too small for that to ever happen.
+  if (pool.get() == nullptr) {
+    pool.reset(new EvaluationPool(maxShards - 1));
+  }
+
+  // NOTE: The allocator's state must not be modified until all the
+  // shards have been evaluated, as they read it without
+  // synchronization.
+  pool->run(shards, evaluateShard);
+
+  return candidates;
+}
+
+
+void HierarchicalAllocatorProcess::evaluate(
+    const SlaveID& slaveId,
+    bool filters,
+    Candidate* candidate)
+{
+  CHECK(slaves.contains(slaveId));
+
+  const Slave& slave = slaves.at(slaveId);
+
+  // Calculate the currently available resources on the slave.
+  Resources available = slave.total - slave.allocated;
+
+  candidate->unreserved = available.unreserved();
+  candidate->reserved = available.reserved();
+  candidate->gpus = slave.total.gpus().getOrElse(0) > 0;
+
+  candidate->filtersEvaluated = filters;
+  candidate->quotaFiltered.clear();
+  candidate->filtered.clear();
+
+  // Only the frameworks that have offer filters on the slave can
+  // filter its resources.
+  if (!filters || !offerFiltered.contains(slaveId)) {
+    return;
+  }
+
+  // Compute the resources each framework would be offered in the
+  // same way as `allocate()`, and check them against its filters.
+  foreach (const FrameworkID& frameworkId, offerFiltered.at(slaveId)) {
+    CHECK(frameworks.contains(frameworkId));
+
+    const Framework& framework = frameworks.at(frameworkId);
+    const Resources reserved = candidate->reserved.reserved(framework.role);
+
+    Resources resources;
+
+    if (quotas.contains(framework.role)) {
+      if (isFiltered(
+              frameworkId,
+              slaveId,
+              (candidate->unreserved + reserved).nonRevocable())) {
+        candidate->quotaFiltered.insert(frameworkId);
+      }
+
+      // Roles with quota are only offered their reserved
+      // resources during the second stage.
+      resources = reserved;
+    } else {
+      resources = reserved + candidate->unreserved;
+    }
+
+    if (!framework.revocable) {
+      resources = resources.nonRevocable();
+    }
+
+    if (isFiltered(frameworkId, slaveId, resources)) {
+      candidate->filtered.insert(frameworkId);
+    }
+  }
+}
+
+
 void HierarchicalAllocatorProcess::deallocate(
     const hashset<SlaveID>& slaveIds_)
 {
@@ -1639,6 +1963,57 @@ void HierarchicalAllocatorProcess::deallocate(
 }
 
 
+void HierarchicalAllocatorProcess::expireOfferFilters()
+{
+  const Time now = Clock::now();
+  const int64_t current = tick(now, allocationInterval);
+
+  // The ticks that have elapsed since the last expiration. If there
+  // are more of them than filled ticks in the wheel, it is cheaper to
+  // look at the filled ticks.
+  vector<int64_t> elapsed;
+
+  if (static_cast<uint64_t>(current - offerFilterTick) <
+        offerFilterWheel.size()) {
+    for (int64_t slot = offerFilterTick; slot <= current; slot++) {
+      if (offerFilterWheel.contains(slot)) {
+        elapsed.push_back(slot);
+      }
+    }
+  } else {
+    foreachkey (int64_t slot, offerFilterWheel) {
+      if (slot <= current) {
+        elapsed.push_back(slot);
+      }
+    }
+  }
+
+  // Filters of the elapsed ticks which are not due yet (i.e., those
+  // expiring later in the current tick or those that have to wait for
+  // a batch allocation) are carried over to the current tick.
+  vector<ExpiringOfferFilter> remaining;
+
+  foreach (int64_t slot, elapsed) {
+    foreach (const ExpiringOfferFilter& filter, offerFilterWheel.at(slot)) {
+      if (filter.expiry <= now && filter.batches < batches) {
+        expire(filter.frameworkId, filter.slaveId, filter.offerFilter);
+      } else {
+        remaining.push_back(filter);
+      }
+    }
+
+    offerFilterWheel.erase(slot);
+  }
+
+  if (!remaining.empty()) {
+    vector<ExpiringOfferFilter>& filters = offerFilterWheel[current];
+    filters.insert(filters.end(), remaining.begin(), remaining.end());
+  }
+
+  offerFilterTick = current;
+}
+
+
 void HierarchicalAllocatorProcess::expire(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
@@ -1655,6 +2030,17 @@ void HierarchicalAllocatorProcess::expire(
     frameworks[frameworkId].offerFilters[slaveId].erase(offerFilter);
     if (frameworks[frameworkId].offerFilters[slaveId].empty()) {
       frameworks[frameworkId].offerFilters.erase(slaveId);
+
+      offerFiltered[slaveId].erase(frameworkId);
+      if (offerFiltered[slaveId].empty()) {
+        offerFiltered.erase(slaveId);
+      }
+    }
+
+    --offerFilterCount;
+
+    if (slaves.contains(slaveId)) {
+      allocationCandidates.insert(slaveId);
     }
   }
 
@@ -1662,6 +2048,28 @@ void HierarchicalAllocatorProcess::expire(
 }
 
 
+void HierarchicalAllocatorProcess::removeOfferFilters(
+    const FrameworkID& frameworkId)
+{
+  CHECK(frameworks.contains(frameworkId));
+
+  Framework& framework = frameworks[frameworkId];
+
+  foreachpair (const SlaveID& slaveId,
+               const hashset<OfferFilter*>& offerFilters,
+               framework.offerFilters) {
+    offerFiltered[slaveId].erase(frameworkId);
+    if (offerFiltered[slaveId].empty()) {
+      offerFiltered.erase(slaveId);
+    }
+
+    offerFilterCount -= offerFilters.size();
+  }
+
+  framework.offerFilters.clear();
+}
+
+
 void HierarchicalAllocatorProcess::expire(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
@@ -1682,6 +2090,10 @@ void HierarchicalAllocatorProcess::expire(
     if(frameworks[frameworkId].inverseOfferFilters[slaveId].empty()) {
       frameworks[frameworkId].inverseOfferFilters.erase(slaveId);
     }
+
+    if (slaves.contains(slaveId)) {
+      allocationCandidates.insert(slaveId);
+    }
   }
 
   delete inverseOfferFilter;
@@ -1716,9 +2128,14 @@ bool HierarchicalAllocatorProcess::isFiltered(
   CHECK(frameworks.contains(frameworkId));
   CHECK(slaves.contains(slaveId));
 
-  if (frameworks[frameworkId].offerFilters.contains(slaveId)) {
-    foreach (
-      OfferFilter* offerFilter, frameworks[frameworkId].offerFilters[slaveId]) {
+  // NOTE: We only use const accessors here since this can be called
+  // concurrently while evaluating candidates, see `evaluate()`.
+  const Framework& framework = frameworks.at(frameworkId);
+
+  if (framework.offerFilters.contains(slaveId)) {
+    metrics.offer_filter_checks += framework.offerFilters.at(slaveId).size();
+
+    foreach (OfferFilter* offerFilter, framework.offerFilters.at(slaveId)) {
       if (offerFilter->filter(resources)) {
         VLOG(1) << "Filtered offer with " << resources
                 << " on agent " << slaveId
@@ -1768,6 +2185,17 @@ bool HierarchicalAllocatorProcess::allocatable(
 }
 
 
+bool HierarchicalAllocatorProcess::allocatable(
+    const ResourceQuantities& quantities)
+{
+  static const uint32_t CPUS = ResourceQuantities::index("cpus");
+  static const uint32_t MEM = ResourceQuantities::index("mem");
+
+  return quantities.get(CPUS) >= MIN_CPUS ||
+         Megabytes(static_cast<uint64_t>(quantities.get(MEM))) >= MIN_MEM;
+}
+
+
 double HierarchicalAllocatorProcess::_resources_offered_or_allocated(
     const string& resource)
 {
@@ -1789,11 +2217,7 @@ double HierarchicalAllocatorProcess::_resources_offered_or_allocated(
 double HierarchicalAllocatorProcess::_resources_total(
     const string& resource)
 {
-  Option<Value::Scalar> total =
-    roleSorter->totalScalarQuantities()
-      .get<Value::Scalar>(resource);
-
-  return total.isSome() ? total->value() : 0;
+  return roleSorter->totalScalarQuantities().get(resource);
 }
 
 
@@ -1801,11 +2225,7 @@ double HierarchicalAllocatorProcess::_quota_allocated(
     const string& role,
     const string& resource)
 {
-  Option<Value::Scalar> used =
-    quotaRoleSorter->allocationScalarQuantities(role)
-      .get<Value::Scalar>(resource);
-
-  return used.isSome() ? used->value() : 0;
+  return quotaRoleSorter->allocationScalarQuantities(role).get(resource);
 }
 
 
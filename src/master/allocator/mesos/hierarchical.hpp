@@ -17,14 +17,19 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <algorithm>
 #include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
+#include <process/time.hpp>
+#include <process/timeout.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
@@ -32,6 +37,8 @@
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
 
+#include "common/resource_quantities.hpp"
+
 #include "master/allocator/mesos/allocator.hpp"
 #include "master/allocator/mesos/metrics.hpp"
 
@@ -64,6 +71,7 @@ namespace internal {
 // Forward declarations.
 class OfferFilter;
 class InverseOfferFilter;
+class EvaluationPool;
 
 
 // Implements the basic allocator algorithm - first pick a role by
@@ -78,14 +86,20 @@ public:
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       initialized(false),
       paused(true),
+      fullAllocationPending(false),
+      batches(0),
       metrics(*this),
+      offerFilterTick(0),
+      offerFilterCount(0),
       roleSorter(nullptr),
       quotaRoleSorter(nullptr),
       roleSorterFactory(_roleSorterFactory),
       frameworkSorterFactory(_frameworkSorterFactory),
-      quotaRoleSorterFactory(_quotaRoleSorterFactory) {}
+      quotaRoleSorterFactory(_quotaRoleSorterFactory),
+      agentsPerShard(MIN_AGENTS_PER_ALLOCATION_SHARD),
+      maxShards(std::max(1u, std::thread::hardware_concurrency())) {}
 
-  virtual ~HierarchicalAllocatorProcess() {}
+  virtual ~HierarchicalAllocatorProcess();
 
   process::PID<HierarchicalAllocatorProcess> self() const
   {
@@ -219,18 +233,65 @@ protected:
   // Allocate resources just from the specified slave.
   void allocate(const SlaveID& slaveId);
 
+  // Allocate resources just from the allocation candidates.
+  void allocateCandidates();
+
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
   // Send inverse offers from the specified slaves.
   void deallocate(const hashset<SlaveID>& slaveIds);
 
+  // The state of an agent that `allocate()` needs for every framework
+  // it considers on the agent. It is evaluated for all agents up front
+  // so that the (sequential) allocation loop doesn't recompute it.
+  struct Candidate
+  {
+    // Resources available on the agent, split by reservation.
+    Resources unreserved;
+    Resources reserved;
+
+    // Whether the agent has GPUs, see MESOS-5634.
+    bool gpus = false;
+
+    // Frameworks that filter the resources they would be offered on
+    // the agent during the first (quota) and second stage. These are
+    // only valid until resources on the agent are allocated, at which
+    // point 'filtersEvaluated' becomes false.
+    bool filtersEvaluated = false;
+    hashset<FrameworkID> quotaFiltered;
+    hashset<FrameworkID> filtered;
+  };
+
+  // Evaluates the candidates for the specified slaves. Large sets of
+  // slaves are sharded across the threads of `pool`, see
+  // `agentsPerShard`.
+  std::vector<Candidate> evaluate(const std::vector<SlaveID>& slaveIds);
+
+  // Evaluates the candidate for the specified slave. If `filters` is
+  // true, the offer filters of the frameworks that have filters on the
+  // slave are evaluated as well.
+  //
+  // NOTE: This only reads the allocator's state so that candidates
+  // can be evaluated concurrently.
+  void evaluate(
+      const SlaveID& slaveId,
+      bool filters,
+      Candidate* candidate);
+
+  // Expire the offer filters that are due, see `offerFilterWheel`.
+  void expireOfferFilters();
+
   // Remove an offer filter for the specified framework.
   void expire(
       const FrameworkID& frameworkId,
       const SlaveID& slaveId,
       OfferFilter* offerFilter);
 
+  // Remove all offer filters for the specified framework. The filters
+  // are deleted once they expire, see `expire()`.
+  void removeOfferFilters(const FrameworkID& frameworkId);
+
   // Remove an inverse offer filter for the specified framework.
   void expire(
       const FrameworkID& frameworkId,
@@ -257,10 +318,27 @@ protected:
       const SlaveID& slaveID);
 
   bool allocatable(const Resources& resources);
+  bool allocatable(const ResourceQuantities& quantities);
 
   bool initialized;
   bool paused;
 
+  // Slaves whose resources might have become allocatable since they
+  // were last considered by an allocation, e.g., because resources
+  // were recovered or an offer filter expired. Batch allocations only
+  // consider these slaves, see `batch()`.
+  hashset<SlaveID> allocationCandidates;
+
+  // Whether the next batch allocation needs to consider all slaves,
+  // e.g., because an allocation was skipped while paused. Batch
+  // allocations also consider all slaves once the timeout (see
+  // `FULL_ALLOCATION_INTERVAL`) has expired.
+  bool fullAllocationPending;
+  process::Timeout fullAllocationTimeout;
+
+  // Number of batch allocations performed so far.
+  size_t batches;
+
   // Recovery data.
   Option<int> expectedAgentCount;
 
@@ -314,8 +392,46 @@ protected:
   double _offer_filters_active(
       const std::string& role);
 
+  double _offer_filters_active_total()
+  {
+    return static_cast<double>(offerFilterCount);
+  }
+
   hashmap<FrameworkID, Framework> frameworks;
 
+  // An offer filter that has yet to expire, see `offerFilterWheel`.
+  struct ExpiringOfferFilter
+  {
+    FrameworkID frameworkId;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+    process::Time expiry;
+
+    // The number of batch allocations performed when the filter was
+    // installed. A filter does not expire before the next batch
+    // allocation, see MESOS-4302 for more information.
+    size_t batches;
+  };
+
+  // A timer wheel of the offer filters, keyed by the tick (i.e., the
+  // allocation interval since the epoch) in which they expire. Rather
+  // than scheduling a timer per filter, batch allocations expire the
+  // filters of the elapsed ticks.
+  //
+  // NOTE: The wheel owns all offer filters, including the ones that
+  // were already removed from their framework, see `expire()`.
+  hashmap<int64_t, std::vector<ExpiringOfferFilter>> offerFilterWheel;
+
+  // The earliest tick of `offerFilterWheel` that has not been expired.
+  int64_t offerFilterTick;
+
+  // Number of offer filters that have not been removed yet.
+  size_t offerFilterCount;
+
+  // The frameworks that have offer filters on each slave, so that
+  // allocations only need to check the filters of these frameworks.
+  hashmap<SlaveID, hashset<FrameworkID>> offerFiltered;
+
   struct Slave
   {
     // Total amount of regular *and* oversubscribed resources.
@@ -467,6 +583,16 @@ protected:
   const std::function<Sorter*()> roleSorterFactory;
   const std::function<Sorter*()> frameworkSorterFactory;
   const std::function<Sorter*()> quotaRoleSorterFactory;
+
+  // The minimum number of agents evaluated by each shard of an
+  // allocation run, and the maximum number of shards, i.e., of
+  // threads evaluating them concurrently.
+  size_t agentsPerShard;
+  size_t maxShards;
+
+  // The threads that evaluate the shards of an allocation run, see
+  // `evaluate()`. Started once an allocation run is first sharded.
+  process::Owned<EvaluationPool> pool;
 };
 
 
@@ -45,12 +45,22 @@ Metrics::Metrics(const HierarchicalAllocatorProcess& _allocator)
         process::defer(
             allocator, &HierarchicalAllocatorProcess::_event_queue_dispatches)),
     allocation_runs("allocator/mesos/allocation_runs"),
-    allocation_run("allocator/mesos/allocation_run", Hours(1))
+    allocation_run("allocator/mesos/allocation_run", Hours(1)),
+    allocation_candidates("allocator/mesos/allocation_candidates"),
+    offer_filters_active_total(
+        "allocator/mesos/offer_filters/active",
+        process::defer(
+            allocator,
+            &HierarchicalAllocatorProcess::_offer_filters_active_total)),
+    offer_filter_checks("allocator/mesos/offer_filters/checks")
 {
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_dispatches_);
   process::metrics::add(allocation_runs);
   process::metrics::add(allocation_run);
+  process::metrics::add(allocation_candidates);
+  process::metrics::add(offer_filters_active_total);
+  process::metrics::add(offer_filter_checks);
 
   // Create and install gauges for the total and allocated
   // amount of standard scalar resources.
@@ -89,6 +99,9 @@ Metrics::~Metrics()
   process::metrics::remove(event_queue_dispatches_);
   process::metrics::remove(allocation_runs);
   process::metrics::remove(allocation_run);
+  process::metrics::remove(allocation_candidates);
+  process::metrics::remove(offer_filters_active_total);
+  process::metrics::remove(offer_filter_checks);
 
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
@@ -67,6 +67,10 @@ struct Metrics
   // Latency of the allocation algorithm.
   process::metrics::Timer<Milliseconds> allocation_run;
 
+  // Number of agents that the allocation runs have considered, i.e.,
+  // together with `allocation_runs`, the agents considered per run.
+  process::metrics::Counter allocation_candidates;
+
   // Gauges for the total amount of each resource in the cluster.
   std::vector<process::metrics::Gauge> resources_total;
 
@@ -81,6 +85,12 @@ struct Metrics
   hashmap<std::string, hashmap<std::string, process::metrics::Gauge>>
     quota_guarantee;
 
+  // Number of active offer filters.
+  process::metrics::Gauge offer_filters_active_total;
+
+  // Number of offer filters that were checked against resources.
+  process::metrics::Counter offer_filter_checks;
+
   // Gauges for the per-role count of active offer filters.
   hashmap<std::string, process::metrics::Gauge> offer_filters_active;
 };
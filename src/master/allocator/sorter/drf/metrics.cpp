@@ -61,7 +61,9 @@ void Metrics::add(const string& client)
   Gauge gauge(
       path::join(prefix, client, "/shares/", "/dominant"),
       defer(context, [this, client]() {
-        return sorter->calculateShare(client);
+        // NOTE: This is the cached share, which reflects changes to
+        // the totals as of the last sort.
+        return sorter->dominantShare(client);
       }));
 
   dominantShares.put(client, gauge);
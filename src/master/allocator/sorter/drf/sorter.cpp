@@ -18,6 +18,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 #include <mesos/resources.hpp>
@@ -26,6 +27,7 @@
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/option.hpp>
 
 #include "logging/logging.hpp"
@@ -35,6 +37,7 @@
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using process::UPID;
 
@@ -65,6 +68,12 @@ void DRFSorter::initialize(
     const Option<set<string>>& _fairnessExcludeResourceNames)
 {
   fairnessExcludeResourceNames = _fairnessExcludeResourceNames;
+
+  // Recalculate the shares of all resources, in case some of
+  // them are now excluded from fair sharing.
+  for (size_t resource = 0; resource < resourceNames.size(); resource++) {
+    dirtyResources.insert(resource);
+  }
 }
 
 
@@ -72,12 +81,12 @@ void DRFSorter::add(const string& name, double weight)
 {
   CHECK(!contains(name));
 
-  Client client(name, 0, 0);
-  clients.insert(client);
-
   allocations[name] = Allocation();
   weights[name] = weight;
 
+  Client client(name, 0, 0);
+  insert(client);
+
   if (metrics.isSome()) {
     metrics->add(name);
   }
@@ -89,12 +98,9 @@ void DRFSorter::update(const string& name, double weight)
   CHECK(weights.contains(name));
   weights[name] = weight;
 
-  // If the total resources have changed, we're going to
-  // recalculate all the shares, so don't bother just
-  // updating this client.
-  if (!dirty) {
-    update(name);
-  }
+  // The per-resource shares do not depend on the weight, so
+  // only the dominant share needs to be recalculated.
+  dirtyClients.insert(name);
 }
 
 
@@ -104,8 +110,20 @@ void DRFSorter::remove(const string& name)
 
   if (it != clients.end()) {
     clients.erase(it);
+    positions.erase(name);
+  }
+
+  if (allocations.contains(name)) {
+    const vector<double>& scalars = allocations[name].scalars;
+
+    for (size_t resource = 0; resource < scalars.size(); resource++) {
+      if (scalars[resource] > 0.0) {
+        allocatedClients[resource].erase(name);
+      }
+    }
   }
 
+  dirtyClients.erase(name);
   allocations.erase(name);
   weights.erase(name);
 
@@ -121,8 +139,8 @@ void DRFSorter::activate(const string& name)
 
   set<Client, DRFComparator>::iterator it = find(name);
   if (it == clients.end()) {
-    Client client(name, calculateShare(name), 0);
-    clients.insert(client);
+    Client client(name, dominantShare(name), 0);
+    insert(client);
   }
 }
 
@@ -137,6 +155,7 @@ void DRFSorter::deactivate(const string& name)
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
     clients.erase(it);
+    positions.erase(name);
   }
 }
 
@@ -157,19 +176,14 @@ void DRFSorter::allocated(
 
     // Remove and reinsert it to update the ordering appropriately.
     clients.erase(it);
-    clients.insert(client);
+    insert(client);
   }
 
   allocations[name].resources[slaveId] += resources;
   allocations[name].scalarQuantities +=
-    resources.createStrippedScalarQuantity();
+    ResourceQuantities::fromScalarResources(resources);
 
-  // If the total resources have changed, we're going to
-  // recalculate all the shares, so don't bother just
-  // updating this client.
-  if (!dirty) {
-    update(name);
-  }
+  updateShares(name);
 }
 
 
@@ -186,10 +200,10 @@ void DRFSorter::update(
   // Otherwise, we need to ensure we re-calculate the shares, as
   // is being currently done, for safety.
 
-  const Resources oldAllocationQuantity =
-    oldAllocation.createStrippedScalarQuantity();
-  const Resources newAllocationQuantity =
-    newAllocation.createStrippedScalarQuantity();
+  const ResourceQuantities oldAllocationQuantity =
+    ResourceQuantities::fromScalarResources(oldAllocation);
+  const ResourceQuantities newAllocationQuantity =
+    ResourceQuantities::fromScalarResources(newAllocation);
 
   CHECK(allocations[name].resources[slaveId].contains(oldAllocation));
   CHECK(allocations[name].scalarQuantities.contains(oldAllocationQuantity));
@@ -200,8 +214,9 @@ void DRFSorter::update(
   allocations[name].scalarQuantities -= oldAllocationQuantity;
   allocations[name].scalarQuantities += newAllocationQuantity;
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+  // Only this client's allocation has changed, so (per the TODO
+  // above) recalculating its shares is sufficient for safety.
+  updateShares(name);
 }
 
 
@@ -213,7 +228,8 @@ const hashmap<SlaveID, Resources>& DRFSorter::allocation(const string& name)
 }
 
 
-const Resources& DRFSorter::allocationScalarQuantities(const string& name)
+const ResourceQuantities& DRFSorter::allocationScalarQuantities(
+    const string& name)
 {
   CHECK(contains(name));
 
@@ -253,7 +269,7 @@ Resources DRFSorter::allocation(const string& name, const SlaveID& slaveId)
 }
 
 
-const Resources& DRFSorter::totalScalarQuantities() const
+const ResourceQuantities& DRFSorter::totalScalarQuantities() const
 {
   return total_.scalarQuantities;
 }
@@ -264,7 +280,8 @@ void DRFSorter::unallocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  const Resources resourcesQuantity = resources.createStrippedScalarQuantity();
+  const ResourceQuantities resourcesQuantity =
+    ResourceQuantities::fromScalarResources(resources);
 
   CHECK(allocations[name].resources[slaveId].contains(resources));
   CHECK(allocations[name].scalarQuantities.contains(resourcesQuantity));
@@ -276,22 +293,25 @@ void DRFSorter::unallocated(
     allocations[name].resources.erase(slaveId);
   }
 
-  if (!dirty) {
-    update(name);
-  }
+  updateShares(name);
 }
 
 
 void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
-    total_.scalarQuantities += resources.createStrippedScalarQuantity();
+    const ResourceQuantities resourcesQuantity =
+      ResourceQuantities::fromScalarResources(resources);
 
-    // We have to recalculate all shares when the total resources
-    // change, but we put it off until sort is called so that if
-    // something else changes before the next allocation we don't
-    // recalculate everything twice.
-    dirty = true;
+    total_.scalarQuantities += resourcesQuantity;
+
+    // Only the shares of the resources whose total has changed need
+    // to be recalculated, but we put it off until sort is called so
+    // that if something else changes before the next allocation we
+    // don't recalculate them twice.
+    foreach (const ResourceQuantities::Entry& entry, resourcesQuantity) {
+      updateTotal(entry.name);
+    }
   }
 }
 
@@ -299,39 +319,64 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
-    const Resources resourcesQuantity =
-      resources.createStrippedScalarQuantity();
+    const ResourceQuantities resourcesQuantity =
+      ResourceQuantities::fromScalarResources(resources);
 
     CHECK(total_.scalarQuantities.contains(resourcesQuantity));
     total_.scalarQuantities -= resourcesQuantity;
 
-    dirty = true;
+    foreach (const ResourceQuantities::Entry& entry, resourcesQuantity) {
+      updateTotal(entry.name);
+    }
   }
 }
 
 
 list<string> DRFSorter::sort()
 {
-  if (dirty) {
-    set<Client, DRFComparator> temp;
+  // Recalculate the shares of the resources whose total has changed,
+  // for the clients that have been allocated any of them. Clients
+  // without an allocation of a resource have a zero share of it,
+  // regardless of its total.
+  foreach (size_t resource, dirtyResources) {
+    foreachpair (const string& name,
+                 Allocation* allocation,
+                 allocatedClients[resource]) {
+      allocation->shares[resource] =
+        calculateShare(resource, allocation->scalars[resource]);
+
+      dirtyClients.insert(name);
+    }
+  }
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client(*it);
+  dirtyResources.clear();
 
-      // Update the 'share' to get proper sorting.
-      client.share = calculateShare(client.name);
+  if (dirtyClients.size() > clients.size() / 2) {
+    // When most of the clients need to be repositioned (e.g., the
+    // total of a resource that all of them have been allocated has
+    // changed), it is cheaper to rebuild the set of clients than to
+    // reposition them one by one.
+    set<Client, DRFComparator> temp;
 
-      temp.insert(client);
-    }
+    foreach (Client client, clients) {
+      if (dirtyClients.contains(client.name)) {
+        // Update the 'share' to get proper sorting.
+        client.share = dominantShare(client.name);
+      }
 
-    clients = temp;
+      positions[client.name] = temp.insert(client).first;
+    }
 
-    // Reset dirty to false so as not to re-calculate *all*
-    // shares unless another dirtying operation occurs.
-    dirty = false;
+    clients.swap(temp);
+  } else {
+    // Reposition only the clients whose dominant share may have changed.
+    foreach (const string& name, dirtyClients) {
+      update(name);
+    }
   }
 
+  dirtyClients.clear();
+
   list<string> result;
 
   set<Client, DRFComparator>::iterator it;
@@ -363,78 +408,131 @@ void DRFSorter::update(const string& name)
     Client client(*it);
 
     // Update the 'share' to get proper sorting.
-    client.share = calculateShare(client.name);
+    client.share = dominantShare(client.name);
 
     // Remove and reinsert it to update the ordering appropriately.
     clients.erase(it);
-    clients.insert(client);
+    insert(client);
   }
 }
 
 
-double DRFSorter::calculateShare(const string& name)
+void DRFSorter::grow(size_t resource)
 {
-  double share = 0.0;
+  while (resourceNames.size() <= resource) {
+    resourceNames.push_back(ResourceQuantities::name(resourceNames.size()));
+    allocatedClients.push_back(hashmap<string, Allocation*>());
+    total_.scalars.push_back(0.0);
+  }
+}
 
-  // TODO(benh): This implementation of "dominant resource fairness"
-  // currently does not take into account resources that are not
-  // scalars.
 
-  foreach (const string& scalar, total_.scalarQuantities.names()) {
-    // Filter out the resources excluded from fair sharing.
-    if (fairnessExcludeResourceNames.isSome() &&
-        fairnessExcludeResourceNames->count(scalar) > 0) {
-      continue;
+void DRFSorter::updateTotal(size_t resource)
+{
+  grow(resource);
+
+  // NOTE: A resource may have multiple entries in `scalarQuantities`
+  // (e.g., for different roles), so we sum all of them.
+  double total = 0.0;
+  foreach (const ResourceQuantities::Entry& entry, total_.scalarQuantities) {
+    if (entry.name == resource) {
+      total += entry.quantity();
     }
+  }
 
-    // We collect the scalar accumulated total value from the
-    // `Resources` object.
-    //
-    // NOTE: Although in principle scalar resources may be spread
-    // across multiple `Resource` objects (e.g., persistent volumes),
-    // we currently strip persistence and reservation metadata from
-    // the resources in `scalarQuantities`.
-    Option<Value::Scalar> __total =
-      total_.scalarQuantities.get<Value::Scalar>(scalar);
-
-    CHECK_SOME(__total);
-    const double _total = __total.get().value();
-
-    if (_total > 0.0) {
-      double allocation = 0.0;
-
-      // We collect the scalar accumulated allocation value from the
-      // `Resources` object.
-      //
-      // NOTE: Although in principle scalar resources may be spread
-      // across multiple `Resource` objects (e.g., persistent volumes),
-      // we currently strip persistence and reservation metadata from
-      // the resources in `scalarQuantities`.
-      Option<Value::Scalar> _allocation =
-        allocations[name].scalarQuantities.get<Value::Scalar>(scalar);
-
-      if (_allocation.isSome()) {
-        allocation = _allocation.get().value();
-      }
+  total_.scalars[resource] = total;
+
+  dirtyResources.insert(resource);
+}
+
+
+void DRFSorter::updateShares(const string& name)
+{
+  CHECK(allocations.contains(name));
+
+  Allocation& allocation = allocations[name];
+
+  foreach (const ResourceQuantities::Entry& entry,
+           allocation.scalarQuantities) {
+    grow(entry.name);
+  }
+
+  vector<double> scalars(resourceNames.size(), 0.0);
+  foreach (const ResourceQuantities::Entry& entry,
+           allocation.scalarQuantities) {
+    scalars[entry.name] += entry.quantity();
+  }
+
+  // Keep 'allocatedClients' in sync with the allocation.
+  for (size_t resource = 0; resource < scalars.size(); resource++) {
+    const bool allocated = scalars[resource] > 0.0;
+    const bool wasAllocated = resource < allocation.scalars.size() &&
+                              allocation.scalars[resource] > 0.0;
+
+    if (allocated && !wasAllocated) {
+      allocatedClients[resource].put(name, &allocation);
+    } else if (!allocated && wasAllocated) {
+      allocatedClients[resource].erase(name);
+    }
+  }
+
+  allocation.scalars = scalars;
+  allocation.shares.assign(scalars.size(), 0.0);
 
-      share = std::max(share, allocation / _total);
+  for (size_t resource = 0; resource < scalars.size(); resource++) {
+    if (scalars[resource] > 0.0) {
+      allocation.shares[resource] =
+        calculateShare(resource, scalars[resource]);
     }
   }
 
-  return share / weights[name];
+  dirtyClients.insert(name);
+}
+
+
+double DRFSorter::calculateShare(size_t resource, double quantity)
+{
+  // Filter out the resources excluded from fair sharing.
+  if (fairnessExcludeResourceNames.isSome() &&
+      fairnessExcludeResourceNames->count(resourceNames[resource]) > 0) {
+    return 0.0;
+  }
+
+  const double total = total_.scalars[resource];
+
+  if (total > 0.0) {
+    return quantity / total;
+  }
+
+  return 0.0;
+}
+
+
+double DRFSorter::dominantShare(const string& name)
+{
+  double share = 0.0;
+
+  foreach (double _share, allocations.at(name).shares) {
+    share = std::max(share, _share);
+  }
+
+  return share / weights.at(name);
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  positions[client.name] = clients.insert(client).first;
 }
 
 
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  if (positions.contains(name)) {
+    return positions.at(name);
   }
 
-  return it;
+  return clients.end();
 }
 
 } // namespace allocator {
@@ -19,13 +19,17 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 #include <mesos/resources.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/option.hpp>
 
+#include "common/resource_quantities.hpp"
+
 #include "master/allocator/sorter/drf/metrics.hpp"
 
 #include "master/allocator/sorter/sorter.hpp"
@@ -105,13 +109,14 @@ public:
   virtual const hashmap<SlaveID, Resources>& allocation(
       const std::string& name);
 
-  virtual const Resources& allocationScalarQuantities(const std::string& name);
+  virtual const ResourceQuantities& allocationScalarQuantities(
+      const std::string& name);
 
   virtual hashmap<std::string, Resources> allocation(const SlaveID& slaveId);
 
   virtual Resources allocation(const std::string& name, const SlaveID& slaveId);
 
-  virtual const Resources& totalScalarQuantities() const;
+  virtual const ResourceQuantities& totalScalarQuantities() const;
 
   virtual void add(const SlaveID& slaveId, const Resources& resources);
 
@@ -124,12 +129,32 @@ public:
   virtual int count();
 
 private:
-  // Recalculates the share for the client and moves
-  // it in 'clients' accordingly.
+  // Repositions the client in 'clients' according to its
+  // (cached) dominant share.
   void update(const std::string& name);
 
-  // Returns the dominant resource share for the client.
-  double calculateShare(const std::string& name);
+  // Ensures that the per-resource vectors below have an entry for
+  // the resource with the given index, see `ResourceQuantities::index`.
+  void grow(size_t resource);
+
+  // Updates the cached total of the resource and marks it dirty,
+  // so that its shares are recalculated on the next sort.
+  void updateTotal(size_t resource);
+
+  // Recalculates the cached shares of all resources allocated to
+  // the client, after its allocation has changed.
+  void updateShares(const std::string& name);
+
+  // Returns the (unweighted) share of the given quantity of the
+  // resource with the given index.
+  double calculateShare(size_t resource, double quantity);
+
+  // Returns the dominant resource share for the client, based on
+  // its cached per-resource shares.
+  double dominantShare(const std::string& name);
+
+  // Inserts the client into 'clients' and records its position.
+  void insert(const Client& client);
 
   // Resources (by name) that will be excluded from fair sharing.
   Option<std::set<std::string>> fairnessExcludeResourceNames;
@@ -138,12 +163,28 @@ private:
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
-  // If true, sort() will recalculate all shares.
-  bool dirty = false;
+  // Clients whose allocation or weight has changed since the last
+  // sort. Only these clients are repositioned in 'clients'.
+  hashset<std::string> dirtyClients;
+
+  // Resources (by index) whose total has changed since the last
+  // sort. Only the shares of these resources are recalculated, and
+  // only for the clients that have been allocated them.
+  std::set<size_t> dirtyResources;
 
   // A set of Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // Maps the names of the active clients to their position in
+  // 'clients', so that a client can be repositioned without
+  // scanning all of them.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> positions;
+
+  // Resource names are interned by `ResourceQuantities`, so that the
+  // per-resource state below can be kept in vectors rather than maps
+  // keyed by name. The names are cached here for fairness exclusion.
+  std::vector<std::string> resourceNames;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
@@ -156,7 +197,10 @@ private:
     // NOTE: We omit information about dynamic reservations and persistent
     // volumes here to enable resources to be aggregated across slaves
     // more effectively. See MESOS-4833 for more information.
-    Resources scalarQuantities;
+    ResourceQuantities scalarQuantities;
+
+    // The quantity of each resource (by index) in 'scalarQuantities'.
+    std::vector<double> scalars;
   } total_;
 
   // Allocation for a client.
@@ -165,12 +209,26 @@ private:
 
     // Similarly, we aggregate scalars across slaves and omit information
     // about dynamic reservations and persistent volumes. See notes above.
-    Resources scalarQuantities;
+    ResourceQuantities scalarQuantities;
+
+    // The quantity of each resource (by index) in 'scalarQuantities'.
+    std::vector<double> scalars;
+
+    // The (unweighted) share of each resource (by index). The
+    // dominant share is the maximum of these.
+    std::vector<double> shares;
   };
 
   // Maps client names to the resources they have been allocated.
   hashmap<std::string, Allocation> allocations;
 
+  // The clients that have been allocated a non-zero quantity of
+  // each resource (by index), along with their allocation.
+  //
+  // NOTE: Pointers to the values of 'allocations' remain valid
+  // until the client is removed, even if 'allocations' is rehashed.
+  std::vector<hashmap<std::string, Allocation*>> allocatedClients;
+
   // Metrics are optionally exposed by the sorter.
   friend Metrics;
   Option<Metrics> metrics;
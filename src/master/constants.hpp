@@ -44,6 +44,11 @@ constexpr double MIN_CPUS = 0.01;
 // Minimum amount of memory per offer.
 constexpr Bytes MIN_MEM = Megabytes(32);
 
+// Minimum number of agents that the allocator evaluates on a single
+// thread during an allocation run. Allocation runs over more agents
+// are sharded across threads, up to one thread per CPU.
+constexpr size_t MIN_AGENTS_PER_ALLOCATION_SHARD = 1000;
+
 // Default interval the master uses to send heartbeats to an HTTP
 // scheduler.
 constexpr Duration DEFAULT_HEARTBEAT_INTERVAL = Seconds(15);
@@ -88,9 +93,32 @@ constexpr size_t DEFAULT_MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
 // Time interval to check for updated watchers list.
 constexpr Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
 
+// Maximum number of deltas the registrar stores in between snapshots
+// of the registry. The deltas are stored in a ring of this many state
+// variables, so it cannot be changed without migrating those.
+constexpr size_t REGISTRY_DELTAS = 128;
+
+// Default maximum number of bytes of events that may be queued for a
+// client subscribed to the 'api/vX' endpoint. A subscriber that falls
+// this far behind is disconnected (and has to resubscribe), so that it
+// can't make the master buffer events without bounds.
+constexpr Bytes DEFAULT_MAX_SUBSCRIBER_QUEUED_BYTES = Megabytes(64);
+
 // Default number of tasks (limit) for /master/tasks endpoint.
 constexpr size_t TASK_LIMIT = 100;
 
+// Size of the chunks in which the read-only endpoints (e.g., /state)
+// stream their responses.
+constexpr Bytes HTTP_STREAMING_CHUNK_SIZE = Kilobytes(64);
+
+// Number of threads that the read-only endpoints (e.g., /state) are
+// serialized on. Requests beyond this wait for a thread to free up.
+constexpr size_t HTTP_STREAMING_THREADS = 4;
+
+// Time after which a client that stopped receiving a streamed response
+// of the read-only endpoints is cut off, which frees up its thread.
+constexpr Duration HTTP_STREAMING_STALL_TIMEOUT = Seconds(30);
+
 /**
  * Label used by the Leader Contender and Detector.
  *
@@ -118,6 +146,11 @@ constexpr char DEFAULT_ALLOCATOR[] = "HierarchicalDRF";
 // The default interval between allocations.
 constexpr Duration DEFAULT_ALLOCATION_INTERVAL = Seconds(1);
 
+// Interval at which batch allocations consider all agents, rather
+// than only the agents whose resources might have become allocatable
+// since they were last considered.
+constexpr Duration FULL_ALLOCATION_INTERVAL = Minutes(1);
+
 // Name of the default, local authorizer.
 constexpr char DEFAULT_AUTHORIZER[] = "local";
 
@@ -107,6 +107,15 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(20));
 
+  add(&Flags::registry_deltas,
+      "registry_deltas",
+      "Whether the registrar stores the changes to the registry as deltas,\n"
+      "and only periodically a snapshot of the whole registry, rather than\n"
+      "storing the whole registry on every change. Masters older than\n"
+      "Mesos 1.1 only read the snapshot, so do not enable this flag before\n"
+      "the masters no longer need to be downgraded to Mesos 1.0.x.",
+      false);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -524,6 +533,13 @@ mesos::internal::master::Flags::Flags()
       "Maximum number of completed tasks per framework to store in memory.",
       DEFAULT_MAX_COMPLETED_TASKS_PER_FRAMEWORK);
 
+  add(&Flags::max_subscriber_queued_bytes,
+      "max_subscriber_queued_bytes",
+      "Maximum size of the events that may be queued for a client\n"
+      "subscribed to the operator API event stream. A subscriber that\n"
+      "falls this far behind is disconnected and has to resubscribe.",
+      DEFAULT_MAX_SUBSCRIBER_QUEUED_BYTES);
+
   add(&Flags::master_contender,
       "master_contender",
       "The symbol name of the master contender to use.\n"
@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
@@ -52,6 +53,7 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  bool registry_deltas;
   bool log_auto_initialize;
   Duration agent_reregister_timeout;
   std::string recovery_agent_removal_limit;
@@ -86,6 +88,7 @@ public:
   Option<std::string> http_framework_authenticators;
   size_t max_completed_frameworks;
   size_t max_completed_tasks_per_framework;
+  Bytes max_subscriber_queued_bytes;
   Option<std::string> master_contender;
   Option<std::string> master_detector;
 
@@ -15,12 +15,20 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <ostream>
 #include <set>
 #include <sstream>
+#include <streambuf>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -38,6 +46,7 @@
 
 #include <mesos/v1/master/master.hpp>
 
+#include <process/async.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/help.hpp>
@@ -63,6 +72,7 @@
 #include <stout/representation.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
 #include <stout/uuid.hpp>
@@ -78,6 +88,7 @@
 #include "master/machine.hpp"
 #include "master/maintenance.hpp"
 #include "master/master.hpp"
+#include "master/state_snapshot.hpp"
 #include "master/validation.hpp"
 
 #include "mesos/mesos.hpp"
@@ -173,27 +184,29 @@ struct Full : Representation<T>
 
 
 // Forward declaration for `FullFrameworkWriter`.
-static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary);
+static void json(
+    JSON::ObjectWriter* writer,
+    const Summary<FrameworkSnapshot>& summary);
 
 
-// Filtered representation of Full<Framework>.
+// Filtered representation of Full<FrameworkSnapshot>.
 // Executors and Tasks are filtered based on whether the
 // user is authorized to view them.
 struct FullFrameworkWriter {
   FullFrameworkWriter(
       const Owned<ObjectApprover>& taskApprover,
       const Owned<ObjectApprover>& executorApprover,
-      const Framework* framework)
+      const FrameworkSnapshot* framework)
     : taskApprover_(taskApprover),
       executorApprover_(executorApprover),
       framework_(framework) {}
 
   void operator()(JSON::ObjectWriter* writer) const
   {
-    json(writer, Summary<Framework>(*framework_));
+    json(writer, Summary<FrameworkSnapshot>(*framework_));
 
     // Add additional fields to those generated by the
-    // `Summary<Framework>` overload.
+    // `Summary<FrameworkSnapshot>` overload.
     writer->field("user", framework_->info.user());
     writer->field("failover_timeout", framework_->info.failover_timeout());
     writer->field("checkpoint", framework_->info.checkpoint());
@@ -206,7 +219,7 @@ struct FullFrameworkWriter {
     }
 
     // TODO(bmahler): Consider deprecating this in favor of the split
-    // used and offered resources added in `Summary<Framework>`.
+    // used and offered resources added in `Summary<FrameworkSnapshot>`.
     writer->field(
         "resources",
         framework_->totalUsedResources + framework_->totalOfferedResources);
@@ -218,7 +231,7 @@ struct FullFrameworkWriter {
 
     // Model all of the tasks associated with a framework.
     writer->field("tasks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (const TaskInfo& taskInfo, framework_->pendingTasks) {
+      foreach (const TaskInfo& taskInfo, framework_->pendingTasks) {
         // Skip unauthorized tasks.
         if (!approveViewTaskInfo(taskApprover_, taskInfo, framework_->info)) {
           continue;
@@ -252,7 +265,7 @@ struct FullFrameworkWriter {
         });
       }
 
-      foreachvalue (Task* task, framework_->tasks) {
+      foreach (const std::shared_ptr<const Task>& task, framework_->tasks) {
         // Skip unauthorized tasks.
         if (!approveViewTask(taskApprover_, *task, framework_->info)) {
           continue;
@@ -263,7 +276,8 @@ struct FullFrameworkWriter {
     });
 
     writer->field("completed_tasks", [this](JSON::ArrayWriter* writer) {
-      foreach (const std::shared_ptr<Task>& task, framework_->completedTasks) {
+      foreach (const std::shared_ptr<const Task>& task,
+               framework_->completedTasks) {
         // Skip unauthorized tasks.
         if (!approveViewTask(taskApprover_, *task.get(), framework_->info)) {
           continue;
@@ -275,8 +289,8 @@ struct FullFrameworkWriter {
 
     // Model all of the offers associated with a framework.
     writer->field("offers", [this](JSON::ArrayWriter* writer) {
-      foreach (Offer* offer, framework_->offers) {
-        writer->element(*offer);
+      foreach (const Offer& offer, framework_->offers) {
+        writer->element(offer);
       }
     });
 
@@ -286,19 +300,20 @@ struct FullFrameworkWriter {
           const SlaveID& slaveId,
           const auto& executorsMap,
           framework_->executors) {
-        foreachvalue (const ExecutorInfo& executor, executorsMap) {
+        foreachvalue (const std::shared_ptr<const ExecutorInfo>& executor,
+                      executorsMap) {
           writer->element([this,
                            &executor,
                            &slaveId](JSON::ObjectWriter* writer) {
             // Skip unauthorized executors.
             if (!approveViewExecutorInfo(
                     executorApprover_,
-                    executor,
+                    *executor,
                     framework_->info)) {
               return;
             }
 
-            json(writer, executor);
+            json(writer, *executor);
             writer->field("slave_id", slaveId.value());
           });
         }
@@ -313,13 +328,15 @@ struct FullFrameworkWriter {
 
   const Owned<ObjectApprover>& taskApprover_;
   const Owned<ObjectApprover>& executorApprover_;
-  const Framework* framework_;
+  const FrameworkSnapshot* framework_;
 };
 
 
-static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
+static void json(
+    JSON::ObjectWriter* writer,
+    const Summary<SlaveSnapshot>& summary)
 {
-  const Slave& slave = summary;
+  const SlaveSnapshot& slave = summary;
 
   writer->field("id", slave.id.value());
   writer->field("pid", string(slave.pid));
@@ -332,7 +349,7 @@ static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
 
   const Resources& totalResources = slave.totalResources;
   writer->field("resources", totalResources);
-  writer->field("used_resources", Resources::sum(slave.usedResources));
+  writer->field("used_resources", slave.usedResources);
   writer->field("offered_resources", slave.offeredResources);
   writer->field("reserved_resources", totalResources.reservations());
   writer->field("unreserved_resources", totalResources.unreserved());
@@ -343,17 +360,21 @@ static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
 }
 
 
-static void json(JSON::ObjectWriter* writer, const Full<Slave>& full)
+static void json(
+    JSON::ObjectWriter* writer,
+    const Full<SlaveSnapshot>& full)
 {
-  const Slave& slave = full;
+  const SlaveSnapshot& slave = full;
 
-  json(writer, Summary<Slave>(slave));
+  json(writer, Summary<SlaveSnapshot>(slave));
 }
 
 
-static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
+static void json(
+    JSON::ObjectWriter* writer,
+    const Summary<FrameworkSnapshot>& summary)
 {
-  const Framework& framework = summary;
+  const FrameworkSnapshot& framework = summary;
 
   writer->field("id", framework.id().value());
   writer->field("name", framework.info.name());
@@ -373,6 +394,396 @@ static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
 }
 
 
+// Adds `bytes` to the memory held by the streamed responses, keeping
+// track of the peak.
+static void streamed(const std::shared_ptr<Metrics>& metrics, size_t bytes)
+{
+  const size_t current = metrics->streamingBytes += bytes;
+
+  size_t peak = metrics->streamingPeakBytes.load();
+  while (current > peak &&
+         !metrics->streamingPeakBytes.compare_exchange_weak(peak, current)) {}
+}
+
+
+// A stream buffer that writes its output to a pipe in chunks of at
+// most `size` bytes. Each chunk is only written once the previous one
+// has been read. Since the `HttpProxy` only reads the next chunk of a
+// response once the previous one was sent on the socket, at most two
+// chunks of a response are buffered at any time (one in the pipe and
+// one on the socket), i.e., the thread writing to the stream blocks
+// while the client is slow to receive the response, hence this must
+// not be used on a libprocess thread.
+//
+// Once the reader end of the pipe is closed (e.g., the client went
+// away), or a chunk is not read within `HTTP_STREAMING_STALL_TIMEOUT`
+// (e.g., the client stopped receiving), the buffer fails, which sets
+// the `badbit` of the stream writing to it and turns the remaining
+// output into no-ops.
+class PipeStreamBuffer : public std::streambuf
+{
+public:
+  PipeStreamBuffer(
+      const Pipe::Writer& _writer,
+      size_t size,
+      const std::shared_ptr<Metrics>& _metrics)
+    : writer(_writer),
+      buffer(size),
+      metrics(_metrics),
+      sending(0)
+  {
+    setp(buffer.data(), buffer.data() + buffer.size());
+  }
+
+  virtual ~PipeStreamBuffer()
+  {
+    // NOTE: We can't tell when the last chunk has been sent, so it is
+    // no longer accounted for once the response is fully written.
+    metrics->streamingBytes -= sending;
+  }
+
+protected:
+  virtual int_type overflow(int_type c) override
+  {
+    if (!flush()) {
+      return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+  virtual int sync() override
+  {
+    return flush() ? 0 : -1;
+  }
+
+private:
+  bool flush()
+  {
+    if (pptr() == pbase()) {
+      return true;
+    }
+
+    const size_t bytes = pptr() - pbase();
+
+    // The chunk is accounted for until it has been sent, see below.
+    streamed(metrics, bytes);
+
+    bool written = writer.write(string(pbase(), pptr()));
+
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    if (written && !wait(writer.drained(), HTTP_STREAMING_STALL_TIMEOUT)) {
+      writer.fail("Timed out waiting for the client to receive the response");
+      written = false;
+    }
+
+    // Once the chunk has been read, the previous chunk has been sent.
+    metrics->streamingBytes -= sending;
+    sending = bytes;
+
+    return written;
+  }
+
+  // Blocks until `future` is no longer pending, or until `timeout`
+  // elapses, in which case this returns false. We don't use
+  // `Future::await()` since it spawns a process for every call.
+  static bool wait(const Future<Nothing>& future, const Duration& timeout)
+  {
+    if (!future.isPending()) {
+      return true;
+    }
+
+    struct Signal
+    {
+      std::mutex mutex;
+      std::condition_variable condition;
+      bool triggered = false;
+    };
+
+    std::shared_ptr<Signal> signal(new Signal());
+
+    future.onAny([signal]() {
+      synchronized (signal->mutex) {
+        signal->triggered = true;
+      }
+
+      signal->condition.notify_all();
+    });
+
+    std::unique_lock<std::mutex> lock(signal->mutex);
+    return signal->condition.wait_for(
+        lock,
+        std::chrono::nanoseconds(timeout.ns()),
+        [&signal]() { return signal->triggered; });
+  }
+
+  Pipe::Writer writer;
+  vector<char> buffer;
+  std::shared_ptr<Metrics> metrics;
+
+  // The size of the last chunk written, which may still be sent.
+  size_t sending;
+};
+
+
+// A fixed set of threads that the streamed responses are serialized
+// on, see `stream()`. Responses requested while all of the threads
+// are busy wait for one to become available.
+class StreamingPool
+{
+public:
+  explicit StreamingPool(size_t size)
+  {
+    // NOTE: The pool is never destroyed (see `stream()`), hence we
+    // don't keep track of the threads to join them.
+    for (size_t i = 0; i < size; i++) {
+      std::thread(&StreamingPool::work, this).detach();
+    }
+  }
+
+  void run(const std::function<void()>& task)
+  {
+    synchronized (mutex) {
+      tasks.push_back(task);
+    }
+
+    available.notify_one();
+  }
+
+private:
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+      available.wait(lock, [this]() { return !tasks.empty(); });
+
+      std::function<void()> task = std::move(tasks.front());
+      tasks.pop_front();
+
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable available;
+  std::deque<std::function<void()>> tasks;
+};
+
+
+// Returns a response that streams the JSON written by `write`, which
+// must only reference `snapshot` (or other data it owns) since it is
+// invoked on another thread, i.e., not on the master actor. The JSON
+// is sent in chunks of `HTTP_STREAMING_CHUNK_SIZE` as it is being
+// serialized, and only as fast as the client receives them, so the
+// response is never held in memory in its entirety.
+//
+// The serialization runs on a pool of `HTTP_STREAMING_THREADS` threads
+// rather than on the libprocess threads (e.g., via `process::async`)
+// since it blocks for as long as the client takes to receive the
+// response. A client that stops receiving the response is cut off
+// after `HTTP_STREAMING_STALL_TIMEOUT`, so that it can't hold on to a
+// thread of the pool.
+template <typename F>
+static Response stream(
+    const std::shared_ptr<Metrics>& metrics,
+    const std::shared_ptr<const StateSnapshot>& snapshot,
+    const F& write,
+    const Option<string>& jsonp)
+{
+  // NOTE: This is leaked, like the libprocess threads, so that the
+  // threads never outlive it.
+  static StreamingPool* pool = new StreamingPool(HTTP_STREAMING_THREADS);
+
+  Pipe pipe;
+
+  OK ok;
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+  ok.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+
+  // These responses used to be compressed before they were streamed,
+  // and are made of large chunks, so they are worth compressing.
+  ok.compressible = true;
+
+  Pipe::Writer writer = pipe.writer();
+
+  // The snapshot is accounted for while the response waits for a
+  // thread of the pool as well, since it is kept alive meanwhile.
+  const size_t bytes = snapshot->bytes() + HTTP_STREAMING_CHUNK_SIZE.bytes();
+
+  streamed(metrics, bytes);
+
+  pool->run([metrics, snapshot, write, jsonp, writer, bytes]() mutable {
+    {
+      PipeStreamBuffer buffer(
+          writer, HTTP_STREAMING_CHUNK_SIZE.bytes(), metrics);
+
+      std::ostream out(&buffer);
+
+      if (jsonp.isSome()) {
+        out << jsonp.get() << "(";
+      }
+
+      out << jsonify(write);
+
+      if (jsonp.isSome()) {
+        out << ");";
+      }
+
+      out.flush();
+    }
+
+    writer.close();
+
+    metrics->streamingBytes -= bytes;
+  });
+
+  return ok;
+}
+
+
+std::shared_ptr<const StateSnapshot> Master::Http::captureSnapshot(
+    uint32_t sections) const
+{
+  if (master->snapshot) {
+    if ((master->snapshot->sections & sections) == sections) {
+      ++master->metrics->http_snapshots_reused;
+      return master->snapshot;
+    }
+
+    // Capture the sections of the cached snapshot as well, so that
+    // the snapshot replacing it serves all of its endpoints.
+    sections |= master->snapshot->sections;
+  }
+
+  master->metrics->http_snapshot_capture.start();
+
+  std::shared_ptr<StateSnapshot> snapshot(new StateSnapshot());
+
+  snapshot->version = ++master->snapshotVersion;
+  snapshot->sections = sections;
+
+  snapshot->info = master->info();
+  snapshot->pid = master->self();
+  snapshot->startTime = master->startTime;
+  snapshot->electedTime = master->electedTime;
+  snapshot->leader = master->leader;
+
+  if (sections & StateSnapshot::FLAGS) {
+    foreachvalue (const flags::Flag& flag, master->flags) {
+      Option<string> value = flag.stringify(master->flags);
+      if (value.isSome()) {
+        snapshot->flags.emplace_back(flag.effective_name().value, value.get());
+      }
+    }
+  }
+
+  snapshot->cluster = master->flags.cluster;
+  snapshot->logDir = master->flags.log_dir;
+  snapshot->externalLogFile = master->flags.external_log_file;
+
+  snapshot->activatedSlaves =
+    static_cast<size_t>(master->_slaves_active());
+  snapshot->deactivatedSlaves =
+    static_cast<size_t>(master->_slaves_inactive());
+
+  // Only the frameworks and agents that changed since the previous
+  // snapshot are copied, the others are shared with it.
+  if (sections & StateSnapshot::AGENTS) {
+    snapshot->slaves.reserve(master->slaves.registered.size());
+    foreachvalue (Slave* slave, master->slaves.registered) {
+      if (!slave->snapshot) {
+        slave->snapshot = std::make_shared<SlaveSnapshot>(*slave);
+      }
+
+      snapshot->slaves.push_back(slave->snapshot);
+    }
+  }
+
+  if (sections & StateSnapshot::FRAMEWORKS) {
+    snapshot->frameworks.reserve(master->frameworks.registered.size());
+    foreachvalue (Framework* framework, master->frameworks.registered) {
+      if (!framework->snapshot) {
+        framework->snapshot = std::make_shared<FrameworkSnapshot>(*framework);
+      }
+
+      snapshot->frameworks.push_back(framework->snapshot);
+    }
+  }
+
+  if (sections & StateSnapshot::COMPLETED_FRAMEWORKS) {
+    snapshot->completedFrameworks.reserve(master->frameworks.completed.size());
+    foreach (const std::shared_ptr<Framework>& framework,
+             master->frameworks.completed) {
+      if (!framework->snapshot) {
+        framework->snapshot = std::make_shared<FrameworkSnapshot>(*framework);
+      }
+
+      snapshot->completedFrameworks.push_back(framework->snapshot);
+    }
+  }
+
+  if (sections & StateSnapshot::ORPHANS) {
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      foreachpair (const FrameworkID& frameworkId,
+                   const auto& tasks,
+                   slave->tasks) {
+        if (master->frameworks.registered.contains(frameworkId)) {
+          continue;
+        }
+
+        snapshot->unregisteredFrameworks.push_back(frameworkId);
+
+        foreachvalue (const Task* task, tasks) {
+          snapshot->orphanTasks.push_back(*CHECK_NOTNULL(task));
+        }
+
+        if (master->frameworks.recovered.contains(frameworkId)) {
+          snapshot->recoveredFrameworks[frameworkId] =
+            master->frameworks.recovered[frameworkId];
+        }
+      }
+
+      foreachpair (const FrameworkID& frameworkId,
+                   const auto& executors,
+                   slave->executors) {
+        if (master->frameworks.registered.contains(frameworkId)) {
+          continue;
+        }
+
+        foreachvalue (const ExecutorInfo& executor, executors) {
+          snapshot->orphanExecutors.push_back(
+              {slave->id, frameworkId, executor});
+        }
+
+        if (master->frameworks.recovered.contains(frameworkId)) {
+          snapshot->recoveredFrameworks[frameworkId] =
+            master->frameworks.recovered[frameworkId];
+        }
+      }
+    }
+  }
+
+  snapshot->authorizationEnabled = master->authorizer.isSome();
+
+  master->snapshot = snapshot;
+
+  master->metrics->http_snapshot_capture.stop();
+
+  return snapshot;
+}
+
+
 void Master::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -437,8 +848,6 @@ Future<Response> Master::Http::api(
     return MethodNotAllowed({"POST"}, request.method);
   }
 
-  v1::master::Call v1Call;
-
   // TODO(anand): Content type values are case-insensitive.
   Option<string> contentType = request.headers.get("Content-Type");
 
@@ -446,33 +855,28 @@ Future<Response> Master::Http::api(
     return BadRequest("Expecting 'Content-Type' to be present");
   }
 
+  ContentType bodyType;
+
   if (contentType.get() == APPLICATION_PROTOBUF) {
-    if (!v1Call.ParseFromString(request.body)) {
-      return BadRequest("Failed to parse body into Call protobuf");
-    }
+    bodyType = ContentType::PROTOBUF;
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
-    Try<v1::master::Call> parse =
-      ::protobuf::parse<v1::master::Call>(value.get());
-
-    if (parse.isError()) {
-      return BadRequest("Failed to convert JSON into Call protobuf: " +
-                        parse.error());
-    }
-
-    v1Call = parse.get();
+    bodyType = ContentType::JSON;
   } else {
     return UnsupportedMediaType(
         string("Expecting 'Content-Type' of ") +
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  mesos::master::Call call = devolve(v1Call);
+  Try<mesos::master::Call> parse =
+    deserialize<mesos::master::Call, v1::master::Call>(bodyType, request.body);
+
+  if (parse.isError()) {
+    return BadRequest("Failed to parse body into Call protobuf: " +
+                      parse.error());
+  }
+
+  mesos::master::Call call;
+  call.Swap(&parse.get());
 
   Option<Error> error = validation::master::call::validate(call, principal);
 
@@ -651,10 +1055,17 @@ Future<Response> Master::Http::subscribe(
       HttpConnection http {pipe.writer(), contentType, UUID::random()};
       master->subscribe(http);
 
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::AGENTS |
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
+
       mesos::master::Event event;
       event.set_type(mesos::master::Event::SUBSCRIBED);
       event.mutable_subscribed()->mutable_get_state()->CopyFrom(
-        _getState(frameworksApprover,
+        _getState(*snapshot,
+                  frameworksApprover,
                   tasksApprover,
                   executorsApprover));
 
@@ -712,8 +1123,6 @@ Future<Response> Master::Http::scheduler(
     return MethodNotAllowed({"POST"}, request.method);
   }
 
-  v1::scheduler::Call v1Call;
-
   // TODO(anand): Content type values are case-insensitive.
   Option<string> contentType = request.headers.get("Content-Type");
 
@@ -721,33 +1130,28 @@ Future<Response> Master::Http::scheduler(
     return BadRequest("Expecting 'Content-Type' to be present");
   }
 
+  ContentType bodyType;
+
   if (contentType.get() == APPLICATION_PROTOBUF) {
-    if (!v1Call.ParseFromString(request.body)) {
-      return BadRequest("Failed to parse body into Call protobuf");
-    }
+    bodyType = ContentType::PROTOBUF;
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
-    Try<v1::scheduler::Call> parse =
-      ::protobuf::parse<v1::scheduler::Call>(value.get());
-
-    if (parse.isError()) {
-      return BadRequest("Failed to convert JSON into Call protobuf: " +
-                        parse.error());
-    }
-
-    v1Call = parse.get();
+    bodyType = ContentType::JSON;
   } else {
     return UnsupportedMediaType(
         string("Expecting 'Content-Type' of ") +
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  scheduler::Call call = devolve(v1Call);
+  Try<scheduler::Call> parse =
+    deserialize<scheduler::Call, v1::scheduler::Call>(bodyType, request.body);
+
+  if (parse.isError()) {
+    return BadRequest("Failed to parse body into Call protobuf: " +
+                      parse.error());
+  }
+
+  scheduler::Call call;
+  call.Swap(&parse.get());
 
   Option<Error> error = validation::scheduler::call::validate(call, principal);
 
@@ -1278,22 +1682,33 @@ Future<Response> Master::Http::frameworks(
                                     Owned<ObjectApprover>,
                                     Owned<ObjectApprover>>& approvers)
           -> Response {
-      // This lambda is consumed before the outer lambda
-      // returns, hence capture by reference is fine here.
-      auto frameworks = [this, &approvers](JSON::ObjectWriter* writer) {
-        // Get approver from tuple.
-        Owned<ObjectApprover> frameworksApprover;
-        Owned<ObjectApprover> tasksApprover;
-        Owned<ObjectApprover> executorsApprover;
-        tie(frameworksApprover, tasksApprover, executorsApprover) = approvers;
+      // Get approver from tuple.
+      Owned<ObjectApprover> frameworksApprover;
+      Owned<ObjectApprover> tasksApprover;
+      Owned<ObjectApprover> executorsApprover;
+      tie(frameworksApprover, tasksApprover, executorsApprover) = approvers;
 
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
+
+      // NOTE: This lambda is invoked on another thread once this
+      // continuation has returned, hence it captures by value.
+      auto frameworks = [snapshot,
+                         frameworksApprover,
+                         tasksApprover,
+                         executorsApprover](JSON::ObjectWriter* writer) {
         // Model all of the frameworks.
         writer->field(
             "frameworks",
-            [this, &frameworksApprover, &executorsApprover, &tasksApprover](
-                JSON::ArrayWriter* writer) {
-              foreachvalue (Framework* framework,
-                            master->frameworks.registered) {
+            [&snapshot,
+             &frameworksApprover,
+             &executorsApprover,
+             &tasksApprover](JSON::ArrayWriter* writer) {
+              foreach (
+                  const std::shared_ptr<const FrameworkSnapshot>& framework,
+                  snapshot->frameworks) {
                 // Skip unauthorized frameworks.
                 if (!approveViewFrameworkInfo(
                         frameworksApprover, framework->info)) {
@@ -1303,7 +1718,7 @@ Future<Response> Master::Http::frameworks(
                 FullFrameworkWriter frameworkWriter(
                     tasksApprover,
                     executorsApprover,
-                    framework);
+                    framework.get());
 
                 writer->element(frameworkWriter);
               }
@@ -1312,10 +1727,13 @@ Future<Response> Master::Http::frameworks(
         // Model all of the completed frameworks.
         writer->field(
             "completed_frameworks",
-            [this, &frameworksApprover, &executorsApprover, &tasksApprover](
-                JSON::ArrayWriter* writer) {
-              foreach (const std::shared_ptr<Framework>& framework,
-                       master->frameworks.completed) {
+            [&snapshot,
+             &frameworksApprover,
+             &executorsApprover,
+             &tasksApprover](JSON::ArrayWriter* writer) {
+              foreach (
+                  const std::shared_ptr<const FrameworkSnapshot>& framework,
+                  snapshot->completedFrameworks) {
                 // Skip unauthorized frameworks.
                 if (!approveViewFrameworkInfo(
                         frameworksApprover, framework->info)) {
@@ -1333,26 +1751,26 @@ Future<Response> Master::Http::frameworks(
 
         // Model all currently unregistered frameworks. This can happen
         // when a framework has yet to re-register after master failover.
-        writer->field("unregistered_frameworks", [this](
+        writer->field("unregistered_frameworks", [&snapshot](
             JSON::ArrayWriter* writer) {
-          // Find unregistered frameworks.
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-              if (!master->frameworks.registered.contains(frameworkId)) {
-                writer->element(frameworkId.value());
-              }
-            }
+          foreach (const FrameworkID& frameworkId,
+                   snapshot->unregisteredFrameworks) {
+            writer->element(frameworkId.value());
           }
         });
       };
 
-      return OK(jsonify(frameworks), request.url.query.get("jsonp"));
+      return stream(
+          master->metrics,
+          snapshot,
+          frameworks,
+          request.url.query.get("jsonp"));
   }));
 }
 
 
 mesos::master::Response::GetFrameworks::Framework model(
-    const Framework& framework)
+    const FrameworkSnapshot& framework)
 {
   mesos::master::Response::GetFrameworks::Framework _framework;
 
@@ -1376,12 +1794,12 @@ mesos::master::Response::GetFrameworks::Framework model(
     _framework.mutable_reregistered_time()->set_nanoseconds(time);
   }
 
-  foreach (const Offer* offer, framework.offers) {
-    _framework.mutable_offers()->Add()->CopyFrom(*offer);
+  foreach (const Offer& offer, framework.offers) {
+    _framework.mutable_offers()->Add()->CopyFrom(offer);
   }
 
-  foreach (const InverseOffer* offer, framework.inverseOffers) {
-    _framework.mutable_inverse_offers()->Add()->CopyFrom(*offer);
+  foreach (const InverseOffer& offer, framework.inverseOffers) {
+    _framework.mutable_inverse_offers()->Add()->CopyFrom(offer);
   }
 
   foreach (const Resource& resource, framework.totalUsedResources) {
@@ -1423,23 +1841,31 @@ Future<Response> Master::Http::getFrameworks(
     .then(defer(master->self(),
         [=](const Owned<ObjectApprover>& frameworksApprover)
           -> Future<Response> {
-      mesos::master::Response response;
-      response.set_type(mesos::master::Response::GET_FRAMEWORKS);
-      response.mutable_get_frameworks()->CopyFrom(
-          _getFrameworks(frameworksApprover));
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
 
-      return OK(serialize(contentType, evolve(response)),
-                stringify(contentType));
+      return process::async([=]() -> Response {
+        mesos::master::Response response;
+        response.set_type(mesos::master::Response::GET_FRAMEWORKS);
+        response.mutable_get_frameworks()->CopyFrom(
+            _getFrameworks(*snapshot, frameworksApprover));
+
+        return OK(serialize(contentType, response),
+                  stringify(contentType));
+      });
     }));
 }
 
 
 mesos::master::Response::GetFrameworks Master::Http::_getFrameworks(
-    const Owned<ObjectApprover>& frameworksApprover) const
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover)
 {
   mesos::master::Response::GetFrameworks getFrameworks;
-  foreachvalue (const Framework* framework,
-                master->frameworks.registered) {
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.frameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
@@ -1448,8 +1874,8 @@ mesos::master::Response::GetFrameworks Master::Http::_getFrameworks(
     getFrameworks.add_frameworks()->CopyFrom(model(*framework));
   }
 
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.completedFrameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
@@ -1458,31 +1884,26 @@ mesos::master::Response::GetFrameworks Master::Http::_getFrameworks(
     getFrameworks.add_completed_frameworks()->CopyFrom(model(*framework));
   }
 
-  foreachvalue (const Slave* slave, master->slaves.registered) {
-    foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-      if (!master->frameworks.registered.contains(frameworkId)) {
-        // TODO(haosdent): This logic should be simplified after
-        // a deprecation cycle starting with 1.0 as after that
-        // we can rely on `master->frameworks.recovered` containing
-        // all FrameworkInfos.
-        // Until then there are 3 cases:
-        // - No authorization enabled: show all orphaned frameworks.
-        // - Authorization enabled, but no FrameworkInfo present:
-        //   do not show orphaned frameworks.
-        // - Authorization enabled, FrameworkInfo present: filter
-        //   based on `approveViewFrameworkInfo`.
-        if (master->authorizer.isSome() &&
-           (!master->frameworks.recovered.contains(frameworkId) ||
-            !approveViewFrameworkInfo(
-                frameworksApprover,
-                master->frameworks.recovered[frameworkId]))) {
-          continue;
-        }
+  foreach (const FrameworkID& frameworkId, snapshot.unregisteredFrameworks) {
+    // NOTE: Frameworks whose `FrameworkInfo` was not recovered from
+    // any agent have no information to show.
+    if (!snapshot.recoveredFrameworks.contains(frameworkId)) {
+      continue;
+    }
 
-        getFrameworks.add_recovered_frameworks()->CopyFrom(
-            master->frameworks.recovered[frameworkId]);
-      }
+    const FrameworkInfo& frameworkInfo =
+      snapshot.recoveredFrameworks.at(frameworkId);
+
+    // TODO(haosdent): This logic should be simplified after
+    // a deprecation cycle starting with 1.0 as after that
+    // we can rely on `master->frameworks.recovered` containing
+    // all FrameworkInfos.
+    if (snapshot.authorizationEnabled &&
+        !approveViewFrameworkInfo(frameworksApprover, frameworkInfo)) {
+      continue;
     }
+
+    getFrameworks.add_recovered_frameworks()->CopyFrom(frameworkInfo);
   }
 
   return getFrameworks;
@@ -1525,35 +1946,44 @@ Future<Response> Master::Http::getExecutors(
       Owned<ObjectApprover> executorsApprover;
       tie(frameworksApprover, executorsApprover) = approvers;
 
-      mesos::master::Response response;
-      response.set_type(mesos::master::Response::GET_EXECUTORS);
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
 
-      response.mutable_get_executors()->CopyFrom(
-          _getExecutors(frameworksApprover, executorsApprover));
+      return process::async([=]() -> Response {
+        mesos::master::Response response;
+        response.set_type(mesos::master::Response::GET_EXECUTORS);
 
-      return OK(serialize(contentType, evolve(response)),
-                stringify(contentType));
+        response.mutable_get_executors()->CopyFrom(
+            _getExecutors(*snapshot, frameworksApprover, executorsApprover));
+
+        return OK(serialize(contentType, response),
+                  stringify(contentType));
+      });
     }));
 }
 
 
 mesos::master::Response::GetExecutors Master::Http::_getExecutors(
-      const Owned<ObjectApprover>& frameworksApprover,
-      const Owned<ObjectApprover>& executorsApprover) const
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover,
+    const Owned<ObjectApprover>& executorsApprover)
 {
   // Construct framework list with both active and completed frameworks.
-  vector<const Framework*> frameworks;
-  foreachvalue (Framework* framework, master->frameworks.registered) {
+  vector<const FrameworkSnapshot*> frameworks;
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.frameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
     }
 
-    frameworks.push_back(framework);
+    frameworks.push_back(framework.get());
   }
 
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.completedFrameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
@@ -1564,14 +1994,15 @@ mesos::master::Response::GetExecutors Master::Http::_getExecutors(
 
   mesos::master::Response::GetExecutors getExecutors;
 
-  foreach (const Framework* framework, frameworks) {
+  foreach (const FrameworkSnapshot* framework, frameworks) {
     foreachpair (const SlaveID& slaveId,
                  const auto& executorsMap,
                  framework->executors) {
-      foreachvalue (const ExecutorInfo& info, executorsMap) {
+      foreachvalue (const std::shared_ptr<const ExecutorInfo>& info,
+                    executorsMap) {
         // Skip unauthorized executors.
         if (!approveViewExecutorInfo(executorsApprover,
-                                     info,
+                                     *info,
                                      framework->info)) {
           continue;
         }
@@ -1579,47 +2010,41 @@ mesos::master::Response::GetExecutors Master::Http::_getExecutors(
         mesos::master::Response::GetExecutors::Executor* executor =
           getExecutors.add_executors();
 
-        executor->mutable_executor_info()->CopyFrom(info);
+        executor->mutable_executor_info()->CopyFrom(*info);
         executor->mutable_slave_id()->CopyFrom(slaveId);
       }
     }
   }
 
   // Orphan executors.
-  foreachvalue (const Slave* slave, master->slaves.registered) {
-    typedef hashmap<ExecutorID, ExecutorInfo> ExecutorMap;
-    foreachpair (const FrameworkID& frameworkId,
-                 const ExecutorMap& executors,
-                 slave->executors) {
-      foreachvalue (const ExecutorInfo& info, executors) {
-        if (!master->frameworks.registered.contains(frameworkId)) {
-          // TODO(haosdent): This logic should be simplified after
-          // a deprecation cycle starting with 1.0 as after that
-          // we can rely on `master->frameworks.recovered` containing
-          // all FrameworkInfos.
-          // Until then there are 3 cases:
-          // - No authorization enabled: show all orphaned executors.
-          // - Authorization enabled, but no FrameworkInfo present:
-          //   do not show orphaned executors.
-          // - Authorization enabled, FrameworkInfo present: filter
-          //   based on `approveViewExecutorInfo`.
-          if (master->authorizer.isSome() &&
-             (!master->frameworks.recovered.contains(frameworkId) ||
-              !approveViewExecutorInfo(
-                  executorsApprover,
-                  info,
-                  master->frameworks.recovered[frameworkId]))) {
-            continue;
-          }
+  foreach (const StateSnapshot::Executor& orphan, snapshot.orphanExecutors) {
+    const FrameworkID& frameworkId = orphan.frameworkId;
+    const ExecutorInfo& info = orphan.info;
+
+    // TODO(haosdent): This logic should be simplified after
+    // a deprecation cycle starting with 1.0 as after that
+    // we can rely on `master->frameworks.recovered` containing
+    // all FrameworkInfos.
+    // Until then there are 3 cases:
+    // - No authorization enabled: show all orphaned executors.
+    // - Authorization enabled, but no FrameworkInfo present:
+    //   do not show orphaned executors.
+    // - Authorization enabled, FrameworkInfo present: filter
+    //   based on `approveViewExecutorInfo`.
+    if (snapshot.authorizationEnabled &&
+       (!snapshot.recoveredFrameworks.contains(frameworkId) ||
+        !approveViewExecutorInfo(
+            executorsApprover,
+            info,
+            snapshot.recoveredFrameworks.at(frameworkId)))) {
+      continue;
+    }
 
-          mesos::master::Response::GetExecutors::Executor* executor =
-            getExecutors.add_orphan_executors();
+    mesos::master::Response::GetExecutors::Executor* executor =
+      getExecutors.add_orphan_executors();
 
-          executor->mutable_executor_info()->CopyFrom(info);
-          executor->mutable_slave_id()->CopyFrom(slave->id);
-        }
-      }
-    }
+    executor->mutable_executor_info()->CopyFrom(info);
+    executor->mutable_slave_id()->CopyFrom(orphan.slaveId);
   }
 
   return getExecutors;
@@ -1669,23 +2094,33 @@ Future<Response> Master::Http::getState(
       Owned<ObjectApprover> executorsApprover;
       tie(frameworksApprover, tasksApprover, executorsApprover) = approvers;
 
-      mesos::master::Response response;
-      response.set_type(mesos::master::Response::GET_STATE);
-      response.mutable_get_state()->CopyFrom(
-          _getState(frameworksApprover,
-                    tasksApprover,
-                    executorsApprover));
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::AGENTS |
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
 
-      return OK(serialize(contentType, evolve(response)),
-                stringify(contentType));
+      return process::async([=]() -> Response {
+        mesos::master::Response response;
+        response.set_type(mesos::master::Response::GET_STATE);
+        response.mutable_get_state()->CopyFrom(
+            _getState(*snapshot,
+                      frameworksApprover,
+                      tasksApprover,
+                      executorsApprover));
+
+        return OK(serialize(contentType, response),
+                  stringify(contentType));
+      });
     }));
 }
 
 
 mesos::master::Response::GetState Master::Http::_getState(
+    const StateSnapshot& snapshot,
     const Owned<ObjectApprover>& frameworksApprover,
     const Owned<ObjectApprover>& tasksApprover,
-    const Owned<ObjectApprover>& executorsApprover) const
+    const Owned<ObjectApprover>& executorsApprover)
 {
   // NOTE: This function must be blocking instead of returning a
   // `Future`. This is because `subscribe()` needs to atomically
@@ -1695,15 +2130,15 @@ mesos::master::Response::GetState Master::Http::_getState(
   mesos::master::Response::GetState getState;
 
   getState.mutable_get_tasks()->CopyFrom(
-    _getTasks(frameworksApprover, tasksApprover));
+    _getTasks(snapshot, frameworksApprover, tasksApprover));
 
   getState.mutable_get_executors()->CopyFrom(
-    _getExecutors(frameworksApprover, executorsApprover));
+    _getExecutors(snapshot, frameworksApprover, executorsApprover));
 
   getState.mutable_get_frameworks()->CopyFrom(
-    _getFrameworks(frameworksApprover));
+    _getFrameworks(snapshot, frameworksApprover));
 
-  getState.mutable_get_agents()->CopyFrom(_getAgents());
+  getState.mutable_get_agents()->CopyFrom(_getAgents(snapshot));
 
   return getState;
 }
@@ -1873,7 +2308,7 @@ Future<Response> Master::Http::getHealth(
   response.set_type(mesos::master::Response::GET_HEALTH);
   response.mutable_get_health()->set_healthy(true);
 
-  return OK(serialize(contentType, evolve(response)),
+  return OK(serialize(contentType, response),
             stringify(contentType));
 }
 
@@ -1917,7 +2352,7 @@ Future<Response> Master::Http::getMetrics(
           metric->set_value(value);
         }
 
-        return OK(serialize(contentType, evolve(response)),
+        return OK(serialize(contentType, response),
                   stringify(contentType));
       });
 }
@@ -1934,7 +2369,7 @@ Future<Response> Master::Http::getLoggingLevel(
   response.set_type(mesos::master::Response::GET_LOGGING_LEVEL);
   response.mutable_get_logging_level()->set_level(FLAGS_v);
 
-  return OK(serialize(contentType, evolve(response)),
+  return OK(serialize(contentType, response),
             stringify(contentType));
 }
 
@@ -1974,7 +2409,7 @@ Future<Response> Master::Http::getLeadingMaster(
   response.mutable_get_leading_master()->mutable_master_info()->CopyFrom(
     master->info());
 
-  return OK(serialize(contentType, evolve(response)),
+  return OK(serialize(contentType, response),
             stringify(contentType));
 }
 
@@ -2216,11 +2651,17 @@ Future<Response> Master::Http::slaves(
     return redirect(request);
   }
 
-  auto slaves = [this](JSON::ObjectWriter* writer) {
-    writer->field("slaves", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (const Slave* slave, master->slaves.registered) {
+  std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+      StateSnapshot::AGENTS);
+
+  // NOTE: This lambda is invoked on another thread once this
+  // handler has returned, hence it captures by value.
+  auto slaves = [snapshot](JSON::ObjectWriter* writer) {
+    writer->field("slaves", [&snapshot](JSON::ArrayWriter* writer) {
+      foreach (const std::shared_ptr<const SlaveSnapshot>& slave,
+               snapshot->slaves) {
         writer->element([&slave](JSON::ObjectWriter* writer) {
-          json(writer, Full<Slave>(*slave));
+          json(writer, Full<SlaveSnapshot>(*slave));
 
           // Add the complete protobuf->JSON for all used, reserved,
           // and offered resources. The other endpoints summarize
@@ -2246,7 +2687,7 @@ Future<Response> Master::Http::slaves(
                 }
               });
 
-          Resources usedResources = Resources::sum(slave->usedResources);
+          const Resources& usedResources = slave->usedResources;
 
           writer->field(
               "used_resources_full",
@@ -2270,7 +2711,11 @@ Future<Response> Master::Http::slaves(
     });
   };
 
-  return OK(jsonify(slaves), request.url.query.get("jsonp"));
+  return stream(
+      master->metrics,
+      snapshot,
+      slaves,
+      request.url.query.get("jsonp"));
 }
 
 
@@ -2281,19 +2726,26 @@ Future<process::http::Response> Master::Http::getAgents(
 {
   CHECK_EQ(mesos::master::Call::GET_AGENTS, call.type());
 
-  mesos::master::Response response;
-  response.set_type(mesos::master::Response::GET_AGENTS);
-  response.mutable_get_agents()->CopyFrom(_getAgents());
+  std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+      StateSnapshot::AGENTS);
 
-  return OK(serialize(contentType, evolve(response)),
-            stringify(contentType));
+  return process::async([=]() -> Response {
+    mesos::master::Response response;
+    response.set_type(mesos::master::Response::GET_AGENTS);
+    response.mutable_get_agents()->CopyFrom(_getAgents(*snapshot));
+
+    return OK(serialize(contentType, response),
+              stringify(contentType));
+  });
 }
 
 
-mesos::master::Response::GetAgents Master::Http::_getAgents() const
+mesos::master::Response::GetAgents Master::Http::_getAgents(
+    const StateSnapshot& snapshot)
 {
   mesos::master::Response::GetAgents getAgents;
-  foreachvalue (const Slave* slave, master->slaves.registered) {
+  foreach (const std::shared_ptr<const SlaveSnapshot>& slave,
+           snapshot.slaves) {
     mesos::master::Response::GetAgents::Agent* agent = getAgents.add_agents();
 
     agent->mutable_agent_info()->CopyFrom(slave->info);
@@ -2314,7 +2766,7 @@ mesos::master::Response::GetAgents Master::Http::_getAgents() const
       agent->add_total_resources()->CopyFrom(resource);
     }
 
-    foreach (const Resource& resource, Resources::sum(slave->usedResources)) {
+    foreach (const Resource& resource, slave->usedResources) {
       agent->add_allocated_resources()->CopyFrom(resource);
     }
 
@@ -2575,19 +3027,26 @@ Future<Response> Master::Http::state(
                                     Owned<ObjectApprover>,
                                     Owned<ObjectApprover>>& approvers)
           -> Response {
-      // This lambda is consumed before the outer lambda
-      // returns, hence capture by reference is fine here.
-      auto state = [this, &approvers](JSON::ObjectWriter* writer) {
-        // Get approver from tuple.
-        Owned<ObjectApprover> frameworksApprover;
-        Owned<ObjectApprover> tasksApprover;
-        Owned<ObjectApprover> executorsApprover;
-        Owned<ObjectApprover> flagsApprover;
-        tie(frameworksApprover,
-            tasksApprover,
-            executorsApprover,
-            flagsApprover) = approvers;
-
+      // Get approver from tuple.
+      Owned<ObjectApprover> frameworksApprover;
+      Owned<ObjectApprover> tasksApprover;
+      Owned<ObjectApprover> executorsApprover;
+      Owned<ObjectApprover> flagsApprover;
+      tie(frameworksApprover,
+          tasksApprover,
+          executorsApprover,
+          flagsApprover) = approvers;
+
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::ALL);
+
+      // NOTE: This lambda is invoked on another thread once this
+      // continuation has returned, hence it captures by value.
+      auto state = [snapshot,
+                    frameworksApprover,
+                    tasksApprover,
+                    executorsApprover,
+                    flagsApprover](JSON::ObjectWriter* writer) {
         writer->field("version", MESOS_VERSION);
 
         if (build::GIT_SHA.isSome()) {
@@ -2605,61 +3064,61 @@ Future<Response> Master::Http::state(
         writer->field("build_date", build::DATE);
         writer->field("build_time", build::TIME);
         writer->field("build_user", build::USER);
-        writer->field("start_time", master->startTime.secs());
+        writer->field("start_time", snapshot->startTime.secs());
 
-        if (master->electedTime.isSome()) {
-          writer->field("elected_time", master->electedTime.get().secs());
+        if (snapshot->electedTime.isSome()) {
+          writer->field("elected_time", snapshot->electedTime.get().secs());
         }
 
-        writer->field("id", master->info().id());
-        writer->field("pid", string(master->self()));
-        writer->field("hostname", master->info().hostname());
-        writer->field("activated_slaves", master->_slaves_active());
-        writer->field("deactivated_slaves", master->_slaves_inactive());
+        writer->field("id", snapshot->info.id());
+        writer->field("pid", string(snapshot->pid));
+        writer->field("hostname", snapshot->info.hostname());
+        writer->field("activated_slaves", snapshot->activatedSlaves);
+        writer->field("deactivated_slaves", snapshot->deactivatedSlaves);
 
-        if (master->leader.isSome()) {
-          writer->field("leader", master->leader.get().pid());
+        if (snapshot->leader.isSome()) {
+          writer->field("leader", snapshot->leader.get().pid());
         }
 
         if (approveViewFlags(flagsApprover)) {
-          if (master->flags.cluster.isSome()) {
-            writer->field("cluster", master->flags.cluster.get());
+          if (snapshot->cluster.isSome()) {
+            writer->field("cluster", snapshot->cluster.get());
           }
 
-          if (master->flags.log_dir.isSome()) {
-            writer->field("log_dir", master->flags.log_dir.get());
+          if (snapshot->logDir.isSome()) {
+            writer->field("log_dir", snapshot->logDir.get());
           }
 
-          if (master->flags.external_log_file.isSome()) {
+          if (snapshot->externalLogFile.isSome()) {
             writer->field("external_log_file",
-                          master->flags.external_log_file.get());
+                          snapshot->externalLogFile.get());
           }
 
-          writer->field("flags", [this](JSON::ObjectWriter* writer) {
-              foreachvalue (const flags::Flag& flag, master->flags) {
-                Option<string> value = flag.stringify(master->flags);
-                if (value.isSome()) {
-                  writer->field(flag.effective_name().value, value.get());
-                }
+          writer->field("flags", [&snapshot](JSON::ObjectWriter* writer) {
+              foreach (const auto& flag, snapshot->flags) {
+                writer->field(flag.first, flag.second);
               }
             });
         }
 
         // Model all of the slaves.
-        writer->field("slaves", [this](JSON::ArrayWriter* writer) {
-          foreachvalue (Slave* slave, master->slaves.registered) {
-            writer->element(Full<Slave>(*slave));
+        writer->field("slaves", [&snapshot](JSON::ArrayWriter* writer) {
+          foreach (const std::shared_ptr<const SlaveSnapshot>& slave,
+                   snapshot->slaves) {
+            writer->element(Full<SlaveSnapshot>(*slave));
           }
         });
 
         // Model all of the frameworks.
         writer->field(
             "frameworks",
-            [this, &frameworksApprover, &executorsApprover, &tasksApprover](
-                JSON::ArrayWriter* writer) {
-              foreachvalue (
-                  Framework* framework,
-                  master->frameworks.registered) {
+            [&snapshot,
+             &frameworksApprover,
+             &executorsApprover,
+             &tasksApprover](JSON::ArrayWriter* writer) {
+              foreach (
+                  const std::shared_ptr<const FrameworkSnapshot>& framework,
+                  snapshot->frameworks) {
                 // Skip unauthorized frameworks.
                 if (!approveViewFrameworkInfo(
                     frameworksApprover, framework->info)) {
@@ -2669,7 +3128,7 @@ Future<Response> Master::Http::state(
                 auto frameworkWriter = FullFrameworkWriter(
                     tasksApprover,
                     executorsApprover,
-                    framework);
+                    framework.get());
 
                 writer->element(frameworkWriter);
               }
@@ -2678,11 +3137,13 @@ Future<Response> Master::Http::state(
         // Model all of the completed frameworks.
         writer->field(
             "completed_frameworks",
-            [this, &frameworksApprover, &executorsApprover, &tasksApprover](
-                JSON::ArrayWriter* writer) {
+            [&snapshot,
+             &frameworksApprover,
+             &executorsApprover,
+             &tasksApprover](JSON::ArrayWriter* writer) {
               foreach (
-                  const std::shared_ptr<Framework>& framework,
-                  master->frameworks.completed) {
+                  const std::shared_ptr<const FrameworkSnapshot>& framework,
+                  snapshot->completedFrameworks) {
                 // Skip unauthorized frameworks.
                 if (!approveViewFrameworkInfo(
                     frameworksApprover, framework->info)) {
@@ -2697,39 +3158,31 @@ Future<Response> Master::Http::state(
             });
 
         // Model all of the orphan tasks.
-        writer->field("orphan_tasks", [this, &tasksApprover](
+        writer->field("orphan_tasks", [&snapshot, &tasksApprover](
             JSON::ArrayWriter* writer) {
-          // Find those orphan tasks.
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            typedef hashmap<TaskID, Task*> TaskMap;
-            foreachvalue (const TaskMap& tasks, slave->tasks) {
-              foreachvalue (const Task* task, tasks) {
-                CHECK_NOTNULL(task);
-                const FrameworkID& frameworkId = task->framework_id();
-                if (!master->frameworks.registered.contains(frameworkId)) {
-                  // TODO(joerg84): This logic should be simplified after
-                  // a deprecation cycle starting with 1.0 as after that
-                  // we can rely on 'master->frameworks.recovered' containing
-                  // all FrameworkInfos.
-                  // Until then there are 3 cases:
-                  // - No authorization enabled: show all orphaned tasks.
-                  // - Authorization enabled, but no FrameworkInfo present:
-                  //   do not show orphaned tasks.
-                  // - Authorization enabled, FrameworkInfo present: filter
-                  //   based on 'approveViewTask'.
-                  if (master->authorizer.isSome() &&
-                     (!master->frameworks.recovered.contains(frameworkId) ||
-                      !approveViewTask(
-                          tasksApprover,
-                          *task,
-                          master->frameworks.recovered[frameworkId]))) {
-                    continue;
-                  }
+          foreach (const Task& task, snapshot->orphanTasks) {
+            const FrameworkID& frameworkId = task.framework_id();
 
-                  writer->element(*task);
-                }
-              }
+            // TODO(joerg84): This logic should be simplified after
+            // a deprecation cycle starting with 1.0 as after that
+            // we can rely on 'master->frameworks.recovered' containing
+            // all FrameworkInfos.
+            // Until then there are 3 cases:
+            // - No authorization enabled: show all orphaned tasks.
+            // - Authorization enabled, but no FrameworkInfo present:
+            //   do not show orphaned tasks.
+            // - Authorization enabled, FrameworkInfo present: filter
+            //   based on 'approveViewTask'.
+            if (snapshot->authorizationEnabled &&
+               (!snapshot->recoveredFrameworks.contains(frameworkId) ||
+                !approveViewTask(
+                    tasksApprover,
+                    task,
+                    snapshot->recoveredFrameworks.at(frameworkId)))) {
+              continue;
             }
+
+            writer->element(task);
           }
         });
 
@@ -2737,20 +3190,20 @@ Future<Response> Master::Http::state(
         // when a framework has yet to re-register after master failover.
         // TODO(vinod): Need to filter these frameworks based on authorization!
         // See the TODO above for "orphan_tasks" for further details.
-        writer->field("unregistered_frameworks", [this](
+        writer->field("unregistered_frameworks", [&snapshot](
             JSON::ArrayWriter* writer) {
-          // Find unregistered frameworks.
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-              if (!master->frameworks.registered.contains(frameworkId)) {
-                writer->element(frameworkId.value());
-              }
-            }
+          foreach (const FrameworkID& frameworkId,
+                   snapshot->unregisteredFrameworks) {
+            writer->element(frameworkId.value());
           }
         });
       };
 
-      return OK(jsonify(state), request.url.query.get("jsonp"));
+      return stream(
+          master->metrics,
+          snapshot,
+          state,
+          request.url.query.get("jsonp"));
     }));
 }
 
@@ -2762,22 +3215,25 @@ Future<Response> Master::Http::state(
 class SlaveFrameworkMapping
 {
 public:
-  SlaveFrameworkMapping(const hashmap<FrameworkID, Framework*>& frameworks)
+  SlaveFrameworkMapping(
+      const vector<std::shared_ptr<const FrameworkSnapshot>>& frameworks)
   {
-    foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
-                 frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
+    foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+             frameworks) {
+      const FrameworkID& frameworkId = framework->id();
+
+      foreach (const TaskInfo& taskInfo, framework->pendingTasks) {
         frameworksToSlaves[frameworkId].insert(taskInfo.slave_id());
         slavesToFrameworks[taskInfo.slave_id()].insert(frameworkId);
       }
 
-      foreachvalue (const Task* task, framework->tasks) {
+      foreach (const std::shared_ptr<const Task>& task, framework->tasks) {
         frameworksToSlaves[frameworkId].insert(task->slave_id());
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+      foreach (const std::shared_ptr<const Task>& task,
+               framework->completedTasks) {
         frameworksToSlaves[frameworkId].insert(task->slave_id());
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
@@ -2863,22 +3319,25 @@ const TaskStateSummary TaskStateSummary::EMPTY;
 class TaskStateSummaries
 {
 public:
-  TaskStateSummaries(const hashmap<FrameworkID, Framework*>& frameworks)
+  TaskStateSummaries(
+      const vector<std::shared_ptr<const FrameworkSnapshot>>& frameworks)
   {
-    foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
-                 frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
+    foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+             frameworks) {
+      const FrameworkID& frameworkId = framework->id();
+
+      foreach (const TaskInfo& taskInfo, framework->pendingTasks) {
         frameworkTaskSummaries[frameworkId].staging++;
         slaveTaskSummaries[taskInfo.slave_id()].staging++;
       }
 
-      foreachvalue (const Task* task, framework->tasks) {
+      foreach (const std::shared_ptr<const Task>& task, framework->tasks) {
         frameworkTaskSummaries[frameworkId].count(*task);
         slaveTaskSummaries[task->slave_id()].count(*task);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+      foreach (const std::shared_ptr<const Task>& task,
+               framework->completedTasks) {
         frameworkTaskSummaries[frameworkId].count(*task);
         slaveTaskSummaries[task->slave_id()].count(*task);
       }
@@ -2956,12 +3415,18 @@ Future<Response> Master::Http::stateSummary(
     .then(defer(master->self(),
         [this, request](const Owned<ObjectApprover>& frameworksApprover)
           -> Response {
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::AGENTS |
+          StateSnapshot::FRAMEWORKS);
+
+      // NOTE: This lambda is invoked on another thread once this
+      // continuation has returned, hence it captures by value.
       auto stateSummary =
-          [this, &frameworksApprover](JSON::ObjectWriter* writer) {
-        writer->field("hostname", master->info().hostname());
+          [snapshot, frameworksApprover](JSON::ObjectWriter* writer) {
+        writer->field("hostname", snapshot->info.hostname());
 
-        if (master->flags.cluster.isSome()) {
-          writer->field("cluster", master->flags.cluster.get());
+        if (snapshot->cluster.isSome()) {
+          writer->field("cluster", snapshot->cluster.get());
         }
 
         // We use the tasks in the 'Frameworks' struct to compute summaries
@@ -2973,22 +3438,22 @@ Future<Response> Master::Http::stateSummary(
         // recent completed / failed tasks.
 
         // Generate mappings from 'slave' to 'framework' and reverse.
-        SlaveFrameworkMapping slaveFrameworkMapping(
-            master->frameworks.registered);
+        SlaveFrameworkMapping slaveFrameworkMapping(snapshot->frameworks);
 
         // Generate 'TaskState' summaries for all framework and slave ids.
-        TaskStateSummaries taskStateSummaries(master->frameworks.registered);
+        TaskStateSummaries taskStateSummaries(snapshot->frameworks);
 
         // Model all of the slaves.
         writer->field("slaves",
-                      [this,
+                      [&snapshot,
                        &slaveFrameworkMapping,
                        &taskStateSummaries](JSON::ArrayWriter* writer) {
-          foreachvalue (Slave* slave, master->slaves.registered) {
+          foreach (const std::shared_ptr<const SlaveSnapshot>& slave,
+                   snapshot->slaves) {
             writer->element([&slave,
                              &slaveFrameworkMapping,
                              &taskStateSummaries](JSON::ObjectWriter* writer) {
-              json(writer, Summary<Slave>(*slave));
+              json(writer, Summary<SlaveSnapshot>(*slave));
 
               // Add the 'TaskState' summary for this slave.
               const TaskStateSummary& summary =
@@ -3020,13 +3485,14 @@ Future<Response> Master::Http::stateSummary(
 
         // Model all of the frameworks.
         writer->field("frameworks",
-                      [this,
+                      [&snapshot,
                        &slaveFrameworkMapping,
                        &taskStateSummaries,
                        &frameworksApprover](JSON::ArrayWriter* writer) {
-          foreachpair (const FrameworkID& frameworkId,
-                       Framework* framework,
-                       master->frameworks.registered) {
+          foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+                   snapshot->frameworks) {
+            const FrameworkID& frameworkId = framework->id();
+
             // Skip unauthorized frameworks.
             if (!approveViewFrameworkInfo(
                 frameworksApprover,
@@ -3038,7 +3504,7 @@ Future<Response> Master::Http::stateSummary(
                              &framework,
                              &slaveFrameworkMapping,
                              &taskStateSummaries](JSON::ObjectWriter* writer) {
-              json(writer, Summary<Framework>(*framework));
+              json(writer, Summary<FrameworkSnapshot>(*framework));
 
               // Add the 'TaskState' summary for this framework.
               const TaskStateSummary& summary =
@@ -3068,7 +3534,11 @@ Future<Response> Master::Http::stateSummary(
         });
       };
 
-      return OK(jsonify(stateSummary), request.url.query.get("jsonp"));
+      return stream(
+          master->metrics,
+          snapshot,
+          stateSummary,
+          request.url.query.get("jsonp"));
     }));
 }
 
@@ -3279,7 +3749,7 @@ Future<Response> Master::Http::listFiles(
         listFiles->add_file_infos()->CopyFrom(fileInfo);
       }
 
-      return OK(serialize(contentType, evolve(response)),
+      return OK(serialize(contentType, response),
                 stringify(contentType));
     });
 }
@@ -3330,7 +3800,7 @@ Future<Response> Master::Http::getRoles(
         getRoles->add_roles()->CopyFrom(role);
       }
 
-      return OK(serialize(contentType, evolve(response)),
+      return OK(serialize(contentType, response),
                 stringify(contentType));
     }));
 }
@@ -3562,59 +4032,74 @@ Future<Response> Master::Http::tasks(
       Owned<ObjectApprover> tasksApprover;
       tie(frameworksApprover, tasksApprover) = approvers;
 
-      // Construct framework list with both active and completed frameworks.
-      vector<const Framework*> frameworks;
-      foreachvalue (Framework* framework, master->frameworks.registered) {
-        // Skip unauthorized frameworks.
-        if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
-          continue;
-        }
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS);
 
-        frameworks.push_back(framework);
-      }
+      // NOTE: This lambda is invoked on another thread once this
+      // continuation has returned, hence it captures by value. The
+      // tasks are collected and sorted there as well.
+      auto tasksWriter = [snapshot,
+                          frameworksApprover,
+                          tasksApprover,
+                          limit,
+                          offset,
+                          _order](JSON::ObjectWriter* writer) {
+        // Construct framework list with both active and completed
+        // frameworks.
+        vector<const FrameworkSnapshot*> frameworks;
+        foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+                 snapshot->frameworks) {
+          // Skip unauthorized frameworks.
+          if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
+            continue;
+          }
 
-      foreach (const std::shared_ptr<Framework>& framework,
-               master->frameworks.completed) {
-        // Skip unauthorized frameworks.
-        if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
-          continue;
+          frameworks.push_back(framework.get());
         }
 
-        frameworks.push_back(framework.get());
-      }
-
-      // Construct task list with both running and finished tasks.
-      vector<const Task*> tasks;
-      foreach (const Framework* framework, frameworks) {
-        foreachvalue (Task* task, framework->tasks) {
-          CHECK_NOTNULL(task);
-          // Skip unauthorized tasks.
-          if (!approveViewTask(tasksApprover, *task, framework->info)) {
+        foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+                 snapshot->completedFrameworks) {
+          // Skip unauthorized frameworks.
+          if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
             continue;
           }
 
-          tasks.push_back(task);
+          frameworks.push_back(framework.get());
         }
-        foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-          // Skip unauthorized tasks.
-          if (!approveViewTask(tasksApprover, *task.get(), framework->info)) {
-            continue;
+
+        // Construct task list with both running and finished tasks.
+        vector<const Task*> tasks;
+        foreach (const FrameworkSnapshot* framework, frameworks) {
+          foreach (const std::shared_ptr<const Task>& task,
+                   framework->tasks) {
+            // Skip unauthorized tasks.
+            if (!approveViewTask(tasksApprover, *task, framework->info)) {
+              continue;
+            }
+
+            tasks.push_back(task.get());
           }
+          foreach (const std::shared_ptr<const Task>& task,
+                   framework->completedTasks) {
+            // Skip unauthorized tasks.
+            if (!approveViewTask(tasksApprover, *task.get(), framework->info)) {
+              continue;
+            }
 
-          tasks.push_back(task.get());
+            tasks.push_back(task.get());
+          }
         }
-      }
 
-      // Sort tasks by task status timestamp. Default order is descending.
-      // The earliest timestamp is chosen for comparison when
-      // multiple are present.
-      if (_order == "asc") {
-        sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-      } else {
-        sort(tasks.begin(), tasks.end(), TaskComparator::descending);
-      }
+        // Sort tasks by task status timestamp. Default order is descending.
+        // The earliest timestamp is chosen for comparison when
+        // multiple are present.
+        if (_order == "asc") {
+          sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
+        } else {
+          sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+        }
 
-      auto tasksWriter = [&tasks, limit, offset](JSON::ObjectWriter* writer) {
         writer->field("tasks",
                       [&tasks, limit, offset](JSON::ArrayWriter* writer) {
           // Collect 'limit' number of tasks starting from 'offset'.
@@ -3625,7 +4110,11 @@ Future<Response> Master::Http::tasks(
         });
       };
 
-      return OK(jsonify(tasksWriter), request.url.query.get("jsonp"));
+      return stream(
+          master->metrics,
+          snapshot,
+          tasksWriter,
+          request.url.query.get("jsonp"));
   }));
 }
 
@@ -3666,36 +4155,46 @@ Future<Response> Master::Http::getTasks(
       Owned<ObjectApprover> tasksApprover;
       tie(frameworksApprover, tasksApprover) = approvers;
 
-      mesos::master::Response response;
-      response.set_type(mesos::master::Response::GET_TASKS);
+      std::shared_ptr<const StateSnapshot> snapshot = captureSnapshot(
+          StateSnapshot::FRAMEWORKS |
+          StateSnapshot::COMPLETED_FRAMEWORKS |
+          StateSnapshot::ORPHANS);
 
-      response.mutable_get_tasks()->CopyFrom(
-          _getTasks(frameworksApprover,
-                    tasksApprover));
+      return process::async([=]() -> Response {
+        mesos::master::Response response;
+        response.set_type(mesos::master::Response::GET_TASKS);
 
-      return OK(serialize(contentType, evolve(response)),
-                stringify(contentType));
+        response.mutable_get_tasks()->CopyFrom(
+            _getTasks(*snapshot,
+                      frameworksApprover,
+                      tasksApprover));
+
+        return OK(serialize(contentType, response),
+                  stringify(contentType));
+      });
   }));
 }
 
 
 mesos::master::Response::GetTasks Master::Http::_getTasks(
+    const StateSnapshot& snapshot,
     const Owned<ObjectApprover>& frameworksApprover,
-    const Owned<ObjectApprover>& tasksApprover) const
+    const Owned<ObjectApprover>& tasksApprover)
 {
   // Construct framework list with both active and completed frameworks.
-  vector<const Framework*> frameworks;
-  foreachvalue (Framework* framework, master->frameworks.registered) {
+  vector<const FrameworkSnapshot*> frameworks;
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.frameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
     }
 
-    frameworks.push_back(framework);
+    frameworks.push_back(framework.get());
   }
 
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
+  foreach (const std::shared_ptr<const FrameworkSnapshot>& framework,
+           snapshot.completedFrameworks) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
       continue;
@@ -3706,10 +4205,9 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
 
   mesos::master::Response::GetTasks getTasks;
 
-  vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
+  foreach (const FrameworkSnapshot* framework, frameworks) {
     // Pending tasks.
-    foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
+    foreach (const TaskInfo& taskInfo, framework->pendingTasks) {
       // Skip unauthorized tasks.
       if (!approveViewTaskInfo(tasksApprover, taskInfo, framework->info)) {
         continue;
@@ -3722,8 +4220,7 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
     }
 
     // Active tasks.
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
+    foreach (const std::shared_ptr<const Task>& task, framework->tasks) {
       // Skip unauthorized tasks.
       if (!approveViewTask(tasksApprover, *task, framework->info)) {
         continue;
@@ -3733,7 +4230,8 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
     }
 
     // Completed tasks.
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+    foreach (const std::shared_ptr<const Task>& task,
+             framework->completedTasks) {
       // Skip unauthorized tasks.
       if (!approveViewTask(tasksApprover, *task.get(), framework->info)) {
         continue;
@@ -3741,39 +4239,32 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
 
       getTasks.add_completed_tasks()->CopyFrom(*task);
     }
+  }
 
-    // Orphan tasks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      typedef hashmap<TaskID, Task*> TaskMap;
-      foreachvalue (const TaskMap& tasks, slave->tasks) {
-        foreachvalue (const Task* task, tasks) {
-          CHECK_NOTNULL(task);
-          const FrameworkID& frameworkId = task->framework_id();
-          if (!master->frameworks.registered.contains(frameworkId)) {
-            // TODO(joerg84): This logic should be simplified after
-            // a deprecation cycle starting with 1.0 as after that
-            // we can rely on `master->frameworks.recovered` containing
-            // all FrameworkInfos.
-            // Until then there are 3 cases:
-            // - No authorization enabled: show all orphaned tasks.
-            // - Authorization enabled, but no FrameworkInfo present:
-            //   do not show orphaned tasks.
-            // - Authorization enabled, FrameworkInfo present: filter
-            //   based on `approveViewTask`.
-            if (master->authorizer.isSome() &&
-               (!master->frameworks.recovered.contains(frameworkId) ||
-                !approveViewTask(
-                    tasksApprover,
-                    *task,
-                    master->frameworks.recovered[frameworkId]))) {
-              continue;
-            }
-
-            getTasks.add_orphan_tasks()->CopyFrom(*task);
-          }
-        }
-      }
+  // Orphan tasks.
+  foreach (const Task& task, snapshot.orphanTasks) {
+    const FrameworkID& frameworkId = task.framework_id();
+
+    // TODO(joerg84): This logic should be simplified after
+    // a deprecation cycle starting with 1.0 as after that
+    // we can rely on `master->frameworks.recovered` containing
+    // all FrameworkInfos.
+    // Until then there are 3 cases:
+    // - No authorization enabled: show all orphaned tasks.
+    // - Authorization enabled, but no FrameworkInfo present:
+    //   do not show orphaned tasks.
+    // - Authorization enabled, FrameworkInfo present: filter
+    //   based on `approveViewTask`.
+    if (snapshot.authorizationEnabled &&
+       (!snapshot.recoveredFrameworks.contains(frameworkId) ||
+        !approveViewTask(
+            tasksApprover,
+            task,
+            snapshot.recoveredFrameworks.at(frameworkId)))) {
+      continue;
     }
+
+    getTasks.add_orphan_tasks()->CopyFrom(task);
   }
 
   return getTasks;
@@ -21,6 +21,7 @@
 #include <fstream>
 #include <iomanip>
 #include <list>
+#include <map>
 #include <memory>
 #include <sstream>
 
@@ -302,9 +303,11 @@ Master::Master(
     detector(_detector),
     authorizer(_authorizer),
     frameworks(flags),
+    subscribers(flags),
     authenticator(None()),
     metrics(new Metrics(*this)),
-    electedTime(None())
+    electedTime(None()),
+    snapshotVersion(0)
 {
   slaves.limiter = _slaveRemovalLimiter;
 
@@ -1168,6 +1171,18 @@ void Master::initialize()
           return http.weights(request, principal);
         });
 
+  // The read-only endpoints only expose the state captured in the
+  // `StateSnapshot`, hence their tags are invalidated along with the
+  // snapshot (see `invalidateSnapshot()`). Their responses are
+  // streamed, so they are only tagged rather than kept.
+  cache("/frameworks", false);
+  cache("/slaves", false);
+  cache("/state.json", false);
+  cache("/state", false);
+  cache("/state-summary", false);
+  cache("/tasks.json", false);
+  cache("/tasks", false);
+
   // Provide HTTP assets from a "webui" directory. This is either
   // specified via flags (which is necessary for running out of the
   // build directory before 'make install') or determined at build
@@ -1970,6 +1985,8 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
   bool wasElected = elected();
   leader = _leader.get();
 
+  invalidateSnapshot();
+
   LOG(INFO) << "The newly elected leader is "
             << (leader.isSome()
                 ? (leader.get().pid() + " with id " + leader.get().id())
@@ -2409,6 +2426,7 @@ void Master::_subscribe(
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
+    framework->invalidateSnapshot();
 
     // Always failover the old framework connection. See MESOS-4712 for details.
     failoverFramework(framework, http);
@@ -2693,6 +2711,7 @@ void Master::_subscribe(
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
+    framework->invalidateSnapshot();
 
     if (force) {
       // TODO(vinod): Now that the scheduler pid is unique we don't
@@ -2744,6 +2763,8 @@ void Master::_subscribe(
         allocator->activateFramework(framework->id());
       }
 
+      framework->invalidateSnapshot();
+
       FrameworkReregisteredMessage message;
       message.mutable_framework_id()->MergeFrom(frameworkInfo.id());
       message.mutable_master_info()->MergeFrom(info_);
@@ -2851,6 +2872,7 @@ void Master::disconnect(Framework* framework)
   LOG(INFO) << "Disconnecting framework " << *framework;
 
   framework->connected = false;
+  framework->invalidateSnapshot();
 
   if (framework->pid.isSome()) {
     // Remove the framework from authenticated. This is safe because
@@ -2876,6 +2898,7 @@ void Master::deactivate(Framework* framework)
 
   // Stop sending offers here for now.
   framework->active = false;
+  framework->invalidateSnapshot();
 
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
@@ -2929,6 +2952,7 @@ void Master::deactivate(Slave* slave)
   LOG(INFO) << "Deactivating agent " << *slave;
 
   slave->active = false;
+  slave->invalidateSnapshot();
 
   allocator->deactivateSlave(slave->id);
 
@@ -3486,6 +3510,7 @@ void Master::accept(
           // will not be launched.
           if (!framework->pendingTasks.contains(task.task_id())) {
             framework->pendingTasks[task.task_id()] = task;
+            framework->invalidateSnapshot();
           }
         }
         break;
@@ -3871,6 +3896,7 @@ void Master::_accept(
 
           // Remove from pending tasks.
           framework->pendingTasks.erase(task.task_id());
+          framework->invalidateSnapshot();
 
           CHECK(!authorization.isDiscarded());
 
@@ -4223,6 +4249,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
     framework->pendingTasks.erase(taskId);
+    framework->invalidateSnapshot();
 
     const StatusUpdate& update = protobuf::createStatusUpdate(
         framework->id(),
@@ -4828,6 +4855,7 @@ void Master::reregisterSlave(
 
   if (slave != nullptr) {
     slave->reregisteredTime = Clock::now();
+    slave->invalidateSnapshot();
 
     // NOTE: This handles the case where a slave tries to
     // re-register with an existing master (e.g. because of a
@@ -4870,6 +4898,8 @@ void Master::reregisterSlave(
     // Update slave's version after re-registering successfully.
     slave->version = version;
 
+    slave->invalidateSnapshot();
+
     // Reconcile tasks between master and the slave.
     // NOTE: This sends the re-registered message, including tasks
     // that need to be reconciled by the slave.
@@ -4883,6 +4913,7 @@ void Master::reregisterSlave(
       slave->connected = true;
       dispatch(slave->observer, &SlaveObserver::reconnect);
       slave->active = true;
+      slave->invalidateSnapshot();
       allocator->activateSlave(slave->id);
     }
 
@@ -5058,6 +5089,7 @@ void Master::__reregisterSlave(
       // TODO(joerg84): Consider recovering this information from
       // registrar instead of from agents.
       this->frameworks.recovered[frameworkInfo.id()] = frameworkInfo;
+      invalidateSnapshot();
     }
   }
 
@@ -5149,6 +5181,7 @@ void Master::updateSlave(
 
   slave->totalResources =
     slave->totalResources.nonRevocable() + oversubscribedResources.revocable();
+  slave->invalidateSnapshot();
 
   // Now, update the allocator with the new estimate.
   allocator->updateSlave(slaveId, oversubscribedResources);
@@ -6223,6 +6256,8 @@ void Master::addFramework(Framework* framework)
     frameworks.recovered.erase(framework->id());
   }
 
+  invalidateSnapshot();
+
   if (framework->pid.isSome()) {
     link(framework->pid.get());
   } else {
@@ -6394,6 +6429,8 @@ void Master::_failoverFramework(Framework* framework)
     allocator->activateFramework(framework->id());
   }
 
+  framework->invalidateSnapshot();
+
   // The scheduler driver safely ignores any duplicate registration
   // messages, so we don't need to compare the old and new pids here.
   FrameworkRegisteredMessage message;
@@ -6437,6 +6474,7 @@ void Master::removeFramework(Framework* framework)
 
   // Remove the pending tasks from the framework.
   framework->pendingTasks.clear();
+  framework->invalidateSnapshot();
 
   // Remove pointers to the framework's tasks in slaves.
   foreachvalue (Task* task, utils::copy(framework->tasks)) {
@@ -6521,6 +6559,7 @@ void Master::removeFramework(Framework* framework)
   }
 
   framework->unregisteredTime = Clock::now();
+  framework->invalidateSnapshot();
 
   const string& role = framework->info.role();
   CHECK(activeRoles.contains(role))
@@ -6563,6 +6602,8 @@ void Master::removeFramework(Framework* framework)
 
   // The completedFramework buffer now owns the framework pointer.
   frameworks.completed.push_back(shared_ptr<Framework>(framework));
+
+  invalidateSnapshot();
 }
 
 
@@ -6621,6 +6662,8 @@ void Master::addSlave(
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
 
+  invalidateSnapshot();
+
   link(slave->pid);
 
   // Map the slave to the machine it is running on.
@@ -6791,6 +6834,8 @@ void Master::removeSlave(
   slaves.removed.put(slave->id, Nothing());
   authenticated.erase(slave->pid);
 
+  invalidateSnapshot();
+
   // Remove the slave from the `machines` mapping.
   CHECK(machines.contains(slave->machineId));
   CHECK(machines[slave->machineId].slaves.contains(slave->id));
@@ -6956,6 +7001,15 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   // MESOS-1746.
   task->mutable_statuses(task->statuses_size() - 1)->clear_data();
 
+  // The task is shared with the `Framework` (if it is registered) and
+  // orphan tasks are part of the master's snapshot.
+  Framework* framework = getFramework(task->framework_id());
+  if (framework != nullptr) {
+    framework->invalidateSnapshot(task->task_id());
+  }
+
+  invalidateSnapshot();
+
   LOG(INFO) << "Updating the state of task " << task->task_id()
             << " of framework " << task->framework_id()
             << " (latest state: " << task->state()
@@ -6975,7 +7029,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
     slave->taskTerminated(task);
 
-    Framework* framework = getFramework(task->framework_id());
     if (framework != nullptr) {
       framework->taskTerminated(task);
     }
@@ -7558,6 +7611,8 @@ void Slave::addTask(Task* task)
     usedResources[frameworkId] += task->resources();
   }
 
+  invalidateSnapshot();
+
   if (!master->subscribers.subscribed.empty()) {
     master->subscribers.send(protobuf::master::event::createTaskAdded(*task));
   }
@@ -7568,13 +7623,52 @@ void Slave::addTask(Task* task)
 }
 
 
+void Slave::invalidateSnapshot()
+{
+  snapshot.reset();
+  master->invalidateSnapshot();
+}
+
+
 void Master::Subscribers::send(const mesos::master::Event& event)
 {
   VLOG(1) << "Notifying all active subscribers about " << event.type() << " "
           << "event";
 
-  foreachvalue (Subscriber subscriber, subscribed) {
-    subscriber.http.send<mesos::master::Event, v1::master::Event>(event);
+  // The records for each content type, encoded on first use. Note
+  // that the event only needs to be evolved for JSON subscribers.
+  std::map<ContentType, string> records;
+
+  vector<UUID> slow;
+
+  foreachpair (const UUID& id, Subscriber& subscriber, subscribed) {
+    HttpConnection& http = subscriber.http;
+
+    if (http.writer.pending() > maxQueuedBytes.bytes()) {
+      LOG(WARNING) << "Disconnecting subscriber " << id << " which has "
+                   << Bytes(http.writer.pending()) << " of events queued";
+
+      http.close();
+      slow.push_back(id);
+      continue;
+    }
+
+    if (records.count(http.contentType) == 0) {
+      ::recordio::Encoder<mesos::master::Event> encoder(
+          [&http](const mesos::master::Event& event) {
+            return serialize(http.contentType, event);
+          });
+
+      records[http.contentType] = encoder.encode(event);
+    }
+
+    http.writer.write(records.at(http.contentType));
+  }
+
+  // NOTE: Closing the write end of the pipe does not trigger the
+  // subscriber's `closed()` future, so we remove them here.
+  foreach (const UUID& id, slow) {
+    subscribed.erase(id);
   }
 }
 
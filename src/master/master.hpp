@@ -75,6 +75,7 @@
 #include "master/machine.hpp"
 #include "master/metrics.hpp"
 #include "master/registrar.hpp"
+#include "master/state_snapshot.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -181,6 +182,8 @@ struct Slave
     if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
       usedResources.erase(frameworkId);
     }
+
+    invalidateSnapshot();
   }
 
   void removeTask(Task* task)
@@ -204,6 +207,8 @@ struct Slave
     }
 
     killedTasks.remove(frameworkId, taskId);
+
+    invalidateSnapshot();
   }
 
   void addOffer(Offer* offer)
@@ -212,6 +217,8 @@ struct Slave
 
     offers.insert(offer);
     offeredResources += offer->resources();
+
+    invalidateSnapshot();
   }
 
   void removeOffer(Offer* offer)
@@ -220,6 +227,8 @@ struct Slave
 
     offeredResources -= offer->resources();
     offers.erase(offer);
+
+    invalidateSnapshot();
   }
 
   void addInverseOffer(InverseOffer* inverseOffer)
@@ -254,6 +263,8 @@ struct Slave
 
     executors[frameworkId][executorInfo.executor_id()] = executorInfo;
     usedResources[frameworkId] += executorInfo.resources();
+
+    invalidateSnapshot();
   }
 
   void removeExecutor(const FrameworkID& frameworkId,
@@ -269,6 +280,8 @@ struct Slave
     if (executors[frameworkId].empty()) {
       executors.erase(frameworkId);
     }
+
+    invalidateSnapshot();
   }
 
   void apply(const Offer::Operation& operation)
@@ -278,8 +291,16 @@ struct Slave
 
     totalResources = resources.get();
     checkpointedResources = totalResources.filter(needCheckpointing);
+
+    invalidateSnapshot();
   }
 
+  // Drops the cached snapshot of this agent, as well as the master's
+  // cached `StateSnapshot`. This must be called whenever any of the
+  // state that is copied into a `SlaveSnapshot` changes, including
+  // the tasks and executors that are exposed as orphans.
+  void invalidateSnapshot();
+
   Master* const master;
   const SlaveID id;
   const SlaveInfo info;
@@ -338,6 +359,10 @@ struct Slave
 
   SlaveObserver* observer;
 
+  // The snapshot of this agent exposed by the read-only endpoints.
+  // It is (re)built lazily, see `Master::Http::captureSnapshot()`.
+  std::shared_ptr<const SlaveSnapshot> snapshot;
+
 private:
   Slave(const Slave&);              // No copying.
   Slave& operator=(const Slave&); // No assigning.
@@ -367,12 +392,36 @@ struct HttpConnection
   template <typename Message, typename Event = v1::scheduler::Event>
   bool send(const Message& message)
   {
-    ::recordio::Encoder<Event> encoder (lambda::bind(
-        serialize, contentType, lambda::_1));
+    ::recordio::Encoder<Event> encoder([this](const Event& event) {
+      return serialize(contentType, event);
+    });
 
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Internal events are serialized without being evolved whenever
+  // possible, see `serialize()` in 'internal/evolve.hpp'.
+  bool send(const scheduler::Event& event)
+  {
+    ::recordio::Encoder<scheduler::Event> encoder(
+        [this](const scheduler::Event& event) {
+          return serialize(contentType, event);
+        });
+
+    return writer.write(encoder.encode(event));
+  }
+
+  // Offers are the largest events sent to schedulers, so rather than
+  // evolving them we send them as an internal event.
+  bool send(const ResourceOffersMessage& message)
+  {
+    scheduler::Event event;
+    event.set_type(scheduler::Event::OFFERS);
+    event.mutable_offers()->mutable_offers()->CopyFrom(message.offers());
+
+    return send(event);
+  }
+
   bool close()
   {
     return writer.close();
@@ -1306,6 +1355,15 @@ private:
   private:
     JSON::Object __flags() const;
 
+    // Returns a snapshot of the master's framework, agent and task
+    // model, from which the read-only endpoints are served. Only the
+    // given `StateSnapshot::Section`s are guaranteed to be captured.
+    // The snapshot is cached until the master's state changes, and
+    // only the frameworks and agents that changed since the previous
+    // snapshot are copied again.
+    std::shared_ptr<const StateSnapshot> captureSnapshot(
+        uint32_t sections) const;
+
     class FlagsError; // Forward declaration.
 
     process::Future<Try<JSON::Object, FlagsError>> _flags(
@@ -1388,7 +1446,10 @@ private:
         const Option<std::string>& principal,
         ContentType contentType) const;
 
-    mesos::master::Response::GetAgents _getAgents() const;
+    // NOTE: The `_get*` helpers below only read from the snapshot,
+    // so they can be invoked off the master actor.
+    static mesos::master::Response::GetAgents _getAgents(
+        const StateSnapshot& snapshot);
 
     process::Future<process::http::Response> getFlags(
         const mesos::master::Call& call,
@@ -1465,9 +1526,10 @@ private:
         const Option<std::string>& principal,
         ContentType contentType) const;
 
-    mesos::master::Response::GetTasks _getTasks(
+    static mesos::master::Response::GetTasks _getTasks(
+        const StateSnapshot& snapshot,
         const process::Owned<ObjectApprover>& frameworksApprover,
-        const process::Owned<ObjectApprover>& tasksApprover) const;
+        const process::Owned<ObjectApprover>& tasksApprover);
 
     process::Future<process::http::Response> createVolumes(
         const mesos::master::Call& call,
@@ -1494,27 +1556,30 @@ private:
         const Option<std::string>& principal,
         ContentType contentType) const;
 
-    mesos::master::Response::GetFrameworks _getFrameworks(
-        const process::Owned<ObjectApprover>& frameworksApprover) const;
+    static mesos::master::Response::GetFrameworks _getFrameworks(
+        const StateSnapshot& snapshot,
+        const process::Owned<ObjectApprover>& frameworksApprover);
 
     process::Future<process::http::Response> getExecutors(
         const mesos::master::Call& call,
         const Option<std::string>& principal,
         ContentType contentType) const;
 
-    mesos::master::Response::GetExecutors _getExecutors(
+    static mesos::master::Response::GetExecutors _getExecutors(
+        const StateSnapshot& snapshot,
         const process::Owned<ObjectApprover>& frameworksApprover,
-        const process::Owned<ObjectApprover>& executorsApprover) const;
+        const process::Owned<ObjectApprover>& executorsApprover);
 
     process::Future<process::http::Response> getState(
         const mesos::master::Call& call,
         const Option<std::string>& principal,
         ContentType contentType) const;
 
-    mesos::master::Response::GetState _getState(
+    static mesos::master::Response::GetState _getState(
+        const StateSnapshot& snapshot,
         const process::Owned<ObjectApprover>& frameworksApprover,
         const process::Owned<ObjectApprover>& taskApprover,
-        const process::Owned<ObjectApprover>& executorsApprover) const;
+        const process::Owned<ObjectApprover>& executorsApprover);
 
     process::Future<process::http::Response> subscribe(
         const mesos::master::Call& call,
@@ -1740,6 +1805,9 @@ private:
 
   struct Subscribers
   {
+    Subscribers(const Flags& masterFlags)
+      : maxQueuedBytes(masterFlags.max_subscriber_queued_bytes) {}
+
     // Represents a client subscribed to the 'api/vX' endpoint.
     //
     // TODO(anand): Add support for filtering. Some subscribers
@@ -1753,8 +1821,14 @@ private:
     };
 
     // Sends the event to all subscribers connected to the 'api/vX' endpoint.
+    // The event is encoded once for each content type rather than for
+    // each subscriber. Subscribers that have more than
+    // `maxQueuedBytes` of events queued are disconnected.
     void send(const mesos::master::Event& event);
 
+    // See the `--max_subscriber_queued_bytes` flag.
+    const Bytes maxQueuedBytes;
+
     // Active subscribers to the 'api/vX' endpoint keyed by the stream
     // identifier.
     hashmap<UUID, Subscriber> subscribed;
@@ -1831,6 +1905,11 @@ private:
     return offers.size();
   }
 
+  double _operator_event_stream_subscribers()
+  {
+    return subscribers.subscribed.size();
+  }
+
   double _event_queue_messages()
   {
     return static_cast<double>(eventCount<process::MessageEvent>());
@@ -1846,6 +1925,16 @@ private:
     return static_cast<double>(eventCount<process::HttpEvent>());
   }
 
+  double _http_streaming_bytes()
+  {
+    return static_cast<double>(metrics->streamingBytes.load());
+  }
+
+  double _http_streaming_peak_bytes()
+  {
+    return static_cast<double>(metrics->streamingPeakBytes.load());
+  }
+
   double _tasks_staging();
   double _tasks_starting();
   double _tasks_running();
@@ -1863,6 +1952,23 @@ private:
 
   Option<process::Time> electedTime; // Time when this master is elected.
 
+  // Drops the cached snapshot of the master's state, see
+  // `Master::Http::captureSnapshot()`, as well as the cached responses
+  // of the read-only endpoints. The snapshots of individual frameworks
+  // and agents are invalidated by `Framework` and `Slave`.
+  void invalidateSnapshot()
+  {
+    snapshot.reset();
+    invalidateCache();
+  }
+
+  // The snapshot served by the read-only endpoints, if it is still
+  // up to date with the master's state.
+  std::shared_ptr<const StateSnapshot> snapshot;
+
+  // Version of the most recently built `StateSnapshot`.
+  uint64_t snapshotVersion;
+
   // Validates the framework including authorization.
   // Returns None if the framework is valid.
   // Returns Error if the framework is invalid.
@@ -2085,6 +2191,8 @@ struct Framework
       totalUsedResources += task->resources();
       usedResources[task->slave_id()] += task->resources();
     }
+
+    invalidateSnapshot();
   }
 
   // Notification of task termination, for resource accounting.
@@ -2103,6 +2211,8 @@ struct Framework
     if (usedResources[task->slave_id()].empty()) {
       usedResources.erase(task->slave_id());
     }
+
+    invalidateSnapshot();
   }
 
   // Sends a message to the connected framework.
@@ -2129,6 +2239,8 @@ struct Framework
   {
     // TODO(adam-mesos): Check if completed task already exists.
     completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+
+    invalidateSnapshot();
   }
 
   void removeTask(Task* task)
@@ -2148,6 +2260,9 @@ struct Framework
     addCompletedTask(*task);
 
     tasks.erase(task->task_id());
+    taskSnapshots.erase(task->task_id());
+
+    invalidateSnapshot();
   }
 
   void addOffer(Offer* offer)
@@ -2156,6 +2271,8 @@ struct Framework
     offers.insert(offer);
     totalOfferedResources += offer->resources();
     offeredResources[offer->slave_id()] += offer->resources();
+
+    invalidateSnapshot();
   }
 
   void removeOffer(Offer* offer)
@@ -2170,6 +2287,8 @@ struct Framework
     }
 
     offers.erase(offer);
+
+    invalidateSnapshot();
   }
 
   void addInverseOffer(InverseOffer* inverseOffer)
@@ -2177,6 +2296,8 @@ struct Framework
     CHECK(!inverseOffers.contains(inverseOffer))
       << "Duplicate inverse offer " << inverseOffer->id();
     inverseOffers.insert(inverseOffer);
+
+    invalidateSnapshot();
   }
 
   void removeInverseOffer(InverseOffer* inverseOffer)
@@ -2185,6 +2306,8 @@ struct Framework
       << "Unknown inverse offer " << inverseOffer->id();
 
     inverseOffers.erase(inverseOffer);
+
+    invalidateSnapshot();
   }
 
   bool hasExecutor(const SlaveID& slaveId,
@@ -2204,6 +2327,8 @@ struct Framework
     executors[slaveId][executorInfo.executor_id()] = executorInfo;
     totalUsedResources += executorInfo.resources();
     usedResources[slaveId] += executorInfo.resources();
+
+    invalidateSnapshot();
   }
 
   void removeExecutor(const SlaveID& slaveId,
@@ -2224,6 +2349,15 @@ struct Framework
     if (executors[slaveId].empty()) {
       executors.erase(slaveId);
     }
+
+    if (executorSnapshots.contains(slaveId)) {
+      executorSnapshots[slaveId].erase(executorId);
+      if (executorSnapshots[slaveId].empty()) {
+        executorSnapshots.erase(slaveId);
+      }
+    }
+
+    invalidateSnapshot();
   }
 
   const FrameworkID id() const { return info.id(); }
@@ -2293,6 +2427,8 @@ struct Framework
     } else {
       info.clear_labels();
     }
+
+    invalidateSnapshot();
   }
 
   void updateConnection(const process::UPID& newPid)
@@ -2305,6 +2441,8 @@ struct Framework
 
     // TODO(benh): unlink(oldPid);
     pid = newPid;
+
+    invalidateSnapshot();
   }
 
   void updateConnection(const HttpConnection& newHttp)
@@ -2324,6 +2462,8 @@ struct Framework
     CHECK_NONE(http);
 
     http = newHttp;
+
+    invalidateSnapshot();
   }
 
   // Closes the HTTP connection and stops the heartbeat.
@@ -2348,6 +2488,26 @@ struct Framework
     heartbeater = None();
   }
 
+  // Drops the cached snapshot of this framework, as well as the
+  // master's cached `StateSnapshot`. This must be called whenever any
+  // of the state that is copied into a `FrameworkSnapshot` changes.
+  // The snapshots of the tasks and executors are kept and shared by
+  // the next `FrameworkSnapshot`, so that rebuilding it only copies
+  // what changed.
+  void invalidateSnapshot()
+  {
+    snapshot.reset();
+    master->invalidateSnapshot();
+  }
+
+  // Like above, but also drops the snapshot of the given task. This
+  // must be called whenever an (active) task is modified in place.
+  void invalidateSnapshot(const TaskID& taskId)
+  {
+    taskSnapshots.erase(taskId);
+    invalidateSnapshot();
+  }
+
   void heartbeat()
   {
     CHECK_NONE(heartbeater);
@@ -2434,6 +2594,19 @@ struct Framework
   // This is only set for HTTP frameworks.
   Option<process::Owned<Heartbeater>> heartbeater;
 
+  // The snapshot of this framework exposed by the read-only
+  // endpoints. It is (re)built lazily, see
+  // `Master::Http::captureSnapshot()`.
+  std::shared_ptr<const FrameworkSnapshot> snapshot;
+
+  // The snapshots of the active tasks and of the executors that are
+  // shared by the `FrameworkSnapshot`s, (re)built lazily along with
+  // them. Executors are never modified once added, while a task's
+  // snapshot is dropped whenever the task is updated.
+  hashmap<TaskID, std::shared_ptr<const Task>> taskSnapshots;
+  hashmap<SlaveID, hashmap<ExecutorID, std::shared_ptr<const ExecutorInfo>>>
+    executorSnapshots;
+
 private:
   Framework(const Framework&);              // No copying.
   Framework& operator=(const Framework&); // No assigning.
@@ -71,6 +71,9 @@ Metrics::Metrics(const Master& master)
     outstanding_offers(
         "master/outstanding_offers",
         defer(master, &Master::_outstanding_offers)),
+    operator_event_stream_subscribers(
+        "master/operator_event_stream_subscribers",
+        defer(master, &Master::_operator_event_stream_subscribers)),
     tasks_staging(
         "master/tasks_staging",
         defer(master, &Master::_tasks_staging)),
@@ -181,7 +184,20 @@ Metrics::Metrics(const Master& master)
     slave_shutdowns_completed(
         "master/slave_shutdowns_completed"),
     slave_shutdowns_canceled(
-        "master/slave_shutdowns_canceled")
+        "master/slave_shutdowns_canceled"),
+    http_snapshot_capture(
+        "master/http/snapshot_capture",
+        Hours(1)),
+    http_snapshots_reused(
+        "master/http/snapshots_reused"),
+    http_streaming_bytes(
+        "master/http/streaming_bytes",
+        defer(master, &Master::_http_streaming_bytes)),
+    http_streaming_peak_bytes(
+        "master/http/streaming_peak_bytes",
+        defer(master, &Master::_http_streaming_peak_bytes)),
+    streamingBytes(0),
+    streamingPeakBytes(0)
 {
   // TODO(dhamon): Check return values of 'add'.
   process::metrics::add(uptime_secs);
@@ -199,6 +215,8 @@ Metrics::Metrics(const Master& master)
 
   process::metrics::add(outstanding_offers);
 
+  process::metrics::add(operator_event_stream_subscribers);
+
   process::metrics::add(tasks_staging);
   process::metrics::add(tasks_starting);
   process::metrics::add(tasks_running);
@@ -267,6 +285,11 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(slave_shutdowns_completed);
   process::metrics::add(slave_shutdowns_canceled);
 
+  process::metrics::add(http_snapshot_capture);
+  process::metrics::add(http_snapshots_reused);
+  process::metrics::add(http_streaming_bytes);
+  process::metrics::add(http_streaming_peak_bytes);
+
   // Create resource gauges.
   // TODO(dhamon): Set these up dynamically when adding a slave based on the
   // resources the slave exposes.
@@ -336,6 +359,8 @@ Metrics::~Metrics()
 
   process::metrics::remove(outstanding_offers);
 
+  process::metrics::remove(operator_event_stream_subscribers);
+
   process::metrics::remove(tasks_staging);
   process::metrics::remove(tasks_starting);
   process::metrics::remove(tasks_running);
@@ -404,6 +429,11 @@ Metrics::~Metrics()
   process::metrics::remove(slave_shutdowns_completed);
   process::metrics::remove(slave_shutdowns_canceled);
 
+  process::metrics::remove(http_snapshot_capture);
+  process::metrics::remove(http_snapshots_reused);
+  process::metrics::remove(http_streaming_bytes);
+  process::metrics::remove(http_streaming_peak_bytes);
+
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
   }
@@ -17,13 +17,16 @@
 #ifndef __MASTER_METRICS_HPP__
 #define __MASTER_METRICS_HPP__
 
+#include <atomic>
 #include <string>
 #include <vector>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "mesos/mesos.hpp"
@@ -56,6 +59,8 @@ struct Metrics
 
   process::metrics::Gauge outstanding_offers;
 
+  process::metrics::Gauge operator_event_stream_subscribers;
+
   // Task state metrics.
   process::metrics::Gauge tasks_staging;
   process::metrics::Gauge tasks_starting;
@@ -179,6 +184,24 @@ struct Metrics
   process::metrics::Counter slave_shutdowns_completed;
   process::metrics::Counter slave_shutdowns_canceled;
 
+  // Time the master actor spends capturing the snapshots that the
+  // read-only endpoints (e.g., /state) are serialized from.
+  process::metrics::Timer<Milliseconds> http_snapshot_capture;
+
+  // Number of requests served from a snapshot that was captured for
+  // an earlier request, since the master's state did not change.
+  process::metrics::Counter http_snapshots_reused;
+
+  // Memory held by the responses being streamed by the read-only
+  // endpoints, i.e., their snapshots and unsent output.
+  process::metrics::Gauge http_streaming_bytes;
+  process::metrics::Gauge http_streaming_peak_bytes;
+
+  // NOTE: These are updated by the threads serializing the
+  // responses, hence atomic.
+  std::atomic<size_t> streamingBytes;
+  std::atomic<size_t> streamingPeakBytes;
+
   // Non-revocable resources.
   std::vector<process::metrics::Gauge> resources_total;
   std::vector<process::metrics::Gauge> resources_used;
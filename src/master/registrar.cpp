@@ -14,13 +14,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
+#include <list>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <mesos/state/protobuf.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -30,10 +35,13 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
@@ -41,6 +49,7 @@
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
 
+#include "master/constants.hpp"
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
 
@@ -65,11 +74,17 @@ using process::TLDR;
 
 using process::http::OK;
 
+using process::metrics::Counter;
 using process::metrics::Gauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
 using std::string;
+using std::tuple;
+using std::vector;
+
+using google::protobuf::RepeatedPtrField;
 
 namespace mesos {
 namespace internal {
@@ -87,6 +102,10 @@ public:
       const Option<string>& _authenticationRealm)
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
+      sequence(0),
+      deltaCount(0),
+      deltaBytes(0),
+      snapshotBytes(0),
       updating(false),
       flags(_flags),
       state(_state),
@@ -154,13 +173,15 @@ private:
             "registrar/registry_size_bytes",
             defer(process, &RegistrarProcess::_registry_size_bytes)),
         state_fetch("registrar/state_fetch"),
-        state_store("registrar/state_store", Days(1))
+        state_store("registrar/state_store", Days(1)),
+        state_store_bytes("registrar/state_store_bytes")
     {
       process::metrics::add(queued_operations);
       process::metrics::add(registry_size_bytes);
 
       process::metrics::add(state_fetch);
       process::metrics::add(state_store);
+      process::metrics::add(state_store_bytes);
     }
 
     ~Metrics()
@@ -170,6 +191,7 @@ private:
 
       process::metrics::remove(state_fetch);
       process::metrics::remove(state_store);
+      process::metrics::remove(state_store_bytes);
     }
 
     Gauge queued_operations;
@@ -177,6 +199,9 @@ private:
 
     Timer<Milliseconds> state_fetch;
     Timer<Milliseconds> state_store;
+
+    // Number of bytes of snapshots and deltas stored.
+    Counter state_store_bytes;
   } metrics;
 
   // Gauge handlers.
@@ -187,25 +212,41 @@ private:
 
   Future<double> _registry_size_bytes()
   {
-    if (variable.isSome()) {
-      return variable.get().get().ByteSize();
+    if (current.isSome()) {
+      return current->ByteSize();
     }
 
     return Failure("Not recovered yet");
   }
 
+  // The latest snapshot of the registry and the ring of deltas.
+  typedef tuple<Variable<Registry>, list<Variable<RegistryDelta>>> Recovery;
+
   // Continuations.
   void _recover(
       const MasterInfo& info,
-      const Future<Variable<Registry> >& recovery);
+      const Future<Recovery>& recovery);
   void __recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
   // Helper for updating state (performing store).
   void update();
   void _update(
-      const Future<Option<Variable<Registry> > >& store,
-      deque<Owned<Operation> > operations);
+      const Future<bool>& store,
+      deque<Owned<Operation> > operations,
+      Owned<Registry> registry);
+
+  // Helpers for storing a snapshot of the whole registry, or only a
+  // delta, and updating the bookkeeping of the deltas once stored.
+  Future<bool> snapshot(Registry registry);
+  bool _snapshot(
+      size_t bytes,
+      const Option<Variable<Registry>>& variable);
+  Future<bool> append(RegistryDelta delta);
+  bool _append(
+      size_t index,
+      size_t bytes,
+      const Option<Variable<RegistryDelta>>& variable);
 
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
@@ -213,7 +254,22 @@ private:
   // performing more State storage operations.
   void abort(const string& message);
 
+  // The registry, i.e., the latest snapshot with all the deltas
+  // stored since applied to it.
+  Option<Registry> current;
+
+  // The latest snapshot of the registry, and the ring of variables
+  // holding the deltas, indexed by sequence number. The ring holds
+  // the last 'REGISTRY_DELTAS' deltas, which always include all the
+  // deltas stored since the latest snapshot.
   Option<Variable<Registry> > variable;
+  vector<Variable<RegistryDelta>> deltas;
+
+  uint64_t sequence; // Sequence number of the next delta.
+  size_t deltaCount; // Number of deltas stored since the snapshot.
+  size_t deltaBytes; // Size of the deltas stored since the snapshot.
+  size_t snapshotBytes; // Size of the snapshot.
+
   deque<Owned<Operation> > operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -257,14 +313,179 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Helpers for comparing the sections of the registry.
+template <typename T>
+static bool equals(const T& left, const T& right)
+{
+  return left.SerializePartialAsString() == right.SerializePartialAsString();
+}
+
+
+template <typename T>
+static bool equals(
+    const RepeatedPtrField<T>& left,
+    const RepeatedPtrField<T>& right)
+{
+  if (left.size() != right.size()) {
+    return false;
+  }
+
+  for (int i = 0; i < left.size(); i++) {
+    if (!equals(left.Get(i), right.Get(i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// Returns the delta that turns the registry 'from' into 'to'.
+//
+// NOTE: Agents are compared by their IDs, since operations only ever
+// admit or remove agents, rather than modify the info of an agent.
+static RegistryDelta diff(const Registry& from, const Registry& to)
+{
+  RegistryDelta delta;
+
+  if (to.has_master() &&
+      (!from.has_master() || !equals(from.master(), to.master()))) {
+    delta.mutable_master()->CopyFrom(to.master());
+  }
+
+  // Operations remove agents from and append agents to the list of
+  // agents, so a single pass determines the agents that were kept
+  // (which retain their order), removed, and added.
+  const RepeatedPtrField<Registry::Slave>& before = from.slaves().slaves();
+  const RepeatedPtrField<Registry::Slave>& after = to.slaves().slaves();
+
+  int j = 0;
+
+  for (int i = 0; i < before.size(); i++) {
+    if (j < after.size() &&
+        before.Get(i).info().id() == after.Get(j).info().id()) {
+      j++;
+    } else {
+      delta.add_removed_slaves()->CopyFrom(before.Get(i).info().id());
+    }
+  }
+
+  for (; j < after.size(); j++) {
+    delta.add_added_slaves()->CopyFrom(after.Get(j));
+  }
+
+  if (!equals(from.machines(), to.machines())) {
+    delta.mutable_machines()->CopyFrom(to.machines());
+  }
+
+  if (!equals(from.schedules(), to.schedules())) {
+    delta.mutable_schedules()->mutable_schedules()->CopyFrom(to.schedules());
+  }
+
+  if (!equals(from.quotas(), to.quotas())) {
+    delta.mutable_quotas()->mutable_quotas()->CopyFrom(to.quotas());
+  }
+
+  if (!equals(from.weights(), to.weights())) {
+    delta.mutable_weights()->mutable_weights()->CopyFrom(to.weights());
+  }
+
+  return delta;
+}
+
+
+// Replays the deltas on the registry in the order of their sequence
+// numbers.
+static void replay(Registry* registry, vector<RegistryDelta> deltas)
+{
+  std::sort(
+      deltas.begin(),
+      deltas.end(),
+      [](const RegistryDelta& left, const RegistryDelta& right) {
+        return left.sequence() < right.sequence();
+      });
+
+  // Rather than replaying the deltas on the list of agents one by
+  // one, we determine the agents that end up removed or added (the
+  // last delta that mentions an agent wins), and rebuild the list of
+  // agents once.
+  hashset<SlaveID> removed;
+  hashmap<SlaveID, Registry::Slave> added;
+  vector<SlaveID> order;
+
+  foreach (const RegistryDelta& delta, deltas) {
+    if (delta.has_master()) {
+      registry->mutable_master()->CopyFrom(delta.master());
+    }
+
+    foreach (const SlaveID& id, delta.removed_slaves()) {
+      added.erase(id);
+      removed.insert(id);
+    }
+
+    foreach (const Registry::Slave& slave, delta.added_slaves()) {
+      removed.erase(slave.info().id());
+      added[slave.info().id()] = slave;
+      order.push_back(slave.info().id());
+    }
+
+    if (delta.has_machines()) {
+      registry->mutable_machines()->CopyFrom(delta.machines());
+    }
+
+    if (delta.has_schedules()) {
+      registry->mutable_schedules()->CopyFrom(delta.schedules().schedules());
+    }
+
+    if (delta.has_quotas()) {
+      registry->mutable_quotas()->CopyFrom(delta.quotas().quotas());
+    }
+
+    if (delta.has_weights()) {
+      registry->mutable_weights()->CopyFrom(delta.weights().weights());
+    }
+  }
+
+  if (!removed.empty() || !added.empty()) {
+    Registry::Slaves slaves;
+
+    foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+      const SlaveID& id = slave.info().id();
+
+      if (removed.contains(id)) {
+        continue;
+      }
+
+      // An agent that is in the snapshot, and was removed and added
+      // again since, keeps its position.
+      if (added.contains(id)) {
+        slaves.add_slaves()->CopyFrom(added.at(id));
+        added.erase(id);
+      } else {
+        slaves.add_slaves()->CopyFrom(slave);
+      }
+    }
+
+    foreach (const SlaveID& id, order) {
+      if (added.contains(id)) {
+        slaves.add_slaves()->CopyFrom(added.at(id));
+        added.erase(id);
+      }
+    }
+
+    registry->mutable_slaves()->Swap(&slaves);
+  }
+}
+
+
 Future<Response> RegistrarProcess::registry(
     const Request& request,
     const Option<string>& /* principal */)
 {
   JSON::Object result;
 
-  if (variable.isSome()) {
-    result = JSON::protobuf(variable.get().get());
+  if (current.isSome()) {
+    result = JSON::protobuf(current.get());
   }
 
   return OK(result, request.url.query.get("jsonp"));
@@ -332,10 +553,17 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
     LOG(INFO) << "Recovering registrar";
 
     metrics.state_fetch.start();
-    state->fetch<Registry>("registry")
+
+    list<Future<Variable<RegistryDelta>>> deltas;
+    for (size_t i = 0; i < REGISTRY_DELTAS; i++) {
+      deltas.push_back(
+          state->fetch<RegistryDelta>("registry_delta_" + stringify(i)));
+    }
+
+    collect(state->fetch<Registry>("registry"), collect(deltas))
       .after(flags.registry_fetch_timeout,
              lambda::bind(
-                 &timeout<Variable<Registry> >,
+                 &timeout<Recovery>,
                  "fetch",
                  flags.registry_fetch_timeout,
                  lambda::_1))
@@ -350,7 +578,7 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 
 void RegistrarProcess::_recover(
     const MasterInfo& info,
-    const Future<Variable<Registry> >& recovery)
+    const Future<Recovery>& recovery)
 {
   updating = false;
 
@@ -362,12 +590,66 @@ void RegistrarProcess::_recover(
   } else {
     Duration elapsed = metrics.state_fetch.stop();
 
+    // Save the snapshot and the deltas.
+    variable = std::get<0>(recovery.get());
+    deltas.assign(
+        std::get<1>(recovery.get()).begin(),
+        std::get<1>(recovery.get()).end());
+
+    Registry registry = variable->get();
+
+    snapshotBytes = registry.ByteSize();
+
+    // Only the deltas stored after the snapshot are replayed, i.e.,
+    // those numbered from the 'delta_sequence' of the snapshot on.
+    // A snapshot without a 'delta_sequence' was stored by a master
+    // that doesn't store deltas, so all the deltas precede it.
+    //
+    // NOTE: Deltas that precede the snapshot must not be replayed:
+    // e.g., replaying the delta that added an agent which was then
+    // removed by the snapshot would add the agent back.
+    vector<RegistryDelta> replayed;
+    deltaBytes = 0;
+
+    sequence = registry.delta_sequence();
+
+    foreach (const Variable<RegistryDelta>& stored, deltas) {
+      const RegistryDelta delta = stored.get();
+
+      if (!delta.has_sequence()) {
+        continue; // Never stored.
+      }
+
+      // Number the next delta after all the deltas in the ring, so
+      // that the deltas which precede the snapshot are never taken
+      // for ones that follow it.
+      sequence = std::max(sequence, delta.sequence() + 1);
+
+      if (registry.has_delta_sequence() &&
+          delta.sequence() >= registry.delta_sequence()) {
+        replayed.push_back(delta);
+        deltaBytes += delta.ByteSize();
+      }
+    }
+
+    deltaCount = replayed.size();
+
+    // Make sure the next update stores a snapshot that covers the
+    // deltas if the current snapshot doesn't say which ones it does.
+    if (!registry.has_delta_sequence()) {
+      deltaCount = REGISTRY_DELTAS;
+    }
+
+    replay(&registry, replayed);
+
+    registry.clear_delta_sequence();
+
     LOG(INFO) << "Successfully fetched the registry"
-              << " (" << Bytes(recovery.get().get().ByteSize()) << ")"
+              << " (" << Bytes(registry.ByteSize()) << ")"
               << " in " << elapsed;
 
     // Save the registry.
-    variable = recovery.get();
+    current = registry;
 
     // Perform the Recover operation to add the new MasterInfo.
     Owned<Operation> operation(new Recover(info));
@@ -394,11 +676,11 @@ void RegistrarProcess::__recover(const Future<bool>& recover)
   } else {
     LOG(INFO) << "Successfully recovered registrar";
 
-    // At this point _update() has updated 'variable' to contain
+    // At this point _update() has updated 'current' to contain
     // the Registry with the latest MasterInfo.
     // Set the promise and un-gate any pending operations.
-    CHECK_SOME(variable);
-    recovered.get()->set(variable.get().get());
+    CHECK_SOME(current);
+    recovered.get()->set(current.get());
   }
 }
 
@@ -420,7 +702,7 @@ Future<bool> RegistrarProcess::_apply(Owned<Operation> operation)
     return Failure(error.get());
   }
 
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
 
   operations.push_back(operation);
   Future<bool> future = operation->future();
@@ -439,7 +721,7 @@ void RegistrarProcess::update()
 
   CHECK(!updating);
   CHECK_NONE(error);
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
 
   // Time how long it takes to apply the operations.
   Stopwatch stopwatch;
@@ -447,18 +729,18 @@ void RegistrarProcess::update()
 
   updating = true;
 
-  // Create a snapshot of the current registry.
-  Registry registry = variable.get().get();
+  // Create a copy of the current registry.
+  Owned<Registry> registry(new Registry(current.get()));
 
   // Create the 'slaveIDs' accumulator.
   hashset<SlaveID> slaveIDs;
-  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
+  foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
     slaveIDs.insert(slave.info().id());
   }
 
   foreach (Owned<Operation> operation, operations) {
     // No need to process the result of the operation.
-    (*operation)(&registry, &slaveIDs, flags.registry_strict);
+    (*operation)(registry.get(), &slaveIDs, flags.registry_strict);
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
@@ -466,14 +748,29 @@ void RegistrarProcess::update()
 
   // Perform the store, and time the operation.
   metrics.state_store.start();
-  state->store(variable.get().mutate(registry))
+
+  // Store a snapshot of the whole registry unless deltas are enabled,
+  // as well as once the ring of deltas is full, or once the deltas add
+  // up to the size of the snapshot (which bounds the amount of data to
+  // read on recovery). Otherwise, only store what the operations
+  // changed.
+  Future<bool> store;
+  if (!flags.registry_deltas ||
+      deltaCount >= REGISTRY_DELTAS ||
+      deltaBytes >= snapshotBytes) {
+    store = snapshot(*registry);
+  } else {
+    store = append(diff(current.get(), *registry));
+  }
+
+  store
     .after(flags.registry_store_timeout,
            lambda::bind(
-               &timeout<Option<Variable<Registry> > >,
+               &timeout<bool>,
                "store",
                flags.registry_store_timeout,
                lambda::_1))
-    .onAny(defer(self(), &Self::_update, lambda::_1, operations));
+    .onAny(defer(self(), &Self::_update, lambda::_1, operations, registry));
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
@@ -481,13 +778,14 @@ void RegistrarProcess::update()
 
 
 void RegistrarProcess::_update(
-    const Future<Option<Variable<Registry> > >& store,
-    deque<Owned<Operation> > applied)
+    const Future<bool>& store,
+    deque<Owned<Operation> > applied,
+    Owned<Registry> registry)
 {
   updating = false;
 
   // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
+  if (!store.isReady() || !store.get()) {
     string message = "Failed to update 'registry': ";
 
     if (store.isFailed()) {
@@ -508,7 +806,7 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the 'registry' in " << elapsed;
 
-  variable = store.get().get();
+  current->Swap(registry.get());
 
   // Remove the operations.
   while (!applied.empty()) {
@@ -524,6 +822,76 @@ void RegistrarProcess::_update(
 }
 
 
+Future<bool> RegistrarProcess::snapshot(Registry registry)
+{
+  CHECK_SOME(variable);
+
+  // The snapshot covers all the deltas stored so far.
+  registry.set_delta_sequence(sequence);
+
+  return state->store(variable->mutate(registry))
+    .then(defer(self(), &Self::_snapshot, registry.ByteSize(), lambda::_1));
+}
+
+
+bool RegistrarProcess::_snapshot(
+    size_t bytes,
+    const Option<Variable<Registry>>& stored)
+{
+  if (stored.isNone()) {
+    return false; // Version mismatch.
+  }
+
+  variable = stored.get();
+
+  snapshotBytes = bytes;
+  deltaCount = 0;
+  deltaBytes = 0;
+
+  metrics.state_store_bytes += bytes;
+
+  return true;
+}
+
+
+Future<bool> RegistrarProcess::append(RegistryDelta delta)
+{
+  CHECK_EQ(REGISTRY_DELTAS, deltas.size());
+
+  delta.set_sequence(sequence);
+
+  const size_t index = sequence % REGISTRY_DELTAS;
+
+  return state->store(deltas[index].mutate(delta))
+    .then(defer(self(),
+                &Self::_append,
+                index,
+                delta.ByteSize(),
+                lambda::_1));
+}
+
+
+bool RegistrarProcess::_append(
+    size_t index,
+    size_t bytes,
+    const Option<Variable<RegistryDelta>>& stored)
+{
+  if (stored.isNone()) {
+    return false; // Version mismatch.
+  }
+
+  deltas[index] = stored.get();
+
+  sequence++;
+  deltaCount++;
+  deltaBytes += bytes;
+
+  metrics.state_store_bytes += bytes;
+
+  return true;
+}
+
+
 void RegistrarProcess::abort(const string& message)
 {
   error = Error(message);
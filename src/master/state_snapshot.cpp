@@ -0,0 +1,196 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include <stout/foreach.hpp>
+
+#include "master/master.hpp"
+#include "master/state_snapshot.hpp"
+
+using std::shared_ptr;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// NOTE: The sizes below are the encoded sizes of the protobufs, which
+// is a lower bound of the memory they use, but is proportional to it
+// and cheap to compute.
+static size_t bytes(const Resources& resources)
+{
+  size_t result = 0;
+
+  foreach (const Resource& resource, resources) {
+    result += resource.ByteSize();
+  }
+
+  return result;
+}
+
+
+FrameworkSnapshot::FrameworkSnapshot(Framework& framework)
+  : info(framework.info),
+    pid(framework.pid),
+    connected(framework.connected),
+    active(framework.active),
+    registeredTime(framework.registeredTime),
+    reregisteredTime(framework.reregisteredTime),
+    unregisteredTime(framework.unregisteredTime),
+    totalUsedResources(framework.totalUsedResources),
+    totalOfferedResources(framework.totalOfferedResources)
+{
+  pendingTasks.reserve(framework.pendingTasks.size());
+  foreachvalue (const TaskInfo& taskInfo, framework.pendingTasks) {
+    pendingTasks.push_back(taskInfo);
+  }
+
+  tasks.reserve(framework.tasks.size());
+  foreachpair (const TaskID& taskId, const Task* task, framework.tasks) {
+    if (!framework.taskSnapshots.contains(taskId)) {
+      framework.taskSnapshots[taskId] = std::make_shared<const Task>(*task);
+    }
+
+    tasks.push_back(framework.taskSnapshots[taskId]);
+  }
+
+  completedTasks.reserve(framework.completedTasks.size());
+  foreach (const shared_ptr<Task>& task, framework.completedTasks) {
+    completedTasks.push_back(task);
+  }
+
+  offers.reserve(framework.offers.size());
+  foreach (const Offer* offer, framework.offers) {
+    offers.push_back(*offer);
+  }
+
+  inverseOffers.reserve(framework.inverseOffers.size());
+  foreach (const InverseOffer* inverseOffer, framework.inverseOffers) {
+    inverseOffers.push_back(*inverseOffer);
+  }
+
+  foreachpair (const SlaveID& slaveId,
+               const auto& executorsMap,
+               framework.executors) {
+    auto& snapshots = framework.executorSnapshots[slaveId];
+
+    foreachpair (const ExecutorID& executorId,
+                 const ExecutorInfo& executorInfo,
+                 executorsMap) {
+      if (!snapshots.contains(executorId)) {
+        snapshots[executorId] = std::make_shared<const ExecutorInfo>(
+            executorInfo);
+      }
+
+      executors[slaveId][executorId] = snapshots[executorId];
+    }
+  }
+}
+
+
+size_t FrameworkSnapshot::bytes() const
+{
+  size_t result = sizeof(*this) + info.ByteSize();
+
+  foreach (const TaskInfo& taskInfo, pendingTasks) {
+    result += taskInfo.ByteSize();
+  }
+
+  // NOTE: The tasks and executors may be shared with other framework
+  // snapshots, in which case they are accounted for in each of them.
+  foreach (const shared_ptr<const Task>& task, tasks) {
+    result += task->ByteSize();
+  }
+
+  // Completed tasks are shared with the master, so we only account
+  // for the pointers.
+  result += completedTasks.size() * sizeof(shared_ptr<const Task>);
+
+  foreach (const Offer& offer, offers) {
+    result += offer.ByteSize();
+  }
+
+  foreach (const InverseOffer& inverseOffer, inverseOffers) {
+    result += inverseOffer.ByteSize();
+  }
+
+  foreachvalue (const auto& executorsMap, executors) {
+    foreachvalue (const shared_ptr<const ExecutorInfo>& executor,
+                  executorsMap) {
+      result += executor->ByteSize();
+    }
+  }
+
+  return result +
+    master::bytes(totalUsedResources) +
+    master::bytes(totalOfferedResources);
+}
+
+
+SlaveSnapshot::SlaveSnapshot(const Slave& slave)
+  : id(slave.id),
+    info(slave.info),
+    pid(slave.pid),
+    version(slave.version),
+    registeredTime(slave.registeredTime),
+    reregisteredTime(slave.reregisteredTime),
+    active(slave.active),
+    totalResources(slave.totalResources),
+    usedResources(Resources::sum(slave.usedResources)),
+    offeredResources(slave.offeredResources) {}
+
+
+size_t SlaveSnapshot::bytes() const
+{
+  return sizeof(*this) +
+    info.ByteSize() +
+    master::bytes(totalResources) +
+    master::bytes(usedResources) +
+    master::bytes(offeredResources);
+}
+
+
+size_t StateSnapshot::bytes() const
+{
+  size_t result = sizeof(*this);
+
+  foreach (const shared_ptr<const SlaveSnapshot>& slave, slaves) {
+    result += slave->bytes();
+  }
+
+  foreach (const shared_ptr<const FrameworkSnapshot>& framework, frameworks) {
+    result += framework->bytes();
+  }
+
+  foreach (const shared_ptr<const FrameworkSnapshot>& framework,
+           completedFrameworks) {
+    result += framework->bytes();
+  }
+
+  foreach (const Task& task, orphanTasks) {
+    result += task.ByteSize();
+  }
+
+  foreach (const Executor& executor, orphanExecutors) {
+    result += executor.info.ByteSize();
+  }
+
+  return result;
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,200 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_MASTER_STATE_SNAPSHOT_HPP__
+#define __MESOS_MASTER_STATE_SNAPSHOT_HPP__
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <process/pid.hpp>
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declarations.
+struct Framework;
+struct Slave;
+
+
+// A copy of the parts of a `Framework` that are exposed by the
+// read-only HTTP endpoints. The active tasks and the executors are
+// shared with the framework's per-task and per-executor snapshots
+// (which are built here if missing), so that a change to a single
+// task does not copy all the others.
+struct FrameworkSnapshot
+{
+  explicit FrameworkSnapshot(Framework& framework);
+
+  const FrameworkID& id() const { return info.id(); }
+
+  // Returns the approximate number of bytes held by this snapshot.
+  size_t bytes() const;
+
+  FrameworkInfo info;
+  Option<process::UPID> pid;
+  bool connected;
+  bool active;
+
+  process::Time registeredTime;
+  process::Time reregisteredTime;
+  process::Time unregisteredTime;
+
+  std::vector<TaskInfo> pendingTasks;
+  std::vector<std::shared_ptr<const Task>> tasks;
+
+  // NOTE: Completed tasks are never modified by the master, so they
+  // are shared with the `Framework` rather than copied.
+  std::vector<std::shared_ptr<const Task>> completedTasks;
+
+  std::vector<Offer> offers;
+  std::vector<InverseOffer> inverseOffers;
+
+  hashmap<SlaveID, hashmap<ExecutorID, std::shared_ptr<const ExecutorInfo>>>
+    executors;
+
+  Resources totalUsedResources;
+  Resources totalOfferedResources;
+};
+
+
+// A copy of the parts of a `Slave` that are exposed by the read-only
+// HTTP endpoints.
+struct SlaveSnapshot
+{
+  explicit SlaveSnapshot(const Slave& slave);
+
+  // Returns the approximate number of bytes held by this snapshot.
+  size_t bytes() const;
+
+  SlaveID id;
+  SlaveInfo info;
+  process::UPID pid;
+  std::string version;
+
+  process::Time registeredTime;
+  Option<process::Time> reregisteredTime;
+
+  bool active;
+
+  Resources totalResources;
+  Resources usedResources;
+  Resources offeredResources;
+};
+
+
+// A consistent, immutable copy of the master's framework, agent and
+// task model. A snapshot is captured on the master actor and holds
+// no references to the master, so the (potentially very large)
+// responses of the read-only endpoints can be serialized from it on
+// other threads.
+//
+// Snapshots are copy-on-write: the master keeps serving the same
+// snapshot until its state changes, and a new snapshot shares the
+// `FrameworkSnapshot`s and `SlaveSnapshot`s of all the frameworks and
+// agents that did not change since the previous one.
+struct StateSnapshot
+{
+  // The parts of the master's state that are captured on demand, so
+  // that each endpoint only pays for copying the ones it exposes.
+  // The remaining fields (e.g., the master info) are always captured.
+  enum Section
+  {
+    FLAGS = 1 << 0,
+
+    // The registered agents.
+    AGENTS = 1 << 1,
+
+    // The registered frameworks.
+    FRAMEWORKS = 1 << 2,
+
+    // The completed frameworks.
+    COMPLETED_FRAMEWORKS = 1 << 3,
+
+    // The tasks and executors of the frameworks that are not
+    // registered, as well as these frameworks themselves.
+    ORPHANS = 1 << 4,
+
+    ALL = FLAGS | AGENTS | FRAMEWORKS | COMPLETED_FRAMEWORKS | ORPHANS,
+  };
+
+  struct Executor
+  {
+    SlaveID slaveId;
+    FrameworkID frameworkId;
+    ExecutorInfo info;
+  };
+
+  // Returns the approximate number of bytes held by this snapshot.
+  size_t bytes() const;
+
+  // Increases monotonically with every snapshot built by the master.
+  uint64_t version;
+
+  // The `Section`s captured in this snapshot, the others are empty.
+  uint32_t sections;
+
+  MasterInfo info;
+  process::UPID pid;
+  process::Time startTime;
+  Option<process::Time> electedTime;
+  Option<MasterInfo> leader;
+
+  // The stringified master flags, in the order of `master->flags`.
+  std::vector<std::pair<std::string, std::string>> flags;
+  Option<std::string> cluster;
+  Option<std::string> logDir;
+  Option<std::string> externalLogFile;
+
+  size_t activatedSlaves;
+  size_t deactivatedSlaves;
+
+  std::vector<std::shared_ptr<const SlaveSnapshot>> slaves;
+  std::vector<std::shared_ptr<const FrameworkSnapshot>> frameworks;
+  std::vector<std::shared_ptr<const FrameworkSnapshot>> completedFrameworks;
+
+  // Tasks and executors on registered agents whose framework is not
+  // registered, along with the framework infos recovered from those
+  // agents.
+  std::vector<Task> orphanTasks;
+  std::vector<Executor> orphanExecutors;
+  hashmap<FrameworkID, FrameworkInfo> recoveredFrameworks;
+
+  // Frameworks that have tasks on registered agents but have yet to
+  // re-register (e.g., after a master failover). A framework is
+  // listed once for each agent it has tasks on.
+  std::vector<FrameworkID> unregisteredFrameworks;
+
+  bool authorizationEnabled;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_STATE_SNAPSHOT_HPP__
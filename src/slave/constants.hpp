@@ -64,6 +64,14 @@ constexpr Duration DISK_WATCH_INTERVAL = Minutes(1);
 // Minimum free disk capacity enforced by the garbage collector.
 constexpr double GC_DISK_HEADROOM = 0.1;
 
+// Maximum number of checks of the disk usage of containers that the
+// `disk/du` isolator carries out at the same time.
+constexpr size_t CONTAINER_DISK_WATCH_CONCURRENCY = 4;
+
+// Maximum number of directories that a check of the disk usage of a
+// container keeps open at a time.
+constexpr size_t DISK_USAGE_MAX_OPEN_DIRECTORIES = 64;
+
 // Maximum number of completed frameworks to store in memory.
 constexpr size_t MAX_COMPLETED_FRAMEWORKS = 50;
 
@@ -14,41 +14,48 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <string.h>
 
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
-#include <tuple>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include <glog/logging.h>
 
 #include <process/check.hpp>
-#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 #include <stout/strings.hpp>
 #include <stout/path.hpp>
+#include <stout/synchronized.hpp>
 
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
 #include <stout/os/stat.hpp>
 
 #include "common/protobuf_utils.hpp"
 
-#include "slave/containerizer/mesos/isolators/posix/disk.hpp"
+#include "slave/constants.hpp"
 
-namespace io = process::io;
+#include "slave/containerizer/mesos/isolators/posix/disk.hpp"
 
 using std::deque;
 using std::list;
@@ -57,20 +64,15 @@ using std::vector;
 
 using process::Failure;
 using process::Future;
-using process::MONITOR;
-using process::NO_SETSID;
 using process::Owned;
 using process::PID;
 using process::Process;
 using process::Promise;
-using process::Subprocess;
 
-using process::await;
 using process::defer;
 using process::delay;
 using process::dispatch;
 using process::spawn;
-using process::subprocess;
 using process::terminate;
 
 using mesos::slave::ContainerConfig;
@@ -85,8 +87,6 @@ namespace slave {
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new MesosIsolator(process::Owned<MesosIsolatorProcess>(
         new PosixDiskIsolatorProcess(flags)));
 }
@@ -99,7 +99,10 @@ PosixDiskIsolatorProcess::Info::PathInfo::~PathInfo()
 
 
 PosixDiskIsolatorProcess::PosixDiskIsolatorProcess(const Flags& _flags)
-  : flags(_flags), collector(flags.container_disk_watch_interval) {}
+  : flags(_flags),
+    collector(
+        flags.container_disk_watch_interval,
+        CONTAINER_DISK_WATCH_CONCURRENCY) {}
 
 
 PosixDiskIsolatorProcess::~PosixDiskIsolatorProcess() {}
@@ -250,8 +253,9 @@ Future<Bytes> PosixDiskIsolatorProcess::collect(
     }
   }
 
-  // We append "/" at the end to make sure that 'du' runs on actual
-  // directory pointed by the symlink (and not the symlink itself).
+  // We append "/" at the end to make sure that the usage is checked
+  // on the actual directory pointed by the symlink (and not the
+  // symlink itself), like 'du' does.
   string _path = path;
   if (path != info->directory && os::stat::islink(path)) {
     _path = path::join(path, "");
@@ -377,20 +381,411 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+// Measures the disk usage of a file hierarchy the way `du -k -s`
+// does: the blocks allocated to every file and directory (but not
+// those that symbolic links point to) are summed up, files with
+// multiple hard links are only counted once, and the result is
+// rounded up to whole kilobytes. Like GNU `du --exclude`, a file is
+// excluded if an exclude pattern matches its path, or any trailing
+// part of its path that starts after a '/'.
+//
+// NOTE: The hierarchy is walked with `openat()` and `fstatat()`
+// relative to the directory being read, so that the kernel does not
+// have to resolve the full path of every file. The directories being
+// walked are kept on an explicit stack rather than the call stack, so
+// that arbitrarily deep hierarchies can be walked, and at most
+// `DISK_USAGE_MAX_OPEN_DIRECTORIES` of them are kept open at a time.
+class DiskUsage
+{
+public:
+  DiskUsage(
+      const vector<string>& _excludes,
+      const std::shared_ptr<std::atomic_bool>& _cancelled)
+    : excludes(_excludes),
+      cancelled(_cancelled),
+      blocks(0),
+      opened(0) {}
+
+  Try<Bytes> operator()(const string& path)
+  {
+    // Like `du`, we only follow the root if it is a symbolic link and
+    // the path ends with a '/'.
+    struct stat s;
+    if (::fstatat(
+            AT_FDCWD,
+            path.c_str(),
+            &s,
+            strings::endsWith(path, "/") ? 0 : AT_SYMLINK_NOFOLLOW) < 0) {
+      return ErrnoError("Failed to stat '" + path + "'");
+    }
+
+    if (excluded(path)) {
+      return Bytes(0);
+    }
+
+    account(s);
+
+    if (S_ISDIR(s.st_mode)) {
+      root = path;
+
+      int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (fd < 0) {
+        return ErrnoError("Failed to open '" + path + "'");
+      }
+
+      // NOTE: Like `fts`, we join the names of files to the root
+      // without its trailing '/' (unless the root is '/').
+      string joined = path;
+      while (joined.size() > 1 && strings::endsWith(joined, "/")) {
+        joined.pop_back();
+      }
+
+      Try<Nothing> walk = this->walk(fd, joined == "/" ? "" : joined);
+      if (walk.isError()) {
+        return Error(walk.error());
+      }
+    }
+
+    // NOTE: `st_blocks` is in units of 512 bytes on all platforms.
+    return Kilobytes((blocks * 512 + 1023) / 1024);
+  }
+
+private:
+  // A directory on the stack of the directories being walked.
+  struct Directory
+  {
+    Directory(const string& _name, const string& _path, DIR* _dir)
+      : name(_name), path(_path), dir(_dir), fd(-1) {}
+
+    // The name of the directory in its parent, and the path that the
+    // names of its entries are joined to.
+    string name;
+    string path;
+
+    // The directory while it is open. Once it was closed to stay
+    // within the limit of open directories, the entries that were
+    // still to be read are kept in 'remaining' (in reverse order),
+    // and 'fd' is the directory reopened by name to stat them.
+    DIR* dir;
+    int fd;
+    vector<string> remaining;
+  };
+
+  bool excluded(const string& path) const
+  {
+    foreach (const string& exclude, excludes) {
+      if (::fnmatch(exclude.c_str(), path.c_str(), 0) == 0) {
+        return true;
+      }
+
+      for (size_t i = 0; i + 1 < path.size(); i++) {
+        if (path[i] == '/' && path[i + 1] != '/' &&
+            ::fnmatch(exclude.c_str(), path.c_str() + i + 1, 0) == 0) {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  void account(const struct stat& s)
+  {
+    if (!S_ISDIR(s.st_mode) &&
+        s.st_nlink > 1 &&
+        !inodes.insert(std::make_pair(s.st_dev, s.st_ino)).second) {
+      return;
+    }
+
+    blocks += s.st_blocks;
+  }
+
+  // Walks the directory open at 'fd' (which it takes ownership of)
+  // and whose path is 'path'.
+  Try<Nothing> walk(int fd, const string& path)
+  {
+    DIR* dir = ::fdopendir(fd);
+    if (dir == nullptr) {
+      ErrnoError error("Failed to open directory '" + path + "'");
+      ::close(fd);
+      return error;
+    }
+
+    stack.push_back(Directory("", path, dir));
+    opened++;
+
+    Try<Nothing> result = Nothing();
+
+    while (!stack.empty()) {
+      if (cancelled->load()) {
+        result = Error("Cancelled");
+        break;
+      }
+
+      Try<Option<string>> name = next();
+      if (name.isError()) {
+        result = Error(name.error());
+        break;
+      }
+
+      if (name->isNone()) {
+        close(&stack.back());
+        stack.pop_back();
+        continue;
+      }
+
+      const string child = stack.back().path + "/" + name->get();
+
+      if (excluded(child)) {
+        continue;
+      }
+
+      // NOTE: We ignore files that are removed while we walk the
+      // hierarchy, since they don't use any disk space anymore.
+      struct stat s;
+      if (::fstatat(
+              descriptor(stack.back()),
+              name->get().c_str(),
+              &s,
+              AT_SYMLINK_NOFOLLOW) < 0) {
+        if (errno == ENOENT) {
+          continue;
+        }
+
+        result = ErrnoError("Failed to stat '" + child + "'");
+        break;
+      }
+
+      account(s);
+
+      if (S_ISDIR(s.st_mode)) {
+        Try<Nothing> reserve = this->reserve();
+        if (reserve.isError()) {
+          result = Error(reserve.error());
+          break;
+        }
+
+        int fd = ::openat(
+            descriptor(stack.back()),
+            name->get().c_str(),
+            O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+        if (fd < 0) {
+          if (errno == ENOENT) {
+            continue;
+          }
+
+          result = ErrnoError("Failed to open '" + child + "'");
+          break;
+        }
+
+        DIR* dir = ::fdopendir(fd);
+        if (dir == nullptr) {
+          result = ErrnoError("Failed to open directory '" + child + "'");
+          ::close(fd);
+          break;
+        }
+
+        stack.push_back(Directory(name->get(), child, dir));
+        opened++;
+      }
+    }
+
+    foreach (Directory& directory, stack) {
+      close(&directory);
+    }
+
+    stack.clear();
+
+    return result;
+  }
+
+  // Returns the name of the next entry of the directory on top of
+  // the stack, or none once all of its entries have been read.
+  Try<Option<string>> next()
+  {
+    Directory& directory = stack.back();
+
+    if (directory.dir == nullptr) {
+      if (directory.remaining.empty()) {
+        return None();
+      }
+
+      if (directory.fd < 0) {
+        Try<Nothing> reserve = this->reserve();
+        if (reserve.isError()) {
+          return Error(reserve.error());
+        }
+
+        directory.fd = reopen(stack.size() - 1);
+        if (directory.fd < 0) {
+          if (errno == ENOENT) {
+            directory.remaining.clear();
+            return None();
+          }
+
+          return ErrnoError("Failed to open '" + directory.path + "'");
+        }
+
+        opened++;
+      }
+
+      const string name = directory.remaining.back();
+      directory.remaining.pop_back();
+      return name;
+    }
+
+    while (true) {
+      errno = 0;
+
+      struct dirent* entry = ::readdir(directory.dir);
+      if (entry == nullptr) {
+        if (errno != 0) {
+          return ErrnoError(
+              "Failed to read directory '" + directory.path + "'");
+        }
+
+        return None();
+      }
+
+      if (::strcmp(entry->d_name, ".") != 0 &&
+          ::strcmp(entry->d_name, "..") != 0) {
+        return string(entry->d_name);
+      }
+    }
+  }
+
+  // Makes room for opening another directory once the limit of open
+  // directories is reached, by closing the directory that was opened
+  // first (i.e., the one closest to the root). The entries of the
+  // directory that are still to be read are read before, so that it
+  // only needs to be reopened to stat them.
+  Try<Nothing> reserve()
+  {
+    if (opened < DISK_USAGE_MAX_OPEN_DIRECTORIES) {
+      return Nothing();
+    }
+
+    foreach (Directory& directory, stack) {
+      if (directory.dir != nullptr) {
+        while (true) {
+          errno = 0;
+
+          struct dirent* entry = ::readdir(directory.dir);
+          if (entry == nullptr) {
+            if (errno != 0) {
+              return ErrnoError(
+                  "Failed to read directory '" + directory.path + "'");
+            }
+            break;
+          }
+
+          if (::strcmp(entry->d_name, ".") != 0 &&
+              ::strcmp(entry->d_name, "..") != 0) {
+            directory.remaining.push_back(entry->d_name);
+          }
+        }
+
+        std::reverse(directory.remaining.begin(), directory.remaining.end());
+
+        close(&directory);
+        return Nothing();
+      }
+
+      if (directory.fd >= 0) {
+        close(&directory);
+        return Nothing();
+      }
+    }
+
+    return Nothing();
+  }
+
+  // Reopens the directory at 'index' on the stack by its path, or one
+  // directory at a time from the root if its path is too long to be
+  // opened at once. Returns -1 and sets `errno` on failure.
+  int reopen(size_t index) const
+  {
+    if (index == 0) {
+      return ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+
+    int fd = ::open(
+        stack[index].path.c_str(),
+        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+    if (fd >= 0 || errno != ENAMETOOLONG) {
+      return fd;
+    }
+
+    fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    for (size_t i = 1; fd >= 0 && i <= index; i++) {
+      int next = ::openat(
+          fd,
+          stack[i].name.c_str(),
+          O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+      int error = errno;
+      ::close(fd);
+      errno = error;
+
+      fd = next;
+    }
+
+    return fd;
+  }
+
+  static int descriptor(const Directory& directory)
+  {
+    return directory.dir != nullptr ? ::dirfd(directory.dir) : directory.fd;
+  }
+
+  void close(Directory* directory)
+  {
+    if (directory->dir != nullptr) {
+      ::closedir(directory->dir);
+      directory->dir = nullptr;
+      opened--;
+    } else if (directory->fd >= 0) {
+      ::close(directory->fd);
+      directory->fd = -1;
+      opened--;
+    }
+  }
+
+  const vector<string> excludes;
+  const std::shared_ptr<std::atomic_bool> cancelled;
+
+  // The inodes of the files with multiple hard links seen so far.
+  std::set<std::pair<dev_t, ino_t>> inodes;
+
+  // The number of 512 byte blocks used.
+  uint64_t blocks;
+
+  // The path of the root as given, and the directories being walked
+  // from the root down to the one being read.
+  string root;
+  vector<Directory> stack;
+
+  // The number of directories on the stack that are open.
+  size_t opened;
+};
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
-  DiskUsageCollectorProcess(const Duration& _interval) : interval(_interval) {}
+  DiskUsageCollectorProcess(const Duration& _interval, size_t _concurrency)
+    : interval(_interval),
+      concurrency(_concurrency) {}
+
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(
       const string& path,
       const vector<string>& excludes)
   {
-    // TODO(jieyu): 'excludes' is not supported on OSX. We should
-    // either return a Failure here, or does not allow 'excludes' to
-    // be specified on OSX.
-
     foreach (const Owned<Entry>& entry, entries) {
       if (entry->path == path) {
         return entry->promise.future();
@@ -409,18 +804,36 @@ public:
 protected:
   void initialize()
   {
-    schedule();
+    // The disk usage is measured on threads of our own, since walking
+    // a file hierarchy blocks on the filesystem (for minutes, for
+    // large ones), which we must not do on libprocess' threads.
+    for (size_t i = 0; i < concurrency; i++) {
+      threads.emplace_back(&Self::run, this);
+    }
+
+    // Each of the 'concurrency' rounds of checks below carries out one
+    // check at a time.
+    for (size_t i = 0; i < concurrency; i++) {
+      schedule();
+    }
   }
 
   void finalize()
   {
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
-
+      entry->cancelled->store(true);
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
+
+    synchronized (mutex) {
+      stopped = true;
+    }
+
+    condition.notify_all();
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
   }
 
 private:
@@ -429,19 +842,25 @@ private:
   {
     explicit Entry(const string& _path, const vector<string>& _excludes)
       : path(_path),
-        excludes(_excludes) {}
+        excludes(_excludes),
+        running(false),
+        cancelled(new std::atomic_bool(false)) {}
 
     string path;
     vector<string> excludes;
-    Option<Subprocess> du;
+    bool running;
     Promise<Bytes> promise;
+
+    // Shared with the thread measuring the disk usage, which stops
+    // once this is set.
+    const std::shared_ptr<std::atomic_bool> cancelled;
   };
 
   void discard(const string& path)
   {
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      // We only cancel those checks that haven't been started.
+      if ((*it)->path == path && !(*it)->running) {
         (*it)->promise.discard();
         entries.erase(it);
         break;
@@ -449,147 +868,120 @@ private:
     }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Starts the first pending check that isn't running yet. Up to
+  // 'concurrency' checks run at the same time, and the minimal
+  // interval between two subsequent checks of each of those is
+  // controlled by 'interval' for throttling purpose.
   void schedule()
   {
-    if (entries.empty()) {
-      delay(interval, self(), &Self::schedule);
+    foreach (const Owned<Entry>& entry, entries) {
+      if (entry->running) {
+        continue;
+      }
+
+      entry->running = true;
+
+      Owned<Promise<Bytes>> promise(new Promise<Bytes>());
+
+      promise->future()
+        .onAny(defer(self(), &Self::_schedule, entry, lambda::_1));
+
+      synchronized (mutex) {
+        checks.push_back(Check{
+            entry->path,
+            entry->excludes,
+            entry->cancelled,
+            promise});
+      }
+
+      condition.notify_one();
       return;
     }
 
-    const Owned<Entry>& entry = entries.front();
-
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-
-    // Construct the 'du' command.
-    vector<string> command = {
-      "du",
-      "-k", // Use 1K size blocks for consistent results across platforms.
-      "-s", // Use 'silent' output mode.
-    };
-
-#ifdef __linux__
-    // Add paths that need to be excluded.
-    foreach (const string& exclude, entry->excludes) {
-      command.push_back("--exclude");
-      command.push_back(exclude);
-    }
-#endif
-
-    // Add path on which 'du' must be run.
-    command.push_back(entry->path);
-
-    // NOTE: The monitor watchdog will watch the parent process and kill
-    // the 'du' process in case that the parent die.
-    Try<Subprocess> s = subprocess(
-        "du",
-        command,
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        NO_SETSID,
-        None(),
-        None(),
-        None(),
-        Subprocess::Hook::None(),
-        None(),
-        MONITOR);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
-
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
+    delay(interval, self(), &Self::schedule);
+  }
+
+  void _schedule(const Owned<Entry>& entry, const Future<Bytes>& future)
+  {
+    if (future.isReady()) {
+      entry->promise.set(future.get());
+    } else {
+      entry->promise.fail(
+          future.isFailed() ? future.failure() : "Check was discarded");
     }
 
-    entry->du = s.get();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->get() == entry.get()) {
+        entries.erase(it);
+        break;
+      }
+    }
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
-      .onAny(defer(self(), &Self::_schedule, lambda::_1));
+    delay(interval, self(), &Self::schedule);
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  // A check handed over to the threads measuring the disk usage.
+  struct Check
   {
-    CHECK_READY(future);
-    CHECK(!entries.empty());
+    string path;
+    vector<string> excludes;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    Owned<Promise<Bytes>> promise;
+  };
 
-    const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
+  // Runs on each of 'threads', carrying out the checks one at a time.
+  void run()
+  {
+    while (true) {
+      Option<Check> check;
 
-    Future<Option<int>> status = std::get<0>(future.get());
+      synchronized (mutex) {
+        while (!stopped && checks.empty()) {
+          synchronized_wait(&condition, &mutex);
+        }
 
-    if (!status.isReady()) {
-      entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
+        if (stopped) {
+          return;
+        }
+
+        check = checks.front();
+        checks.pop_front();
       }
-    } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
-        entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
+
+      Try<Bytes> usage =
+        DiskUsage(check->excludes, check->cancelled)(check->path);
+
+      if (usage.isError()) {
+        check->promise->fail(
+            "Failed to check disk usage at '" + check->path + "': " +
+            usage.error());
       } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
-        } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
-        }
+        check->promise->set(usage.get());
       }
     }
-
-    entries.pop_front();
-    delay(interval, self(), &Self::schedule);
   }
 
   const Duration interval;
+  const size_t concurrency;
 
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
+
+  std::vector<std::thread> threads;
+
+  // The checks to be carried out by 'threads'.
+  std::mutex mutex;
+  std::condition_variable condition;
+  deque<Check> checks;
+  bool stopped = false;
 };
 
 
-DiskUsageCollector::DiskUsageCollector(const Duration& interval)
+DiskUsageCollector::DiskUsageCollector(
+    const Duration& interval,
+    size_t concurrency)
 {
-  process = new DiskUsageCollectorProcess(interval);
+  process = new DiskUsageCollectorProcess(interval, concurrency);
   spawn(process);
 }
 
@@ -39,15 +39,19 @@ class DiskUsageCollectorProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. Up to
+// 'concurrency' paths are checked at the same time, each of them
+// in-process on a thread of its own (rather than by running 'du').
 class DiskUsageCollector
 {
 public:
-  DiskUsageCollector(const Duration& interval);
+  DiskUsageCollector(const Duration& interval, size_t concurrency = 1);
   ~DiskUsageCollector();
 
-  // Returns the disk usage rooted at 'path'. The user can discard the
-  // returned future to cancel the check.
+  // Returns the disk usage rooted at 'path', as 'du -k -s' with an
+  // '--exclude' for each of 'excludes' would report it. The user can
+  // discard the returned future to cancel the check (unless it has
+  // been started already).
   process::Future<Bytes> usage(
       const std::string& path,
       const std::vector<std::string>& excludes);
@@ -60,13 +64,13 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // ContainerLimitation when a container exceeds its disk quota. This
 // leverages the DiskUsageCollector to ensure that we don't induce too
-// much CPU usage and disk caching effects from running 'du' too
-// often.
+// much CPU usage and disk caching effects from checking the disk
+// usage too often.
 //
-// NOTE: Currently all containers are processed in the same queue,
-// which means that when a container starts, it could take many disk
-// collection intervals until any data is available in the resource
-// usage statistics!
+// NOTE: Currently all containers are processed in the same queue
+// (albeit a few at a time), which means that when a container starts,
+// it could take many disk collection intervals until any data is
+// available in the resource usage statistics!
 //
 // TODO(jieyu): Consider handling each container independently, or
 // triggering an initial collection when the container starts, to
@@ -692,6 +692,16 @@ mesos::internal::slave::Flags::Flags()
       "used for the `disk/du` isolator.",
       Seconds(15));
 
+  add(&Flags::container_usage_sampling_interval,
+      "container_usage_sampling_interval",
+      "The interval at which the agent samples the resource usage of all\n"
+      "containers. The resource estimator, the QoS controller and the\n"
+      "`/monitor/statistics` and `/containers` endpoints are served from\n"
+      "the samples, rather than each of them collecting the usage of every\n"
+      "container anew. If zero, the usage is only collected on demand, and\n"
+      "shared by the consumers that ask for it at the same time.",
+      Seconds(0));
+
   // TODO(jieyu): Consider enabling this flag by default. Remember
   // to update the user doc if we decide to do so.
   add(&Flags::enforce_container_disk_quota,
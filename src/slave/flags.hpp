@@ -133,6 +133,7 @@ public:
   Option<std::string> network_cni_plugins_dir;
   Option<std::string> network_cni_config_dir;
   Duration container_disk_watch_interval;
+  Duration container_usage_sampling_interval;
   bool enforce_container_disk_quota;
   Option<Modules> modules;
   Option<std::string> modulesDir;
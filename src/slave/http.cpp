@@ -303,39 +303,33 @@ Future<Response> Slave::Http::api(
     return MethodNotAllowed({"POST"}, request.method);
   }
 
-  v1::agent::Call v1Call;
-
   Option<string> contentType = request.headers.get("Content-Type");
   if (contentType.isNone()) {
     return BadRequest("Expecting 'Content-Type' to be present");
   }
 
+  ContentType bodyType;
+
   if (contentType.get() == APPLICATION_PROTOBUF) {
-    if (!v1Call.ParseFromString(request.body)) {
-      return BadRequest("Failed to parse body into Call protobuf");
-    }
+    bodyType = ContentType::PROTOBUF;
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
-    Try<v1::agent::Call> parse =
-      ::protobuf::parse<v1::agent::Call>(value.get());
-
-    if (parse.isError()) {
-      return BadRequest("Failed to convert JSON into Call protobuf: " +
-                        parse.error());
-    }
-
-    v1Call = parse.get();
+    bodyType = ContentType::JSON;
   } else {
     return UnsupportedMediaType(
         string("Expecting 'Content-Type' of ") +
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  agent::Call call = devolve(v1Call);
+  Try<agent::Call> parse =
+    deserialize<agent::Call, v1::agent::Call>(bodyType, request.body);
+
+  if (parse.isError()) {
+    return BadRequest("Failed to parse body into Call protobuf: " +
+                      parse.error());
+  }
+
+  agent::Call call;
+  call.Swap(&parse.get());
 
   Option<Error> error = validation::agent::call::validate(call);
 
@@ -420,39 +414,32 @@ Future<Response> Slave::Http::executor(const Request& request) const
     return MethodNotAllowed({"POST"}, request.method);
   }
 
-  v1::executor::Call v1Call;
-
   Option<string> contentType = request.headers.get("Content-Type");
   if (contentType.isNone()) {
     return BadRequest("Expecting 'Content-Type' to be present");
   }
 
+  ContentType bodyType;
+
   if (contentType.get() == APPLICATION_PROTOBUF) {
-    if (!v1Call.ParseFromString(request.body)) {
-      return BadRequest("Failed to parse body into Call protobuf");
-    }
+    bodyType = ContentType::PROTOBUF;
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
-    Try<v1::executor::Call> parse =
-      ::protobuf::parse<v1::executor::Call>(value.get());
-
-    if (parse.isError()) {
-      return BadRequest("Failed to convert JSON into Call protobuf: " +
-                        parse.error());
-    }
-
-    v1Call = parse.get();
+    bodyType = ContentType::JSON;
   } else {
     return UnsupportedMediaType(
         string("Expecting 'Content-Type' of ") +
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  const executor::Call call = devolve(v1Call);
+  Try<executor::Call> parse =
+    deserialize<executor::Call, v1::executor::Call>(bodyType, request.body);
+
+  if (parse.isError()) {
+    return BadRequest("Failed to parse body into Call protobuf: " +
+                      parse.error());
+  }
+
+  const executor::Call& call = parse.get();
 
   Option<Error> error = validation::executor::call::validate(call);
 
@@ -650,7 +637,7 @@ Future<Response> Slave::Http::getHealth(
   response.set_type(agent::Response::GET_HEALTH);
   response.mutable_get_health()->set_healthy(true);
 
-  return OK(serialize(contentType, evolve(response)),
+  return OK(serialize(contentType, response),
             stringify(contentType));
 }
 
@@ -694,7 +681,7 @@ Future<Response> Slave::Http::getMetrics(
           metric->set_value(value);
         }
 
-        return OK(serialize(contentType, evolve(response)),
+        return OK(serialize(contentType, response),
                   stringify(contentType));
       });
 }
@@ -711,7 +698,7 @@ Future<Response> Slave::Http::getLoggingLevel(
   response.set_type(agent::Response::GET_LOGGING_LEVEL);
   response.mutable_get_logging_level()->set_level(FLAGS_v);
 
-  return OK(serialize(contentType, evolve(response)),
+  return OK(serialize(contentType, response),
             stringify(contentType));
 }
 
@@ -777,7 +764,7 @@ Future<Response> Slave::Http::listFiles(
         listFiles->add_file_infos()->CopyFrom(fileInfo);
       }
 
-      return OK(serialize(contentType, evolve(response)),
+      return OK(serialize(contentType, response),
                 stringify(contentType));
     });
 }
@@ -1120,7 +1107,7 @@ Future<Response> Slave::Http::statistics(
           }
 
           return statisticsLimiter->acquire()
-            .then(defer(slave->self(), &Slave::usage))
+            .then(defer(slave->self(), &Slave::usage, Duration::zero()))
             .then(defer(slave->self(),
                   [this, request](const ResourceUsage& usage) {
               return _statistics(usage, request);
@@ -1309,7 +1296,8 @@ Future<JSON::Array> Slave::Http::__containers() const
 
       metadata->push_back(entry);
       statusFutures.push_back(slave->containerizer->status(containerId));
-      statsFutures.push_back(slave->containerizer->usage(containerId));
+      statsFutures.push_back(
+          slave->usageSampler->usage(containerId, Duration::zero()));
     }
   }
 
@@ -456,15 +456,22 @@ void Slave::initialize()
       << " for --gc_disk_headroom. Must be between 0.0 and 1.0";
   }
 
-  Try<Nothing> initialize =
-    resourceEstimator->initialize(defer(self(), &Self::usage));
+  usageSampler.reset(new UsageSampler(
+      containerizer,
+      flags.container_usage_sampling_interval));
+
+  // The resource estimator and the QoS controller accept samples of
+  // the usage as old as the interval at which they ask for it.
+  Try<Nothing> initialize = resourceEstimator->initialize(
+      defer(self(), &Self::usage, flags.oversubscribed_resources_interval));
 
   if (initialize.isError()) {
     EXIT(EXIT_FAILURE)
       << "Failed to initialize the resource estimator: " << initialize.error();
   }
 
-  initialize = qosController->initialize(defer(self(), &Self::usage));
+  initialize = qosController->initialize(
+      defer(self(), &Self::usage, flags.qos_correction_interval_min));
 
   if (initialize.isError()) {
     EXIT(EXIT_FAILURE)
@@ -5228,7 +5235,7 @@ void Slave::_qosCorrections(const Future<list<QoSCorrection>>& future)
 }
 
 
-Future<ResourceUsage> Slave::usage()
+Future<ResourceUsage> Slave::usage(const Duration& staleness)
 {
   // NOTE: We use 'Owned' here trying to avoid the expensive copy.
   // C++11 lambda only supports capturing variables that have copy
@@ -5262,7 +5269,7 @@ Future<ResourceUsage> Slave::usage()
         }
       }
 
-      futures.push_back(containerizer->usage(executor->containerId));
+      futures.push_back(usageSampler->usage(executor->containerId, staleness));
     }
   }
 
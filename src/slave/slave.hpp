@@ -77,6 +77,7 @@
 #include "slave/metrics.hpp"
 #include "slave/paths.hpp"
 #include "slave/state.hpp"
+#include "slave/usage_sampler.hpp"
 
 // `REGISTERING` is used as an enum value, but it's actually defined as a
 // constant in the Windows SDK.
@@ -400,8 +401,10 @@ public:
       const process::Future<std::list<
           mesos::slave::QoSCorrection>>& correction);
 
-  // Returns the resource usage information for all executors.
-  virtual process::Future<ResourceUsage> usage();
+  // Returns the resource usage information for all executors, from
+  // samples of the usage of their containers taken less than
+  // 'staleness' ago (see `UsageSampler`).
+  virtual process::Future<ResourceUsage> usage(const Duration& staleness);
 
   // Handle the second phase of shutting down an executor for those
   // executors that have not properly shutdown within a timeout.
@@ -614,6 +617,10 @@ private:
 
   Containerizer* containerizer;
 
+  // Shares the resource usage of the containers among `usage()` and
+  // the '/containers' endpoint.
+  process::Owned<UsageSampler> usageSampler;
+
   Files* files;
 
   Metrics metrics;
@@ -694,7 +701,9 @@ struct HttpConnection
                  ContentType _contentType)
     : writer(_writer),
       contentType(_contentType),
-      encoder(lambda::bind(serialize, contentType, lambda::_1)) {}
+      encoder([_contentType](const v1::executor::Event& event) {
+        return serialize(_contentType, event);
+      }) {}
 
   // Converts the message to an Event before sending.
   template <typename Message>
@@ -0,0 +1,338 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+
+#include <mesos/type_utils.hpp>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
+
+#include "slave/usage_sampler.hpp"
+
+#include "slave/containerizer/containerizer.hpp"
+
+using namespace process;
+
+using process::metrics::Counter;
+using process::metrics::Gauge;
+
+using std::list;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+class UsageSamplerProcess : public Process<UsageSamplerProcess>
+{
+public:
+  UsageSamplerProcess(
+      Containerizer* _containerizer,
+      const Duration& _interval)
+    : ProcessBase(process::ID::generate("usage-sampler")),
+      containerizer(_containerizer),
+      interval(_interval),
+      duration(Duration::zero()),
+      metrics(*this) {}
+
+  Future<ResourceStatistics> usage(
+      const ContainerID& containerId,
+      const Duration& staleness);
+
+protected:
+  virtual void initialize();
+
+private:
+  // Samples the usage of all the containers, and schedules the next
+  // round of sampling once done.
+  void sample();
+  void _sample(const Future<hashset<ContainerID>>& containers);
+  void __sample(const hashset<ContainerID>& containers);
+
+  // Collects the usage of the container, unless it is being collected
+  // already. Each caller gets its own future, so that a caller which
+  // discards its future doesn't discard the collection shared with
+  // the other callers.
+  Future<ResourceStatistics> collect(const ContainerID& containerId);
+
+  void collected(
+      const ContainerID& containerId,
+      const Future<ResourceStatistics>& future);
+
+  Future<double> _sample_age_secs();
+
+  struct Sample
+  {
+    ResourceStatistics statistics;
+    Time time;
+  };
+
+  struct Metrics
+  {
+    explicit Metrics(const UsageSamplerProcess& process);
+    ~Metrics();
+
+    // The time it takes to sample the usage of all the containers.
+    process::metrics::Timer<Milliseconds> sampling;
+
+    // The time since the usage of all the containers was last sampled.
+    process::metrics::Gauge sample_age_secs;
+
+    // The requests for usage served from a sample, and those that
+    // had to wait for the usage to be collected.
+    process::metrics::Counter cache_hits;
+    process::metrics::Counter cache_misses;
+  };
+
+  Containerizer* containerizer;
+  const Duration interval;
+
+  // How long the last round of sampling took.
+  Duration duration;
+
+  // NOTE: Samples are only kept when sampling periodically, since the
+  // samples of the containers that are gone are dropped after every
+  // round of sampling.
+  hashmap<ContainerID, Sample> samples;
+
+  // The collections of usage that are in progress.
+  hashmap<ContainerID, Future<ResourceStatistics>> collecting;
+
+  // When the usage of all the containers was last sampled.
+  Option<Time> sampled;
+
+  Metrics metrics;
+};
+
+
+void UsageSamplerProcess::initialize()
+{
+  if (interval > Duration::zero()) {
+    sample();
+  }
+}
+
+
+Future<ResourceStatistics> UsageSamplerProcess::usage(
+    const ContainerID& containerId,
+    const Duration& staleness)
+{
+  if (samples.contains(containerId)) {
+    const Sample& sample = samples.at(containerId);
+
+    // A sample from the latest round of sampling is recent enough for
+    // any consumer. A sample gets up to the interval plus the time it
+    // takes to sample all the containers old before the next round
+    // replaces it, and accepting less would have consumers collect the
+    // usage on their own in between the rounds.
+    const Duration accepted = std::max(staleness, interval + duration);
+
+    if (Clock::now() - sample.time < accepted) {
+      ++metrics.cache_hits;
+      return sample.statistics;
+    }
+  }
+
+  ++metrics.cache_misses;
+  return collect(containerId);
+}
+
+
+void UsageSamplerProcess::sample()
+{
+  metrics.sampling.start();
+
+  containerizer->containers()
+    .onAny(defer(self(), &Self::_sample, lambda::_1));
+}
+
+
+void UsageSamplerProcess::_sample(
+    const Future<hashset<ContainerID>>& containers)
+{
+  if (!containers.isReady()) {
+    LOG(WARNING) << "Failed to get the containers to sample the usage of: "
+                 << (containers.isFailed() ? containers.failure()
+                                           : "discarded");
+
+    delay(interval, self(), &Self::sample);
+    return;
+  }
+
+  list<Future<ResourceStatistics>> futures;
+  foreach (const ContainerID& containerId, containers.get()) {
+    futures.push_back(collect(containerId));
+  }
+
+  // NOTE: We don't care whether the usage of a container could be
+  // collected here (e.g., it may have terminated in the meantime),
+  // since `collected()` takes care of the samples.
+  await(futures)
+    .onAny(defer(self(), &Self::__sample, containers.get()));
+}
+
+
+void UsageSamplerProcess::__sample(const hashset<ContainerID>& containers)
+{
+  duration = metrics.sampling.stop();
+
+  sampled = Clock::now();
+
+  // Drop the samples of the containers that are gone.
+  foreach (const ContainerID& containerId, samples.keys()) {
+    if (!containers.contains(containerId)) {
+      samples.erase(containerId);
+    }
+  }
+
+  delay(interval, self(), &Self::sample);
+}
+
+
+Future<ResourceStatistics> UsageSamplerProcess::collect(
+    const ContainerID& containerId)
+{
+  if (!collecting.contains(containerId)) {
+    Future<ResourceStatistics> future = containerizer->usage(containerId);
+
+    collecting.put(containerId, future);
+
+    future.onAny(defer(self(), &Self::collected, containerId, lambda::_1));
+  }
+
+  Owned<Promise<ResourceStatistics>> promise(
+      new Promise<ResourceStatistics>());
+
+  collecting.at(containerId)
+    .onAny([promise](const Future<ResourceStatistics>& future) {
+      if (promise->future().hasDiscard()) {
+        promise->discard();
+      } else if (future.isReady()) {
+        promise->set(future.get());
+      } else if (future.isFailed()) {
+        promise->fail(future.failure());
+      } else {
+        promise->discard();
+      }
+    });
+
+  return promise->future();
+}
+
+
+void UsageSamplerProcess::collected(
+    const ContainerID& containerId,
+    const Future<ResourceStatistics>& future)
+{
+  collecting.erase(containerId);
+
+  if (future.isReady()) {
+    if (interval > Duration::zero()) {
+      samples[containerId] = Sample{future.get(), Clock::now()};
+    }
+  } else {
+    // The container is most likely gone, in which case we should not
+    // keep serving its last sample.
+    samples.erase(containerId);
+  }
+}
+
+
+Future<double> UsageSamplerProcess::_sample_age_secs()
+{
+  if (sampled.isNone()) {
+    return Failure("Not sampled yet");
+  }
+
+  return (Clock::now() - sampled.get()).secs();
+}
+
+
+UsageSamplerProcess::Metrics::Metrics(const UsageSamplerProcess& process)
+  : sampling(
+        "slave/container_usage_sampling"),
+    sample_age_secs(
+        "slave/container_usage_sample_age_secs",
+        defer(process, &UsageSamplerProcess::_sample_age_secs)),
+    cache_hits(
+        "slave/container_usage_cache_hits"),
+    cache_misses(
+        "slave/container_usage_cache_misses")
+{
+  process::metrics::add(sampling);
+  process::metrics::add(sample_age_secs);
+  process::metrics::add(cache_hits);
+  process::metrics::add(cache_misses);
+}
+
+
+UsageSamplerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(sampling);
+  process::metrics::remove(sample_age_secs);
+  process::metrics::remove(cache_hits);
+  process::metrics::remove(cache_misses);
+}
+
+
+UsageSampler::UsageSampler(
+    Containerizer* containerizer,
+    const Duration& interval)
+{
+  process = new UsageSamplerProcess(containerizer, interval);
+  spawn(process);
+}
+
+
+UsageSampler::~UsageSampler()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<ResourceStatistics> UsageSampler::usage(
+    const ContainerID& containerId,
+    const Duration& staleness)
+{
+  return dispatch(
+      process,
+      &UsageSamplerProcess::usage,
+      containerId,
+      staleness);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
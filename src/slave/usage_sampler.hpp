@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_USAGE_SAMPLER_HPP__
+#define __SLAVE_USAGE_SAMPLER_HPP__
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+
+#include <stout/duration.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declarations.
+class Containerizer;
+class UsageSamplerProcess;
+
+
+// Samples the resource usage of the containers of a containerizer,
+// so that the consumers of the usage on the agent (the resource
+// estimator, the QoS controller and the HTTP endpoints) share the
+// samples rather than each of them collecting the usage (e.g., by
+// reading cgroups, or running 'perf') anew for every container.
+//
+// If an interval is given, all the containers are sampled once per
+// interval. Otherwise, the usage is only collected on demand, which
+// is still shared by the consumers that ask at the same time, but no
+// samples are kept.
+class UsageSampler
+{
+public:
+  UsageSampler(
+      Containerizer* containerizer,
+      const Duration& interval);
+
+  virtual ~UsageSampler();
+
+  // Returns the latest sample of the usage of the container if it was
+  // taken less than 'staleness' ago, or in the latest round of
+  // sampling (i.e., less than the interval plus the time it takes to
+  // sample all the containers ago). Otherwise, the usage is collected
+  // anew, along with any other consumer waiting for it.
+  // The future will fail if the usage of the container can't be
+  // collected (e.g., because the container is unknown). Discarding
+  // the future doesn't affect the other consumers.
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId,
+      const Duration& staleness);
+
+private:
+  UsageSamplerProcess* process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_USAGE_SAMPLER_HPP__
@@ -137,6 +137,12 @@ private:
   const size_t diffsBetweenSnapshots;
 
   // Used to serialize Log::Writer::append/truncate operations.
+  //
+  // NOTE: Log::Writer pipelines concurrent writes, but a write that
+  // follows one which returned none might still end up in the log.
+  // Since a snapshot or diff only makes sense on top of the ones
+  // written before it, each operation has to complete before the
+  // next one is issued.
   Mutex mutex;
 
   // Whether or not we've started the ability to append to log.
@@ -550,7 +550,7 @@ TEST_F(ROOT_XFS_QuotaTest, NoCheckpointRecovery)
   EXPECT_EQ(TASK_RUNNING, status.get().state());
 
   Future<ResourceUsage> usage1 =
-    process::dispatch(slave.get()->pid, &Slave::usage);
+    process::dispatch(slave.get()->pid, &Slave::usage, Duration::zero());
   AWAIT_READY(usage1);
 
   // We should have 1 executor using resources.
@@ -575,7 +575,7 @@ TEST_F(ROOT_XFS_QuotaTest, NoCheckpointRecovery)
   AWAIT_READY(slaveReregisteredMessage);
 
   Future<ResourceUsage> usage2 =
-    process::dispatch(slave.get()->pid, &Slave::usage);
+    process::dispatch(slave.get()->pid, &Slave::usage, Duration::zero());
   AWAIT_READY(usage2);
 
   // We should have no executors left because we didn't checkpoint.
@@ -662,7 +662,7 @@ TEST_F(ROOT_XFS_QuotaTest, CheckpointRecovery)
   EXPECT_EQ(TASK_RUNNING, status.get().state());
 
   Future<ResourceUsage> usage1 =
-    process::dispatch(slave.get()->pid, &Slave::usage);
+    process::dispatch(slave.get()->pid, &Slave::usage, Duration::zero());
   AWAIT_READY(usage1);
 
   // We should have 1 executor using resources.
@@ -681,7 +681,7 @@ TEST_F(ROOT_XFS_QuotaTest, CheckpointRecovery)
   AWAIT_READY(slaveReregisteredMessage);
 
   Future<ResourceUsage> usage2 =
-    process::dispatch(slave.get()->pid, &Slave::usage);
+    process::dispatch(slave.get()->pid, &Slave::usage, Duration::zero());
   AWAIT_READY(usage2);
 
   // We should have still have 1 executor using resources.
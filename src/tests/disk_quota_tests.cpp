@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
 #include <string>
 #include <vector>
 
@@ -30,6 +32,8 @@
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "master/master.hpp"
@@ -57,6 +61,7 @@ using testing::Return;
 
 using mesos::internal::master::Master;
 
+using mesos::internal::slave::DISK_USAGE_MAX_OPEN_DIRECTORIES;
 using mesos::internal::slave::DiskUsageCollector;
 using mesos::internal::slave::Fetcher;
 using mesos::internal::slave::MesosContainerizer;
@@ -172,6 +177,109 @@ TEST_F(DiskUsageCollectorTest, ExcludeRelativePath)
 #endif
 
 
+// This test verifies that the usage of a directory matches what 'du'
+// reports for it, including for hard links, symbolic links, sparse
+// files and excluded paths.
+TEST_F(DiskUsageCollectorTest, MatchesDu)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string nested = path::join(dir, "nested", "deeply");
+  string volume = path::join(dir, "volume");
+
+  ASSERT_SOME(os::mkdir(nested));
+  ASSERT_SOME(os::mkdir(volume));
+
+  string file1 = path::join(dir, "file1");
+  string file2 = path::join(nested, "file2");
+  string file3 = path::join(volume, "file3");
+
+  ASSERT_SOME(os::write(file1, string(Kilobytes(100).bytes(), 'x')));
+  ASSERT_SOME(os::write(file2, string(Kilobytes(5).bytes() + 1, 'y')));
+  ASSERT_SOME(os::write(file3, string(Kilobytes(64).bytes(), 'z')));
+
+  // A hard link is only counted once, and a symbolic link is not
+  // followed.
+  ASSERT_EQ(0, ::link(file1.c_str(), path::join(nested, "link").c_str()));
+  ASSERT_SOME(fs::symlink(file3, path::join(dir, "symlink")));
+
+  // A sparse file only uses the blocks that were written.
+  ASSERT_SOME(os::shell(
+      "dd if=/dev/zero of=%s bs=1024 count=1 seek=1024 2>/dev/null",
+      path::join(dir, "sparse").c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1), 2);
+
+  Future<Bytes> usage1 = collector.usage(dir, {});
+  Future<Bytes> usage2 = collector.usage(nested, {});
+
+  Try<string> du1 = os::shell("du -k -s %s", dir.c_str());
+  ASSERT_SOME(du1);
+
+  Try<string> du2 = os::shell("du -k -s %s", nested.c_str());
+  ASSERT_SOME(du2);
+
+  AWAIT_READY(usage1);
+  EXPECT_EQ(strings::tokenize(du1.get(), " \t")[0],
+            stringify(usage1->kilobytes()));
+
+  AWAIT_READY(usage2);
+  EXPECT_EQ(strings::tokenize(du2.get(), " \t")[0],
+            stringify(usage2->kilobytes()));
+
+#ifdef __linux__
+  Future<Bytes> usage3 = collector.usage(dir, {volume});
+
+  Try<string> du3 =
+    os::shell("du -k -s --exclude %s %s", volume.c_str(), dir.c_str());
+
+  ASSERT_SOME(du3);
+
+  AWAIT_READY(usage3);
+  EXPECT_EQ(strings::tokenize(du3.get(), " \t")[0],
+            stringify(usage3->kilobytes()));
+#endif // __linux__
+}
+
+
+// This test verifies that the usage of a hierarchy that is nested
+// deeper than the number of directories a check keeps open matches
+// what 'du' reports for it.
+TEST_F(DiskUsageCollectorTest, DeepNesting)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string nested = dir;
+
+  // Every level holds a file and a directory besides the directory
+  // that is nested further, so that there are entries left to read
+  // in the directories that are closed (and reopened) on the way.
+  for (size_t i = 0; i < 4 * DISK_USAGE_MAX_OPEN_DIRECTORIES; i++) {
+    ASSERT_SOME(os::mkdir(path::join(nested, "sibling")));
+    ASSERT_SOME(os::write(
+        path::join(nested, "sibling", "file"),
+        string(Kilobytes(4).bytes(), 'x')));
+
+    ASSERT_SOME(os::write(
+        path::join(nested, "file"),
+        string(Kilobytes(8).bytes() + i, 'y')));
+
+    nested = path::join(nested, "d");
+  }
+
+  ASSERT_SOME(os::mkdir(nested));
+
+  DiskUsageCollector collector(Milliseconds(1), 1);
+
+  Future<Bytes> usage = collector.usage(dir, {});
+
+  Try<string> du = os::shell("du -k -s %s", dir.c_str());
+  ASSERT_SOME(du);
+
+  AWAIT_READY(usage);
+  EXPECT_EQ(strings::tokenize(du.get(), " \t")[0],
+            stringify(usage->kilobytes()));
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
@@ -53,6 +53,8 @@ using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFAllocatorProcess;
+using mesos::internal::master::allocator::MesosAllocator;
 
 using mesos::internal::protobuf::createLabel;
 
@@ -289,6 +291,20 @@ private:
 class HierarchicalAllocatorTest : public HierarchicalAllocatorTestBase {};
 
 
+// A hierarchical allocator that evaluates every allocation run over
+// more than `AGENTS_PER_SHARD` agents in up to `MAX_SHARDS` shards.
+template <size_t AGENTS_PER_SHARD, size_t MAX_SHARDS>
+class ShardedAllocatorProcess : public HierarchicalDRFAllocatorProcess
+{
+public:
+  ShardedAllocatorProcess()
+  {
+    agentsPerShard = AGENTS_PER_SHARD;
+    maxShards = MAX_SHARDS;
+  }
+};
+
+
 // TODO(bmahler): These tests were transformed directly from
 // integration tests into unit tests. However, these tests
 // should be simplified even further to each test a single
@@ -2613,6 +2629,66 @@ TEST_F(HierarchicalAllocatorTest, AllocationRunsMetric)
 }
 
 
+// This test checks that batch allocations consider the agents on which
+// resources were recovered, and that the number of agents considered
+// is counted by the metric.
+TEST_F(HierarchicalAllocatorTest, AllocationCandidatesMetric)
+{
+  Clock::pause();
+
+  initialize();
+
+  SlaveInfo agent1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent1.id(), agent1, None(), agent1.resources(), {});
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent2.id(), agent2, None(), agent2.resources(), {});
+
+  // Both agents are allocated to the framework once it is added.
+  FrameworkInfo framework = createFrameworkInfo("role");
+  allocator->addFramework(framework.id(), framework, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation->frameworkId);
+  EXPECT_EQ(2u, allocation->resources.size());
+
+  JSON::Object metrics = Metrics();
+
+  ASSERT_EQ(1u, metrics.values.count("allocator/mesos/allocation_candidates"));
+
+  const double candidates =
+    metrics.values["allocator/mesos/allocation_candidates"]
+      .as<JSON::Number>().as<double>();
+
+  // Recovering the resources on one agent makes it a candidate.
+  allocator->recoverResources(
+      framework.id(),
+      agent1.id(),
+      agent1.resources(),
+      None());
+
+  // The next batch allocation only considers the recovered agent, and
+  // re-offers its resources.
+  Clock::advance(flags.allocation_interval);
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation->frameworkId);
+  EXPECT_EQ(1u, allocation->resources.size());
+  EXPECT_TRUE(allocation->resources.contains(agent1.id()));
+
+  JSON::Object expected;
+  expected.values = {
+    {"allocator/mesos/allocation_candidates", candidates + 1}
+  };
+
+  JSON::Value value = Metrics();
+
+  EXPECT_TRUE(value.contains(expected));
+}
+
+
 // This test checks that the allocation run timer
 // metrics are reported in the metrics endpoint.
 TEST_F(HierarchicalAllocatorTest, AllocationRunTimerMetrics)
@@ -3181,6 +3257,105 @@ TEST_F(HierarchicalAllocatorTest, ReviveOffers)
 }
 
 
+// This test ensures that sharding the evaluation of the agents across
+// threads doesn't change the outcome of an allocation run.
+TEST_F(HierarchicalAllocatorTest, ShardedEvaluation)
+{
+  // Collects, for each framework, the agents it was offered during
+  // a batch allocation, by their index.
+  auto allocate = [this](map<size_t, set<size_t>>* offered) {
+    Clock::pause();
+
+    initialize();
+
+    vector<FrameworkInfo> frameworks;
+    for (size_t i = 0; i < 3; i++) {
+      frameworks.push_back(createFrameworkInfo("role" + stringify(i)));
+      allocator->addFramework(
+          frameworks.back().id(), frameworks.back(), {});
+    }
+
+    // Each agent's resources are reserved for one of the roles, so
+    // that every agent can only be offered to a single framework.
+    vector<SlaveInfo> agents;
+    for (size_t i = 0; i < 30; i++) {
+      const string role = "role" + stringify(i % frameworks.size());
+
+      agents.push_back(createSlaveInfo(
+          "cpus(" + role + "):1;mem(" + role + "):512;disk(" + role + "):0"));
+
+      allocator->addSlave(
+          agents.back().id(),
+          agents.back(),
+          None(),
+          agents.back().resources(),
+          {});
+
+      AWAIT_READY(allocations.get());
+    }
+
+    // The frameworks decline half of the agents with a filter, and
+    // the others without one.
+    Filters filter1000s;
+    filter1000s.set_refuse_seconds(1000.);
+
+    for (size_t i = 0; i < agents.size(); i++) {
+      allocator->recoverResources(
+          frameworks[i % frameworks.size()].id(),
+          agents[i].id(),
+          agents[i].resources(),
+          i % 2 == 0 ? Option<Filters>(filter1000s) : None());
+    }
+
+    // Advance the clock to trigger a batch allocation.
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    for (size_t i = 0; i < frameworks.size(); i++) {
+      Future<Allocation> allocation = allocations.get();
+      AWAIT_READY(allocation);
+
+      for (size_t j = 0; j < frameworks.size(); j++) {
+        if (frameworks[j].id() != allocation->frameworkId) {
+          continue;
+        }
+
+        for (size_t k = 0; k < agents.size(); k++) {
+          if (allocation->resources.contains(agents[k].id())) {
+            (*offered)[j].insert(k);
+          }
+        }
+      }
+    }
+
+    Clock::resume();
+  };
+
+  map<size_t, set<size_t>> unsharded;
+  allocate(&unsharded);
+
+  delete allocator;
+  allocator = createAllocator<MesosAllocator<ShardedAllocatorProcess<1, 4>>>();
+
+  map<size_t, set<size_t>> sharded;
+  allocate(&sharded);
+
+  // Only the agents declined without a filter are offered again.
+  ASSERT_EQ(3u, unsharded.size());
+
+  foreachpair (size_t framework, const set<size_t>& agents, unsharded) {
+    EXPECT_EQ(5u, agents.size());
+
+    foreach (size_t agent, agents) {
+      EXPECT_EQ(1u, agent % 2);
+      EXPECT_EQ(framework, agent % 3);
+    }
+  }
+
+  EXPECT_EQ(unsharded, sharded);
+}
+
+
 class HierarchicalAllocator_BENCHMARK_Test
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -3407,6 +3582,197 @@ TEST_F(HierarchicalAllocator_BENCHMARK_Test, DeclineOffers)
 }
 
 
+// This benchmark measures the allocation cycles once the frameworks
+// have declined every agent with a long lived offer filter, i.e., with
+// 100k outstanding offer filters, and the expiration of these filters.
+TEST_F(HierarchicalAllocator_BENCHMARK_Test, OfferFilters)
+{
+  unsigned frameworkCount = 100;
+  unsigned slaveCount = 1000;
+  master::Flags flags;
+
+  // Choose an interval longer than the time we expect a single cycle to take so
+  // that we don't back up the process queue.
+  flags.allocation_interval = Hours(1);
+
+  // The filters need to outlive the allocation cycles that install them.
+  Duration filterTimeout = flags.allocation_interval * frameworkCount * 2;
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  struct OfferedResources {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources_)
+  {
+    foreach (auto resources, resources_) {
+      offers.push_back(
+          OfferedResources{frameworkId, resources.first, resources.second});
+    }
+  };
+
+  cout << "Using " << slaveCount << " agents and "
+       << frameworkCount << " frameworks" << endl;
+
+  initialize(flags, offerCallback);
+
+  for (unsigned i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework = createFrameworkInfo("*");
+    allocator->addFramework(framework.id(), framework, {});
+  }
+
+  for (unsigned i = 0; i < slaveCount; i++) {
+    SlaveInfo slave = createSlaveInfo(
+        "cpus:24;mem:4096;disk:4096;ports:[31000-32000]");
+    allocator->addSlave(slave.id(), slave, None(), slave.resources(), {});
+  }
+
+  // Wait for all the `addSlave` operations to be processed.
+  Clock::settle();
+
+  Filters filters;
+  filters.set_refuse_seconds(filterTimeout.secs());
+
+  Stopwatch watch;
+  watch.start();
+
+  // Every agent is offered to each framework in turn, until all of
+  // the frameworks have declined every agent.
+  unsigned rounds = 0;
+  while (!offers.empty()) {
+    foreach (const OfferedResources& offer, offers) {
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, filters);
+    }
+
+    offers.clear();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    rounds++;
+  }
+
+  JSON::Object metrics = Metrics();
+
+  cout << "Installed " << metrics.values["allocator/mesos/offer_filters/active"]
+       << " offer filters in " << rounds << " allocation cycles"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  cout << "Allocation cycle with all agents filtered took "
+       << watch.elapsed() << " to make " << offers.size() << " offers"
+       << endl;
+
+  watch.start();
+
+  Clock::advance(filterTimeout);
+  Clock::settle();
+
+  cout << "Expiring the offer filters and the allocation cycle took "
+       << watch.elapsed() << " to make " << offers.size() << " offers"
+       << endl;
+
+  Clock::resume();
+}
+
+
+// Measures the allocation cycles over agents with many offer filters,
+// with the evaluation of the agents on a single thread, and sharded
+// across threads as configured by default.
+TEST_F(HierarchicalAllocator_BENCHMARK_Test, ShardedEvaluation)
+{
+  const size_t frameworkCount = 50;
+  const size_t slaveCount = 10000;
+  const size_t rounds = 10;
+
+  master::Flags flags;
+  flags.allocation_interval = Hours(1);
+
+  // The filters need to outlive the allocation cycles that install them.
+  Filters filters;
+  filters.set_refuse_seconds((flags.allocation_interval * rounds * 2).secs());
+
+  cout << "Using " << slaveCount << " agents and "
+       << frameworkCount << " frameworks" << endl;
+
+  foreach (bool sharded, vector<bool>({false, true})) {
+    delete allocator;
+
+    allocator = sharded
+      ? createAllocator<HierarchicalDRFAllocator>()
+      : createAllocator<MesosAllocator<ShardedAllocatorProcess<
+            master::MIN_AGENTS_PER_ALLOCATION_SHARD, 1>>>();
+
+    Clock::pause();
+
+    vector<Allocation> offers;
+
+    auto offerCallback = [&offers](
+        const FrameworkID& frameworkId,
+        const hashmap<SlaveID, Resources>& resources) {
+      offers.push_back(Allocation{frameworkId, resources});
+    };
+
+    initialize(flags, offerCallback);
+
+    for (size_t i = 0; i < frameworkCount; i++) {
+      FrameworkInfo framework = createFrameworkInfo("*");
+      allocator->addFramework(framework.id(), framework, {});
+    }
+
+    for (size_t i = 0; i < slaveCount; i++) {
+      SlaveInfo slave = createSlaveInfo(
+          "cpus:24;mem:4096;disk:4096;ports:[31000-32000]");
+      allocator->addSlave(slave.id(), slave, None(), slave.resources(), {});
+    }
+
+    // Wait for all the `addSlave` operations to be processed.
+    Clock::settle();
+
+    Stopwatch watch;
+    watch.start();
+
+    // Every round, the frameworks decline all of their offers with a
+    // filter, so the agents accumulate filters from a framework more
+    // in every round.
+    for (size_t round = 0; round < rounds; round++) {
+      foreach (const Allocation& offer, offers) {
+        foreachpair (const SlaveID& slaveId,
+                     const Resources& resources,
+                     offer.resources) {
+          allocator->recoverResources(
+              offer.frameworkId, slaveId, resources, filters);
+        }
+      }
+
+      offers.clear();
+
+      Clock::advance(flags.allocation_interval);
+      Clock::settle();
+    }
+
+    cout << rounds << " allocation cycles "
+         << (sharded ? "with" : "without") << " sharding took "
+         << watch.elapsed() << endl;
+
+    Clock::resume();
+  }
+}
+
+
 // This returns a `Labels` that has 12 key-value pairs, which should
 // be more than we expect most frameworks to use in practice. We
 // ensure that the first 11 key-value pairs are equal, which results
@@ -19,12 +19,14 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/log/log.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -68,11 +70,13 @@ using namespace process;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 using mesos::log::Log;
 
@@ -321,6 +325,98 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+// Tests that a storage restores its state from the summary it keeps,
+// rather than by reading all of its records.
+TYPED_TEST(LogStorageTest, RestoreSummary)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(1);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    // Append (and learn) from position 0 to position 9.
+    for (uint64_t i = 0; i < 10; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      ASSERT_SOME(storage.persist(action));
+    }
+
+    // Append (without learning) position 10, 11 and 13.
+    vector<Action> actions;
+    foreach (uint64_t i, vector<uint64_t>({10, 11, 13})) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      actions.push_back(action);
+    }
+
+    ASSERT_SOME(storage.persist(actions));
+
+    // Truncate to position 3 (at position 14).
+    Action truncate;
+    truncate.set_position(14);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(3);
+
+    ASSERT_SOME(storage.persist(truncate));
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  // Only the summary and the metadata should have been read.
+  EXPECT_EQ(2u, state.get().records);
+
+  EXPECT_EQ(Metadata::VOTING, state.get().metadata.status());
+  EXPECT_EQ(1u, state.get().metadata.promised());
+  EXPECT_EQ(3u, state.get().begin);
+  EXPECT_EQ(14u, state.get().end);
+
+  IntervalSet<uint64_t> learned;
+  learned += (Bound<uint64_t>::closed(3), Bound<uint64_t>::closed(9));
+  learned += 14;
+
+  IntervalSet<uint64_t> unlearned;
+  unlearned += (Bound<uint64_t>::closed(10), Bound<uint64_t>::closed(11));
+  unlearned += 13;
+
+  EXPECT_EQ(learned, state.get().learned);
+  EXPECT_EQ(unlearned, state.get().unlearned);
+
+  EXPECT_ERROR(storage.read(2));
+
+  Try<Action> action = storage.read(13);
+  ASSERT_SOME(action);
+  EXPECT_EQ(13u, action.get().position());
+  EXPECT_FALSE(action.get().learned());
+  EXPECT_EQ("13", action.get().append().bytes());
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1207,6 +1303,310 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+// Verifies that appends issued without waiting for the previous ones
+// (more than the coordinator keeps in flight) are written in order.
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  vector<Future<Option<uint64_t> > > appending;
+  for (uint64_t position = 1; position <= 100; position++) {
+    appending.push_back(coord.append(stringify(position)));
+  }
+
+  for (uint64_t position = 1; position <= 100; position++) {
+    AWAIT_READY(appending[position - 1]);
+    EXPECT_SOME_EQ(position, appending[position - 1].get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 100);
+    AWAIT_READY(actions);
+    EXPECT_EQ(100u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+// Verifies that all the appends in flight return none when the
+// coordinator gets demoted.
+TEST_F(CoordinatorTest, PipelinedAppendsDemoted)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica2, network2);
+
+  {
+    Future<Option<uint64_t> > electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  vector<Future<Option<uint64_t> > > appending;
+  for (int i = 0; i < 10; i++) {
+    appending.push_back(coord1.append(stringify(i)));
+  }
+
+  foreach (const Future<Option<uint64_t> >& append, appending) {
+    AWAIT_READY(append);
+    EXPECT_NONE(append.get());
+  }
+
+  {
+    Future<Option<uint64_t> > append = coord1.append("hello world");
+    AWAIT_READY(append);
+    EXPECT_NONE(append.get());
+  }
+
+  {
+    Future<Option<uint64_t> > append = coord2.append("hello hello");
+    AWAIT_READY(append);
+    EXPECT_SOME(append.get());
+  }
+}
+
+
+// Verifies that when a write in the middle of the pipeline is
+// rejected, it and all the writes issued after it return none, and
+// that the next elected coordinator finds each of their positions
+// either written or filled with a no-op.
+TEST_F(CoordinatorTest, PipelinedAppendsRejectedMidPipeline)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  vector<Future<Option<uint64_t> > > appending;
+  for (uint64_t position = 1; position <= 5; position++) {
+    appending.push_back(coord1.append(stringify(position)));
+  }
+
+  for (uint64_t position = 1; position <= 5; position++) {
+    AWAIT_READY(appending[position - 1]);
+    EXPECT_SOME_EQ(position, appending[position - 1].get());
+  }
+
+  // Have replica2 promise position 8 to a higher proposal, so that it
+  // rejects the write to that position, but not the writes around it.
+  {
+    PromiseRequest request;
+    request.set_proposal(100);
+    request.set_position(8);
+
+    Future<PromiseResponse> response =
+      protocol::promise(replica2->pid(), request);
+
+    AWAIT_READY(response);
+    EXPECT_TRUE(response.get().okay());
+  }
+
+  for (uint64_t position = 6; position <= 10; position++) {
+    appending.push_back(coord1.append(stringify(position)));
+  }
+
+  // The writes before the rejected one might complete, or return none
+  // if they were still being learned; the rest return none.
+  bool aborted = false;
+  for (uint64_t position = 6; position <= 10; position++) {
+    AWAIT_READY(appending[position - 1]);
+
+    if (aborted || position >= 8) {
+      EXPECT_NONE(appending[position - 1].get());
+    } else if (appending[position - 1].get().isNone()) {
+      aborted = true;
+    } else {
+      EXPECT_SOME_EQ(position, appending[position - 1].get());
+    }
+  }
+
+  // The coordinator is demoted.
+  {
+    Future<Option<uint64_t> > append = coord1.append("hello world");
+    AWAIT_READY(append);
+    EXPECT_NONE(append.get());
+  }
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica2, network2);
+
+  Option<uint64_t> end;
+  for (int i = 0; end.isNone() && i < 3; i++) {
+    Future<Option<uint64_t> > electing = coord2.elect();
+    AWAIT_READY(electing);
+    end = electing.get();
+  }
+
+  ASSERT_SOME(end);
+  EXPECT_LE(5u, end.get());
+  EXPECT_GE(10u, end.get());
+
+  // Any of the positions the rejected writes were issued for might
+  // have been written by a quorum (even those following position 8),
+  // otherwise they are filled with no-ops.
+  {
+    Future<list<Action> > actions = replica2->read(1, end.get());
+    AWAIT_READY(actions);
+    EXPECT_EQ(end.get(), actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+
+      if (action.type() == Action::NOP) {
+        EXPECT_LT(5u, action.position());
+        EXPECT_NONE(appending[action.position() - 1].get());
+      } else {
+        ASSERT_EQ(Action::APPEND, action.type());
+        EXPECT_EQ(stringify(action.position()), action.append().bytes());
+      }
+    }
+  }
+
+  {
+    Future<Option<uint64_t> > append = coord2.append("hello hello");
+    AWAIT_READY(append);
+    EXPECT_SOME_EQ(end.get() + 1, append.get());
+  }
+}
+
+
+// Verifies that a batch of writes is written to consecutive positions
+// and learned by the local replica.
+TEST_F(CoordinatorTest, BatchWrite)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  vector<Action> batch;
+  for (uint64_t position = 1; position <= 10; position++) {
+    Action action;
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(position));
+    batch.push_back(action);
+  }
+
+  {
+    Future<Option<uint64_t> > writing = coord.write(batch);
+    AWAIT_READY(writing);
+    EXPECT_SOME_EQ(1u, writing.get());
+  }
+
+  {
+    Future<Option<uint64_t> > appending = coord.append("11");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(11u, appending.get());
+  }
+
+  const vector<Shared<Replica>> replicas = {replica1, replica2};
+
+  foreach (const Shared<Replica>& replica, replicas) {
+    Future<list<Action> > actions = replica->read(1, 11);
+    AWAIT_READY(actions);
+    EXPECT_EQ(11u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_TRUE(action.learned());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1516,6 +1916,67 @@ TEST_F(CoordinatorTest, TruncateLearnedFill)
 }
 
 
+class Coordinator_BENCHMARK_Test
+  : public CoordinatorTest,
+    public WithParamInterface<size_t> {};
+
+
+// The coordinator benchmark tests are parameterized by the number of
+// replicas.
+INSTANTIATE_TEST_CASE_P(
+    ReplicaCount,
+    Coordinator_BENCHMARK_Test,
+    ::testing::Values(3U, 5U));
+
+
+// Measures the throughput of appends issued without waiting for the
+// previous ones, which the coordinator pipelines.
+TEST_P(Coordinator_BENCHMARK_Test, PipelinedAppends)
+{
+  const size_t replicaCount = GetParam();
+  const size_t appendCount = 100000;
+
+  vector<Shared<Replica> > replicas;
+  set<UPID> pids;
+
+  for (size_t i = 0; i < replicaCount; i++) {
+    const string path = os::getcwd() + "/.log" + stringify(i);
+    initializer.flags.path = path;
+    initializer.execute();
+
+    replicas.push_back(Shared<Replica>(new Replica(path)));
+    pids.insert(replicas.back()->pid());
+  }
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(replicaCount / 2 + 1, replicas.front(), network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    ASSERT_SOME(electing.get());
+  }
+
+  const string bytes(100, 'x');
+
+  Stopwatch watch;
+  watch.start();
+
+  Future<Option<uint64_t> > appending;
+  for (size_t i = 0; i < appendCount; i++) {
+    appending = coord.append(bytes);
+  }
+
+  AWAIT_READY_FOR(appending, Minutes(10));
+  ASSERT_SOME(appending.get());
+
+  LOG(INFO) << "Appended " << appendCount << " entries to " << replicaCount
+            << " replicas in " << watch.elapsed() << " ("
+            << appendCount / watch.elapsed().secs() << " appends/sec)";
+}
+
+
 class MockReplica : public Replica
 {
 public:
@@ -2107,6 +2568,88 @@ TEST_F(LogTest, Metrics)
 }
 
 
+// Verifies that a writer with group commit enabled writes concurrent
+// appends in order, using fewer rounds than appends.
+TEST_F(LogTest, GroupCommit)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids, false, "prefix/");
+
+  Log::Writer writer(&log, Milliseconds(10), "prefix/writer/");
+
+  Future<Option<Log::Position> > start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  const size_t appends = 100;
+
+  list<Future<Option<Log::Position> > > positions;
+  for (size_t i = 0; i < appends; i++) {
+    positions.push_back(writer.append(stringify(i)));
+  }
+
+  AWAIT_READY(collect(positions));
+
+  Option<Log::Position> previous = start.get();
+  foreach (const Future<Option<Log::Position> >& position, positions) {
+    ASSERT_SOME(position.get());
+    EXPECT_LT(previous.get(), position.get().get());
+    previous = position.get();
+  }
+
+  Log::Reader reader(&log);
+
+  Future<list<Log::Entry> > entries = reader.read(
+      positions.front().get().get(),
+      positions.back().get().get());
+
+  AWAIT_READY(entries);
+  ASSERT_EQ(appends, entries.get().size());
+
+  size_t i = 0;
+  foreach (const Log::Entry& entry, entries.get()) {
+    EXPECT_EQ(stringify(i++), entry.data);
+  }
+
+  // A second writer of the same log exposes its metrics under the
+  // prefix it is given.
+  Log::Writer idle(&log, Milliseconds(10), "prefix/idle/");
+
+  JSON::Object snapshot = Metrics();
+
+  ASSERT_EQ(
+      1u, snapshot.values.count("prefix/writer/log/group_commit/entries"));
+  EXPECT_EQ(
+      appends, snapshot.values["prefix/writer/log/group_commit/entries"]);
+
+  ASSERT_EQ(
+      1u, snapshot.values.count("prefix/writer/log/group_commit/batches"));
+  EXPECT_GT(
+      appends,
+      snapshot.values["prefix/writer/log/group_commit/batches"]
+        .as<JSON::Number>().as<size_t>());
+
+  EXPECT_EQ(
+      1u, snapshot.values.count("prefix/writer/log/group_commit/commit_ms"));
+
+  EXPECT_EQ(0, snapshot.values["prefix/idle/log/group_commit/entries"]);
+  EXPECT_EQ(0, snapshot.values["prefix/idle/log/group_commit/batches"]);
+}
+
+
 #ifdef MESOS_HAS_JAVA
 // TODO(jieyu): We copy the code from TemporaryDirectoryTest here
 // because we cannot inherit from two test fixtures. In this future,
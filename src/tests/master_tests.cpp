@@ -49,6 +49,7 @@
 #include "common/build.hpp"
 #include "common/protobuf_utils.hpp"
 
+#include "master/constants.hpp"
 #include "master/flags.hpp"
 #include "master/master.hpp"
 
@@ -70,6 +71,7 @@
 #include "tests/mesos.hpp"
 #include "tests/utils.hpp"
 
+using mesos::internal::master::HTTP_STREAMING_THREADS;
 using mesos::internal::master::Master;
 
 using mesos::internal::master::allocator::MesosAllocatorProcess;
@@ -1639,6 +1641,10 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
   EXPECT_EQ(1u, snapshot.values.count("master/event_queue_dispatches"));
   EXPECT_EQ(1u, snapshot.values.count("master/event_queue_http_requests"));
 
+  EXPECT_EQ(1u, snapshot.values.count("master/http/snapshots_reused"));
+  EXPECT_EQ(1u, snapshot.values.count("master/http/streaming_bytes"));
+  EXPECT_EQ(1u, snapshot.values.count("master/http/streaming_peak_bytes"));
+
   EXPECT_EQ(1u, snapshot.values.count("master/cpus_total"));
   EXPECT_EQ(1u, snapshot.values.count("master/cpus_used"));
   EXPECT_EQ(1u, snapshot.values.count("master/cpus_percent"));
@@ -1661,6 +1667,7 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 
   EXPECT_EQ(1u, snapshot.values.count("registrar/state_fetch_ms"));
   EXPECT_EQ(1u, snapshot.values.count("registrar/state_store_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("registrar/state_store_bytes"));
 
   // Allocator Metrics.
   EXPECT_EQ(1u, snapshot.values.count(
@@ -3069,6 +3076,332 @@ TEST_F(MasterTest, StateEndpoint)
 }
 
 
+// This test ensures that the state endpoint streams its response in
+// chunks, including when JSONP is requested, and that the master
+// reports the time spent capturing the state that is streamed.
+TEST_F(MasterTest, StateEndpointStreaming)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(APPLICATION_JSON, "Content-Type", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("chunked", "Transfer-Encoding", response);
+  EXPECT_NONE(response.get().headers.get("Content-Length"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(stringify(master.get()->pid), parse.get().values["pid"]);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      "jsonp=callback",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "text/javascript", "Content-Type", response);
+
+  const string& body = response.get().body;
+  ASSERT_TRUE(strings::startsWith(body, "callback("));
+  ASSERT_TRUE(strings::endsWith(body, ");"));
+
+  parse = JSON::parse<JSON::Object>(
+      body.substr(strlen("callback("), body.size() - strlen("callback();")));
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(stringify(master.get()->pid), parse.get().values["pid"]);
+
+  JSON::Object snapshot = Metrics();
+
+  EXPECT_EQ(1u, snapshot.values.count("master/http/snapshot_capture_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("master/http/streaming_bytes"));
+  EXPECT_EQ(1u, snapshot.values.count("master/http/streaming_peak_bytes"));
+}
+
+
+// This test verifies that the read-only endpoints share the master's
+// state snapshot while the state does not change, and that changes
+// to the state are reflected by subsequent requests.
+TEST_F(MasterTest, StateEndpointSnapshotReuse)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Make sure the agent does not update its state in the meantime.
+  Clock::pause();
+  Clock::settle();
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  const string body = response.get().body;
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_EQ(body, response.get().body);
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(1, metrics.values["master/http/snapshots_reused"]);
+
+  Clock::resume();
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> frameworks = parse.get().find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_EQ(1u, frameworks.get().values.size());
+
+  Result<JSON::Array> slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves.get().values.size());
+
+  driver.stop();
+  driver.join();
+}
+
+
+// This test verifies that a snapshot captured for an endpoint that
+// only exposes some of the master's state is not reused by endpoints
+// exposing more, while the snapshot replacing it serves both.
+TEST_F(MasterTest, StateEndpointSnapshotSections)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Make sure the agent does not update its state in the meantime.
+  Clock::pause();
+  Clock::settle();
+
+  // The agents are all that is captured for '/slaves'.
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "slaves",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Object> flags = parse.get().find<JSON::Object>("flags");
+  ASSERT_SOME(flags);
+  EXPECT_FALSE(flags.get().values.empty());
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(0, metrics.values["master/http/snapshots_reused"]);
+
+  // The snapshot captured for '/state' serves '/slaves' as well.
+  response = process::http::get(
+      master.get()->pid,
+      "slaves",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves.get().values.size());
+
+  metrics = Metrics();
+  EXPECT_EQ(1, metrics.values["master/http/snapshots_reused"]);
+
+  Clock::resume();
+}
+
+
+// This test verifies that more concurrent requests to the streamed
+// endpoints than there are threads to serialize them on all succeed,
+// i.e., the requests beyond the pool wait for a thread to free up.
+TEST_F(MasterTest, StateEndpointStreamingPool)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  vector<Future<Response>> responses;
+  for (size_t i = 0; i < 2 * HTTP_STREAMING_THREADS; i++) {
+    responses.push_back(process::http::get(
+        master.get()->pid,
+        i % 2 == 0 ? "state" : "slaves",
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL)));
+  }
+
+  foreach (const Future<Response>& response, responses) {
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+    Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+    ASSERT_SOME(parse);
+  }
+}
+
+
+// This test verifies that an update of a task is visible in the next
+// snapshot, even though the framework's other state did not change.
+TEST_F(MasterTest, StateEndpointSnapshotTaskUpdate)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  ExecutorDriver* execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(SaveArg<0>(&execDriver));
+
+  Future<TaskInfo> launchTask;
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(FutureArg<1>(&launchTask));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(launchTask);
+
+  auto tasks = [&master]() -> Future<Response> {
+    return process::http::get(
+        master.get()->pid,
+        "tasks",
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+  };
+
+  Future<Response> response = tasks();
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Value> value = JSON::parse<JSON::Value>(response.get().body);
+  ASSERT_SOME(value);
+
+  Try<JSON::Value> expected = JSON::parse(
+      "{\"tasks\":[{\"state\":\"TASK_STAGING\"}]}");
+  ASSERT_SOME(expected);
+  EXPECT_TRUE(value.get().contains(expected.get()));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  TaskStatus running;
+  running.mutable_task_id()->CopyFrom(task.task_id());
+  running.set_state(TASK_RUNNING);
+  execDriver->sendStatusUpdate(running);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  response = tasks();
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  value = JSON::parse<JSON::Value>(response.get().body);
+  ASSERT_SOME(value);
+
+  expected = JSON::parse("{\"tasks\":[{\"state\":\"TASK_RUNNING\"}]}");
+  ASSERT_SOME(expected);
+  EXPECT_TRUE(value.get().contains(expected.get()));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test ensures that the framework's information is included in
 // the master's state endpoint.
 //
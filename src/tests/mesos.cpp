@@ -544,7 +544,7 @@ MockSlave::MockSlave(
     .WillRepeatedly(Invoke(this, &MockSlave::unmocked___recover));
   EXPECT_CALL(*this, qosCorrections())
     .WillRepeatedly(Invoke(this, &MockSlave::unmocked_qosCorrections));
-  EXPECT_CALL(*this, usage())
+  EXPECT_CALL(*this, usage(_))
     .WillRepeatedly(Invoke(this, &MockSlave::unmocked_usage));
 }
 
@@ -601,9 +601,10 @@ void MockSlave::unmocked_qosCorrections()
 }
 
 
-process::Future<ResourceUsage> MockSlave::unmocked_usage()
+process::Future<ResourceUsage> MockSlave::unmocked_usage(
+    const Duration& staleness)
 {
-  return slave::Slave::usage();
+  return slave::Slave::usage(staleness);
 }
 
 
@@ -1387,9 +1387,9 @@ public:
       const process::Future<std::list<
           mesos::slave::QoSCorrection>>& correction));
 
-  MOCK_METHOD0(usage, process::Future<ResourceUsage>());
+  MOCK_METHOD1(usage, process::Future<ResourceUsage>(const Duration&));
 
-  process::Future<ResourceUsage> unmocked_usage();
+  process::Future<ResourceUsage> unmocked_usage(const Duration& staleness);
 
 private:
   Files files;
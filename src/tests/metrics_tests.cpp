@@ -197,6 +197,7 @@ TEST_F(MetricsTest, Master)
 
   EXPECT_EQ(1u, stats.values.count("registrar/state_fetch_ms"));
   EXPECT_EQ(1u, stats.values.count("registrar/state_store_ms"));
+  EXPECT_EQ(1u, stats.values.count("registrar/state_store_bytes"));
 }
 
 
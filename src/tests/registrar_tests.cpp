@@ -50,6 +50,7 @@
 
 #include "log/tool/initialize.hpp"
 
+#include "master/constants.hpp"
 #include "master/flags.hpp"
 #include "master/maintenance.hpp"
 #include "master/master.hpp"
@@ -116,6 +117,7 @@ using mesos::http::authentication::BasicAuthenticatorFactory;
 using mesos::state::LogStorage;
 using mesos::state::Storage;
 using mesos::state::protobuf::State;
+using mesos::state::protobuf::Variable;
 
 using state::Entry;
 
@@ -1008,6 +1010,128 @@ TEST_P(RegistrarTest, Bootstrap)
 }
 
 
+// Tests that the registry is recovered from its latest snapshot and
+// the deltas stored since, across several snapshots and after the
+// ring of deltas wrapped around.
+TEST_P(RegistrarTest, RecoverDeltas)
+{
+  flags.registry_deltas = true;
+
+  vector<SlaveInfo> infos;
+  for (size_t i = 0; i < 2 * REGISTRY_DELTAS; i++) {
+    SlaveInfo info = slave;
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  hashmap<string, double> weights;
+  weights["role"] = 2.0;
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    // Await each operation so that they are all stored separately.
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    }
+
+    for (size_t i = 0; i < infos.size(); i += 2) {
+      AWAIT_TRUE(
+          registrar.apply(Owned<Operation>(new RemoveSlave(infos[i]))));
+    }
+
+    AWAIT_TRUE(registrar.apply(
+        Owned<Operation>(new UpdateWeights(getWeightInfos(weights)))));
+  }
+
+  Future<std::set<string>> names = state->names();
+  AWAIT_READY(names);
+  EXPECT_EQ(1u, names.get().count("registry"));
+  EXPECT_EQ(1u, names.get().count("registry_delta_0"));
+  EXPECT_EQ(1u, names.get().count(
+      "registry_delta_" + stringify(REGISTRY_DELTAS - 1)));
+
+  Registrar registrar(flags, state);
+
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY(registry);
+
+  set<string> expected;
+  for (size_t i = 1; i < infos.size(); i += 2) {
+    expected.insert(infos[i].id().value());
+  }
+
+  set<string> recovered;
+  foreach (const Registry::Slave& slave, registry.get().slaves().slaves()) {
+    recovered.insert(slave.info().id().value());
+  }
+
+  EXPECT_EQ(REGISTRY_DELTAS, (size_t) registry.get().slaves().slaves_size());
+  EXPECT_EQ(expected, recovered);
+
+  ASSERT_EQ(1, registry.get().weights_size());
+  EXPECT_EQ("role", registry.get().weights(0).info().role());
+  EXPECT_EQ(2.0, registry.get().weights(0).info().weight());
+}
+
+
+// Tests that the deltas stored before a snapshot are not replayed on
+// top of it: the delta that admitted an agent must not add the agent
+// back when its removal was stored as a snapshot.
+TEST_P(RegistrarTest, RecoverRemovalInSnapshot)
+{
+  flags.registry_deltas = true;
+
+  SlaveInfo removed = slave;
+  removed.mutable_id()->set_value("removed");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+
+    // Admit and remove the agent until the removal (rather than the
+    // admission) is stored as a snapshot, which it is at the latest
+    // once the ring of deltas is full.
+    Future<Variable<Registry>> snapshot;
+    bool boundary = false;
+    for (size_t i = 0; !boundary && i < 2 * REGISTRY_DELTAS; i++) {
+      AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(removed))));
+
+      snapshot = state->fetch<Registry>("registry");
+      AWAIT_READY(snapshot);
+
+      const uint64_t covered = snapshot.get().get().delta_sequence();
+
+      AWAIT_TRUE(
+          registrar.apply(Owned<Operation>(new RemoveSlave(removed))));
+
+      snapshot = state->fetch<Registry>("registry");
+      AWAIT_READY(snapshot);
+
+      boundary = snapshot.get().get().delta_sequence() != covered;
+    }
+
+    ASSERT_TRUE(boundary);
+
+    // The snapshot covers the delta that admitted the agent.
+    ASSERT_EQ(1, snapshot.get().get().slaves().slaves_size());
+    EXPECT_EQ(slave.id(), snapshot.get().get().slaves().slaves(0).info().id());
+  }
+
+  Registrar registrar(flags, state);
+
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY(registry);
+
+  ASSERT_EQ(1, registry.get().slaves().slaves_size());
+  EXPECT_EQ(slave.id(), registry.get().slaves().slaves(0).info().id());
+  EXPECT_FALSE(registry.get().has_delta_sequence());
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -1025,10 +1149,13 @@ TEST_P(RegistrarTest, FetchTimeout)
   MockStorage storage;
   State state(&storage);
 
+  // The registrar fetches the snapshot of the registry along with
+  // the deltas stored since.
   Future<Nothing> get;
   EXPECT_CALL(storage, get(_))
     .WillOnce(DoAll(FutureSatisfy(&get),
-                    Return(Future<Option<Entry> >())));
+                    Return(Future<Option<Entry> >())))
+    .WillRepeatedly(Return(Future<Option<Entry> >()));
 
   Registrar registrar(flags, &state);
 
@@ -1057,7 +1184,7 @@ TEST_P(RegistrarTest, StoreTimeout)
   Registrar registrar(flags, &state);
 
   EXPECT_CALL(storage, get(_))
-    .WillOnce(Return(None()));
+    .WillRepeatedly(Return(None()));
 
   Future<Nothing> set;
   EXPECT_CALL(storage, set(_, _))
@@ -1087,7 +1214,7 @@ TEST_P(RegistrarTest, Abort)
   Registrar registrar(flags, &state);
 
   EXPECT_CALL(storage, get(_))
-    .WillOnce(Return(None()));
+    .WillRepeatedly(Return(None()));
 
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(Return(Future<bool>(true)))              // Recovery.
@@ -1239,6 +1366,64 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
   cout << "Removed " << slaveCount << " agents in " << watch.elapsed() << endl;
 }
 
+
+// Measures the cost of storing single operations (e.g., an agent
+// registering with a master) in a registry that holds many agents.
+TEST_P(Registrar_BENCHMARK_Test, SingleOperations)
+{
+  flags.registry_deltas = true;
+
+  Registrar registrar(flags, state);
+  AWAIT_READY(registrar.recover(master));
+
+  Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  size_t slaveCount = GetParam();
+
+  vector<SlaveInfo> infos;
+  for (size_t i = 0; i < slaveCount + 1000; ++i) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(
+        string("201310101658-2280333834-5050-48574-") + stringify(i));
+    info.mutable_resources()->MergeFrom(resources);
+    info.mutable_attributes()->MergeFrom(attributes);
+    infos.push_back(info);
+  }
+
+  // Admit the agents in a single batch.
+  Future<bool> result;
+  for (size_t i = 0; i < slaveCount; ++i) {
+    result = registrar.apply(Owned<Operation>(new AdmitSlave(infos[i])));
+  }
+  AWAIT_READY_FOR(result, Minutes(5));
+
+  JSON::Object metrics = Metrics();
+  ASSERT_EQ(1u, metrics.values.count("registrar/state_store_bytes"));
+
+  const uint64_t stored = metrics.values["registrar/state_store_bytes"]
+    .as<JSON::Number>().as<uint64_t>();
+
+  // Admit and remove agents one at a time.
+  Stopwatch watch;
+  watch.start();
+  for (size_t i = slaveCount; i < infos.size(); ++i) {
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(infos[i]))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new RemoveSlave(infos[i]))));
+  }
+
+  metrics = Metrics();
+
+  const uint64_t bytes = metrics.values["registrar/state_store_bytes"]
+    .as<JSON::Number>().as<uint64_t>() - stored;
+
+  cout << "Admitted and removed " << infos.size() - slaveCount << " agents"
+       << " one at a time with " << slaveCount << " agents in the registry"
+       << " in " << watch.elapsed() << ", storing " << Bytes(bytes) << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -25,6 +25,9 @@
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+
+#include "common/resource_quantities.hpp"
 
 #include "master/master.hpp"
 
@@ -32,6 +35,8 @@
 
 using namespace mesos::internal::master;
 
+using std::cout;
+using std::endl;
 using std::map;
 using std::ostringstream;
 using std::pair;
@@ -2405,6 +2410,173 @@ TEST(RevocableResourceTest, Filter)
   EXPECT_EQ(r2, (r1 + r2).nonRevocable());
 }
 
+
+// This test verifies that the quantities of scalar resources omit
+// reservations and persistent volumes, like
+// `Resources::createStrippedScalarQuantity()`.
+TEST(ResourceQuantitiesTest, FromScalarResources)
+{
+  Resources resources = Resources::parse("cpus:1;mem:512;ports:[1-10]").get();
+  resources += Resources(createReservedResource(
+      "cpus", "2", "role", createReservationInfo("principal")));
+  resources += createPersistentVolume(
+      Megabytes(64), "role", "id", "path", "principal");
+  resources += createRevocableResource("cpus", "3", "*", true);
+
+  const ResourceQuantities quantities =
+    ResourceQuantities::fromScalarResources(resources);
+
+  EXPECT_EQ(resources.createStrippedScalarQuantity(), quantities.toResources());
+
+  EXPECT_DOUBLE_EQ(6, quantities.get("cpus"));
+  EXPECT_DOUBLE_EQ(512, quantities.get("mem"));
+  EXPECT_DOUBLE_EQ(64, quantities.get("disk"));
+  EXPECT_DOUBLE_EQ(0, quantities.get("ports"));
+
+  EXPECT_DOUBLE_EQ(6, quantities.get(ResourceQuantities::index("cpus")));
+
+  EXPECT_EQ(set<string>({"cpus", "disk", "mem"}), quantities.names());
+
+  EXPECT_TRUE(ResourceQuantities::fromScalarResources(Resources()).empty());
+}
+
+
+// This test verifies that the arithmetic on quantities has the same
+// semantics as the arithmetic on stripped `Resources`.
+TEST(ResourceQuantitiesTest, Arithmetic)
+{
+  Resources r1 = Resources::parse("cpus:1;mem:512;disk:1024").get();
+  Resources r2 = Resources::parse("cpus(role):2.5;mem:256;gpus:1").get();
+  r2 += createRevocableResource("cpus", "1", "*", true);
+
+  const ResourceQuantities q1 = ResourceQuantities::fromScalarResources(r1);
+  const ResourceQuantities q2 = ResourceQuantities::fromScalarResources(r2);
+
+  EXPECT_EQ(r1 + r2, (q1 + q2).toResources());
+  EXPECT_EQ(r1 - r2, (q1 - q2).toResources());
+  EXPECT_EQ(r2 - r1, (q2 - q1).toResources());
+
+  EXPECT_EQ(q1, q1 + q2 - q2);
+  EXPECT_NE(q1, q2);
+
+  EXPECT_TRUE((q1 + q2).contains(q1));
+  EXPECT_TRUE((q1 + q2).contains(q2));
+  EXPECT_FALSE(q1.contains(q1 + q2));
+  EXPECT_FALSE(q1.contains(q2));
+
+  ResourceQuantities quantities;
+  quantities += q1;
+  quantities += q1;
+  quantities -= q1;
+
+  EXPECT_EQ(q1, quantities);
+
+  quantities -= q1;
+
+  EXPECT_TRUE(quantities.empty());
+
+  // Fractional quantities are kept with the precision of the
+  // `Value::Scalar` arithmetic.
+  const ResourceQuantities fraction =
+    ResourceQuantities::fromScalarResources(Resources::parse("cpus:0.1").get());
+
+  ResourceQuantities sum;
+  for (int i = 0; i < 10; i++) {
+    sum += fraction;
+  }
+
+  EXPECT_EQ(
+      ResourceQuantities::fromScalarResources(Resources::parse("cpus:1").get()),
+      sum);
+}
+
+
+// This test verifies that the quantities are kept in order when they
+// no longer fit inline.
+TEST(ResourceQuantitiesTest, ManyResources)
+{
+  Resources resources;
+  for (int i = 0; i < 20; i++) {
+    resources += Resources::parse("custom" + stringify(i), "1", "*").get();
+    resources += Resources::parse("custom" + stringify(i), "1", "role").get();
+  }
+
+  const ResourceQuantities quantities =
+    ResourceQuantities::fromScalarResources(resources);
+
+  EXPECT_EQ(40u, quantities.size());
+  EXPECT_EQ(resources, quantities.toResources());
+  EXPECT_EQ(20u, quantities.flatten().size());
+  EXPECT_DOUBLE_EQ(2, quantities.flatten().get("custom7"));
+
+  EXPECT_EQ(resources + resources, (quantities + quantities).toResources());
+  EXPECT_TRUE((quantities - quantities).empty());
+}
+
+
+// This benchmark compares the arithmetic done by the allocator on
+// stripped `Resources` with the same arithmetic on `ResourceQuantities`.
+TEST(ResourceQuantities_BENCHMARK_Test, Arithmetic)
+{
+  const size_t iterations = 100000;
+
+  const Resources total =
+    Resources::parse("cpus:24;mem:4096;disk:4096;cpus(role):8;gpus:1").get();
+
+  const Resources allocation =
+    Resources::parse("cpus:1;mem:128;disk:128;cpus(role):1").get();
+
+  Stopwatch watch;
+
+  {
+    const Resources totalQuantity = total.createStrippedScalarQuantity();
+
+    Resources allocated;
+
+    watch.start();
+
+    for (size_t i = 0; i < iterations; i++) {
+      const Resources quantity = allocation.createStrippedScalarQuantity();
+
+      if (totalQuantity.contains(allocated + quantity)) {
+        allocated += quantity;
+      } else {
+        allocated -= quantity;
+      }
+    }
+
+    watch.stop();
+
+    cout << "Took " << watch.elapsed() << " to do " << iterations
+         << " stripped resources additions and subtractions" << endl;
+  }
+
+  {
+    const ResourceQuantities totalQuantity =
+      ResourceQuantities::fromScalarResources(total);
+
+    ResourceQuantities allocated;
+
+    watch.start();
+
+    for (size_t i = 0; i < iterations; i++) {
+      const ResourceQuantities quantity =
+        ResourceQuantities::fromScalarResources(allocation);
+
+      if (totalQuantity.contains(allocated + quantity)) {
+        allocated += quantity;
+      } else {
+        allocated -= quantity;
+      }
+    }
+
+    watch.stop();
+
+    cout << "Took " << watch.elapsed() << " to do " << iterations
+         << " resource quantities additions and subtractions" << endl;
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
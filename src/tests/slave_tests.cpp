@@ -55,6 +55,7 @@
 #include "slave/gc.hpp"
 #include "slave/flags.hpp"
 #include "slave/slave.hpp"
+#include "slave/usage_sampler.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
@@ -1619,7 +1620,7 @@ TEST_F(SlaveTest, StatisticsEndpointGetResourceUsageFailed)
 
   MockSlave slave(CreateSlaveFlags(), &detector, &containerizer);
 
-  EXPECT_CALL(slave, usage())
+  EXPECT_CALL(slave, usage(_))
     .WillOnce(Return(Failure("Resource Collection Failure")));
 
   spawn(slave);
@@ -1719,6 +1720,133 @@ TEST_F(SlaveTest, StatisticsEndpointRunningExecutor)
 }
 
 
+// This test verifies that concurrent requests to the usage sampler
+// share a single collection of the usage of a container, that a
+// request which is discarded doesn't affect the others, and that no
+// samples are kept when the usage is only collected on demand.
+TEST_F(SlaveTest, UsageSamplerOnDemand)
+{
+  Clock::pause();
+
+  TestContainerizer containerizer;
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Promise<ResourceStatistics> promise;
+
+  EXPECT_CALL(containerizer, usage(containerId))
+    .WillOnce(Return(promise.future()));
+
+  UsageSampler sampler(&containerizer, Duration::zero());
+
+  Future<ResourceStatistics> usage1 = sampler.usage(containerId, Seconds(10));
+  Future<ResourceStatistics> usage2 = sampler.usage(containerId, Seconds(10));
+
+  // Make sure the usage is being collected.
+  Clock::settle();
+
+  usage1.discard();
+
+  Clock::settle();
+
+  EXPECT_FALSE(promise.future().hasDiscard());
+
+  ResourceStatistics statistics;
+  statistics.set_timestamp(1);
+
+  promise.set(statistics);
+
+  AWAIT_DISCARDED(usage1);
+  AWAIT_READY(usage2);
+
+  EXPECT_EQ(1, usage2->timestamp());
+
+  Clock::settle();
+
+  // No sample is kept, so the usage is collected anew.
+  statistics.set_timestamp(2);
+
+  EXPECT_CALL(containerizer, usage(containerId))
+    .WillOnce(Return(statistics));
+
+  Future<ResourceStatistics> usage3 = sampler.usage(containerId, Seconds(10));
+
+  AWAIT_READY(usage3);
+  EXPECT_EQ(2, usage3->timestamp());
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(0, metrics.values["slave/container_usage_cache_hits"]);
+  EXPECT_EQ(3, metrics.values["slave/container_usage_cache_misses"]);
+
+  Clock::resume();
+}
+
+
+// This test verifies that when sampling periodically, the usage
+// sampler serves a sample from the latest round of sampling even to a
+// consumer that accepts less stale samples, and that the sample of a
+// container is dropped once the container is gone.
+TEST_F(SlaveTest, UsageSamplerPeriodic)
+{
+  Clock::pause();
+
+  // The containerizer doesn't know of any containers, so every round
+  // of sampling drops the samples that were taken on demand.
+  TestContainerizer containerizer;
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  ResourceStatistics statistics;
+  statistics.set_timestamp(1);
+
+  EXPECT_CALL(containerizer, usage(containerId))
+    .WillOnce(Return(statistics));
+
+  UsageSampler sampler(&containerizer, Seconds(10));
+
+  // Wait for the first round of sampling to finish.
+  Clock::settle();
+
+  Future<ResourceStatistics> usage1 = sampler.usage(containerId, Seconds(0));
+
+  AWAIT_READY(usage1);
+  EXPECT_EQ(1, usage1->timestamp());
+
+  Clock::settle();
+  Clock::advance(Seconds(5));
+
+  // The sample is less than an interval old.
+  Future<ResourceStatistics> usage2 = sampler.usage(containerId, Seconds(0));
+
+  AWAIT_READY(usage2);
+  EXPECT_EQ(1, usage2->timestamp());
+
+  // The next round of sampling drops the sample.
+  Clock::advance(Seconds(5));
+  Clock::settle();
+
+  statistics.set_timestamp(2);
+
+  EXPECT_CALL(containerizer, usage(containerId))
+    .WillOnce(Return(statistics));
+
+  Future<ResourceStatistics> usage3 = sampler.usage(containerId, Minutes(1));
+
+  AWAIT_READY(usage3);
+  EXPECT_EQ(2, usage3->timestamp());
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1, metrics.values["slave/container_usage_cache_hits"]);
+  EXPECT_EQ(2, metrics.values["slave/container_usage_cache_misses"]);
+
+  Clock::resume();
+}
+
+
 // This test confirms that an agent's statistics endpoint is
 // authenticated. We rely on the agent implicitly having HTTP
 // authentication enabled.
@@ -2840,7 +2968,7 @@ TEST_F(SlaveTest, ContainerizerUsageFailure)
 
   // We expect that the slave will still returns ResourceUsage but no
   // statistics will be found.
-  Future<ResourceUsage> usage = slave.usage();
+  Future<ResourceUsage> usage = slave.usage(Duration::zero());
 
   AWAIT_READY(usage);
   ASSERT_EQ(1, usage.get().executors_size());
@@ -3458,7 +3586,7 @@ TEST_F(SlaveTest, TotalSlaveResourcesIncludedInUsage)
 
   // We expect that the slave will return ResourceUsage with
   // total resources reported.
-  Future<ResourceUsage> usage = slave.usage();
+  Future<ResourceUsage> usage = slave.usage(Duration::zero());
 
   AWAIT_READY(usage);
 
@@ -3511,7 +3639,7 @@ TEST_F(SlaveTest, CheckpointedResourcesIncludedInUsage)
 
   // We expect that the slave will return ResourceUsage with
   // total and checkpointed slave resources reported.
-  Future<ResourceUsage> usage = slave.usage();
+  Future<ResourceUsage> usage = slave.usage(Duration::zero());
 
   AWAIT_READY(usage);
 
@@ -17,14 +17,21 @@
 #include <stdarg.h>
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/resources.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
@@ -32,8 +39,14 @@
 
 using mesos::internal::master::allocator::DRFSorter;
 
+using std::cout;
+using std::endl;
 using std::list;
+using std::set;
 using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -479,6 +492,248 @@ TEST(SorterTest, RevocableResources)
   EXPECT_EQ("b", sorted.back());
 }
 
+
+// This test verifies that the order that the sorter maintains
+// incrementally, as the totals, weights and allocations change, is
+// the same as the order of a sorter that calculates all of the
+// shares from scratch.
+TEST(SorterTest, IncrementalSort)
+{
+  // The GPUs are excluded from fair sharing, so changes to their
+  // total must not change the order.
+  const set<string> excluded = {"gpus"};
+
+  SlaveID slaveA;
+  slaveA.set_value("agentA");
+
+  SlaveID slaveB;
+  slaveB.set_value("agentB");
+
+  hashmap<SlaveID, Resources> totals;
+  totals[slaveA] =
+    Resources::parse("cpus:100;mem:1000;disk:1000;gpus:10").get();
+  totals[slaveB] = Resources::parse("cpus:50;mem:2000;disk:500").get();
+
+  const vector<string> names = {"a", "b", "c", "d", "e", "f", "g", "h"};
+
+  hashmap<string, double> weights;
+  hashmap<string, Resources> allocations;
+
+  DRFSorter sorter;
+  sorter.initialize(excluded);
+
+  foreachpair (const SlaveID& slaveId, const Resources& total, totals) {
+    sorter.add(slaveId, total);
+  }
+
+  for (size_t i = 0; i < names.size(); i++) {
+    weights[names[i]] = 1;
+    allocations[names[i]] = Resources::parse(
+        "cpus:" + stringify(i + 1) + ";"
+        "mem:" + stringify(10 * (names.size() - i)) + ";"
+        "gpus:1").get();
+
+    sorter.add(names[i]);
+    sorter.allocated(names[i], slaveA, allocations[names[i]]);
+  }
+
+  // Returns the order of a sorter that is given the current totals,
+  // weights and allocations up front.
+  //
+  // NOTE: Each client is allocated resources once in both sorters,
+  // so that ties are broken the same way.
+  auto recompute = [&]() {
+    DRFSorter reference;
+    reference.initialize(excluded);
+
+    foreachpair (const SlaveID& slaveId, const Resources& total, totals) {
+      reference.add(slaveId, total);
+    }
+
+    foreach (const string& name, names) {
+      reference.add(name, weights[name]);
+      reference.allocated(name, slaveA, allocations[name]);
+    }
+
+    return reference.sort();
+  };
+
+  EXPECT_EQ(recompute(), sorter.sort());
+
+  for (size_t round = 0; round < 24; round++) {
+    switch (round % 4) {
+      case 0: {
+        // Change the totals of resources that all clients have been
+        // allocated.
+        sorter.remove(slaveB, totals[slaveB]);
+
+        totals[slaveB] = Resources::parse(
+            "cpus:" + stringify(10 + (7 * round) % 50) + ";"
+            "mem:" + stringify(500 + (37 * round) % 1500) + ";"
+            "disk:500").get();
+
+        sorter.add(slaveB, totals[slaveB]);
+        break;
+      }
+      case 1: {
+        // Change the total of the excluded resource.
+        sorter.remove(slaveA, totals[slaveA]);
+
+        totals[slaveA] = Resources::parse(
+            "cpus:100;mem:1000;disk:1000;"
+            "gpus:" + stringify(1 + round % 9)).get();
+
+        sorter.add(slaveA, totals[slaveA]);
+        break;
+      }
+      case 2: {
+        // Change the weight of a single client.
+        const string& name = names[round % names.size()];
+
+        weights[name] = 1 + (round % 5) * 0.5;
+
+        sorter.update(name, weights[name]);
+        break;
+      }
+      case 3: {
+        // Change the allocation of a single client.
+        const string& name = names[(3 * round) % names.size()];
+
+        Resources allocation = Resources::parse(
+            "cpus:" + stringify(1 + round % 13) + ";"
+            "mem:" + stringify(10 + (17 * round) % 90)).get();
+
+        if ((round / 4) % 2 == 1) {
+          allocation += Resources::parse("gpus:2").get();
+        }
+
+        sorter.update(name, slaveA, allocations[name], allocation);
+
+        allocations[name] = allocation;
+        break;
+      }
+    }
+
+    EXPECT_EQ(recompute(), sorter.sort()) << "Round " << round;
+  }
+}
+
+
+class Sorter_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The sorter benchmark tests are parameterized by the number of clients.
+INSTANTIATE_TEST_CASE_P(
+    ClientCount,
+    Sorter_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U, 20000U, 50000U));
+
+
+// This benchmark measures the latency of `sort()` as the number of
+// clients grows, both when only a single client's allocation has
+// changed and when the total resources have changed.
+TEST_P(Sorter_BENCHMARK_Test, Sort)
+{
+  const size_t clientCount = GetParam();
+  const size_t iterations = 10;
+
+  cout << "Using " << clientCount << " clients" << endl;
+
+  DRFSorter sorter;
+
+  vector<SlaveID> agents;
+  vector<string> clients;
+
+  agents.reserve(clientCount);
+  clients.reserve(clientCount);
+
+  const Resources agentResources =
+    Resources::parse("cpus:24;mem:4096;disk:4096").get();
+
+  const Resources allocation =
+    Resources::parse("cpus:1;mem:128;disk:128").get();
+
+  Stopwatch watch;
+  watch.start();
+
+  // Each client has an allocation on a separate agent.
+  for (size_t i = 0; i < clientCount; i++) {
+    SlaveID agentId;
+    agentId.set_value("agent" + stringify(i));
+    agents.push_back(agentId);
+
+    string client = "framework" + stringify(i);
+    clients.push_back(client);
+
+    sorter.add(agentId, agentResources);
+    sorter.add(client);
+    // Vary the allocations so that the clients have different shares.
+    sorter.allocated(
+        client,
+        agentId,
+        Resources::parse(
+            "cpus:" + stringify(i % 16 + 1) +
+            ";mem:" + stringify(128 * (i % 8 + 1))).get());
+  }
+
+  sorter.sort();
+
+  cout << "Added " << clientCount << " clients and sorted them"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    sorter.sort();
+  }
+
+  cout << "sort() with no changes took "
+       << watch.elapsed() / iterations << " on average" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    const string& client = clients[i % clientCount];
+    const SlaveID& agentId = agents[i % clientCount];
+
+    sorter.allocated(client, agentId, allocation);
+    sorter.sort();
+  }
+
+  cout << "sort() after a single allocation change took "
+       << watch.elapsed() / iterations << " on average" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    const string& client = clients[i % clientCount];
+    const SlaveID& agentId = agents[i % clientCount];
+
+    // Updating an allocation in place (e.g., when a persistent
+    // volume is created) does not change its quantities.
+    sorter.update(client, agentId, allocation, allocation);
+    sorter.sort();
+  }
+
+  cout << "sort() after a single allocation update took "
+       << watch.elapsed() / iterations << " on average" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    SlaveID agentId;
+    agentId.set_value("extra" + stringify(i));
+
+    sorter.add(agentId, agentResources);
+    sorter.sort();
+  }
+
+  cout << "sort() after a total resources change took "
+       << watch.elapsed() / iterations << " on average" << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {